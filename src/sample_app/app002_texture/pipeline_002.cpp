@@ -6,7 +6,7 @@
 #include <si_base/core/core.h>
 #include <si_app/file/path_storage.h>
 #include <si_base/math/math.h>
-#include <si_base/file/file_utility.h>
+#include <si_base/file/mapped_file.h>
 #include <si_base/container/array.h>
 
 namespace SI
@@ -220,15 +220,15 @@ namespace APP002
 			m_textureConstant->m_uvScale[1]     = 1.0f;
 		}
 
-		std::vector<uint8_t> texData;
 		GfxDdsMetaData texMetaData;
 		{
 			char ddsFilePath[260];
 			sprintf_s(ddsFilePath, "%stexture\\test_texture.dds", SI_PATH_STORAGE().GetAssetDirPath());
-			int ret = FileUtility::Load(texData, ddsFilePath);
+			MappedFile texFile;
+			int ret = texFile.Open(ddsFilePath);
 			SI_ASSERT(ret==0);
 
-			m_texture.InitializeDDS("test_texture", &texData[0], texData.size());
+			m_texture.InitializeDDS("test_texture", texFile.GetData(), texFile.GetSize());
 		}
 		
 		// render targetのセットアップ.
@@ -58,6 +58,10 @@ namespace APP004
 	
 	int Pipeline::OnInitialize(const AppInitializeInfo& info)
 	{
+		// 先頭のコンテキストでクリア、最後のコンテキストで合成をして、間をスレッド数で分けて描画する.
+		m_jobSystem.Initialize();
+		m_graphicsContextCount = m_jobSystem.GetThreadCount() + 2;
+
 		if( PipelineBase::OnInitialize(info) != 0) return -1;
 		if( LoadAsset(info) != 0 ) return -1;
 
@@ -66,9 +70,13 @@ namespace APP004
 
 	int Pipeline::LoadAsset(const AppInitializeInfo& info)
 	{
-		GltfLoader loader;
+		GltfLoader loader(nullptr, &m_jobSystem);
 		m_scenesInstance = ScenesInstance::Create(loader.Load("asset\\model\\cornel_box.gltf"));
 
+		const GltfLoaderTimings& timings = loader.GetTimings();
+		SI_PRINT("GltfLoader: total=%.2fms (parse=%.2fms buffers=%.2fms accessors=%.2fms images=%.2fms scene=%.2fms)\n",
+			timings.m_total, timings.m_parse, timings.m_buffers, timings.m_accessors, timings.m_images, timings.m_scene);
+
 		m_renderer.Add(m_scenesInstance);
 		
 		// textureシェーダのセットアップ.
@@ -182,6 +190,8 @@ namespace APP004
 
 		PipelineBase::OnTerminate();
 
+		m_jobSystem.Terminate();
+
 		return 0;
 	}
 	
@@ -204,13 +214,6 @@ namespace APP004
 			m_rt,
 			GfxResourceState::RenderTarget);
 		
-		context.SetRenderTarget(m_rt, m_depth);
-
-		GfxViewport viewport0 = GfxViewport(0.0f, 0.0f, (float)m_rt.GetWidth(), (float)m_rt.GetHeight());
-		GfxScissor scissor0  = GfxScissor(0, 0, m_rt.GetWidth(), m_rt.GetHeight());
-		context.SetViewports(1, &viewport0);
-		context.SetScissors(1, &scissor0);
-
 		context.ClearRenderTarget(m_rt);
 		context.ClearDepthStencilTarget(m_depth);
 
@@ -223,39 +226,54 @@ namespace APP004
 			renderDesc.m_dsvFormat = GfxFormat::D32_Float;
 			renderDesc.m_depthEnable = true;
 			renderDesc.m_depthWriteMask = GfxDepthWriteMask::All;
-			m_renderer.Render(
-				context,
+
+			// 最初と最後以外のコンテキストに並列で記録する.
+			m_renderer.RenderParallel(
+				m_jobSystem,
+				m_contextManager,
+				1,
+				m_contextManager.GetGraphicsContextCount() - 2,
 				RendererDrawStageType::Opaque,
-				renderDesc);
+				renderDesc,
+				[this](GfxGraphicsContext& drawContext)
+				{
+					drawContext.SetRenderTarget(m_rt, m_depth);
+
+					GfxViewport viewport0 = GfxViewport(0.0f, 0.0f, (float)m_rt.GetWidth(), (float)m_rt.GetHeight());
+					GfxScissor scissor0  = GfxScissor(0, 0, m_rt.GetWidth(), m_rt.GetHeight());
+					drawContext.SetViewports(1, &viewport0);
+					drawContext.SetScissors(1, &scissor0);
+				});
 		}
 		
-		context.ResourceBarrier(m_rt, GfxResourceState::PixelShaderResource);		
-		context.ResourceBarrier(m_depth, GfxResourceState::GenericRead);
+		GfxGraphicsContext& lastContext = m_contextManager.GetLastGraphicsContext();
+		lastContext.ResourceBarrier(m_rt, GfxResourceState::PixelShaderResource);		
+		lastContext.ResourceBarrier(m_depth, GfxResourceState::GenericRead);
 		
 		// 箱を描いたレンダーターゲットテクスチャをスワップチェインに描画する
 		{
 			GfxTestureEx_SwapChain& swapChainTexture = m_swapChain.GetTexture();
 			GfxViewport viewport1(0.0f, 0.0f, (float)swapChainTexture.GetWidth(), (float)swapChainTexture.GetHeight());
 			GfxScissor  scissor1(0, 0, swapChainTexture.GetWidth(), swapChainTexture.GetHeight());
-			context.SetRenderTarget(swapChainTexture);
-			context.SetViewports(1, &viewport1);
-			context.SetScissors(1, &scissor1);
+			lastContext.SetRenderTarget(swapChainTexture);
+			lastContext.SetViewports(1, &viewport1);
+			lastContext.SetScissors(1, &scissor1);
 		
-			context.SetPipelineState(m_graphicsState);
-			context.SetGraphicsRootSignature(m_rootSignature);
+			lastContext.SetPipelineState(m_graphicsState);
+			lastContext.SetGraphicsRootSignature(m_rootSignature);
 
-			context.SetDynamicViewDescriptor(0, 0, m_rt);
-			context.SetDynamicSamplerDescriptor(1, 0, m_sampler);
-			context.SetGraphicsRootCBV(2, m_constantBuffer.Get());
+			lastContext.SetDynamicViewDescriptor(0, 0, m_rt);
+			lastContext.SetDynamicSamplerDescriptor(1, 0, m_sampler);
+			lastContext.SetGraphicsRootCBV(2, m_constantBuffer.Get());
 
 			swapChainTexture.SetClearColor(GfxColorRGBA(0.0f, 0.2f, 0.4f, 1.0f));
-			context.ClearRenderTarget(swapChainTexture);
+			lastContext.ClearRenderTarget(swapChainTexture);
 
-			context.SetPrimitiveTopology(GfxPrimitiveTopology::TriangleList);
+			lastContext.SetPrimitiveTopology(GfxPrimitiveTopology::TriangleList);
 
-			context.SetDynamicVB(0, ArraySize(kVertexData), sizeof(kVertexData[0]), kVertexData);
+			lastContext.SetDynamicVB(0, ArraySize(kVertexData), sizeof(kVertexData[0]), kVertexData);
 
-			context.DrawInstanced(6, 1, 0, 0);
+			lastContext.DrawInstanced(6, 1, 0, 0);
 		}
 
 		EndRender();
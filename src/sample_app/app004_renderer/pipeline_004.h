@@ -5,6 +5,7 @@
 #include <si_base/math/math_declare.h>
 #include <si_base/math/math.h>
 #include <si_base/renderer/scenes_instance.h>
+#include <si_base/concurency/job_system.h>
 
 namespace SI
 {
@@ -49,6 +50,8 @@ namespace APP004
 		
 		Vfloat4x4                m_view;
 		Vfloat4x4                m_proj;
+
+		JobSystem                m_jobSystem;
 	};
 	
 } // namespace APP004
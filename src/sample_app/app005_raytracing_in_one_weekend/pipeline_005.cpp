@@ -13,6 +13,7 @@
 #define HIGH_RESOLUTION 0
 #define MIDDLE_RESOLUTION 0
 #define CPU_RATTRACING 1
+#define BVH_BENCHMARK 0
 
 #if CPU_RATTRACING
 #define THE_NEXT_WEEK 1
@@ -20,12 +21,22 @@
 #define THE_NEXT_WEEK 0
 #endif
 
+// 1なら起動時に全サンプルを待たず、毎フレーム少しずつサンプルを積み上げて表示する.
+#if THE_NEXT_WEEK
+#define PROGRESSIVE_RAYTRACING 1
+#else
+#define PROGRESSIVE_RAYTRACING 0
+#endif
+
 namespace SI
 {
 namespace APP005
 {
 	namespace
 	{
+		// プログレッシブレイトレースの1パス(1フレーム)あたりのサンプル数.
+		static const uint32_t kSamplePerPass = 4;
+
 		struct PosUvVertex
 		{
 			float m_x;
@@ -232,7 +243,16 @@ namespace APP005
 #if CPU_RATTRACING
 
 #if THE_NEXT_WEEK
+#if BVH_BENCHMARK
+		RayTracingTheNextWeek::RunBvhBenchmark(m_resultTexture.GetWidth(), m_resultTexture.GetHeight());
+#endif
+#if PROGRESSIVE_RAYTRACING
+		m_progressiveRaytracer.Initialize(m_resultTexture.GetWidth(), m_resultTexture.GetHeight());
+		m_progressiveRaytracer.RenderPass(kSamplePerPass);
+		const std::vector<float>& textureData = m_progressiveRaytracer.GetTextureData();
+#else
 		auto textureData = RayTracingTheNextWeek::GenerateRaytracingTextureData(m_resultTexture.GetWidth(), m_resultTexture.GetHeight());
+#endif
 #else
 		auto textureData = RayTracingInOneWeekEnd::GenerateRaytracingTextureData(m_resultTexture.GetWidth(), m_resultTexture.GetHeight());
 #endif
@@ -283,6 +303,8 @@ namespace APP005
 	int Pipeline::OnTerminate()
 	{
 		m_swapChain.Wait();
+
+		m_progressiveRaytracer.Terminate();
 		
 		for(int i=0; i<kMaxRaytracingCompute; ++i)
 		{
@@ -353,6 +375,26 @@ namespace APP005
 		s_lastComputeId = m_currentComputeId;
 #endif
 
+#if PROGRESSIVE_RAYTRACING
+		// パスはJobSystemで進めて、描画は待たない. パスが終わった時だけ結果を転送し直す.
+		if(m_progressiveRaytracer.TakeFinishedPass())
+		{
+			const std::vector<float>& textureData = m_progressiveRaytracer.GetTextureData();
+			context.UploadTexture(
+				m_device,
+				m_resultTexture,
+				&textureData[0],
+				sizeof(textureData[0]) * textureData.size(),
+				GfxResourceState::PixelShaderResource);
+		}
+
+		// 転送し終わってから次のパスを始める. 実行中はテクスチャのデータを書き換えるため.
+		if(!m_progressiveRaytracer.IsPassRunning() && !m_progressiveRaytracer.IsConverged())
+		{
+			m_progressiveRaytracer.StartPass(kSamplePerPass);
+		}
+#endif
+
 		{
 			GfxTestureEx_SwapChain& swapChainTexture = m_swapChain.GetTexture();
 			GfxViewport viewport1(0.0f, 0.0f, (float)swapChainTexture.GetWidth(), (float)swapChainTexture.GetHeight());
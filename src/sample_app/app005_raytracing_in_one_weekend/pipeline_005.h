@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <si_app/pipeline/pipeline_base.h>
 #include <si_base/math/math_declare.h>
+#include "raytracing_the_next_week.h"
 
 namespace SI
 {
@@ -48,6 +49,8 @@ namespace APP005
 
 		GfxDynamicSampler        m_sampler;
 		int                      m_currentComputeId;
+
+		RayTracingTheNextWeek::ProgressiveRaytracer m_progressiveRaytracer;
 	};
 	
 } // namespace APP003
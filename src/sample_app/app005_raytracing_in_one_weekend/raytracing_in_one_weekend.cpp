@@ -4,7 +4,7 @@
 #include <si_base/core/core.h>
 #include <si_base/math/math.h>
 #include <si_base/core/constant.h>
-#include <random>
+#include <si_base/math/sampling.h>
 #include <chrono>
 #include <si_base/concurency/atomic.h>
 #include <si_base/concurency/mutex.h>
@@ -36,39 +36,61 @@ private:
 	Vfloat3 direction;
 };
 
+// 描画中は、今追跡しているサンプルのサンプラを指す.
+// シーンの構築中などnullptrの時は固定シードのPCG32を使うので、毎回同じ結果になる.
+thread_local Sampling::SobolSampler* t_sampler = nullptr;
+
+// t_samplerを一時的に差し替える.
+class SamplerScope
+{
+public:
+	explicit SamplerScope(Sampling::SobolSampler& sampler)
+		: m_prevSampler(t_sampler)
+	{
+		t_sampler = &sampler;
+	}
+
+	~SamplerScope()
+	{
+		t_sampler = m_prevSampler;
+	}
+
+private:
+	Sampling::SobolSampler* m_prevSampler;
+};
+
 float FloatUnitRand()
 {
-	thread_local std::random_device rd;
-	thread_local std::mt19937 mt(rd());
-	thread_local std::uniform_real_distribution<float> dist(0.0,1.0);
+	if(t_sampler) return t_sampler->Get1D();
 
-	float f = dist(mt);
-	SI_ASSERT(0.0f <= f && f <= 1.0f);
-	return f;
+	thread_local Pcg32 random;
+	return random.NextFloat();
 }
 
-Vfloat3 RandomInUnitSphere()
+void FloatUnitRand2(float& outU, float& outV)
 {
-	Vfloat3 o;
-
-	do
+	if(t_sampler)
 	{
-		o = 2.0 * Vfloat3(FloatUnitRand(), FloatUnitRand(), FloatUnitRand()) - Vfloat3::One();
-	} while(1.0f <= o.LengthSqr());
+		t_sampler->Get2D(outU, outV);
+		return;
+	}
 
-	return o;
+	outU = FloatUnitRand();
+	outV = FloatUnitRand();
 }
 
-Vfloat3 RandomInUnitDisk()
+Vfloat3 RandomInUnitSphere()
 {
-	Vfloat3 o;
-
-	do
-	{
-		o = 2.0 * Vfloat3(FloatUnitRand(), FloatUnitRand(), 0) - Vfloat3(1.0f, 1.0f, 0.0f);
-	} while(1.0f <= Math::Dot(o,o));
+	float u, v;
+	FloatUnitRand2(u, v);
+	return Sampling::UniformSampleBall(u, v, FloatUnitRand());
+}
 
-	return o;
+Vfloat3 RandomInUnitDisk()
+{
+	float u, v;
+	FloatUnitRand2(u, v);
+	return Sampling::ConcentricSampleDisk(u, v);
 }
 
 class Material;
@@ -599,21 +621,21 @@ std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height
 		uint32_t y = n / rowPitch;
 		Vfloat3 color(0.0f);
 		
-		for (uint32_t us = 0; us < sampleUPerPixel; ++us)
+		Sampling::SobolSampler sampler;
+		SamplerScope samplerScope(sampler);
+		for (uint32_t s = 0; s < samplePerPixel; ++s)
 		{
-			float u = (float)x / (float)rowPitch;
-			u += ((float)us + 0.5f) / (float)sampleUPerPixel / (float)width;
+			sampler.Start(n / pixelSize, s);
 
-			for (uint32_t vs = 0; vs < sampleVPerPixel; ++vs)
-			{
-				float v = (float)y / (float)height;
-				v += ((float)vs + 0.5f) / (float)sampleVPerPixel / (float)height;
-		
-				Ray ray = camera.CalcRay(u, v);
-				Vfloat3 sampleColor = RayToColor(ray, hitables);
+			float su, sv;
+			FloatUnitRand2(su, sv);
+			float u = (float)x / (float)rowPitch + su / (float)width;
+			float v = (float)y / (float)height   + sv / (float)height;
 
-				color += sampleColor / (float)samplePerPixel;
-			}
+			Ray ray = camera.CalcRay(u, v);
+			Vfloat3 sampleColor = RayToColor(ray, hitables);
+
+			color += sampleColor / (float)samplePerPixel;
 		}
 
 		color = Math::Sqrt(color); // gamma
@@ -4,13 +4,17 @@
 #include <si_base/core/core.h>
 #include <si_base/math/math.h>
 #include <si_base/core/constant.h>
-#include <random>
+#include <si_base/math/sampling.h>
+#include <immintrin.h>
 #include <chrono>
+#include <unordered_map>
 #include <si_base/concurency/atomic.h>
 #include <si_base/concurency/mutex.h>
+#include <si_base/concurency/job_system.h>
 #include <si_base/gpu/gfx_dds.h>
 #include <si_base/gpu/gfx_utility.h>
-#include <si_base/file/file_utility.h>
+#include <si_base/file/mapped_file.h>
+#include <si_base/misc/bitwise.h>
 #include <si_app/file/path_storage.h>
 //#include <omp.h>
 
@@ -43,39 +47,69 @@ private:
 	float time;
 };
 
+// 描画中は、今追跡しているサンプルのサンプラを指す.
+// シーンの構築中などnullptrの時は固定シードのPCG32を使うので、毎回同じ結果になる.
+thread_local Sampling::SobolSampler* t_sampler = nullptr;
+
+// t_samplerを一時的に差し替える.
+class SamplerScope
+{
+public:
+	explicit SamplerScope(Sampling::SobolSampler& sampler)
+		: m_prevSampler(t_sampler)
+	{
+		t_sampler = &sampler;
+	}
+
+	~SamplerScope()
+	{
+		t_sampler = m_prevSampler;
+	}
+
+private:
+	Sampling::SobolSampler* m_prevSampler;
+};
+
 float FloatUnitRand()
 {
-	thread_local std::random_device rd;
-	thread_local std::mt19937 mt(rd());
-	thread_local std::uniform_real_distribution<float> dist(0.0,1.0);
+	if(t_sampler) return t_sampler->Get1D();
 
-	float f = dist(mt);
-	SI_ASSERT(0.0f <= f && f <= 1.0f);
-	return f;
+	thread_local Pcg32 random;
+	return random.NextFloat();
 }
 
-Vfloat3 RandomInUnitSphere()
+void FloatUnitRand2(float& outU, float& outV)
 {
-	Vfloat3 o;
-
-	do
+	if(t_sampler)
 	{
-		o = 2.0 * Vfloat3(FloatUnitRand(), FloatUnitRand(), FloatUnitRand()) - Vfloat3::One();
-	} while(1.0f <= o.LengthSqr());
+		t_sampler->Get2D(outU, outV);
+		return;
+	}
 
-	return o;
+	outU = FloatUnitRand();
+	outV = FloatUnitRand();
 }
 
-Vfloat3 RandomInUnitDisk()
+Vfloat3 RandomInUnitSphere()
 {
-	Vfloat3 o;
+	float u, v;
+	FloatUnitRand2(u, v);
+	return Sampling::UniformSampleBall(u, v, FloatUnitRand());
+}
 
-	do
-	{
-		o = 2.0 * Vfloat3(FloatUnitRand(), FloatUnitRand(), 0) - Vfloat3(1.0f, 1.0f, 0.0f);
-	} while(1.0f <= Math::Dot(o,o));
+// 単位球面上の一様な点.
+Vfloat3 RandomUnitVector()
+{
+	float u, v;
+	FloatUnitRand2(u, v);
+	return Sampling::UniformSampleSphere(u, v);
+}
 
-	return o;
+Vfloat3 RandomInUnitDisk()
+{
+	float u, v;
+	FloatUnitRand2(u, v);
+	return Sampling::ConcentricSampleDisk(u, v);
 }
 
 class Texture
@@ -312,17 +346,18 @@ public:
 
 	void Load(const char* ddsFilePath)
 	{
-		int ret = SI::FileUtility::Load(m_texData, ddsFilePath);
+		int ret = m_texFile.Open(ddsFilePath);
 		SI_ASSERT(ret==0);
 
-		ret = SI::LoadDdsFromMemory(m_texMetaData, &m_texData[0], m_texData.size());
+		// m_texMetaData.m_imageはマップしたファイルの中を指す.
+		ret = SI::LoadDdsFromMemory(m_texMetaData, m_texFile.GetData(), m_texFile.GetSize());
 		SI_ASSERT(ret==0);
 
 		if(SI::IsBlockCompression(m_texMetaData.m_format))
 		{
 			SI_ASSERT(0, "圧縮テクスチャは未対応.");
 
-			m_texData.clear();
+			m_texFile.Close();
 			m_texMetaData = GfxDdsMetaData();
 			m_pixelByteSize = 0;
 		}
@@ -365,13 +400,15 @@ public:
 		return color;
 	}
 	
-	std::vector<uint8_t> m_texData;
+	SI::MappedFile m_texFile;
 	GfxDdsMetaData m_texMetaData;
 	uint32_t m_pixelByteSize;
 };
 
 class Material;
 
+static const uint32_t kInvalidIndex = UINT32_MAX;
+
 struct HitRecord
 {
 	HitRecord()
@@ -379,6 +416,8 @@ struct HitRecord
 		, position(0.0f)
 		, normal(0.0f, 1.0f, 0.0f)
 		, material(nullptr)
+		, materialIndex(kInvalidIndex)
+		, primitiveIndex(kInvalidIndex)
 		, u(0.0f)
 		, v(0.0f)
 	{}
@@ -387,10 +426,39 @@ struct HitRecord
 	Vfloat3 position;
 	Vfloat3 normal;
 	const Material* material;
+	uint32_t materialIndex; // PrimitiveSceneのマテリアルテーブルのindex.
+	uint32_t primitiveIndex;
 	float u;
 	float v;
 };
 
+enum class MaterialType : uint32_t
+{
+	Lambert,
+	Metal,
+	Dielectric,
+	DiffuseLight,
+	Isotropic,
+};
+
+// マテリアルテーブルの1要素. 型タグで分岐して、仮想関数を使わずに散乱を計算する.
+struct MaterialEntry
+{
+	MaterialEntry()
+		: m_type(MaterialType::Lambert)
+		, m_texture(nullptr)
+		, m_albedo(1.0f)
+		, m_roughness(0.0f)
+		, m_refractiveIndex(1.0f)
+	{}
+
+	MaterialType   m_type;
+	const Texture* m_texture;         // Lambert, DiffuseLight, Isotropic
+	Vfloat3        m_albedo;          // Metal
+	float          m_roughness;       // Metal
+	float          m_refractiveIndex; // Dielectric
+};
+
 class Material
 {
 public:
@@ -399,6 +467,9 @@ public:
 
 	virtual bool Scatter(const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay) const = 0;
 	virtual Vfloat3 Emitted(float u, float v, const Vfloat3& p) const{ return Vfloat3(0.0f); }
+
+	// マテリアルテーブルに登録する時の値.
+	virtual MaterialEntry GetEntry() const = 0;
 };
 
 Vfloat3 Reflect(const Vfloat3& unitV, const Vfloat3& normal)
@@ -436,6 +507,19 @@ public:
 	virtual ~Dielectric(){}
 
 	virtual bool Scatter(const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay) const override
+	{
+		return Scatter(refractiveIndex, ray, record, outAttenuation, outRay);
+	}
+
+	virtual MaterialEntry GetEntry() const override
+	{
+		MaterialEntry entry;
+		entry.m_type            = MaterialType::Dielectric;
+		entry.m_refractiveIndex = refractiveIndex;
+		return entry;
+	}
+
+	static bool Scatter(float refractiveIndex, const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay)
 	{
 		Vfloat3 normalizedRayDir = ray.Dir().Normalize();
 		Vfloat3 outwardNormal;
@@ -491,6 +575,20 @@ public:
 	virtual ~Metal(){}
 
 	virtual bool Scatter(const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay) const override
+	{
+		return Scatter(albedo, roughness, ray, record, outAttenuation, outRay);
+	}
+
+	virtual MaterialEntry GetEntry() const override
+	{
+		MaterialEntry entry;
+		entry.m_type      = MaterialType::Metal;
+		entry.m_albedo    = albedo;
+		entry.m_roughness = roughness;
+		return entry;
+	}
+
+	static bool Scatter(const Vfloat3& albedo, float roughness, const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay)
 	{
 		Vfloat3 reflectedDir = Reflect(ray.Dir().Normalize(), record.normal);
 		
@@ -530,6 +628,14 @@ public:
 		return m_emit->Value(u,v,p);
 	}
 
+	virtual MaterialEntry GetEntry() const override
+	{
+		MaterialEntry entry;
+		entry.m_type    = MaterialType::DiffuseLight;
+		entry.m_texture = m_emit;
+		return entry;
+	}
+
 private:
 	const Texture* m_emit;
 };
@@ -542,9 +648,28 @@ public:
 
 	virtual bool Scatter(const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay) const override
 	{
-		Vfloat3 target = record.position + record.normal + RandomInUnitSphere();
-		outRay = Ray(record.position, target - record.position, ray.Time());
-		outAttenuation = m_albedo->Value(record.u, record.v, record.position);
+		return Scatter(m_albedo, ray, record, outAttenuation, outRay);
+	}
+
+	virtual MaterialEntry GetEntry() const override
+	{
+		MaterialEntry entry;
+		entry.m_type    = MaterialType::Lambert;
+		entry.m_texture = m_albedo;
+		return entry;
+	}
+
+	static bool Scatter(const Texture* albedo, const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay)
+	{
+		// 法線に単位球面上の点を足すと、cosに比例した分布になる.
+		// ちょうど打ち消し合って長さが0になった時は法線の方向に飛ばす.
+		Vfloat3 dir = record.normal + RandomUnitVector();
+		if(Math::Dot(dir, dir) < 1.0e-8f)
+		{
+			dir = record.normal;
+		}
+		outRay = Ray(record.position, dir, ray.Time());
+		outAttenuation = albedo->Value(record.u, record.v, record.position);
 		return true;
 	}
 
@@ -561,9 +686,22 @@ public:
 	}
 	
 	virtual bool Scatter(const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay) const override
+	{
+		return Scatter(m_albedo, ray, record, outAttenuation, outRay);
+	}
+
+	virtual MaterialEntry GetEntry() const override
+	{
+		MaterialEntry entry;
+		entry.m_type    = MaterialType::Isotropic;
+		entry.m_texture = m_albedo;
+		return entry;
+	}
+
+	static bool Scatter(const Texture* albedo, const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay)
 	{
 		outRay = Ray(record.position, RandomInUnitSphere(), ray.Time());
-		outAttenuation = m_albedo->Value(record.u, record.v, record.position);
+		outAttenuation = albedo->Value(record.u, record.v, record.position);
 		return true;
 	}
 
@@ -614,200 +752,1009 @@ Aabb CombineAabb(const Aabb& a, const Aabb& b)
 	return Aabb(Math::Min(a.Min(), b.Min()), Math::Max(a.Max(), b.Max()));
 }
 
-class Hitable
+// 交差判定のループで仮想関数を呼ばないように、プリミティブを型ごとのSoA配列に展開して持つ.
+// RotateY/Translateのようなラッパーは行列のインスタンスに、FlipNormalはフラグにまとめる.
+enum class PrimitiveType : uint32_t
 {
-public:
-	Hitable(){}
-	virtual ~Hitable(){}
+	Sphere, // MovingSphereも速度付きの球として持つ.
+	Rect,
+	Box,
+	Medium,
+};
 
-	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const = 0;
-	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const = 0;
+struct PrimitiveRef
+{
+	PrimitiveType m_type;
+	uint32_t      m_index;      // 型ごとの配列のindex.
+	uint32_t      m_instance;   // kInvalidIndexならワールド空間に置かれている.
+	uint32_t      m_flipNormal;
 };
 
-class ConstantMedium : public Hitable
+struct PrimitiveInstance
 {
-public:
-	ConstantMedium(Hitable* hitable, float density, const Isotropic* phaseFunction)
-		: m_hitable(hitable)
-		, m_density(density)
-		, m_phaseFunction(phaseFunction)
+	Vfloat4x3 m_worldToObject;
+	Vfloat4x3 m_objectToWorld; // 回転と平行移動だけなので、法線も上3x3で変換できる.
+};
+
+// Hitableを展開する時に、親から子に引き継ぐ状態.
+struct PrimitiveContext
+{
+	PrimitiveContext()
+		: m_worldToObject(Vfloat4x3::Identity())
+		, m_objectToWorld(Vfloat4x3::Identity())
+		, m_hasTransform(false)
+		, m_flipNormal(false)
+		, m_medium(kInvalidIndex)
 	{}
 
-	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	void Translate(const Vfloat3& offset)
 	{
-		HitRecord rec0, rec1;
-		if(!m_hitable->Hit(ray, -FLT_MAX, FLT_MAX, rec0)){ return false; }
-		if(!m_hitable->Hit(ray, rec0.t+0.0001f, FLT_MAX, rec1)){ return false; }
-		
-		if(rec0.t < minT) rec0.t = minT;
-		if(maxT < rec1.t) rec1.t = maxT;
+		m_worldToObject = Math::Multiply(m_worldToObject, Math::Translate4x3(-offset));
+		m_objectToWorld = Math::Multiply(Math::Translate4x3(offset), m_objectToWorld);
+		m_hasTransform  = true;
+	}
 
-		if(rec1.t <= rec0.t) return false;
+	// RotateY::CalcRotateY(v, sinTheta, cosTheta)でワールドから物体の空間に回す.
+	void RotateY(float sinTheta, float cosTheta)
+	{
+		Vfloat4x3 rotate(
+			Vfloat3( cosTheta, 0.0f, sinTheta),
+			Vfloat3(     0.0f, 1.0f,     0.0f),
+			Vfloat3(-sinTheta, 0.0f, cosTheta),
+			Vfloat3(0.0f));
+		Vfloat4x3 inverseRotate(
+			Vfloat3(cosTheta, 0.0f, -sinTheta),
+			Vfloat3(    0.0f, 1.0f,      0.0f),
+			Vfloat3(sinTheta, 0.0f,  cosTheta),
+			Vfloat3(0.0f));
+		m_worldToObject = Math::Multiply(m_worldToObject, rotate);
+		m_objectToWorld = Math::Multiply(inverseRotate, m_objectToWorld);
+		m_hasTransform  = true;
+	}
 
-		if(rec0.t < 0) rec0.t = 0;
+	Vfloat4x3 m_worldToObject;
+	Vfloat4x3 m_objectToWorld;
+	bool      m_hasTransform;
+	bool      m_flipNormal;
+	uint32_t  m_medium;       // 有効なら、このmediumの境界として登録する.
+};
 
-		float distance = (rec1.t - rec0.t) * ray.Dir().Length().AsFloat();
-		float hitDistance = -(1/m_density) * log(FloatUnitRand());
+inline Vfloat3 TransformVector(const Vfloat3& v, const Vfloat4x3& m)
+{
+	return v.X() * m[0] + v.Y() * m[1] + v.Z() * m[2];
+}
 
-		if(distance <= hitDistance) return false;
+// 光源上で選んだ点.
+struct LightSample
+{
+	Vfloat3 m_position;
+	Vfloat3 m_normal;
+	Vfloat3 m_emitted;
+	float   m_area;
+};
 
-		outRecord.t        = rec0.t + hitDistance / ray.Dir().Length().AsFloat();
-		outRecord.position = ray.PointAt(outRecord.t);
-		outRecord.normal   = Vfloat3(1,0,0); // arbitary
-		outRecord.material = m_phaseFunction;
+class PrimitiveStorage
+{
+public:
+	PrimitiveStorage()
+		: m_time0(0.0f)
+		, m_time1(1.0f)
+	{
+	}
 
-		return true;
+	~PrimitiveStorage()
+	{
 	}
 
-	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const override
+	void Clear()
 	{
-		return m_hitable->BoundingBox(t0, t1, outAabb);
+		m_refs.clear();
+		m_aabbs.clear();
+		m_instances.clear();
+		m_materials.clear();
+		m_materialIndices.clear();
+		m_spheres = SphereArray();
+		m_rects   = RectArray();
+		m_boxes   = BoxArray();
+		m_media.clear();
+		m_lights.clear();
+		m_refLightFlags.clear();
 	}
 
-	Hitable* m_hitable;
-	float m_density;
-	const Material* m_phaseFunction;
-};
+	void SetTimeRange(float t0, float t1)
+	{
+		m_time0 = t0;
+		m_time1 = t1;
+	}
 
+	uint32_t AddMaterial(const Material* material)
+	{
+		auto it = m_materialIndices.find(material);
+		if(it != m_materialIndices.end()) return it->second;
 
-class Translate : public Hitable
-{
-public:
-	Translate(
-		Hitable* hitable,
-		const Vfloat3& offset)
-		: m_hitable(hitable)
-		, m_offset(offset)
-	{}
+		uint32_t index = (uint32_t)m_materials.size();
+		m_materials.push_back(material->GetEntry());
+		m_materialIndices[material] = index;
+		return index;
+	}
 
-	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	void AddSphere(const Vfloat3& center0, const Vfloat3& center1, float time0, float time1, float radius, const Material* material, const PrimitiveContext& context)
 	{
-		Ray movedRay(ray.Pos() - m_offset, ray.Dir(), ray.Time());
-		if(m_hitable->Hit(movedRay, minT, maxT, outRecord))
+		Vfloat3 velocity = (time0 < time1)? (center1 - center0) / (time1 - time0) : Vfloat3(0.0f);
+
+		// 回転と平行移動では形が変わらないので、中心をワールド空間に移して交差判定での変換を省く.
+		// uvは元の空間の向きで求めるので、インスタンスはその時だけ使う.
+		uint32_t uvInstance = kInvalidIndex;
+		Vfloat3 center = center0;
+		if(context.m_hasTransform)
 		{
-			outRecord.position += m_offset;
-			return true;
+			uvInstance = AddInstance(context);
+			center     = Math::Multiply(center0, context.m_objectToWorld);
+			velocity   = TransformVector(velocity, context.m_objectToWorld);
 		}
-		else
+
+		SphereArray& spheres = m_spheres;
+		uint32_t index = (uint32_t)spheres.m_radius.size();
+		spheres.m_centerX  .push_back(center.Xf());
+		spheres.m_centerY  .push_back(center.Yf());
+		spheres.m_centerZ  .push_back(center.Zf());
+		spheres.m_velocityX.push_back(velocity.Xf());
+		spheres.m_velocityY.push_back(velocity.Yf());
+		spheres.m_velocityZ.push_back(velocity.Zf());
+		spheres.m_time0    .push_back(time0);
+		spheres.m_radius   .push_back(radius);
+		spheres.m_material .push_back(AddMaterial(material));
+		spheres.m_uvInstance.push_back(uvInstance);
+
+		// 描画する時間の範囲で動く分を囲む.
+		Vfloat3 r(radius);
+		Vfloat3 c0 = center + (m_time0 - time0) * velocity;
+		Vfloat3 c1 = center + (m_time1 - time0) * velocity;
+		Aabb aabb = CombineAabb(Aabb(c0 - r, c0 + r), Aabb(c1 - r, c1 + r));
+
+		PrimitiveContext worldContext;
+		worldContext.m_flipNormal = context.m_flipNormal;
+		worldContext.m_medium     = context.m_medium;
+		AddRef(PrimitiveType::Sphere, index, aabb, worldContext);
+	}
+
+	// axis: 面の法線の軸. (u,v)は残りの軸を小さい方から並べたもの.
+	void AddRect(uint32_t axis, float u0, float u1, float v0, float v1, float k, const Material* material, const PrimitiveContext& context)
+	{
+		RectArray& rects = m_rects;
+		uint32_t index = (uint32_t)rects.m_k.size();
+		rects.m_axis    .push_back(axis);
+		rects.m_k       .push_back(k);
+		rects.m_u0      .push_back(u0);
+		rects.m_u1      .push_back(u1);
+		rects.m_v0      .push_back(v0);
+		rects.m_v1      .push_back(v1);
+		rects.m_material.push_back(AddMaterial(material));
+
+		float minV[3];
+		float maxV[3];
+		uint32_t uAxis = (axis==0)? 1 : 0;
+		uint32_t vAxis = (axis==2)? 1 : 2;
+		minV[axis]  = k - 0.001f;
+		maxV[axis]  = k + 0.001f;
+		minV[uAxis] = u0;
+		maxV[uAxis] = u1;
+		minV[vAxis] = v0;
+		maxV[vAxis] = v1;
+		Aabb aabb(Vfloat3(minV[0], minV[1], minV[2]), Vfloat3(maxV[0], maxV[1], maxV[2]));
+		AddRef(PrimitiveType::Rect, index, aabb, context);
+	}
+
+	void AddBox(const Vfloat3& p0, const Vfloat3& p1, const Material* material, const PrimitiveContext& context)
+	{
+		BoxArray& boxes = m_boxes;
+		uint32_t index = (uint32_t)boxes.m_material.size();
+		boxes.m_minX    .push_back(p0.Xf());
+		boxes.m_minY    .push_back(p0.Yf());
+		boxes.m_minZ    .push_back(p0.Zf());
+		boxes.m_maxX    .push_back(p1.Xf());
+		boxes.m_maxY    .push_back(p1.Yf());
+		boxes.m_maxZ    .push_back(p1.Zf());
+		boxes.m_material.push_back(AddMaterial(material));
+
+		AddRef(PrimitiveType::Box, index, Aabb(p0, p1), context);
+	}
+
+	// 境界の形はBeginMediumとEndMediumの間に、m_mediumを設定したcontextで1つだけ登録する.
+	uint32_t BeginMedium(float density, const Material* phaseFunction)
+	{
+		Medium medium;
+		medium.m_density  = density;
+		medium.m_material = AddMaterial(phaseFunction);
+		medium.m_boundary.m_type = PrimitiveType::Medium;
+		m_media.push_back(medium);
+		return (uint32_t)m_media.size() - 1;
+	}
+
+	void EndMedium(uint32_t mediumIndex)
+	{
+		const Medium& medium = m_media[mediumIndex];
+		SI_ASSERT(medium.m_boundary.m_type != PrimitiveType::Medium, "媒質の境界が登録されていない.");
+
+		PrimitiveRef ref;
+		ref.m_type       = PrimitiveType::Medium;
+		ref.m_index      = mediumIndex;
+		ref.m_instance   = kInvalidIndex;
+		ref.m_flipNormal = 0;
+		m_refs.push_back(ref);
+		m_aabbs.push_back(medium.m_boundaryAabb);
+	}
+
+	bool HitPrimitive(uint32_t refIndex, const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		const PrimitiveRef& ref = m_refs[refIndex];
+		bool hit = (ref.m_type == PrimitiveType::Medium)?
+			HitMedium(ref.m_index, ray, minT, maxT, outRecord) :
+			HitRef(ref, ray, minT, maxT, outRecord);
+		if(hit)
 		{
-			return false;
+			outRecord.primitiveIndex = refIndex;
 		}
+		return hit;
 	}
 
-	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const override
+	// HitPrimitiveと同じ判定で、HitRecordを作らずに当たったかだけ返す.
+	bool OccludedPrimitive(uint32_t refIndex, const Ray& ray, float minT, float maxT) const
 	{
-		if(m_hitable->BoundingBox(t0, t1, outAabb))
+		const PrimitiveRef& ref = m_refs[refIndex];
+		if(ref.m_type == PrimitiveType::Medium)
 		{
-			outAabb = Aabb(outAabb.Min() + m_offset, outAabb.Max() + m_offset);
-			return true;
+			// 媒質は境界の出入りを求める必要があるので、そのまま判定する.
+			HitRecord record;
+			return HitMedium(ref.m_index, ray, minT, maxT, record);
 		}
-		else
+
+		Ray localRay = ToLocalRay(ref, ray);
+		float t;
+		switch(ref.m_type)
 		{
-			return false;
+		case PrimitiveType::Sphere:
+			return IntersectSphere(SphereCenter(ref.m_index, localRay.Time()), m_spheres.m_radius[ref.m_index], localRay, minT, maxT, t);
+		case PrimitiveType::Rect:
+			{
+				float u, v;
+				return IntersectRect(ref.m_index, localRay, minT, maxT, t, u, v);
+			}
+		case PrimitiveType::Box:
+			{
+				uint32_t axis;
+				bool maxFace;
+				return IntersectBox(ref.m_index, localRay, minT, maxT, t, axis, maxFace);
+			}
+		default: SI_ASSERT(0); break;
 		}
+		return false;
 	}
 
-private:
-	Hitable* m_hitable;
-	Vfloat3 m_offset;
-};
+	// 球のuvは重いので、走査中の候補ではなく最も近い交点についてだけ求める.
+	void FinalizeHit(HitRecord& record) const
+	{
+		const PrimitiveRef& ref = m_refs[record.primitiveIndex];
+		if(ref.m_type != PrimitiveType::Sphere) return;
 
-class RotateY : public Hitable
-{
-public:
-	RotateY(Hitable* hitable, float angle)
-		: m_hitable(hitable)
+		Vfloat3 unitP = ref.m_flipNormal? -record.normal : record.normal;
+		SphereUv(ref.m_index, unitP, record.u, record.v);
+	}
+
+	bool Scatter(const Ray& ray, const HitRecord& record, Vfloat3& outAttenuation, Ray& outRay) const
 	{
-		m_sinTheta = sin(angle);
-		m_cosTheta = cos(angle);
-		m_hasAabb = m_hitable->BoundingBox(0, 1, m_aabb); 
-		
-		Vfloat3 points[8] =
-		{
-			m_aabb.Min(),
-			Vfloat3(m_aabb.Max().X(), m_aabb.Min().Y(), m_aabb.Min().Z()),
-			Vfloat3(m_aabb.Min().X(), m_aabb.Max().Y(), m_aabb.Min().Z()),
-			Vfloat3(m_aabb.Max().X(), m_aabb.Max().Y(), m_aabb.Min().Z()),
-			Vfloat3(m_aabb.Min().X(), m_aabb.Min().Y(), m_aabb.Max().Z()),
-			Vfloat3(m_aabb.Max().X(), m_aabb.Min().Y(), m_aabb.Max().Z()),
-			Vfloat3(m_aabb.Min().X(), m_aabb.Max().Y(), m_aabb.Max().Z()),
-			m_aabb.Max(),
-		};
-		
-		Vfloat3 minPos(FLT_MAX);
-		Vfloat3 maxPos(-FLT_MAX);
-		for(const Vfloat3& p : points)
+		const MaterialEntry& material = m_materials[record.materialIndex];
+		switch(material.m_type)
 		{
-			Vfloat3 rotatedP = CalcRotateY(p, -m_sinTheta, m_cosTheta); // 逆回転
-			minPos = Math::Min(minPos, rotatedP);
-			maxPos = Math::Max(maxPos, rotatedP);
+		case MaterialType::Lambert:
+			return Lambert::Scatter(material.m_texture, ray, record, outAttenuation, outRay);
+		case MaterialType::Metal:
+			return Metal::Scatter(material.m_albedo, material.m_roughness, ray, record, outAttenuation, outRay);
+		case MaterialType::Dielectric:
+			return Dielectric::Scatter(material.m_refractiveIndex, ray, record, outAttenuation, outRay);
+		case MaterialType::Isotropic:
+			return Isotropic::Scatter(material.m_texture, ray, record, outAttenuation, outRay);
+		default:
+			return false;
 		}
-
-		m_aabb = Aabb(minPos, maxPos);
 	}
 
-	static Vfloat3 CalcRotateY(const Vfloat3& v, float sinTheta, float cosTheta)
+	Vfloat3 Emitted(const HitRecord& record) const
 	{
-		return Vfloat3(
-			cosTheta*v.X() - sinTheta*v.Z(),
-			v.Y(),
-			sinTheta*v.X() + cosTheta*v.Z());
+		const MaterialEntry& material = m_materials[record.materialIndex];
+		if(material.m_type != MaterialType::DiffuseLight) return Vfloat3(0.0f);
+
+		return material.m_texture->Value(record.u, record.v, record.position);
 	}
 
-	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	// DiffuseLightの球とRectを、光源サンプリングの対象として集める.
+	// それ以外の形の光源は、散乱したレイが当たった時にだけ寄与する.
+	void BuildLights()
 	{
-		Vfloat3 pos = ray.Pos();
-		Vfloat3 dir = ray.Dir();		
-		pos = CalcRotateY(pos, m_sinTheta, m_cosTheta);
-		dir = CalcRotateY(dir, m_sinTheta, m_cosTheta);
-
-		Ray rotatedRay(pos, dir, ray.Time());
-		if(m_hitable->Hit(rotatedRay, minT, maxT, outRecord))
-		{
-			outRecord.position = CalcRotateY(outRecord.position, -m_sinTheta, m_cosTheta); // 逆回転
-			outRecord.normal   = CalcRotateY(outRecord.normal,   -m_sinTheta, m_cosTheta); // 逆回転
-			return true;
-		}
-		else
+		m_lights.clear();
+		m_refLightFlags.assign(m_refs.size(), 0);
+		for(uint32_t i=0; i<(uint32_t)m_refs.size(); ++i)
 		{
-			return false;
+			const PrimitiveRef& ref = m_refs[i];
+			uint32_t material = kInvalidIndex;
+			switch(ref.m_type)
+			{
+			case PrimitiveType::Sphere: material = m_spheres.m_material[ref.m_index]; break;
+			case PrimitiveType::Rect:   material = m_rects.m_material[ref.m_index];   break;
+			default: break;
+			}
+			if(material == kInvalidIndex || m_materials[material].m_type != MaterialType::DiffuseLight) continue;
+
+			m_lights.push_back(i);
+			m_refLightFlags[i] = 1;
 		}
 	}
 
-	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const override
+	// lightIndex番目の光源上の点を、面積に対して一様に選ぶ.
+	void SampleLight(uint32_t lightIndex, float time, float u, float v, LightSample& outSample) const
 	{
-		if(m_hasAabb)
+		const PrimitiveRef& ref = m_refs[m_lights[lightIndex]];
+		uint32_t material = kInvalidIndex;
+		float textureU = 0.0f;
+		float textureV = 0.0f;
+		if(ref.m_type == PrimitiveType::Rect)
 		{
-			outAabb = m_aabb;
-			return true;
+			const RectArray& rects = m_rects;
+			uint32_t index = ref.m_index;
+			uint32_t axis  = rects.m_axis[index];
+			uint32_t uAxis = (axis==0)? 1 : 0;
+			uint32_t vAxis = (axis==2)? 1 : 2;
+			float u0 = rects.m_u0[index];
+			float u1 = rects.m_u1[index];
+			float v0 = rects.m_v0[index];
+			float v1 = rects.m_v1[index];
+
+			float position[3];
+			float normal[3] = { 0.0f, 0.0f, 0.0f };
+			position[axis]  = rects.m_k[index];
+			position[uAxis] = u0 + u * (u1 - u0);
+			position[vAxis] = v0 + v * (v1 - v0);
+			normal[axis]    = 1.0f;
+
+			outSample.m_position = Vfloat3(position[0], position[1], position[2]);
+			outSample.m_normal   = Vfloat3(normal[0], normal[1], normal[2]);
+			outSample.m_area     = (u1 - u0) * (v1 - v0);
+			if(ref.m_instance != kInvalidIndex)
+			{
+				const PrimitiveInstance& instance = m_instances[ref.m_instance];
+				outSample.m_position = Math::Multiply(outSample.m_position, instance.m_objectToWorld);
+				outSample.m_normal   = TransformVector(outSample.m_normal, instance.m_objectToWorld);
+			}
+			material = rects.m_material[index];
+			textureU = u;
+			textureV = v;
 		}
 		else
 		{
-			return false;
+			SI_ASSERT(ref.m_type == PrimitiveType::Sphere);
+			uint32_t index = ref.m_index;
+			float radius = m_spheres.m_radius[index];
+			Vfloat3 dir = Sampling::UniformSampleSphere(u, v);
+
+			outSample.m_position = SphereCenter(index, time) + radius * dir;
+			outSample.m_normal   = dir;
+			outSample.m_area     = 4.0f * SI::kPi * radius * radius;
+			material = m_spheres.m_material[index];
+			SphereUv(index, dir, textureU, textureV);
 		}
+
+		outSample.m_emitted = m_materials[material].m_texture->Value(textureU, textureV, outSample.m_position);
 	}
 
-private:
-	Hitable* m_hitable;
-	float m_sinTheta;
-	float m_cosTheta;
-	bool m_hasAabb;
-	Aabb m_aabb;
-};
+	uint32_t GetLightCount() const{ return (uint32_t)m_lights.size(); }
 
-class XYRect : public Hitable
-{
-public:
-	XYRect(float x0, float x1, float y0, float y1, float z, const Material* m)
-		: m_x0(x0)
-		, m_x1(x1)
-		, m_y0(y0)
-		, m_y1(y1)
-		, m_z(z)
-		, m_material(m)
-	{}
+	// 光源サンプリングで寄与を足し済みの光源か.
+	bool IsSampledLight(const HitRecord& record) const{ return m_refLightFlags[record.primitiveIndex] != 0; }
 
-	bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	const MaterialEntry& GetMaterial(const HitRecord& record) const{ return m_materials[record.materialIndex]; }
+
+	size_t GetPrimitiveCount() const{ return m_refs.size(); }
+	const std::vector<Aabb>&          GetPrimitiveAabbs() const{ return m_aabbs; }
+	const std::vector<MaterialEntry>& GetMaterials()      const{ return m_materials; }
+
+private:
+	struct SphereArray
+	{
+		std::vector<float>    m_centerX;
+		std::vector<float>    m_centerY;
+		std::vector<float>    m_centerZ;
+		std::vector<float>    m_velocityX;
+		std::vector<float>    m_velocityY;
+		std::vector<float>    m_velocityZ;
+		std::vector<float>    m_time0;
+		std::vector<float>    m_radius;
+		std::vector<uint32_t> m_material;
+		std::vector<uint32_t> m_uvInstance;
+	};
+
+	struct RectArray
+	{
+		std::vector<uint32_t> m_axis;
+		std::vector<float>    m_k;
+		std::vector<float>    m_u0;
+		std::vector<float>    m_u1;
+		std::vector<float>    m_v0;
+		std::vector<float>    m_v1;
+		std::vector<uint32_t> m_material;
+	};
+
+	struct BoxArray
+	{
+		std::vector<float>    m_minX;
+		std::vector<float>    m_minY;
+		std::vector<float>    m_minZ;
+		std::vector<float>    m_maxX;
+		std::vector<float>    m_maxY;
+		std::vector<float>    m_maxZ;
+		std::vector<uint32_t> m_material;
+	};
+
+	struct Medium
+	{
+		PrimitiveRef m_boundary;
+		Aabb         m_boundaryAabb;
+		float        m_density;
+		uint32_t     m_material;
+	};
+
+	// 同じラッパーの下に並ぶプリミティブは、直前のインスタンスを共有する.
+	uint32_t AddInstance(const PrimitiveContext& context)
+	{
+		if(!m_instances.empty())
+		{
+			const PrimitiveInstance& last = m_instances.back();
+			if(memcmp(&last.m_worldToObject, &context.m_worldToObject, sizeof(Vfloat4x3))==0 &&
+				memcmp(&last.m_objectToWorld, &context.m_objectToWorld, sizeof(Vfloat4x3))==0)
+			{
+				return (uint32_t)m_instances.size() - 1;
+			}
+		}
+
+		PrimitiveInstance instance;
+		instance.m_worldToObject = context.m_worldToObject;
+		instance.m_objectToWorld = context.m_objectToWorld;
+		m_instances.push_back(instance);
+		return (uint32_t)m_instances.size() - 1;
+	}
+
+	void AddRef(PrimitiveType type, uint32_t index, const Aabb& localAabb, const PrimitiveContext& context)
+	{
+		PrimitiveRef ref;
+		ref.m_type       = type;
+		ref.m_index      = index;
+		ref.m_instance   = kInvalidIndex;
+		ref.m_flipNormal = context.m_flipNormal? 1 : 0;
+
+		Aabb aabb = localAabb;
+		if(context.m_hasTransform)
+		{
+			ref.m_instance = AddInstance(context);
+
+			// 8頂点を変換して囲み直す.
+			Vfloat3 minPos(FLT_MAX);
+			Vfloat3 maxPos(-FLT_MAX);
+			for(uint32_t i=0; i<8; ++i)
+			{
+				Vfloat3 corner(
+					(i & 1)? localAabb.Max().Xf() : localAabb.Min().Xf(),
+					(i & 2)? localAabb.Max().Yf() : localAabb.Min().Yf(),
+					(i & 4)? localAabb.Max().Zf() : localAabb.Min().Zf());
+				Vfloat3 p = Math::Multiply(corner, context.m_objectToWorld);
+				minPos = Math::Min(minPos, p);
+				maxPos = Math::Max(maxPos, p);
+			}
+			aabb = Aabb(minPos, maxPos);
+		}
+
+		if(context.m_medium != kInvalidIndex)
+		{
+			Medium& medium = m_media[context.m_medium];
+			SI_ASSERT(medium.m_boundary.m_type == PrimitiveType::Medium, "媒質の境界は1つだけ.");
+			medium.m_boundary     = ref;
+			medium.m_boundaryAabb = aabb;
+			return;
+		}
+
+		m_refs.push_back(ref);
+		m_aabbs.push_back(aabb);
+	}
+
+	// インスタンスなら物体の空間で判定する. 方向は正規化しないのでtはそのまま使える.
+	Ray ToLocalRay(const PrimitiveRef& ref, const Ray& ray) const
+	{
+		if(ref.m_instance == kInvalidIndex) return ray;
+
+		const PrimitiveInstance& instance = m_instances[ref.m_instance];
+		return Ray(Math::Multiply(ray.Pos(), instance.m_worldToObject), TransformVector(ray.Dir(), instance.m_worldToObject), ray.Time());
+	}
+
+	bool HitRef(const PrimitiveRef& ref, const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		const PrimitiveInstance* instance = (ref.m_instance != kInvalidIndex)? &m_instances[ref.m_instance] : nullptr;
+		Ray localRay = ToLocalRay(ref, ray);
+
+		bool hit = false;
+		switch(ref.m_type)
+		{
+		case PrimitiveType::Sphere: hit = HitSphere(ref.m_index, localRay, minT, maxT, outRecord); break;
+		case PrimitiveType::Rect:   hit = HitRect  (ref.m_index, localRay, minT, maxT, outRecord); break;
+		case PrimitiveType::Box:    hit = HitBox   (ref.m_index, localRay, minT, maxT, outRecord); break;
+		default: SI_ASSERT(0); break;
+		}
+		if(!hit) return false;
+
+		if(instance)
+		{
+			outRecord.position = Math::Multiply(outRecord.position, instance->m_objectToWorld);
+			outRecord.normal   = TransformVector(outRecord.normal, instance->m_objectToWorld);
+		}
+		if(ref.m_flipNormal)
+		{
+			outRecord.normal = -outRecord.normal;
+		}
+		return true;
+	}
+
+	Vfloat3 SphereCenter(uint32_t index, float time) const
+	{
+		const SphereArray& spheres = m_spheres;
+		float dt = time - spheres.m_time0[index];
+		return Vfloat3(
+			spheres.m_centerX[index] + dt * spheres.m_velocityX[index],
+			spheres.m_centerY[index] + dt * spheres.m_velocityY[index],
+			spheres.m_centerZ[index] + dt * spheres.m_velocityZ[index]);
+	}
+
+	// unitPはワールド空間での中心から表面への単位ベクトル.
+	void SphereUv(uint32_t index, const Vfloat3& unitP, float& outU, float& outV) const
+	{
+		uint32_t uvInstance = m_spheres.m_uvInstance[index];
+		Vfloat3 localP = (uvInstance != kInvalidIndex)? TransformVector(unitP, m_instances[uvInstance].m_worldToObject) : unitP;
+
+		float phi   = atan2(localP.Zf(), localP.Xf());
+		float theta = asin(SI::Clamp(localP.Yf(), -1.0f, 1.0f));
+		outU = 1.0f - (phi + SI::kPi) / (2 * SI::kPi);
+		outV = (theta + SI::kPi*0.5f) / SI::kPi;
+	}
+
+	static bool IntersectSphere(const Vfloat3& center, float radius, const Ray& ray, float minT, float maxT, float& outT)
+	{
+		Vfloat3 cp = ray.Pos() - center;
+		float a = Math::Dot(ray.Dir(), ray.Dir());
+		float b = 2.0f * Math::Dot(ray.Dir(), cp);
+		float c = Math::Dot(cp, cp) - radius*radius;
+
+		float discriminant = b*b - 4*a*c;
+		if(discriminant <= 0.0f) return false;
+		float sqrtDiscriminant = sqrt(discriminant);
+
+		float t = (-b - sqrtDiscriminant) / (2.0f * a);
+		if(!(minT < t && t < maxT))
+		{
+			t = (-b + sqrtDiscriminant) / (2.0f * a);
+			if(!(minT < t && t < maxT)) return false;
+		}
+		outT = t;
+		return true;
+	}
+
+	bool HitSphere(uint32_t index, const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		const SphereArray& spheres = m_spheres;
+		Vfloat3 center = SphereCenter(index, ray.Time());
+
+		float t;
+		if(!IntersectSphere(center, spheres.m_radius[index], ray, minT, maxT, t)) return false;
+
+		outRecord.t             = t;
+		outRecord.position      = ray.PointAt(t);
+		outRecord.normal        = Math::Normalize(outRecord.position - center);
+		outRecord.material      = nullptr;
+		outRecord.materialIndex = spheres.m_material[index];
+		outRecord.u             = 0.0f; // FinalizeHitで求める.
+		outRecord.v             = 0.0f;
+		return true;
+	}
+
+	// outU, outVは平面上の座標. 0-1への正規化はHitRectで行う.
+	bool IntersectRect(uint32_t index, const Ray& ray, float minT, float maxT, float& outT, float& outU, float& outV) const
+	{
+		const RectArray& rects = m_rects;
+		uint32_t axis  = rects.m_axis[index];
+		uint32_t uAxis = (axis==0)? 1 : 0;
+		uint32_t vAxis = (axis==2)? 1 : 2;
+
+		PackedFloat3 pos = ray.Pos().GetPackedFloat3();
+		PackedFloat3 dir = ray.Dir().GetPackedFloat3();
+
+		float t = (rects.m_k[index] - pos.m_v[axis]) / dir.m_v[axis];
+		if(t<minT || maxT<t) return false;
+
+		float u = pos.m_v[uAxis] + t * dir.m_v[uAxis];
+		float v = pos.m_v[vAxis] + t * dir.m_v[vAxis];
+		if(u < rects.m_u0[index] || rects.m_u1[index] < u) return false;
+		if(v < rects.m_v0[index] || rects.m_v1[index] < v) return false;
+
+		outT = t;
+		outU = u;
+		outV = v;
+		return true;
+	}
+
+	bool HitRect(uint32_t index, const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		const RectArray& rects = m_rects;
+		uint32_t axis = rects.m_axis[index];
+
+		float t, u, v;
+		if(!IntersectRect(index, ray, minT, maxT, t, u, v)) return false;
+
+		float u0 = rects.m_u0[index];
+		float u1 = rects.m_u1[index];
+		float v0 = rects.m_v0[index];
+		float v1 = rects.m_v1[index];
+
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		normal[axis] = 1.0f;
+
+		outRecord.u             = (u - u0) / (u1 - u0);
+		outRecord.v             = (v - v0) / (v1 - v0);
+		outRecord.t             = t;
+		outRecord.material      = nullptr;
+		outRecord.materialIndex = rects.m_material[index];
+		outRecord.position      = ray.PointAt(t);
+		outRecord.normal        = Vfloat3(normal[0], normal[1], normal[2]);
+		return true;
+	}
+
+	// 6枚のRectの代わりにslabテストで判定する. outAxisとoutMaxFaceは当たった面.
+	bool IntersectBox(uint32_t index, const Ray& ray, float minT, float maxT, float& outT, uint32_t& outAxis, bool& outMaxFace) const
+	{
+		const BoxArray& boxes = m_boxes;
+		const float boxMin[3] = { boxes.m_minX[index], boxes.m_minY[index], boxes.m_minZ[index] };
+		const float boxMax[3] = { boxes.m_maxX[index], boxes.m_maxY[index], boxes.m_maxZ[index] };
+
+		PackedFloat3 pos = ray.Pos().GetPackedFloat3();
+		PackedFloat3 dir = ray.Dir().GetPackedFloat3();
+
+		float    tNear    = -FLT_MAX;
+		float    tFar     = FLT_MAX;
+		uint32_t nearAxis = 0;
+		uint32_t farAxis  = 0;
+		for(uint32_t a=0; a<3; ++a)
+		{
+			float invDir = 1.0f / dir.m_v[a];
+			float t0 = (boxMin[a] - pos.m_v[a]) * invDir;
+			float t1 = (boxMax[a] - pos.m_v[a]) * invDir;
+			if(invDir < 0.0f) std::swap(t0, t1);
+			if(tNear < t0){ tNear = t0; nearAxis = a; }
+			if(t1 < tFar) { tFar  = t1; farAxis  = a; }
+		}
+		if(tFar < tNear) return false;
+
+		if(minT <= tNear && tNear <= maxT)
+		{
+			outT = tNear;
+			outAxis = nearAxis;
+			outMaxFace = dir.m_v[nearAxis] < 0.0f;
+			return true;
+		}
+		if(minT <= tFar && tFar <= maxT)
+		{
+			outT = tFar;
+			outAxis = farAxis;
+			outMaxFace = 0.0f <= dir.m_v[farAxis];
+			return true;
+		}
+		return false;
+	}
+
+	// 法線は外向きで、Rectの時と同じuvを返す.
+	bool HitBox(uint32_t index, const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		const BoxArray& boxes = m_boxes;
+		const float boxMin[3] = { boxes.m_minX[index], boxes.m_minY[index], boxes.m_minZ[index] };
+		const float boxMax[3] = { boxes.m_maxX[index], boxes.m_maxY[index], boxes.m_maxZ[index] };
+
+		float t;
+		uint32_t axis;
+		bool maxFace;
+		if(!IntersectBox(index, ray, minT, maxT, t, axis, maxFace)) return false;
+
+		PackedFloat3 pos = ray.Pos().GetPackedFloat3();
+		PackedFloat3 dir = ray.Dir().GetPackedFloat3();
+
+		uint32_t uAxis = (axis==0)? 1 : 0;
+		uint32_t vAxis = (axis==2)? 1 : 2;
+		float u = pos.m_v[uAxis] + t * dir.m_v[uAxis];
+		float v = pos.m_v[vAxis] + t * dir.m_v[vAxis];
+
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		normal[axis] = maxFace? 1.0f : -1.0f;
+
+		outRecord.u             = (u - boxMin[uAxis]) / (boxMax[uAxis] - boxMin[uAxis]);
+		outRecord.v             = (v - boxMin[vAxis]) / (boxMax[vAxis] - boxMin[vAxis]);
+		outRecord.t             = t;
+		outRecord.material      = nullptr;
+		outRecord.materialIndex = boxes.m_material[index];
+		outRecord.position      = ray.PointAt(t);
+		outRecord.normal        = Vfloat3(normal[0], normal[1], normal[2]);
+		return true;
+	}
+
+	bool HitMedium(uint32_t index, const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		const Medium& medium = m_media[index];
+
+		HitRecord rec0, rec1;
+		if(!HitRef(medium.m_boundary, ray, -FLT_MAX, FLT_MAX, rec0)){ return false; }
+		if(!HitRef(medium.m_boundary, ray, rec0.t+0.0001f, FLT_MAX, rec1)){ return false; }
+
+		if(rec0.t < minT) rec0.t = minT;
+		if(maxT < rec1.t) rec1.t = maxT;
+
+		if(rec1.t <= rec0.t) return false;
+
+		if(rec0.t < 0) rec0.t = 0;
+
+		float rayLength = ray.Dir().Length().AsFloat();
+		float distance = (rec1.t - rec0.t) * rayLength;
+		float hitDistance = -(1/medium.m_density) * log(FloatUnitRand());
+
+		if(distance <= hitDistance) return false;
+
+		outRecord.t             = rec0.t + hitDistance / rayLength;
+		outRecord.position      = ray.PointAt(outRecord.t);
+		outRecord.normal        = Vfloat3(1,0,0); // arbitary
+		outRecord.material      = nullptr;
+		outRecord.materialIndex = medium.m_material;
+		outRecord.u             = 0.0f;
+		outRecord.v             = 0.0f;
+		return true;
+	}
+
+private:
+	std::vector<PrimitiveRef>      m_refs;      // BVHに登録するプリミティブ.
+	std::vector<Aabb>              m_aabbs;     // m_refsと同じ並びのワールド空間のAABB.
+	std::vector<PrimitiveInstance> m_instances;
+	std::vector<MaterialEntry>     m_materials;
+	std::unordered_map<const Material*, uint32_t> m_materialIndices;
+	SphereArray                    m_spheres;
+	RectArray                      m_rects;
+	BoxArray                       m_boxes;
+	std::vector<Medium>            m_media;
+	std::vector<uint32_t>          m_lights;        // 光源サンプリングするプリミティブ(m_refsのindex).
+	std::vector<uint8_t>           m_refLightFlags; // m_refsと同じ並び. m_lightsに含まれていれば1.
+	float                          m_time0; // 描画するシャッターの開閉時間.
+	float                          m_time1;
+};
+
+class Hitable
+{
+public:
+	Hitable(){}
+	virtual ~Hitable(){}
+
+	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const = 0;
+	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const = 0;
+
+	// 描画用に、プリミティブをPrimitiveStorageの配列に展開する.
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const = 0;
+};
+
+class ConstantMedium : public Hitable
+{
+public:
+	ConstantMedium(Hitable* hitable, float density, const Isotropic* phaseFunction)
+		: m_hitable(hitable)
+		, m_density(density)
+		, m_phaseFunction(phaseFunction)
+	{}
+
+	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	{
+		HitRecord rec0, rec1;
+		if(!m_hitable->Hit(ray, -FLT_MAX, FLT_MAX, rec0)){ return false; }
+		if(!m_hitable->Hit(ray, rec0.t+0.0001f, FLT_MAX, rec1)){ return false; }
+		
+		if(rec0.t < minT) rec0.t = minT;
+		if(maxT < rec1.t) rec1.t = maxT;
+
+		if(rec1.t <= rec0.t) return false;
+
+		if(rec0.t < 0) rec0.t = 0;
+
+		float distance = (rec1.t - rec0.t) * ray.Dir().Length().AsFloat();
+		float hitDistance = -(1/m_density) * log(FloatUnitRand());
+
+		if(distance <= hitDistance) return false;
+
+		outRecord.t        = rec0.t + hitDistance / ray.Dir().Length().AsFloat();
+		outRecord.position = ray.PointAt(outRecord.t);
+		outRecord.normal   = Vfloat3(1,0,0); // arbitary
+		outRecord.material = m_phaseFunction;
+
+		return true;
+	}
+
+	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const override
+	{
+		return m_hitable->BoundingBox(t0, t1, outAabb);
+	}
+
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		uint32_t mediumIndex = storage.BeginMedium(m_density, m_phaseFunction);
+		PrimitiveContext boundaryContext = context;
+		boundaryContext.m_flipNormal = false;
+		boundaryContext.m_medium     = mediumIndex;
+		m_hitable->Flatten(storage, boundaryContext);
+		storage.EndMedium(mediumIndex);
+	}
+
+	Hitable* m_hitable;
+	float m_density;
+	const Material* m_phaseFunction;
+};
+
+
+class Translate : public Hitable
+{
+public:
+	Translate(
+		Hitable* hitable,
+		const Vfloat3& offset)
+		: m_hitable(hitable)
+		, m_offset(offset)
+	{}
+
+	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	{
+		Ray movedRay(ray.Pos() - m_offset, ray.Dir(), ray.Time());
+		if(m_hitable->Hit(movedRay, minT, maxT, outRecord))
+		{
+			outRecord.position += m_offset;
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const override
+	{
+		if(m_hitable->BoundingBox(t0, t1, outAabb))
+		{
+			outAabb = Aabb(outAabb.Min() + m_offset, outAabb.Max() + m_offset);
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		PrimitiveContext childContext = context;
+		childContext.Translate(m_offset);
+		m_hitable->Flatten(storage, childContext);
+	}
+
+private:
+	Hitable* m_hitable;
+	Vfloat3 m_offset;
+};
+
+class RotateY : public Hitable
+{
+public:
+	RotateY(Hitable* hitable, float angle)
+		: m_hitable(hitable)
+	{
+		m_sinTheta = sin(angle);
+		m_cosTheta = cos(angle);
+		m_hasAabb = m_hitable->BoundingBox(0, 1, m_aabb); 
+		
+		Vfloat3 points[8] =
+		{
+			m_aabb.Min(),
+			Vfloat3(m_aabb.Max().X(), m_aabb.Min().Y(), m_aabb.Min().Z()),
+			Vfloat3(m_aabb.Min().X(), m_aabb.Max().Y(), m_aabb.Min().Z()),
+			Vfloat3(m_aabb.Max().X(), m_aabb.Max().Y(), m_aabb.Min().Z()),
+			Vfloat3(m_aabb.Min().X(), m_aabb.Min().Y(), m_aabb.Max().Z()),
+			Vfloat3(m_aabb.Max().X(), m_aabb.Min().Y(), m_aabb.Max().Z()),
+			Vfloat3(m_aabb.Min().X(), m_aabb.Max().Y(), m_aabb.Max().Z()),
+			m_aabb.Max(),
+		};
+		
+		Vfloat3 minPos(FLT_MAX);
+		Vfloat3 maxPos(-FLT_MAX);
+		for(const Vfloat3& p : points)
+		{
+			Vfloat3 rotatedP = CalcRotateY(p, -m_sinTheta, m_cosTheta); // 逆回転
+			minPos = Math::Min(minPos, rotatedP);
+			maxPos = Math::Max(maxPos, rotatedP);
+		}
+
+		m_aabb = Aabb(minPos, maxPos);
+	}
+
+	static Vfloat3 CalcRotateY(const Vfloat3& v, float sinTheta, float cosTheta)
+	{
+		return Vfloat3(
+			cosTheta*v.X() - sinTheta*v.Z(),
+			v.Y(),
+			sinTheta*v.X() + cosTheta*v.Z());
+	}
+
+	virtual bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+	{
+		Vfloat3 pos = ray.Pos();
+		Vfloat3 dir = ray.Dir();		
+		pos = CalcRotateY(pos, m_sinTheta, m_cosTheta);
+		dir = CalcRotateY(dir, m_sinTheta, m_cosTheta);
+
+		Ray rotatedRay(pos, dir, ray.Time());
+		if(m_hitable->Hit(rotatedRay, minT, maxT, outRecord))
+		{
+			outRecord.position = CalcRotateY(outRecord.position, -m_sinTheta, m_cosTheta); // 逆回転
+			outRecord.normal   = CalcRotateY(outRecord.normal,   -m_sinTheta, m_cosTheta); // 逆回転
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	virtual bool BoundingBox(float t0, float t1, Aabb& outAabb) const override
+	{
+		if(m_hasAabb)
+		{
+			outAabb = m_aabb;
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		PrimitiveContext childContext = context;
+		childContext.RotateY(m_sinTheta, m_cosTheta);
+		m_hitable->Flatten(storage, childContext);
+	}
+
+private:
+	Hitable* m_hitable;
+	float m_sinTheta;
+	float m_cosTheta;
+	bool m_hasAabb;
+	Aabb m_aabb;
+};
+
+class XYRect : public Hitable
+{
+public:
+	XYRect(float x0, float x1, float y0, float y1, float z, const Material* m)
+		: m_x0(x0)
+		, m_x1(x1)
+		, m_y0(y0)
+		, m_y1(y1)
+		, m_z(z)
+		, m_material(m)
+	{}
+
+	bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
 	{
 		float t = (m_z - ray.Pos().Z().AsFloat()) / ray.Dir().Z().AsFloat();
 		if(t<minT || maxT<t) return false;
@@ -834,6 +1781,11 @@ public:
 		return true;
 	}
 
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		storage.AddRect(2, m_x0, m_x1, m_y0, m_y1, m_z, m_material, context);
+	}
+
 private:
 	float m_x0, m_x1;
 	float m_y0, m_y1;
@@ -880,6 +1832,11 @@ public:
 		return true;
 	}
 
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		storage.AddRect(1, m_x0, m_x1, m_z0, m_z1, m_y, m_material, context);
+	}
+
 private:
 	float m_x0, m_x1;
 	float m_z0, m_z1;
@@ -926,6 +1883,11 @@ public:
 		return true;
 	}
 
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		storage.AddRect(0, m_y0, m_y1, m_z0, m_z1, m_x, m_material, context);
+	}
+
 private:
 	float m_y0, m_y1;
 	float m_z0, m_z1;
@@ -959,6 +1921,13 @@ public:
 		return m_hitable->BoundingBox(t0, t1, outAabb);
 	}
 
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		PrimitiveContext childContext = context;
+		childContext.m_flipNormal = !context.m_flipNormal;
+		m_hitable->Flatten(storage, childContext);
+	}
+
 private:
 	const Hitable* m_hitable;
 };
@@ -1025,6 +1994,11 @@ public:
 		return true;
 	}
 
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		storage.AddSphere(center, center, 0.0f, 0.0f, radius, material, context);
+	}
+
 	void GetUv(const Vfloat3& p, float& u, float& v) const
 	{
 		Vfloat3 unitP = Math::Normalize(p-center);
@@ -1146,6 +2120,11 @@ public:
 		return true;
 	}
 
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		storage.AddSphere(center0, center1, time0, time1, radius, material, context);
+	}
+
 private:
 	Vfloat3 center0;
 	Vfloat3 center1;
@@ -1155,134 +2134,784 @@ private:
 	const Material* material;
 };
 
-class BvhNode : public Hitable
+// 32byteにまとめたBVHのノード. 全ノードを一つの配列に並べて持つ.
+// 節の場合、左の子は直後(自身のindex+1)に、右の子はm_offsetの位置に置かれる.
+// 葉の場合、プリミティブ配列のm_offsetからm_count個を持つ.
+struct alignas(32) BvhFlatNode
+{
+	float    m_min[3];
+	uint32_t m_offset;
+	float    m_max[3];
+	uint16_t m_count;
+	uint16_t m_axis;
+
+	bool IsLeaf() const{ return 0 < m_count; }
+};
+static_assert(sizeof(BvhFlatNode)==32, "BvhFlatNode size must be 32.");
+
+// Binned SAHで構築して、スタックでループ走査するBVH.
+class Bvh
 {
 public:
-	BvhNode()
-		: m_left(nullptr)
-		, m_right(nullptr)
-		, m_owner(false)
-	{}
+	static const uint32_t kBinCount     = 16;
+	static const uint32_t kMaxLeafCount = 4;
+	static const uint32_t kStackSize    = 64;
+
+	// 走査のスタックは木の深さまでしか積まないので、構築時に深さを制限してあふれないようにする.
+	// 制限を超えたら葉にし、葉に入りきらない数なら数で半分にしていくので、残り24段で十分足りる.
+	static const uint32_t kMaxBuildDepth = kStackSize - 24;
+
+public:
+	Bvh()
+	{
+	}
+
+	~Bvh()
+	{
+	}
 
-	~BvhNode()
+	// プリミティブはaabbsのindexで参照する. 交差判定はHitに渡す関数に任せる.
+	void Build(const std::vector<Aabb>& aabbs)
 	{
-		if(m_owner)
+		m_nodes.clear();
+		m_primitiveIndices.clear();
+		if(aabbs.empty()) return;
+
+		std::vector<BuildPrimitive> buildPrims;
+		buildPrims.reserve(aabbs.size());
+		for(uint32_t i=0; i<(uint32_t)aabbs.size(); ++i)
+		{
+			BuildPrimitive prim;
+			prim.m_aabb   = aabbs[i];
+			prim.m_center = 0.5f * (prim.m_aabb.Min() + prim.m_aabb.Max());
+			prim.m_index  = i;
+			buildPrims.push_back(prim);
+		}
+
+		m_nodes.reserve(2 * buildPrims.size());
+		m_primitiveIndices.reserve(buildPrims.size());
+		BuildRecursive(buildPrims, 0, (uint32_t)buildPrims.size(), 0);
+	}
+	
+	// hitPrimitive(primitiveIndex, ray, minT, maxT, outRecord)で葉のプリミティブと交差判定する.
+	template<typename HitPrimitiveFunc>
+	bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord, const HitPrimitiveFunc& hitPrimitive) const
+	{
+		if(m_nodes.empty()) return false;
+
+		// 除算は走査前に一度だけ. 0除算でinfになってもslabテストは成り立つ.
+		Vfloat3 invDir = Vfloat3::One() / ray.Dir();
+		bool dirIsNeg[3] =
+		{
+			invDir.Xf() < 0.0f,
+			invDir.Yf() < 0.0f,
+			invDir.Zf() < 0.0f,
+		};
+
+		uint32_t stack[kStackSize];
+		uint32_t stackCount = 0;
+		uint32_t nodeIndex  = 0;
+		bool hitAnything = false;
+		float closestT = maxT;
+
+		while(true)
+		{
+			const BvhFlatNode& node = m_nodes[nodeIndex];
+			if(HitNode(node, ray.Pos(), invDir, minT, closestT))
+			{
+				if(node.IsLeaf())
+				{
+					const uint32_t* prims = &m_primitiveIndices[node.m_offset];
+					for(uint32_t i=0; i<node.m_count; ++i)
+					{
+						if(hitPrimitive(prims[i], ray, minT, closestT, outRecord))
+						{
+							closestT = outRecord.t;
+							hitAnything = true;
+						}
+					}
+					
+					if(stackCount==0) break;
+					nodeIndex = stack[--stackCount];
+				}
+				else
+				{
+					// レイの向きに近い方の子を先に辿る.
+					SI_ASSERT(stackCount < kStackSize);
+					if(dirIsNeg[node.m_axis])
+					{
+						stack[stackCount++] = nodeIndex + 1;
+						nodeIndex = node.m_offset;
+					}
+					else
+					{
+						stack[stackCount++] = node.m_offset;
+						nodeIndex = nodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if(stackCount==0) break;
+				nodeIndex = stack[--stackCount];
+			}
+		}
+
+		return hitAnything;
+	}
+
+	// 影のレイ用. occluded(primitiveIndex, ray, minT, maxT)が最初にtrueを返したところで打ち切る.
+	template<typename OccludedFunc>
+	bool HitAny(const Ray& ray, float minT, float maxT, const OccludedFunc& occluded) const
+	{
+		if(m_nodes.empty()) return false;
+
+		Vfloat3 invDir = Vfloat3::One() / ray.Dir();
+
+		uint32_t stack[kStackSize];
+		uint32_t stackCount = 0;
+		uint32_t nodeIndex  = 0;
+
+		while(true)
 		{
-			delete m_left;
-			delete m_right;
+			const BvhFlatNode& node = m_nodes[nodeIndex];
+			if(HitNode(node, ray.Pos(), invDir, minT, maxT))
+			{
+				if(node.IsLeaf())
+				{
+					const uint32_t* prims = &m_primitiveIndices[node.m_offset];
+					for(uint32_t i=0; i<node.m_count; ++i)
+					{
+						if(occluded(prims[i], ray, minT, maxT)) return true;
+					}
+
+					if(stackCount==0) break;
+					nodeIndex = stack[--stackCount];
+				}
+				else
+				{
+					// どれか1つに当たればよいので、子を辿る順番は気にしない.
+					SI_ASSERT(stackCount < kStackSize);
+					stack[stackCount++] = node.m_offset;
+					nodeIndex = nodeIndex + 1;
+				}
+			}
+			else
+			{
+				if(stackCount==0) break;
+				nodeIndex = stack[--stackCount];
+			}
 		}
+
+		return false;
+	}
+
+	bool BoundingBox(Aabb& outAabb) const
+	{
+		if(m_nodes.empty()) return false;
+
+		outAabb = Aabb(Vfloat3(m_nodes[0].m_min), Vfloat3(m_nodes[0].m_max));
+		return true;
 	}
 
-	static int CompareAabb(int axis, const void* a, const void* b)
+	size_t GetNodeCount() const{ return m_nodes.size(); }
+	const std::vector<BvhFlatNode>& GetNodes()            const{ return m_nodes; }
+	const std::vector<uint32_t>&    GetPrimitiveIndices() const{ return m_primitiveIndices; }
+
+private:
+	struct BuildPrimitive
 	{
-		const Hitable* hitable0 = *(const Hitable**)a;
-		const Hitable* hitable1 = *(const Hitable**)b;
-		Aabb aabb0;
-		Aabb aabb1;
-		bool ret0 = hitable0->BoundingBox(0, 0, aabb0);
-		bool ret1 = hitable1->BoundingBox(0, 0, aabb1);
-		SI_ASSERT(ret0 && ret1);
+		Aabb     m_aabb;
+		Vfloat3  m_center;
+		uint32_t m_index;
+	};
 
-		if(aabb0.Min()[axis] < aabb1.Min()[axis])
+	struct Bin
+	{
+		Bin()
+			: m_min(FLT_MAX)
+			, m_max(-FLT_MAX)
+			, m_count(0)
 		{
-			return -1;
 		}
-		else
+
+		Vfloat3  m_min;
+		Vfloat3  m_max;
+		uint32_t m_count;
+	};
+
+	static float SurfaceArea(const Vfloat3& minV, const Vfloat3& maxV)
+	{
+		Vfloat3 d = Math::Max(maxV - minV, Vfloat3::Zero());
+		return 2.0f * Math::Dot(d, d.Swizzle<1,2,0>()).AsFloat();
+	}
+
+	static bool HitNode(const BvhFlatNode& node, const Vfloat3& rayPos, const Vfloat3& invDir, float minT, float maxT)
+	{
+		// w成分にはm_offset等が入るが、HorizontalMin/Maxはxyzしか見ないので問題ない.
+		Vfloat3 nodeMin(_mm_load_ps(node.m_min));
+		Vfloat3 nodeMax(_mm_load_ps(node.m_max));
+		Vfloat3 tx0 = (nodeMin - rayPos) * invDir;
+		Vfloat3 tx1 = (nodeMax - rayPos) * invDir;
+
+		float tMin = SI::Max(Math::HorizontalMax(Math::Min(tx0, tx1)).AsFloat(), minT);
+		float tMax = SI::Min(Math::HorizontalMin(Math::Max(tx0, tx1)).AsFloat(), maxT);
+		return tMin <= tMax;
+	}
+
+	uint32_t PushNode(const Vfloat3& minV, const Vfloat3& maxV)
+	{
+		uint32_t index = (uint32_t)m_nodes.size();
+		m_nodes.emplace_back();
+
+		BvhFlatNode& node = m_nodes.back();
+		PackedFloat3 packedMin = minV.GetPackedFloat3();
+		PackedFloat3 packedMax = maxV.GetPackedFloat3();
+		memcpy(node.m_min, packedMin.m_v, sizeof(node.m_min));
+		memcpy(node.m_max, packedMax.m_v, sizeof(node.m_max));
+		node.m_offset = 0;
+		node.m_count  = 0;
+		node.m_axis   = 0;
+		return index;
+	}
+
+	void MakeLeaf(uint32_t nodeIndex, std::vector<BuildPrimitive>& prims, uint32_t begin, uint32_t end)
+	{
+		BvhFlatNode& node = m_nodes[nodeIndex];
+		node.m_offset = (uint32_t)m_primitiveIndices.size();
+		node.m_count  = (uint16_t)(end - begin);
+		for(uint32_t i=begin; i<end; ++i)
 		{
-			return 1;
+			m_primitiveIndices.push_back(prims[i].m_index);
 		}
 	}
 
-	void BuildBvh(const Hitable** list, int listCount, float t0, float t1, int axisIndex=0)
+	uint32_t BuildRecursive(std::vector<BuildPrimitive>& prims, uint32_t begin, uint32_t end, uint32_t depth)
 	{
-		SI_ASSERT(m_left==nullptr);
-		SI_ASSERT(m_right==nullptr);
+		SI_ASSERT(begin < end);
+		SI_ASSERT(depth < kStackSize);
+
+		Vfloat3 boundsMin(FLT_MAX);
+		Vfloat3 boundsMax(-FLT_MAX);
+		Vfloat3 centerMin(FLT_MAX);
+		Vfloat3 centerMax(-FLT_MAX);
+		for(uint32_t i=begin; i<end; ++i)
+		{
+			boundsMin = Math::Min(boundsMin, prims[i].m_aabb.Min());
+			boundsMax = Math::Max(boundsMax, prims[i].m_aabb.Max());
+			centerMin = Math::Min(centerMin, prims[i].m_center);
+			centerMax = Math::Max(centerMax, prims[i].m_center);
+		}
+
+		uint32_t nodeIndex = PushNode(boundsMin, boundsMax);
+		uint32_t count = end - begin;
+		if(count <= 1 || (kMaxBuildDepth <= depth && count <= UINT16_MAX))
+		{
+			MakeLeaf(nodeIndex, prims, begin, end);
+			return nodeIndex;
+		}
+		
+		// 全軸について、重心をビンに振り分けてSAHのコストが最小になる分割を探す.
+		Vfloat3 centerExtent = centerMax - centerMin;
+		float parentArea = SurfaceArea(boundsMin, boundsMax);
+		float bestCost = FLT_MAX;
+		int   bestAxis = -1;
+		uint32_t bestSplit = 0;
+		for(int axis=0; axis<3; ++axis)
+		{
+			float extent = centerExtent[axis].AsFloat();
+			if(extent <= 0.0f) continue;
+
+			float axisMin = centerMin[axis].AsFloat();
+			float binScale = (float)kBinCount / extent;
+
+			Bin bins[kBinCount];
+			for(uint32_t i=begin; i<end; ++i)
+			{
+				uint32_t b = SI::Min((uint32_t)((prims[i].m_center[axis].AsFloat() - axisMin) * binScale), kBinCount-1);
+				bins[b].m_min = Math::Min(bins[b].m_min, prims[i].m_aabb.Min());
+				bins[b].m_max = Math::Max(bins[b].m_max, prims[i].m_aabb.Max());
+				++bins[b].m_count;
+			}
+
+			// 右側からの累積を先に求めておく.
+			float    rightArea [kBinCount];
+			uint32_t rightCount[kBinCount];
+			Vfloat3 accumMin(FLT_MAX);
+			Vfloat3 accumMax(-FLT_MAX);
+			uint32_t accumCount = 0;
+			for(uint32_t b=kBinCount-1; 0<b; --b)
+			{
+				accumMin = Math::Min(accumMin, bins[b].m_min);
+				accumMax = Math::Max(accumMax, bins[b].m_max);
+				accumCount += bins[b].m_count;
+				rightArea[b]  = SurfaceArea(accumMin, accumMax);
+				rightCount[b] = accumCount;
+			}
+			
+			accumMin = Vfloat3(FLT_MAX);
+			accumMax = Vfloat3(-FLT_MAX);
+			accumCount = 0;
+			for(uint32_t b=0; b<kBinCount-1; ++b)
+			{
+				accumMin = Math::Min(accumMin, bins[b].m_min);
+				accumMax = Math::Max(accumMax, bins[b].m_max);
+				accumCount += bins[b].m_count;
+				if(accumCount==0 || rightCount[b+1]==0) continue;
+
+				float cost = SurfaceArea(accumMin, accumMax) * (float)accumCount + rightArea[b+1] * (float)rightCount[b+1];
+				if(cost < bestCost)
+				{
+					bestCost  = cost;
+					bestAxis  = axis;
+					bestSplit = b;
+				}
+			}
+		}
 
-		int axis = axisIndex % 3;
-		if(axis==0)
+		// 節の走査コストを1、プリミティブの交差コストを1として比べる.
+		// 重心が全て重なっていてビンで分けられない時も葉にする.
+		bool makeLeaf = false;
+		if(bestAxis < 0)
 		{
-			std::qsort(list, listCount, sizeof(Hitable*), [](const void* a, const void* b)->int{ return CompareAabb(0, a, b); });
+			makeLeaf = (count <= UINT16_MAX);
 		}
-		else if(axis==1)
+		else if(count <= kMaxLeafCount)
 		{
-			std::qsort(list, listCount, sizeof(Hitable*), [](const void* a, const void* b)->int{ return CompareAabb(1, a, b); });
+			float leafCost = (float)count;
+			float splitCost = 1.0f + bestCost / parentArea;
+			makeLeaf = (leafCost <= splitCost);
 		}
-		else
+
+		if(makeLeaf)
 		{
-			std::qsort(list, listCount, sizeof(Hitable*), [](const void* a, const void* b)->int{ return CompareAabb(2, a, b); });
+			MakeLeaf(nodeIndex, prims, begin, end);
+			return nodeIndex;
 		}
 
-		if(listCount==1)
+		uint32_t mid = begin;
+		if(0 <= bestAxis && depth < kMaxBuildDepth)
+		{
+			float axisMin = centerMin[bestAxis].AsFloat();
+			float binScale = (float)kBinCount / centerExtent[bestAxis].AsFloat();
+			auto midIt = std::partition(prims.begin() + begin, prims.begin() + end, [&](const BuildPrimitive& p)
+			{
+				uint32_t b = SI::Min((uint32_t)((p.m_center[bestAxis].AsFloat() - axisMin) * binScale), kBinCount-1);
+				return b <= bestSplit;
+			});
+			mid = (uint32_t)(midIt - prims.begin());
+		}
+		
+		// 分割に失敗した時は数で半分にする.
+		if(mid==begin || mid==end)
 		{
-			m_left = m_right = list[0];
+			bestAxis = SI::Max(bestAxis, 0);
+			mid = begin + count/2;
+			std::nth_element(prims.begin() + begin, prims.begin() + mid, prims.begin() + end, [&](const BuildPrimitive& a, const BuildPrimitive& b)
+			{
+				return a.m_center[bestAxis].AsFloat() < b.m_center[bestAxis].AsFloat();
+			});
 		}
-		else if(listCount==2)
+
+		BuildRecursive(prims, begin, mid, depth + 1);
+		uint32_t rightIndex = BuildRecursive(prims, mid, end, depth + 1);
+
+		BvhFlatNode& node = m_nodes[nodeIndex];
+		node.m_offset = rightIndex;
+		node.m_axis   = (uint16_t)bestAxis;
+		return nodeIndex;
+	}
+
+private:
+	std::vector<BvhFlatNode> m_nodes;
+	std::vector<uint32_t>    m_primitiveIndices;
+};
+
+// WideBvhで使うSIMD命令の差分を吸収する. 4分岐はSSE、8分岐はAVXを使う.
+// 8分岐は/arch:AVXでビルドした時だけ定義して、AVXの無いCPUで不正命令にならないようにする.
+template<uint32_t kWidth>
+struct WideBvhSimd;
+
+template<>
+struct WideBvhSimd<4>
+{
+	using Vec = __m128;
+	static Vec  Set1 (float f)                  { return _mm_set1_ps(f); }
+	static Vec  Load (const float* p)           { return _mm_load_ps(p); }
+	static void Store(float* p, Vec a)          { _mm_store_ps(p, a); }
+	static Vec  Sub  (Vec a, Vec b)             { return _mm_sub_ps(a, b); }
+	static Vec  Mul  (Vec a, Vec b)             { return _mm_mul_ps(a, b); }
+	static Vec  Min  (Vec a, Vec b)             { return _mm_min_ps(a, b); }
+	static Vec  Max  (Vec a, Vec b)             { return _mm_max_ps(a, b); }
+	static uint32_t LessEqualMask(Vec a, Vec b) { return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(a, b)); }
+};
+
+#if defined(__AVX__)
+template<>
+struct WideBvhSimd<8>
+{
+	using Vec = __m256;
+	static Vec  Set1 (float f)                  { return _mm256_set1_ps(f); }
+	static Vec  Load (const float* p)           { return _mm256_load_ps(p); }
+	static void Store(float* p, Vec a)          { _mm256_store_ps(p, a); }
+	static Vec  Sub  (Vec a, Vec b)             { return _mm256_sub_ps(a, b); }
+	static Vec  Mul  (Vec a, Vec b)             { return _mm256_mul_ps(a, b); }
+	static Vec  Min  (Vec a, Vec b)             { return _mm256_min_ps(a, b); }
+	static Vec  Max  (Vec a, Vec b)             { return _mm256_max_ps(a, b); }
+	static uint32_t LessEqualMask(Vec a, Vec b) { return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+};
+#endif
+
+// kWidth個の子のAABBをSoAで持つノード.
+template<uint32_t kWidth>
+struct alignas(32) WideBvhNode
+{
+	float    m_bounds[6][kWidth]; // minX, minY, minZ, maxX, maxY, maxZ の順.
+	uint32_t m_child[kWidth];     // 節: 子ノードのindex. 葉: プリミティブのoffset.
+	uint16_t m_count[kWidth];     // 葉のプリミティブ数. 節なら0.
+	uint32_t m_childCount;
+};
+
+// 二分木のBvhを畳み込んで作る、4分岐(QBVH)/8分岐(OBVH)のBVH.
+// 1本のレイを全ての子のAABBと一度にslabテストする.
+template<uint32_t kWidth>
+class WideBvh
+{
+public:
+	using Simd = WideBvhSimd<kWidth>;
+	using Vec  = typename Simd::Vec;
+	using Node = WideBvhNode<kWidth>;
+
+	static const uint32_t kStackSize = 64 * kWidth;
+
+public:
+	WideBvh()
+	{
+	}
+
+	~WideBvh()
+	{
+	}
+
+	void Build(const std::vector<Aabb>& aabbs)
+	{
+		m_nodes.clear();
+		m_primitiveIndices.clear();
+
+		Bvh binaryBvh;
+		binaryBvh.Build(aabbs);
+
+		const std::vector<BvhFlatNode>& binaryNodes = binaryBvh.GetNodes();
+		if(binaryNodes.empty()) return;
+
+		m_primitiveIndices = binaryBvh.GetPrimitiveIndices();
+		m_nodes.reserve(binaryNodes.size() / (kWidth-1) + 1);
+
+		if(binaryNodes[0].IsLeaf())
 		{
-			m_left = list[0];
-			m_right = list[1];
+			uint32_t root = 0;
+			Collapse(binaryNodes, &root, 1);
 		}
 		else
 		{
-			m_left  = new BvhNode();
-			m_right = new BvhNode();
-			m_owner = true;
-			
-			int leftCount = listCount/2;
-			((BvhNode*)m_left)->BuildBvh (list,             leftCount,             t0, t1, axis+1);
-			((BvhNode*)m_right)->BuildBvh(list + leftCount, listCount - leftCount, t0, t1, axis+1);
+			uint32_t children[2] = { 1, binaryNodes[0].m_offset };
+			Collapse(binaryNodes, children, 2);
+		}
+	}
+
+	template<typename HitPrimitiveFunc>
+	bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord, const HitPrimitiveFunc& hitPrimitive) const
+	{
+		if(m_nodes.empty()) return false;
+
+		PackedFloat3 pos    = ray.Pos().GetPackedFloat3();
+		PackedFloat3 invDir = (Vfloat3::One() / ray.Dir()).GetPackedFloat3();
+
+		// レイの向きで手前側の面を決めておけば、min/maxの入れ替えが要らない.
+		Vec rayPos[3];
+		Vec rayInvDir[3];
+		uint32_t nearPlane[3];
+		uint32_t farPlane[3];
+		for(uint32_t a=0; a<3; ++a)
+		{
+			rayPos[a]    = Simd::Set1(pos.m_v[a]);
+			rayInvDir[a] = Simd::Set1(invDir.m_v[a]);
+			nearPlane[a] = (invDir.m_v[a] < 0.0f)? a+3 : a;
+			farPlane[a]  = (invDir.m_v[a] < 0.0f)? a   : a+3;
+		}
+
+		struct StackEntry
+		{
+			uint32_t m_nodeIndex;
+			float    m_tNear;
+		};
+		StackEntry stack[kStackSize];
+		uint32_t stackCount = 0;
+		stack[stackCount++] = { 0, minT };
+
+		bool hitAnything = false;
+		float closestT = maxT;
+
+		while(0 < stackCount)
+		{
+			const StackEntry entry = stack[--stackCount];
+			if(closestT < entry.m_tNear) continue;
+
+			const Node& node = m_nodes[entry.m_nodeIndex];
+
+			// NaNは第2引数が返るので、累積値を第2引数にしてNaNを無視する.
+			Vec tNear = Simd::Set1(minT);
+			Vec tFar  = Simd::Set1(closestT);
+			for(uint32_t a=0; a<3; ++a)
+			{
+				Vec tn = Simd::Mul(Simd::Sub(Simd::Load(node.m_bounds[nearPlane[a]]), rayPos[a]), rayInvDir[a]);
+				Vec tf = Simd::Mul(Simd::Sub(Simd::Load(node.m_bounds[farPlane[a]]),  rayPos[a]), rayInvDir[a]);
+				tNear = Simd::Max(tn, tNear);
+				tFar  = Simd::Min(tf, tFar);
+			}
+
+			uint32_t hitMask = Simd::LessEqualMask(tNear, tFar) & ((1u << node.m_childCount) - 1u);
+			if(hitMask==0) continue;
+
+			alignas(32) float tNearArray[kWidth];
+			Simd::Store(tNearArray, tNear);
+
+			// 当たった子を近い順に並べる.
+			uint32_t order[kWidth];
+			uint32_t orderCount = 0;
+			while(hitMask)
+			{
+				uint32_t c = (uint32_t)Bitwise::LSB32(hitMask);
+				hitMask &= hitMask - 1;
+
+				uint32_t j = orderCount++;
+				while(0<j && tNearArray[c] < tNearArray[order[j-1]])
+				{
+					order[j] = order[j-1];
+					--j;
+				}
+				order[j] = c;
+			}
+
+			// 葉はその場で交差判定してclosestTを縮め、節は遠い順に積んで近い方から取り出す.
+			for(uint32_t i=0; i<orderCount; ++i)
+			{
+				uint32_t c = order[i];
+				if(node.m_count[c]==0 || closestT < tNearArray[c]) continue;
+
+				const uint32_t* prims = &m_primitiveIndices[node.m_child[c]];
+				for(uint32_t p=0; p<node.m_count[c]; ++p)
+				{
+					if(hitPrimitive(prims[p], ray, minT, closestT, outRecord))
+					{
+						closestT = outRecord.t;
+						hitAnything = true;
+					}
+				}
+			}
+
+			for(uint32_t i=orderCount; 0<i; --i)
+			{
+				uint32_t c = order[i-1];
+				if(node.m_count[c]!=0 || closestT < tNearArray[c]) continue;
+
+				SI_ASSERT(stackCount < kStackSize);
+				stack[stackCount++] = { node.m_child[c], tNearArray[c] };
+			}
+		}
+
+		return hitAnything;
+	}
+
+	// 影のレイ用. occluded(primitiveIndex, ray, minT, maxT)が最初にtrueを返したところで打ち切る.
+	// 最も近い交点は要らないので、子を並べ替えずに葉から判定する.
+	template<typename OccludedFunc>
+	bool HitAny(const Ray& ray, float minT, float maxT, const OccludedFunc& occluded) const
+	{
+		if(m_nodes.empty()) return false;
+
+		PackedFloat3 pos    = ray.Pos().GetPackedFloat3();
+		PackedFloat3 invDir = (Vfloat3::One() / ray.Dir()).GetPackedFloat3();
+
+		Vec rayPos[3];
+		Vec rayInvDir[3];
+		uint32_t nearPlane[3];
+		uint32_t farPlane[3];
+		for(uint32_t a=0; a<3; ++a)
+		{
+			rayPos[a]    = Simd::Set1(pos.m_v[a]);
+			rayInvDir[a] = Simd::Set1(invDir.m_v[a]);
+			nearPlane[a] = (invDir.m_v[a] < 0.0f)? a+3 : a;
+			farPlane[a]  = (invDir.m_v[a] < 0.0f)? a   : a+3;
+		}
+
+		uint32_t stack[kStackSize];
+		uint32_t stackCount = 0;
+		stack[stackCount++] = 0;
+
+		while(0 < stackCount)
+		{
+			const Node& node = m_nodes[stack[--stackCount]];
+
+			Vec tNear = Simd::Set1(minT);
+			Vec tFar  = Simd::Set1(maxT);
+			for(uint32_t a=0; a<3; ++a)
+			{
+				Vec tn = Simd::Mul(Simd::Sub(Simd::Load(node.m_bounds[nearPlane[a]]), rayPos[a]), rayInvDir[a]);
+				Vec tf = Simd::Mul(Simd::Sub(Simd::Load(node.m_bounds[farPlane[a]]),  rayPos[a]), rayInvDir[a]);
+				tNear = Simd::Max(tn, tNear);
+				tFar  = Simd::Min(tf, tFar);
+			}
+
+			uint32_t hitMask = Simd::LessEqualMask(tNear, tFar) & ((1u << node.m_childCount) - 1u);
+			while(hitMask)
+			{
+				uint32_t c = (uint32_t)Bitwise::LSB32(hitMask);
+				hitMask &= hitMask - 1;
+
+				if(node.m_count[c]==0)
+				{
+					SI_ASSERT(stackCount < kStackSize);
+					stack[stackCount++] = node.m_child[c];
+					continue;
+				}
+
+				const uint32_t* prims = &m_primitiveIndices[node.m_child[c]];
+				for(uint32_t p=0; p<node.m_count[c]; ++p)
+				{
+					if(occluded(prims[p], ray, minT, maxT)) return true;
+				}
+			}
 		}
-		
-		Aabb leftAabb;
-		Aabb rightAabb;
-		bool ret0 = m_left->BoundingBox(t0, t1, leftAabb);
-		bool ret1 = m_right->BoundingBox(t0, t1, rightAabb);
-		SI_ASSERT(ret0 && ret1);
 
-		m_aabb = CombineAabb(leftAabb, rightAabb);
+		return false;
 	}
-	
-	bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const override
+
+	size_t GetNodeCount() const{ return m_nodes.size(); }
+
+private:
+	static float SurfaceArea(const BvhFlatNode& node)
 	{
-		if(!m_aabb.Hit(ray, minT, maxT)) return false;
-		
-		HitRecord leftRecord;
-		HitRecord rightRecord;
-		
-		bool hitLeft  = m_left? m_left->Hit(ray, minT, maxT, leftRecord) : false;
-		bool hitRight = m_right? m_right->Hit(ray, minT, maxT, rightRecord) : false;
+		float dx = node.m_max[0] - node.m_min[0];
+		float dy = node.m_max[1] - node.m_min[1];
+		float dz = node.m_max[2] - node.m_min[2];
+		return 2.0f * (dx*dy + dy*dz + dz*dx);
+	}
 
-		if(hitLeft && hitRight)
+	// 二分木の節を表面積の大きい順に開いて、最大kWidth個の子にまとめる.
+	uint32_t Collapse(const std::vector<BvhFlatNode>& binaryNodes, const uint32_t* firstChildren, uint32_t firstChildCount)
+	{
+		uint32_t children[kWidth];
+		uint32_t childCount = firstChildCount;
+		for(uint32_t i=0; i<firstChildCount; ++i)
 		{
-			outRecord = (leftRecord.t < rightRecord.t)? leftRecord : rightRecord;
-			return true;
+			children[i] = firstChildren[i];
 		}
-		else if(hitLeft)
+
+		while(childCount < kWidth)
 		{
-			outRecord = leftRecord;
-			return true;
+			int   openIndex = -1;
+			float openArea  = -1.0f;
+			for(uint32_t i=0; i<childCount; ++i)
+			{
+				const BvhFlatNode& child = binaryNodes[children[i]];
+				if(child.IsLeaf()) continue;
+
+				float area = SurfaceArea(child);
+				if(openArea < area)
+				{
+					openArea  = area;
+					openIndex = (int)i;
+				}
+			}
+			if(openIndex < 0) break;
+
+			uint32_t opened = children[openIndex];
+			children[openIndex]    = opened + 1;
+			children[childCount++] = binaryNodes[opened].m_offset;
 		}
-		else if(hitRight)
+
+		uint32_t nodeIndex = (uint32_t)m_nodes.size();
+		m_nodes.emplace_back();
 		{
-			outRecord = rightRecord;
-			return true;
+			Node& node = m_nodes.back();
+			memset(&node, 0, sizeof(node));
+			node.m_childCount = childCount;
 		}
 
-		return false;
-	}
+		for(uint32_t i=0; i<childCount; ++i)
+		{
+			const BvhFlatNode& child = binaryNodes[children[i]];
 
-	bool BoundingBox(float t0, float t1, Aabb& outAabb) const
-	{
-		outAabb = m_aabb;
-		return true;
+			uint32_t childIndex = 0;
+			if(child.IsLeaf())
+			{
+				childIndex = child.m_offset;
+			}
+			else
+			{
+				uint32_t grandChildren[2] = { children[i] + 1, child.m_offset };
+				childIndex = Collapse(binaryNodes, grandChildren, 2);
+			}
+
+			// 再帰でm_nodesが再確保されるので、ここで取り直す.
+			Node& node = m_nodes[nodeIndex];
+			for(uint32_t a=0; a<3; ++a)
+			{
+				node.m_bounds[a  ][i] = child.m_min[a];
+				node.m_bounds[a+3][i] = child.m_max[a];
+			}
+			node.m_child[i] = childIndex;
+			node.m_count[i] = child.m_count;
+		}
+
+		return nodeIndex;
 	}
 
 private:
-	const Hitable* m_left;
-	const Hitable* m_right;
-	Aabb m_aabb;
-	bool m_owner;
+	std::vector<Node>     m_nodes;
+	std::vector<uint32_t> m_primitiveIndices;
+};
+
+// シーンの走査に使うBVHの分岐数. 2ならBvh、4ならSSE、8ならAVXのWideBvhを使う.
+static const uint32_t kBvhWidth = 4;
+
+template<uint32_t kWidth>
+struct BvhSelector
+{
+	using Type = WideBvh<kWidth>;
+};
+
+template<>
+struct BvhSelector<2>
+{
+	using Type = Bvh;
 };
 
+using SceneBvh = BvhSelector<kBvhWidth>::Type;
+
+// nullptrを除いたHitableと、そのAABBを同じ並びで集める. BVHのプリミティブindexはこの並びを指す.
+inline void CollectHitableAabbs(
+	const std::vector<const Hitable*>& hitables,
+	float t0,
+	float t1,
+	std::vector<const Hitable*>& outHitables,
+	std::vector<Aabb>& outAabbs)
+{
+	outHitables.clear();
+	outAabbs.clear();
+	for(const Hitable* h : hitables)
+	{
+		if(h==nullptr) continue;
+
+		Aabb aabb;
+		bool ret = h->BoundingBox(t0, t1, aabb);
+		SI_ASSERT(ret);
+		outHitables.push_back(h);
+		outAabbs.push_back(aabb);
+	}
+}
+
 class HitableList : public Hitable
 {
 public:
@@ -1313,8 +2942,11 @@ public:
 	{
 		SI_ASSERT(m_bvh==nullptr);
 
-		m_bvh = new BvhNode();
-		m_bvh->BuildBvh(&m_hitables[0], (int)m_hitables.size(), t0, t1);
+		std::vector<Aabb> aabbs;
+		CollectHitableAabbs(m_hitables, t0, t1, m_bvhHitables, aabbs);
+
+		m_bvh = new SceneBvh();
+		m_bvh->Build(aabbs);
 
 		return true;
 	}
@@ -1323,7 +2955,10 @@ public:
 	{
 		if(m_bvh)
 		{
-			return m_bvh->Hit(ray, minT, maxT, outRecord);
+			return m_bvh->Hit(ray, minT, maxT, outRecord, [this](uint32_t index, const Ray& r, float t0, float t1, HitRecord& rec)
+			{
+				return m_bvhHitables[index]->Hit(r, t0, t1, rec);
+			});
 		}
 
 		bool hitAnything = false;
@@ -1345,6 +2980,17 @@ public:
 		return hitAnything;
 	}
 
+	const std::vector<const Hitable*>& GetHitables() const{ return m_hitables; }
+
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		for(const Hitable* h : m_hitables)
+		{
+			if(h==nullptr) continue;
+			h->Flatten(storage, context);
+		}
+	}
+
 	bool BoundingBox(float t0, float t1, Aabb& outAabb) const
 	{
 		if(m_hitables.empty()) return false;
@@ -1364,7 +3010,57 @@ public:
 
 protected:
 	std::vector<const Hitable*> m_hitables;
-	BvhNode *m_bvh;
+	std::vector<const Hitable*> m_bvhHitables; // m_bvhのプリミティブindexが指すHitable.
+	SceneBvh *m_bvh;
+};
+
+// HitableListを展開したプリミティブと、それを走査するBVH. 描画はこちらで行う.
+class PrimitiveScene : public PrimitiveStorage
+{
+public:
+	PrimitiveScene()
+	{
+	}
+
+	~PrimitiveScene()
+	{
+	}
+
+	void Build(const HitableList& world, float t0, float t1)
+	{
+		Clear();
+		SetTimeRange(t0, t1);
+		world.Flatten(*this, PrimitiveContext());
+		BuildLights();
+		m_bvh.Build(GetPrimitiveAabbs());
+	}
+
+	// 影のレイ用. 交点の情報は要らないので、(minT, maxT)で最初に見つけた交点で打ち切る.
+	bool Occluded(const Ray& ray, float minT, float maxT) const
+	{
+		return m_bvh.HitAny(ray, minT, maxT, [this](uint32_t index, const Ray& r, float t0, float t1)
+		{
+			return OccludedPrimitive(index, r, t0, t1);
+		});
+	}
+
+	bool Hit(const Ray& ray, float minT, float maxT, HitRecord& outRecord) const
+	{
+		bool hit = m_bvh.Hit(ray, minT, maxT, outRecord, [this](uint32_t index, const Ray& r, float t0, float t1, HitRecord& rec)
+		{
+			return HitPrimitive(index, r, t0, t1, rec);
+		});
+		if(hit)
+		{
+			FinalizeHit(outRecord);
+		}
+		return hit;
+	}
+
+	const SceneBvh& GetBvh() const{ return m_bvh; }
+
+private:
+	SceneBvh m_bvh;
 };
 
 class SceneBase : public HitableList
@@ -1441,6 +3137,12 @@ public:
 		return true;
 	}
 
+	// 6枚のRectではなく、1つの箱として登録する.
+	virtual void Flatten(PrimitiveStorage& storage, const PrimitiveContext& context) const override
+	{
+		storage.AddBox(m_p0, m_p1, m_material, context);
+	}
+
 private:
 	Vfloat3 m_p0;
 	Vfloat3 m_p1;
@@ -1642,7 +3344,7 @@ public:
 class ManySpheres : public SceneBase
 {
 public:
-	ManySpheres(float time0, float time1)
+	ManySpheres(float time0 = 0.0f, float time1 = 1.0f)
 	{
 		float timeDif = time1 - time0;
 		m_textures.push_back( new ConstantTexture(Vfloat3(0.2f, 0.3f, 0.1f)) );
@@ -1744,94 +3446,553 @@ public:
 		vertical = 2.0f * halfHeight * focusDist * v;
 	}
 
-	Ray CalcRay(float s, float t)
+	Ray CalcRay(float s, float t)
+	{
+		Vfloat3 rd = lensRadius * RandomInUnitDisk();
+		Vfloat3 offset = u * rd.X() + v * rd.Y();
+		float time = time0 + FloatUnitRand() * (time1 - time0);
+		return Ray(origin + offset, lowerLeftCorner + s*horizontal + t*vertical - (origin + offset), time);
+	}
+
+private:
+	Vfloat3 origin;
+	Vfloat3 lowerLeftCorner;
+	Vfloat3 horizontal;
+	Vfloat3 vertical;
+	Vfloat3 u,v,w;
+	float time0;
+	float time1;
+	float lensRadius;
+};
+
+bool CheckIfRayHitsSphere(const Ray& ray, const Sphere& sphere, float& outT)
+{
+	Vfloat3 cp = ray.Pos() - sphere.Center();
+	
+	float dotDirDir = Math::Dot(ray.Dir(), ray.Dir());
+	float dotDirCp  = Math::Dot(ray.Dir(), cp);
+	float dotCpCp   = Math::Dot(cp, cp);
+	
+	float a = dotDirDir;
+	float b = 2.0f*dotDirCp;
+	float c = dotCpCp - sphere.Radius()*sphere.Radius();
+
+	float discriminant = b*b - 4*a*c;
+	if(discriminant < 0.0f)
+	{
+		outT = -1.0f;
+		return false;
+	}
+
+	outT = (-b - sqrt(discriminant)) / (2.0f * a);
+	return true;
+}
+
+// スループット計測用. スレッド毎に数えて最後に合算する.
+thread_local uint64_t t_rayCount = 0;
+
+Vfloat3 MissColor(const Ray& r)
+{
+#if 1
+	return Vfloat3(0.0f);
+#else
+	Vfloat3 unitDir = (r.Dir()).Normalize();
+
+	float t = 0.5f*unitDir.Y() + 0.5f;
+	return Lerp(Vfloat3(1.0f), Vfloat3(0.5f, 0.7f, 1.0f), t);
+#endif
+}
+
+// 1なら、拡散面と媒質で光源を直接サンプリングする(Next Event Estimation).
+#define NEXT_EVENT_ESTIMATION 1
+
+static const int kMaxBounce             = 64;
+static const int kRussianRouletteBounce = 3; // この回数以降は、スループットに応じて確率的にパスを打ち切る.
+
+// 光源を1つ選んでその上の点への寄与を返す. attenuationは交点で散乱した時の減衰.
+Vfloat3 SampleDirectLight(const PrimitiveScene& scene, const Ray& ray, const HitRecord& record, const MaterialEntry& material, const Vfloat3& attenuation)
+{
+	uint32_t lightCount = scene.GetLightCount();
+	uint32_t lightIndex = SI::Min((uint32_t)(FloatUnitRand() * (float)lightCount), lightCount - 1);
+	float u, v;
+	FloatUnitRand2(u, v);
+
+	LightSample light;
+	scene.SampleLight(lightIndex, ray.Time(), u, v, light);
+
+	Vfloat3 toLight = light.m_position - record.position;
+	float distanceSq = Math::Dot(toLight, toLight);
+	if(distanceSq <= 0.0f) return Vfloat3(0.0f);
+
+	float distance = sqrtf(distanceSq);
+	Vfloat3 dir = toLight / distance;
+
+	// BRDF(位相関数)とcosの積. Lambertはalbedo/π、等方散乱は1/4π.
+	float scattering = 0.0f;
+	if(material.m_type == MaterialType::Lambert)
+	{
+		float cosSurface = Math::Dot(record.normal, dir);
+		if(cosSurface <= 0.0f) return Vfloat3(0.0f);
+		scattering = cosSurface / SI::kPi;
+	}
+	else
+	{
+		scattering = 1.0f / (4.0f * SI::kPi);
+	}
+
+	// DiffuseLightは両面が光る.
+	float cosLight = fabsf(Math::Dot(light.m_normal, dir).AsFloat());
+	if(cosLight <= 0.0f) return Vfloat3(0.0f);
+
+	++t_rayCount;
+	if(scene.Occluded(Ray(record.position, dir, ray.Time()), 0.001f, distance * 0.999f)) return Vfloat3(0.0f);
+
+	// 面積に対するpdfは1/(光源数*面積).
+	float weight = scattering * cosLight * (float)lightCount * light.m_area / distanceSq;
+	return attenuation * light.m_emitted * weight;
+}
+
+// パスの1頂点を処理する. 放射を足して、パスを続けるならoutRayとスループットを更新してtrueを返す.
+// countEmissionは直前の頂点で光源サンプリングをしていない時にtrueで、二重に数えないようにする.
+bool ShadeVertex(const PrimitiveScene& scene, const Ray& ray, const HitRecord& record, int bounce, Vfloat3& inoutThroughput, bool& inoutCountEmission, Vfloat3& inoutRadiance, Ray& outRay)
+{
+	if(inoutCountEmission || !scene.IsSampledLight(record))
+	{
+		inoutRadiance += inoutThroughput * scene.Emitted(record);
+	}
+
+	Vfloat3 attenuation;
+	if(kMaxBounce <= bounce || !scene.Scatter(ray, record, attenuation, outRay)) return false;
+
+#if NEXT_EVENT_ESTIMATION
+	const MaterialEntry& material = scene.GetMaterial(record);
+	bool sampleLight =
+		0 < scene.GetLightCount() &&
+		(material.m_type == MaterialType::Lambert || material.m_type == MaterialType::Isotropic);
+	if(sampleLight)
+	{
+		inoutRadiance += inoutThroughput * SampleDirectLight(scene, ray, record, material, attenuation);
+	}
+	inoutCountEmission = !sampleLight;
+#endif
+
+	inoutThroughput *= attenuation;
+
+	if(kRussianRouletteBounce <= bounce)
+	{
+		float survival = SI::Min(Math::HorizontalMax(inoutThroughput).AsFloat(), 0.95f);
+		if(survival <= FloatUnitRand()) return false;
+
+		inoutThroughput /= survival;
+	}
+
+	return true;
+}
+
+// 再帰せずに、スループットを持ち回ってパスを追跡する.
+Vfloat3 RayToColor(const Ray& primaryRay, const PrimitiveScene& scene)
+{
+	Vfloat3 radiance(0.0f);
+	Vfloat3 throughput = Vfloat3::One();
+	bool countEmission = true;
+
+	Ray ray = primaryRay;
+	for(int bounce=0; ; ++bounce)
+	{
+		++t_rayCount;
+
+		HitRecord record;
+		if(!scene.Hit(ray, 0.001f, FLT_MAX, record))
+		{
+			radiance += throughput * MissColor(ray);
+			break;
+		}
+
+		Ray scatteredRay;
+		if(!ShadeVertex(scene, ray, record, bounce, throughput, countEmission, radiance, scatteredRay)) break;
+
+		ray = scatteredRay;
+	}
+
+	return radiance;
+}
+
+// 一次レイをパケットで、二次以降をストリームでまとめて追跡するモード.
+// 1ならパケット/ストリーム、0なら1本ずつRayToColorで追跡する.
+#define PACKET_TRACING 1
+
+// 1なら、スレッド数を変えてレイトレースの時間を計測してから本番を描画する.
+#define JOB_SCALING_BENCHMARK 0
+// パケットのレーン数. 8はAVXを使うので、/arch:AVXでビルドした時だけ選ぶ.
+#if defined(__AVX__)
+static const uint32_t kPacketSize = 8;
+#else
+static const uint32_t kPacketSize = 4;
+#endif
+
+// 同じ画素から出るコヒーレントなレイをSoAで持つ.
+template<uint32_t kSize>
+struct alignas(32) RayPacket
+{
+	void Setup(const Ray* rays, uint32_t count)
+	{
+		SI_ASSERT(0 < count && count <= kSize);
+		m_rays  = rays;
+		m_count = count;
+
+		for(uint32_t i=0; i<kSize; ++i)
+		{
+			// 余ったレーンは先頭のレイで埋めて、マスクで無視する.
+			const Ray& ray = rays[(i < count)? i : 0];
+			PackedFloat3 pos    = ray.Pos().GetPackedFloat3();
+			PackedFloat3 invDir = (Vfloat3::One() / ray.Dir()).GetPackedFloat3();
+			for(uint32_t a=0; a<3; ++a)
+			{
+				m_pos[a][i]    = pos.m_v[a];
+				m_invDir[a][i] = invDir.m_v[a];
+			}
+			m_tMax[i] = FLT_MAX;
+		}
+	}
+
+	float      m_pos[3][kSize];
+	float      m_invDir[3][kSize];
+	float      m_tMax[kSize];
+	const Ray* m_rays;
+	uint32_t   m_count;
+};
+
+// パケット内の全レイを1つのノードのAABBと一度にslabテストしながらBvhを辿る.
+// 当たったレーンのビットマスクを返す.
+template<uint32_t kSize>
+uint32_t IntersectPacket(const Bvh& bvh, const PrimitiveScene& scene, RayPacket<kSize>& packet, float minT, HitRecord* outRecords)
+{
+	using Simd = WideBvhSimd<kSize>;
+	using Vec  = typename Simd::Vec;
+
+	const std::vector<BvhFlatNode>& nodes = bvh.GetNodes();
+	const std::vector<uint32_t>& primitives = bvh.GetPrimitiveIndices();
+	if(nodes.empty()) return 0;
+
+	Vec rayPos[3];
+	Vec rayInvDir[3];
+	for(uint32_t a=0; a<3; ++a)
+	{
+		rayPos[a]    = Simd::Load(packet.m_pos[a]);
+		rayInvDir[a] = Simd::Load(packet.m_invDir[a]);
+	}
+	Vec minTv = Simd::Set1(minT);
+
+	// コヒーレントなので、子を辿る順番は先頭のレイの向きで決める.
+	bool dirIsNeg[3] =
+	{
+		packet.m_invDir[0][0] < 0.0f,
+		packet.m_invDir[1][0] < 0.0f,
+		packet.m_invDir[2][0] < 0.0f,
+	};
+
+	const uint32_t activeMask = (1u << packet.m_count) - 1u;
+	uint32_t hitMask = 0;
+
+	uint32_t stack[Bvh::kStackSize];
+	uint32_t stackCount = 0;
+	uint32_t nodeIndex  = 0;
+
+	while(true)
+	{
+		const BvhFlatNode& node = nodes[nodeIndex];
+
+		Vec tNear = minTv;
+		Vec tFar  = Simd::Load(packet.m_tMax);
+		for(uint32_t a=0; a<3; ++a)
+		{
+			Vec t0 = Simd::Mul(Simd::Sub(Simd::Set1(node.m_min[a]), rayPos[a]), rayInvDir[a]);
+			Vec t1 = Simd::Mul(Simd::Sub(Simd::Set1(node.m_max[a]), rayPos[a]), rayInvDir[a]);
+			tNear = Simd::Max(Simd::Min(t0, t1), tNear);
+			tFar  = Simd::Min(Simd::Max(t0, t1), tFar);
+		}
+
+		uint32_t nodeMask = Simd::LessEqualMask(tNear, tFar) & activeMask;
+		if(nodeMask!=0 && !node.IsLeaf())
+		{
+			SI_ASSERT(stackCount < Bvh::kStackSize);
+			if(dirIsNeg[node.m_axis])
+			{
+				stack[stackCount++] = nodeIndex + 1;
+				nodeIndex = node.m_offset;
+			}
+			else
+			{
+				stack[stackCount++] = node.m_offset;
+				nodeIndex = nodeIndex + 1;
+			}
+			continue;
+		}
+
+		// 葉は当たったレーンだけ1本ずつ交差判定する.
+		while(nodeMask)
+		{
+			uint32_t lane = (uint32_t)Bitwise::LSB32(nodeMask);
+			nodeMask &= nodeMask - 1;
+
+			const uint32_t* prims = &primitives[node.m_offset];
+			for(uint32_t p=0; p<node.m_count; ++p)
+			{
+				if(scene.HitPrimitive(prims[p], packet.m_rays[lane], minT, packet.m_tMax[lane], outRecords[lane]))
+				{
+					packet.m_tMax[lane] = outRecords[lane].t;
+					hitMask |= 1u << lane;
+				}
+			}
+		}
+
+		if(stackCount==0) break;
+		nodeIndex = stack[--stackCount];
+	}
+
+	for(uint32_t mask=hitMask; mask; mask&=mask-1)
+	{
+		scene.FinalizeHit(outRecords[Bitwise::LSB32(mask)]);
+	}
+
+	return hitMask;
+}
+
+// ストリームで追跡中のパス.
+struct PathState
+{
+	Ray     m_ray;
+	Vfloat3 m_throughput;
+	bool    m_countEmission;
+	Sampling::SobolSampler m_sampler;
+};
+
+// 交点の放射を足して、散乱したら次のストリームに積む.
+inline void ShadePathVertex(const PrimitiveScene& scene, const Ray& ray, const HitRecord& record, const Vfloat3& throughput, bool countEmission, Sampling::SobolSampler& sampler, int bounce, Vfloat3& inoutRadiance, std::vector<PathState>& outNextPaths)
+{
+	SamplerScope samplerScope(sampler);
+
+	PathState next;
+	next.m_throughput    = throughput;
+	next.m_countEmission = countEmission;
+	if(ShadeVertex(scene, ray, record, bounce, next.m_throughput, next.m_countEmission, inoutRadiance, next.m_ray))
+	{
+		next.m_sampler = sampler;
+		outNextPaths.push_back(next);
+	}
+}
+
+// レイの向きの符号(8象限)でバケットソートした順番を作る.
+inline void SortPathsByOctant(const std::vector<PathState>& paths, std::vector<uint32_t>& outOrder)
+{
+	uint32_t bucketOffset[9] = {};
+	thread_local std::vector<uint8_t> octants;
+	octants.resize(paths.size());
+
+	for(size_t i=0; i<paths.size(); ++i)
+	{
+		const Vfloat3 dir = paths[i].m_ray.Dir();
+		uint8_t octant = (uint8_t)(
+			((dir.Xf() < 0.0f)? 1 : 0) |
+			((dir.Yf() < 0.0f)? 2 : 0) |
+			((dir.Zf() < 0.0f)? 4 : 0));
+		octants[i] = octant;
+		++bucketOffset[octant+1];
+	}
+
+	for(uint32_t b=1; b<9; ++b)
 	{
-		Vfloat3 rd = lensRadius * RandomInUnitDisk();
-		Vfloat3 offset = u * rd.X() + v * rd.Y();
-		float time = time0 + FloatUnitRand() * (time1 - time0);
-		return Ray(origin + offset, lowerLeftCorner + s*horizontal + t*vertical - (origin + offset), time);
+		bucketOffset[b] += bucketOffset[b-1];
 	}
 
-private:
-	Vfloat3 origin;
-	Vfloat3 lowerLeftCorner;
-	Vfloat3 horizontal;
-	Vfloat3 vertical;
-	Vfloat3 u,v,w;
-	float time0;
-	float time1;
-	float lensRadius;
-};
+	outOrder.resize(paths.size());
+	for(size_t i=0; i<paths.size(); ++i)
+	{
+		outOrder[bucketOffset[octants[i]]++] = (uint32_t)i;
+	}
+}
 
-bool CheckIfRayHitsSphere(const Ray& ray, const Sphere& sphere, float& outT)
+// 一次レイはkSize本ずつパケットで、二次以降は象限でソートしたストリームで追跡して
+// 全サンプルの放射の合計を返す. primarySamplersは一次レイを作った時点の各サンプルのサンプラ.
+template<uint32_t kSize>
+Vfloat3 TraceRayStream(const std::vector<Ray>& primaryRays, std::vector<Sampling::SobolSampler>& primarySamplers, const PrimitiveScene& scene, const Bvh& packetBvh)
 {
-	Vfloat3 cp = ray.Pos() - sphere.Center();
-	
-	float dotDirDir = Math::Dot(ray.Dir(), ray.Dir());
-	float dotDirCp  = Math::Dot(ray.Dir(), cp);
-	float dotCpCp   = Math::Dot(cp, cp);
+	thread_local std::vector<PathState> paths;
+	thread_local std::vector<PathState> nextPaths;
+	thread_local std::vector<uint32_t>  order;
 	
-	float a = dotDirDir;
-	float b = 2.0f*dotDirCp;
-	float c = dotCpCp - sphere.Radius()*sphere.Radius();
+	Vfloat3 radiance(0.0f);
+	paths.clear();
 
-	float discriminant = b*b - 4*a*c;
-	if(discriminant < 0.0f)
+	for(size_t i=0; i<primaryRays.size(); i+=kSize)
 	{
-		outT = -1.0f;
-		return false;
+		uint32_t count = (uint32_t)SI::Min(primaryRays.size() - i, (size_t)kSize);
+		t_rayCount += count;
+
+		RayPacket<kSize> packet;
+		packet.Setup(&primaryRays[i], count);
+
+		HitRecord records[kSize];
+		uint32_t hitMask = IntersectPacket(packetBvh, scene, packet, 0.001f, records);
+		for(uint32_t lane=0; lane<count; ++lane)
+		{
+			const Ray& ray = primaryRays[i + lane];
+			if(hitMask & (1u << lane))
+			{
+				ShadePathVertex(scene, ray, records[lane], Vfloat3::One(), true, primarySamplers[i + lane], 0, radiance, paths);
+			}
+			else
+			{
+				radiance += MissColor(ray);
+			}
+		}
 	}
 
-	outT = (-b - sqrt(discriminant)) / (2.0f * a);
-	return true;
+	for(int bounce=1; !paths.empty(); ++bounce)
+	{
+		SortPathsByOctant(paths, order);
+		nextPaths.clear();
+		t_rayCount += paths.size();
+
+		for(uint32_t index : order)
+		{
+			PathState& path = paths[index];
+			HitRecord record;
+			if(scene.Hit(path.m_ray, 0.001f, FLT_MAX, record))
+			{
+				ShadePathVertex(scene, path.m_ray, record, path.m_throughput, path.m_countEmission, path.m_sampler, bounce, radiance, nextPaths);
+			}
+			else
+			{
+				radiance += path.m_throughput * MissColor(path.m_ray);
+			}
+		}
+
+		std::swap(paths, nextPaths);
+	}
+
+	return radiance;
 }
 
-Vfloat3 RayToColor(const Ray& r, const Hitable& world, int bounce = 0)
+namespace
 {
-	HitRecord record;
-	if(world.Hit(r, 0.001f, FLT_MAX, record))
+	template<typename BvhType, typename HitPrimitiveFunc>
+	void MeasureBvh(const char* name, const std::vector<Aabb>& aabbs, const HitPrimitiveFunc& hitPrimitive, const std::vector<Ray>& rays)
 	{
-		Ray scatteredRay;
-		Vfloat3 attenuation;
-		Vfloat3 emissive = record.material->Emitted(record.u, record.v, record.position);
-		if( bounce < 64 && record.material->Scatter(r, record, attenuation, scatteredRay) )
-		{
-			return emissive + attenuation * RayToColor(scatteredRay, world, bounce+1);
-		}
-		else
+		BvhType bvh;
+		auto buildStart = std::chrono::system_clock::now();
+		bvh.Build(aabbs);
+		int buildUs = (int)std::chrono::duration_cast<std::chrono::microseconds>((std::chrono::system_clock::now() - buildStart)).count();
+
+		uint32_t hitCount = 0;
+		HitRecord record;
+		auto traceStart = std::chrono::system_clock::now();
+		for(const Ray& ray : rays)
 		{
-			return emissive;
+			if(bvh.Hit(ray, 0.001f, FLT_MAX, record, hitPrimitive)) ++hitCount;
 		}
+		int traceUs = (int)std::chrono::duration_cast<std::chrono::microseconds>((std::chrono::system_clock::now() - traceStart)).count();
+
+		SI_PRINT("  %-10s nodes=%6d build=%6dus trace=%8dus (%.2fMrays/s) hit=%d\n",
+			name,
+			(int)bvh.GetNodeCount(),
+			buildUs,
+			traceUs,
+			(double)rays.size() / (double)SI::Max(traceUs, 1),
+			(int)hitCount);
 	}
-	else
+
+	// 一次レイと、その交点からランダムな方向に飛ばす二次レイで比べる.
+	void BenchmarkScene(const char* sceneName, const HitableList& world, Camera& camera, uint32_t width, uint32_t height, float t0, float t1)
 	{
-#if 1
-		return Vfloat3(0.0f);
-#else
-		Vfloat3 unitDir = (r.Dir()).Normalize();
+		std::vector<Ray> rays;
+		rays.reserve(2 * width * height);
+
+		PrimitiveScene scene;
+		scene.Build(world, t0, t1);
+
+		HitRecord record;
+		for(uint32_t y=0; y<height; ++y)
+		{
+			for(uint32_t x=0; x<width; ++x)
+			{
+				float u = ((float)x + FloatUnitRand()) / (float)width;
+				float v = ((float)y + FloatUnitRand()) / (float)height;
+				Ray ray = camera.CalcRay(u, v);
+				rays.push_back(ray);
+
+				if(scene.Hit(ray, 0.001f, FLT_MAX, record))
+				{
+					rays.push_back(Ray(record.position, Math::Normalize(RandomInUnitSphere()), ray.Time()));
+				}
+			}
+		}
+
+		// Hitableの仮想関数で判定する場合と、展開したプリミティブで判定する場合.
+		std::vector<const Hitable*> hitables;
+		std::vector<Aabb> hitableAabbs;
+		CollectHitableAabbs(world.GetHitables(), t0, t1, hitables, hitableAabbs);
+		auto hitHitable = [&hitables](uint32_t index, const Ray& r, float minT, float maxT, HitRecord& rec)
+		{
+			return hitables[index]->Hit(r, minT, maxT, rec);
+		};
+		auto hitPrimitive = [&scene](uint32_t index, const Ray& r, float minT, float maxT, HitRecord& rec)
+		{
+			return scene.HitPrimitive(index, r, minT, maxT, rec);
+		};
 
-		float t = 0.5f*unitDir.Y() + 0.5f;
-		return Lerp(Vfloat3(1.0f), Vfloat3(0.5f, 0.7f, 1.0f), t);
+		SI_PRINT("%s rays=%d hitables=%d primitives=%d\n", sceneName, (int)rays.size(), (int)hitables.size(), (int)scene.GetPrimitiveCount());
+		MeasureBvh<Bvh>        ("Binary",    hitableAabbs, hitHitable, rays);
+		MeasureBvh<WideBvh<4>> ("Wide4/SSE", hitableAabbs, hitHitable, rays);
+#if defined(__AVX__)
+		MeasureBvh<WideBvh<8>> ("Wide8/AVX", hitableAabbs, hitHitable, rays);
+#endif
+		MeasureBvh<Bvh>        ("Flat2",     scene.GetPrimitiveAabbs(), hitPrimitive, rays);
+		MeasureBvh<WideBvh<4>> ("Flat4/SSE", scene.GetPrimitiveAabbs(), hitPrimitive, rays);
+#if defined(__AVX__)
+		MeasureBvh<WideBvh<8>> ("Flat8/AVX", scene.GetPrimitiveAabbs(), hitPrimitive, rays);
 #endif
 	}
 }
 
-std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height)
+void RunBvhBenchmark(uint32_t width, uint32_t height)
 {
-	auto start = std::chrono::system_clock::now();
-	SI_SCOPE_EXIT( SI_PRINT("GenerateRaytracingTextureData=%dms\n", (int)std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() - start)).count()); );
-
-	const uint32_t pixelSize = 4;
-	const uint32_t rowPitch = width * pixelSize;
-	const uint32_t textureSize = rowPitch * height;
-
-	const uint32_t sampleUPerPixel = 16;
-	const uint32_t sampleVPerPixel = 16;
-	const uint32_t samplePerPixel = sampleUPerPixel * sampleVPerPixel;
+	float time0 = 0;
+	float time1 = 1;
+	float aspect = (float)width/(float)height;
+	
+	{
+		Vfloat3 cameraPos(278,278,-800);
+		Vfloat3 cameraTarget(278.0f, 278.0f, 0.0f);
+		Camera camera(cameraPos, cameraTarget, Vfloat3(0.0f, 1.0f ,0.0f), 40, aspect, 0.0f, (cameraTarget - cameraPos).Length(), time0, time1);
+		CornellBox world;
+		BenchmarkScene("CornellBox", world, camera, width, height, time0, time1);
+	}
+	
+	{
+		Vfloat3 cameraPos(478,278,-800);
+		Vfloat3 cameraTarget(278.0f, 278.0f, 0.0f);
+		Camera camera(cameraPos, cameraTarget, Vfloat3(0.0f, 1.0f ,0.0f), 30, aspect, 0.0f, (cameraTarget - cameraPos).Length(), time0, time1);
+		FinalScene world;
+		BenchmarkScene("FinalScene", world, camera, width, height, time0, time1);
+	}
+}
 
-	std::vector<float> data(textureSize);
-	float* pData = &data[0];
+// 描画するシーン.
+#if 0
+typedef ManySpheres RenderScene;
+#elif 0
+typedef TwoPerlinSphere RenderScene;
+#elif 0
+typedef SimpleLightScene RenderScene;
+#elif 0
+typedef CornellBox RenderScene;
+#else
+typedef FinalScene RenderScene;
+#endif
 
+Camera CreateRenderCamera(uint32_t width, uint32_t height, float time0, float time1)
+{
 #if 0
 	Vfloat3 cameraPos(4,2,4);
 	float vFov = 90;
@@ -1865,11 +4026,7 @@ std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height
 #endif
 	float apature = 0.05f;
 
-	float time0 = 0;
-	float time1 = 1;
-	float timeDif = time1 - time0;
-
-	Camera camera(
+	return Camera(
 		cameraPos,
 		cameraTarget,
 		Vfloat3(0.0f, 1.0f ,0.0f),  // vup
@@ -1879,19 +4036,42 @@ std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height
 		focusDist,
 		time0,
 		time1);
+}
 
-#if 0
-	ManySpheres world(time0, time1);
-#elif 0
-	TwoPerlinSphere world;
-#elif 0
-	SimpleLightScene world;
-#elif 0
-	CornellBox world;
-#else
-	FinalScene world;
+std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height)
+{
+	auto start = std::chrono::system_clock::now();
+	SI_SCOPE_EXIT( SI_PRINT("GenerateRaytracingTextureData=%dms\n", (int)std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() - start)).count()); );
+
+	const uint32_t pixelSize = 4;
+	const uint32_t rowPitch = width * pixelSize;
+	const uint32_t textureSize = rowPitch * height;
+
+	const uint32_t sampleUPerPixel = 16;
+	const uint32_t sampleVPerPixel = 16;
+	const uint32_t samplePerPixel = sampleUPerPixel * sampleVPerPixel;
+
+	std::vector<float> data(textureSize);
+	float* pData = &data[0];
+
+	float time0 = 0;
+	float time1 = 1;
+
+	Camera camera = CreateRenderCamera(width, height, time0, time1);
+
+	RenderScene world;
+	PrimitiveScene scene;
+	{
+		auto buildStart = std::chrono::system_clock::now();
+		scene.Build(world, time0, time1);
+		SI_PRINT("BuildBvh=%dms primitives=%d\n", (int)std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() - buildStart)).count(), (int)scene.GetPrimitiveCount());
+	}
+
+#if PACKET_TRACING
+	// パケット用の二分木. シーンのBVHとは別に持つ.
+	Bvh packetBvh;
+	packetBvh.Build(scene.GetPrimitiveAabbs());
 #endif
-	world.Build(time0, time1);
 
 	auto func = [&](uint32_t n)
 	{
@@ -1899,22 +4079,44 @@ std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height
 		uint32_t y = n / rowPitch;
 		Vfloat3 color(0.0f);
 		
-		for (uint32_t us = 0; us < sampleUPerPixel; ++us)
+#if PACKET_TRACING
+		thread_local std::vector<Ray> primaryRays;
+		thread_local std::vector<Sampling::SobolSampler> primarySamplers;
+		primaryRays.clear();
+		primarySamplers.resize(samplePerPixel);
+		for (uint32_t s = 0; s < samplePerPixel; ++s)
 		{
-			float u = (float)x / (float)rowPitch;
-			u += ((float)us + 0.5f) / (float)sampleUPerPixel / (float)width;
+			Sampling::SobolSampler& sampler = primarySamplers[s];
+			sampler.Start(n / pixelSize, s);
+			SamplerScope samplerScope(sampler);
 
-			for (uint32_t vs = 0; vs < sampleVPerPixel; ++vs)
-			{
-				float v = (float)y / (float)height;
-				v += ((float)vs + 0.5f) / (float)sampleVPerPixel / (float)height;
-		
-				Ray ray = camera.CalcRay(u, v);
-				Vfloat3 sampleColor = RayToColor(ray, world);
+			float su, sv;
+			FloatUnitRand2(su, sv);
+			float u = (float)x / (float)rowPitch + su / (float)width;
+			float v = (float)y / (float)height   + sv / (float)height;
 
-				color += sampleColor / (float)samplePerPixel;
-			}
+			primaryRays.push_back(camera.CalcRay(u, v));
+		}
+
+		color = TraceRayStream<kPacketSize>(primaryRays, primarySamplers, scene, packetBvh) / (float)samplePerPixel;
+#else
+		Sampling::SobolSampler sampler;
+		SamplerScope samplerScope(sampler);
+		for (uint32_t s = 0; s < samplePerPixel; ++s)
+		{
+			sampler.Start(n / pixelSize, s);
+
+			float su, sv;
+			FloatUnitRand2(su, sv);
+			float u = (float)x / (float)rowPitch + su / (float)width;
+			float v = (float)y / (float)height   + sv / (float)height;
+
+			Ray ray = camera.CalcRay(u, v);
+			Vfloat3 sampleColor = RayToColor(ray, scene);
+
+			color += sampleColor / (float)samplePerPixel;
 		}
+#endif
 
 		color = Math::Sqrt(color); // gamma
 
@@ -1924,45 +4126,336 @@ std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height
 		pData[n + 3] = 1.0f;	    // A
 	};
 
+	// 16x16ピクセルのタイルを1つのJobとして処理する.
+	const uint32_t tileSize = 16;
+	const uint32_t tileCountX = (width  + tileSize - 1) / tileSize;
+	const uint32_t tileCountY = (height + tileSize - 1) / tileSize;
+
+	auto render = [&](JobSystem& jobSystem, const char* label)
 	{
+		std::atomic<uint64_t> totalRayCount = 0;
 		auto start2 = std::chrono::system_clock::now();
-		SI_SCOPE_EXIT( SI_PRINT("RaytracingTime=%dms\n", (int)std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() - start2)).count()); );
+		SI_SCOPE_EXIT(
+			int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() - start2)).count();
+			double mrays = (double)totalRayCount / (double)SI::Max(ms, 1) / 1000.0;
+			SI_PRINT("%s=%dms (%.2fMrays/s, %dthreads)\n", label, ms, mrays, (int)jobSystem.GetThreadCount()); );
 
-#if 1
-		std::atomic<int> pix = 0;
-		auto funcEntry = [&]()
+		jobSystem.ParallelFor(tileCountX * tileCountY, 1, [&](uint32_t begin, uint32_t end)
 		{
-			for (int pp = pix.fetch_add((int)pixelSize); pp < (int)textureSize; pp = pix.fetch_add((int)pixelSize))
+			uint64_t rayCountStart = t_rayCount;
+			for(uint32_t tile=begin; tile<end; ++tile)
 			{
-				func(pp);
+				uint32_t x0 = (tile % tileCountX) * tileSize;
+				uint32_t y0 = (tile / tileCountX) * tileSize;
+				uint32_t x1 = SI::Min(x0 + tileSize, width);
+				uint32_t y1 = SI::Min(y0 + tileSize, height);
+
+				for(uint32_t py=y0; py<y1; ++py)
+				{
+					for(uint32_t px=x0; px<x1; ++px)
+					{
+						func(py * rowPitch + px * pixelSize);
+					}
+				}
 			}
-		};
-		std::vector<std::thread> threads;
-		// スレッド立てて
-		for(int i=0; i<7; ++i)
+			totalRayCount += t_rayCount - rayCountStart;
+		});
+	};
+
+#if JOB_SCALING_BENCHMARK
+	// 1スレッドから全コアまで倍々にしてスケーリングを計測する.
+	{
+		uint32_t maxThreadCount = SI::Max(std::thread::hardware_concurrency(), 1u);
+		for(uint32_t threadCount=1; ; threadCount = SI::Min(threadCount * 2, maxThreadCount))
+		{
+			JobSystem jobSystem;
+			jobSystem.Initialize(threadCount);
+			render(jobSystem, "ScalingTime");
+			jobSystem.Terminate();
+
+			if(threadCount == maxThreadCount) break;
+		}
+	}
+#endif
+
+	{
+		JobSystem jobSystem;
+		jobSystem.Initialize();
+		render(jobSystem, "RaytracingTime");
+		jobSystem.Terminate();
+	}
+
+	return std::move(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	const float    kProgressiveTime0 = 0.0f;
+	const float    kProgressiveTime1 = 1.0f;
+
+	// 分散を推定するために最低限必要なパス数.
+	const uint32_t kMinPassPerPixel = 16;
+	// これ以上はサンプルしない.
+	const uint32_t kMaxSamplePerPixel = 16 * 16 * 4;
+	// 平均値の標準誤差が輝度のこの割合以下になったら収束したとみなす.
+	const float    kRelativeErrorThreshold = 0.05f;
+	// 暗いピクセルで閾値が小さくなりすぎないようにするための下限.
+	const float    kMinLuminance = 0.05f;
+
+	inline float Luminance(const Vfloat3& c)
+	{
+		return 0.2126f * c.X() + 0.7152f * c.Y() + 0.0722f * c.Z();
+	}
+}
+
+struct ProgressiveRaytracer::Impl
+{
+	Impl(uint32_t width, uint32_t height)
+		: m_width(width)
+		, m_height(height)
+		, m_camera(CreateRenderCamera(width, height, kProgressiveTime0, kProgressiveTime1))
+		, m_passCount(0)
+		, m_hasFinishedPass(false)
+	{
+	}
+
+	uint32_t              m_width;
+	uint32_t              m_height;
+	Camera                m_camera;
+	RenderScene           m_world;
+	PrimitiveScene        m_scene;
+#if PACKET_TRACING
+	Bvh                   m_packetBvh;
+#endif
+	JobSystem             m_jobSystem;
+
+	std::vector<Vfloat3>  m_radianceSum;    // 線形空間での放射輝度の合計.
+	std::vector<uint32_t> m_sampleCount;
+	// パスごとの平均輝度をバッチ平均として扱い、その1次と2次のモーメントを貯める.
+	std::vector<double>   m_passLuminanceSum;
+	std::vector<double>   m_passLuminanceSqSum;
+	std::vector<uint32_t> m_pixelPassCount;
+	std::vector<uint32_t> m_activePixels;   // 未収束のピクセル番号.
+	std::vector<float>    m_textureData;
+	uint32_t              m_passCount;
+	std::chrono::system_clock::time_point m_startTime;
+
+	JobCounter            m_passCounter;     // 実行中のパスのJob.
+	bool                  m_hasFinishedPass; // 終わったパスをまだTakeFinishedPassで受け取っていない.
+};
+
+ProgressiveRaytracer::ProgressiveRaytracer()
+	: m_impl(nullptr)
+{
+}
+
+ProgressiveRaytracer::~ProgressiveRaytracer()
+{
+	Terminate();
+}
+
+void ProgressiveRaytracer::Initialize(uint32_t width, uint32_t height)
+{
+	Terminate();
+
+	m_impl = new Impl(width, height);
+	m_impl->m_startTime = std::chrono::system_clock::now();
+	m_impl->m_scene.Build(m_impl->m_world, kProgressiveTime0, kProgressiveTime1);
+#if PACKET_TRACING
+	m_impl->m_packetBvh.Build(m_impl->m_scene.GetPrimitiveAabbs());
+#endif
+	m_impl->m_jobSystem.Initialize();
+
+	const uint32_t pixelCount = width * height;
+	m_impl->m_radianceSum.resize(pixelCount, Vfloat3(0.0f));
+	m_impl->m_sampleCount.resize(pixelCount, 0);
+	m_impl->m_passLuminanceSum.resize(pixelCount, 0.0);
+	m_impl->m_passLuminanceSqSum.resize(pixelCount, 0.0);
+	m_impl->m_pixelPassCount.resize(pixelCount, 0);
+	m_impl->m_textureData.resize(pixelCount * 4, 0.0f);
+
+	m_impl->m_activePixels.resize(pixelCount);
+	for(uint32_t i=0; i<pixelCount; ++i)
+	{
+		m_impl->m_activePixels[i] = i;
+	}
+}
+
+void ProgressiveRaytracer::Terminate()
+{
+	if(m_impl)
+	{
+		m_impl->m_jobSystem.Wait(m_impl->m_passCounter);
+		m_impl->m_jobSystem.Terminate();
+		delete m_impl;
+		m_impl = nullptr;
+	}
+}
+
+bool ProgressiveRaytracer::RenderPass(uint32_t samplePerPass)
+{
+	SI_ASSERT(m_impl);
+	StartPass(samplePerPass);
+	m_impl->m_jobSystem.Wait(m_impl->m_passCounter);
+	m_impl->m_hasFinishedPass = false;
+	return !m_impl->m_activePixels.empty();
+}
+
+bool ProgressiveRaytracer::StartPass(uint32_t samplePerPass)
+{
+	SI_ASSERT(m_impl);
+	Impl& impl = *m_impl;
+	if(!impl.m_passCounter.IsDone() || impl.m_activePixels.empty()) return false;
+
+	// パス自体もJobにして、呼び出しスレッド(描画)を止めないようにする.
+	impl.m_jobSystem.Run([this, samplePerPass]()
+	{
+		ExecutePass(samplePerPass);
+	}, &impl.m_passCounter);
+	impl.m_hasFinishedPass = true;
+	return true;
+}
+
+bool ProgressiveRaytracer::IsPassRunning() const
+{
+	return m_impl? !m_impl->m_passCounter.IsDone() : false;
+}
+
+bool ProgressiveRaytracer::TakeFinishedPass()
+{
+	if(!m_impl || !m_impl->m_hasFinishedPass || !m_impl->m_passCounter.IsDone()) return false;
+
+	m_impl->m_hasFinishedPass = false;
+	return true;
+}
+
+bool ProgressiveRaytracer::ExecutePass(uint32_t samplePerPass)
+{
+	Impl& impl = *m_impl;
+	if(impl.m_activePixels.empty()) return false;
+
+	samplePerPass = SI::Max(samplePerPass, 1u);
+	const uint32_t width  = impl.m_width;
+	const uint32_t height = impl.m_height;
+
+	// 未収束のピクセルは走査順に並んでいるので、連続した塊ごとにJobにする.
+	impl.m_jobSystem.ParallelFor((uint32_t)impl.m_activePixels.size(), 256, [&](uint32_t begin, uint32_t end)
+	{
+		thread_local std::vector<Ray> primaryRays;
+		thread_local std::vector<Sampling::SobolSampler> primarySamplers;
+
+		for(uint32_t i=begin; i<end; ++i)
 		{
-			threads.emplace_back(funcEntry);
+			uint32_t pixel = impl.m_activePixels[i];
+			uint32_t x = pixel % width;
+			uint32_t y = pixel / width;
+
+			// 前のパスの続きのサンプル番号から始めて、Sobol列を先へ進める.
+			primaryRays.clear();
+			primarySamplers.resize(samplePerPass);
+			for(uint32_t s=0; s<samplePerPass; ++s)
+			{
+				Sampling::SobolSampler& sampler = primarySamplers[s];
+				sampler.Start(pixel, impl.m_sampleCount[pixel] + s);
+				SamplerScope samplerScope(sampler);
+
+				float su, sv;
+				FloatUnitRand2(su, sv);
+				float u = ((float)x + su) / (float)width;
+				float v = ((float)y + sv) / (float)height;
+				primaryRays.push_back(impl.m_camera.CalcRay(u, v));
+			}
+
+#if PACKET_TRACING
+			Vfloat3 passRadiance = TraceRayStream<kPacketSize>(primaryRays, primarySamplers, impl.m_scene, impl.m_packetBvh);
+#else
+			Vfloat3 passRadiance(0.0f);
+			for(uint32_t s=0; s<samplePerPass; ++s)
+			{
+				SamplerScope samplerScope(primarySamplers[s]);
+				passRadiance += RayToColor(primaryRays[s], impl.m_scene);
+			}
+#endif
+
+			double passLuminance = (double)Luminance(passRadiance / (float)samplePerPass);
+			impl.m_radianceSum[pixel]        += passRadiance;
+			impl.m_sampleCount[pixel]        += samplePerPass;
+			impl.m_passLuminanceSum[pixel]   += passLuminance;
+			impl.m_passLuminanceSqSum[pixel] += passLuminance * passLuminance;
+			++impl.m_pixelPassCount[pixel];
+
+			Vfloat3 color = Math::Sqrt(impl.m_radianceSum[pixel] / (float)impl.m_sampleCount[pixel]); // gamma
+			float* pData = &impl.m_textureData[pixel * 4];
+			pData[0] = color.X(); // R
+			pData[1] = color.Y(); // G
+			pData[2] = color.Z(); // B
+			pData[3] = 1.0f;      // A
 		}
+	});
 
-		// 一緒に仕事する.
-		funcEntry();
+	++impl.m_passCount;
 
-		// 待つ
-		for(auto& t : threads)
+	// 平均値の標準誤差が十分小さくなったピクセルを外す.
+	size_t activeCount = 0;
+	for(uint32_t pixel : impl.m_activePixels)
+	{
+		uint32_t n = impl.m_pixelPassCount[pixel];
+		bool converged = (kMaxSamplePerPixel <= impl.m_sampleCount[pixel]);
+		if(!converged && kMinPassPerPixel <= n)
 		{
-			t.join();
+			double mean     = impl.m_passLuminanceSum[pixel] / (double)n;
+			double variance = SI::Max(impl.m_passLuminanceSqSum[pixel] / (double)n - mean * mean, 0.0) * (double)n / (double)(n - 1);
+			double error    = sqrt(variance / (double)n);
+			// 全てのパスが0だったピクセルは、背景が黒いなどで本当に黒いとみなして収束扱いにする.
+			converged = (mean <= 0.0) || (error <= kRelativeErrorThreshold * SI::Max(mean, (double)kMinLuminance));
 		}
-		threads.clear();
-#else
-		//#pragma omp parallel for
-		for (int32_t pix = 0; pix < (int)textureSize; pix += pixelSize)
+
+		if(!converged)
 		{
-			func(pix);
+			impl.m_activePixels[activeCount++] = pixel;
 		}
-#endif
 	}
+	impl.m_activePixels.resize(activeCount);
 
-	return std::move(data);
+	if(impl.m_activePixels.empty())
+	{
+		uint64_t totalSample = 0;
+		for(uint32_t count : impl.m_sampleCount)
+		{
+			totalSample += count;
+		}
+
+		SI_PRINT("ProgressiveRaytracing=%dms (%u passes, %.1f samples/pixel)\n",
+			(int)std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() - impl.m_startTime)).count(),
+			impl.m_passCount,
+			(double)totalSample / (double)impl.m_sampleCount.size());
+		return false;
+	}
+
+	return true;
+}
+
+const std::vector<float>& ProgressiveRaytracer::GetTextureData() const
+{
+	SI_ASSERT(m_impl);
+	return m_impl->m_textureData;
+}
+
+uint32_t ProgressiveRaytracer::GetPassCount() const
+{
+	return m_impl? m_impl->m_passCount : 0;
+}
+
+uint32_t ProgressiveRaytracer::GetActivePixelCount() const
+{
+	return m_impl? (uint32_t)m_impl->m_activePixels.size() : 0;
+}
+
+bool ProgressiveRaytracer::IsConverged() const
+{
+	return m_impl? m_impl->m_activePixels.empty() : false;
 }
 
 } // namespace RayTracingTheNextWeek
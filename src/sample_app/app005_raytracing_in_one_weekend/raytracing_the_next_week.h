@@ -8,6 +8,49 @@ namespace SI
 namespace RayTracingTheNextWeek
 {
 	std::vector<float> GenerateRaytracingTextureData(uint32_t width, uint32_t height);
+
+	// BVHの分岐数(2/4/8)ごとに構築と走査の時間を計測して出力する.
+	void RunBvhBenchmark(uint32_t width, uint32_t height);
+
+	// 1パスごとにサンプルを積み上げて、途中経過をすぐに見られるようにするレイトレーサ.
+	// 分散が十分小さくなったピクセルはそれ以上サンプルしない(適応サンプリング).
+	class ProgressiveRaytracer
+	{
+	public:
+		ProgressiveRaytracer();
+		~ProgressiveRaytracer();
+
+		void Initialize(uint32_t width, uint32_t height);
+		void Terminate();
+
+		// 未収束のピクセルにsamplePerPass個ずつサンプルを足して、現在の推定値を更新する.
+		// 終わるまで待つ. まだ未収束のピクセルが残っていればtrueを返す.
+		bool RenderPass(uint32_t samplePerPass);
+
+		// RenderPassと同じ処理をJobSystemで始めて、すぐに戻る. 実行中か収束済みならfalseを返す.
+		bool StartPass(uint32_t samplePerPass);
+		bool IsPassRunning() const;
+
+		// StartPassしたパスが終わっていれば、1回だけtrueを返す. trueの時に結果を転送する.
+		bool TakeFinishedPass();
+
+		// 以下はパスの実行中に呼ばないこと.
+
+		// ガンマ補正済みのRGBA(float4)の現在の推定値.
+		const std::vector<float>& GetTextureData() const;
+
+		uint32_t GetPassCount() const;
+		uint32_t GetActivePixelCount() const;
+		bool     IsConverged() const;
+
+	private:
+		// RenderPassの本体. StartPassからはJobとして呼ばれる.
+		bool ExecutePass(uint32_t samplePerPass);
+
+	private:
+		struct Impl;
+		Impl* m_impl;
+	};
 	
 } // namespace RayTracingTheNextWeek
 } // namespace SI
\ No newline at end of file
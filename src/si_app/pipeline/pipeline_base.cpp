@@ -24,6 +24,7 @@ namespace SI
 	
 	PipelineBase::PipelineBase(int observerSortKey)
 		: AppModule(observerSortKey)
+		, m_graphicsContextCount(3)
 	{
 	}
 
@@ -34,6 +35,8 @@ namespace SI
 	
 	int PipelineBase::OnInitialize(const AppInitializeInfo& info)
 	{
+		m_frameAllocator.Initialize();
+
 		GfxDeviceConfig deviceConfig;
 		deviceConfig.m_width = info.m_width;
 		deviceConfig.m_height = info.m_height;
@@ -43,13 +46,19 @@ namespace SI
 			return -1;
 		}
 
+		// PSOは実行ファイルの横にキャッシュして、次回起動時の作成を省く.
+		char graphicsStateCachePath[260];
+		sprintf_s(graphicsStateCachePath, "%sgraphics_state_cache.bin", SI_PATH_STORAGE().GetExeDirPath());
+
 		GfxCoreDesc coreDesc;
+		coreDesc.m_graphicsStateCachePath = graphicsStateCachePath;
 		m_core.Initialize(coreDesc);
 
 		m_commandQueue = m_device.CreateCommandQueue();
 		m_swapChain = m_device.CreateSwapChain(deviceConfig, m_commandQueue);
 
 		GfxContextManagerDesc contextManagerDesc;
+		contextManagerDesc.m_contextCount = m_graphicsContextCount;
 		m_contextManager.Initialize(contextManagerDesc);
 		//m_graphicsCommandList = m_device.CreateGraphicsCommandList();
 
@@ -74,6 +83,8 @@ namespace SI
 
 		//m_device.Terminate();
 
+		m_frameAllocator.Terminate();
+
 		return 0;
 	}
 	
@@ -90,6 +101,9 @@ namespace SI
 	
 	void PipelineBase::BeginRender()
 	{
+		// 前のフレームのジョブは終わっているので、ここで一時メモリを切り替える.
+		m_frameAllocator.Flip();
+
 		m_contextManager.ResetContexts();
 
 		GfxGraphicsContext& context = m_contextManager.GetGraphicsContext(0);
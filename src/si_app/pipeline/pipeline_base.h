@@ -3,6 +3,7 @@
 #include <cstdint>
 #include "si_app/app/app_module.h"
 #include "si_base/gpu/gfx.h"
+#include "si_base/memory/frame_allocator.h"
 #include "si_base/renderer/renderer.h"
 
 namespace SI
@@ -31,12 +32,14 @@ namespace SI
 		void EndRender();
 
 	protected:
+		FrameAllocator           m_frameAllocator;
 		GfxDevice                m_device;
 		GfxCore                  m_core;
 		GfxCommandQueue          m_commandQueue;
 		GfxSwapChain             m_swapChain;
 		GfxContextManager        m_contextManager;
 		Renderer                 m_renderer;
+		uint32_t                 m_graphicsContextCount; // OnInitialize前に変更すること.
 		
 	};
 
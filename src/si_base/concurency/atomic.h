@@ -46,21 +46,28 @@ namespace SI
 		T operator--()                { return m_value.operator--(); }
 
 		// 後置
-		T operator++(T dummy) volatile{ return m_value.operator++(dummy); }
-		T operator++(T dummy)         { return m_value.operator++(dummy); }
-		T operator--(T dummy) volatile{ return m_value.operator--(dummy); }
-		T operator--(T dummy)         { return m_value.operator--(dummy); }
+		T operator++(int dummy) volatile{ return m_value.operator++(dummy); }
+		T operator++(int dummy)         { return m_value.operator++(dummy); }
+		T operator--(int dummy) volatile{ return m_value.operator--(dummy); }
+		T operator--(int dummy)         { return m_value.operator--(dummy); }
 
 		operator T()             const{ return m_value; }
 
+		T    Load(std::memory_order order = std::memory_order_seq_cst) const{ return m_value.load(order); }
+		void Store(T value, std::memory_order order = std::memory_order_seq_cst){ m_value.store(value, order); }
+		T    Exchange(T value){ return m_value.exchange(value); }
+
+		// 失敗したらexpectedに今の値が入る. ループで使う前提なのでweak.
+		bool CompareExchange(T& expected, T desired){ return m_value.compare_exchange_weak(expected, desired); }
+
 	private:
 		std::atomic<T> m_value;
 	};
 	
-	//using AtomicUint32 = Atomic<uint32_t>;
+	using AtomicUint32 = Atomic<uint32_t>;
 	using AtomicInt32  = Atomic<int32_t>;
-	//using AtomicUint64 = Atomic<uint32_t>;
-	using AtomicInt64  = Atomic<int32_t>;
+	using AtomicUint64 = Atomic<uint64_t>;
+	using AtomicInt64  = Atomic<int64_t>;
 
 } // namespace SI
 
@@ -0,0 +1,213 @@
+﻿
+#include "si_base/concurency/job_system.h"
+
+#include "si_base/core/core.h"
+
+namespace SI
+{
+	namespace
+	{
+		// ワーカースレッドが、どのJobSystemの何番目のdequeを使うか.
+		thread_local const JobSystem* t_ownerJobSystem = nullptr;
+		thread_local uint32_t         t_queueIndex     = 0;
+	}
+
+	JobSystem::JobSystem()
+		: m_pendingJobCount(0)
+		, m_exit(false)
+	{
+	}
+
+	JobSystem::~JobSystem()
+	{
+		Terminate();
+	}
+
+	void JobSystem::Initialize(uint32_t threadCount)
+	{
+		SI_ASSERT(m_queues.empty());
+
+		if(threadCount == 0)
+		{
+			threadCount = SI::Max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		m_exit = false;
+		m_pendingJobCount = 0;
+
+		m_queues.resize(threadCount);
+		for(uint32_t i=0; i<threadCount; ++i)
+		{
+			m_queues[i] = SI_NEW(JobQueue);
+		}
+
+		m_workers.reserve(threadCount - 1);
+		for(uint32_t i=1; i<threadCount; ++i)
+		{
+			m_workers.emplace_back([this, i](){ WorkerMain(i); });
+		}
+	}
+
+	void JobSystem::Terminate()
+	{
+		if(m_queues.empty()) return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_exit = true;
+		}
+		m_wakeCondition.notify_all();
+
+		for(std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+		m_workers.clear();
+
+		for(JobQueue* queue : m_queues)
+		{
+			SI_ASSERT(queue->m_jobs.empty(), "未実行のJobが残っている.");
+			SI_DELETE(queue);
+		}
+		m_queues.clear();
+	}
+
+	void JobSystem::Run(const JobFunc& func, JobCounter* counter)
+	{
+		SI_ASSERT(!m_queues.empty());
+
+		if(counter)
+		{
+			++counter->m_count;
+		}
+
+		JobQueue& queue = *m_queues[GetCurrentQueueIndex()];
+		{
+			MutexLocker locker(queue.m_mutex);
+			queue.m_jobs.push_back(Job{func, counter});
+		}
+
+		++m_pendingJobCount;
+		{
+			// 寝る直前のワーカーが起床を取りこぼさないように、一度ロックを通しておく.
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+		}
+		m_wakeCondition.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		uint32_t queueIndex = GetCurrentQueueIndex();
+		while(!counter.IsDone())
+		{
+			if(!TryExecuteJob(queueIndex))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::WaitUntil(const std::function<bool(void)>& isDone)
+	{
+		uint32_t queueIndex = GetCurrentQueueIndex();
+		while(!isDone())
+		{
+			if(!TryExecuteJob(queueIndex))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const ParallelForFunc& func)
+	{
+		if(count == 0) return;
+		grainSize = SI::Max(grainSize, 1u);
+
+		JobCounter counter;
+		for(uint32_t begin=0; begin<count; begin+=grainSize)
+		{
+			uint32_t end = SI::Min(begin + grainSize, count);
+			Run([&func, begin, end](){ func(begin, end); }, &counter);
+		}
+
+		Wait(counter);
+	}
+
+	void JobSystem::WorkerMain(uint32_t queueIndex)
+	{
+		t_ownerJobSystem = this;
+		t_queueIndex     = queueIndex;
+
+		while(true)
+		{
+			if(TryExecuteJob(queueIndex)) continue;
+
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_wakeCondition.wait(lock, [this](){ return m_exit || 0 < (int32_t)m_pendingJobCount; });
+			if(m_exit) break;
+		}
+
+		t_ownerJobSystem = nullptr;
+		t_queueIndex     = 0;
+	}
+
+	bool JobSystem::TryExecuteJob(uint32_t queueIndex)
+	{
+		Job job;
+		if(!PopJob(queueIndex, job) && !StealJob(queueIndex, job))
+		{
+			return false;
+		}
+
+		job.m_func();
+
+		if(job.m_counter)
+		{
+			--job.m_counter->m_count;
+		}
+		return true;
+	}
+
+	bool JobSystem::PopJob(uint32_t queueIndex, Job& outJob)
+	{
+		JobQueue& queue = *m_queues[queueIndex];
+		MutexLocker locker(queue.m_mutex);
+		if(queue.m_jobs.empty()) return false;
+
+		outJob = std::move(queue.m_jobs.back());
+		queue.m_jobs.pop_back();
+		--m_pendingJobCount;
+		return true;
+	}
+
+	bool JobSystem::StealJob(uint32_t thiefIndex, Job& outJob)
+	{
+		uint32_t queueCount = (uint32_t)m_queues.size();
+		for(uint32_t i=1; i<queueCount; ++i)
+		{
+			JobQueue& queue = *m_queues[(thiefIndex + i) % queueCount];
+			if(!queue.m_mutex.TryLock()) continue; // 取り合っている所は避ける.
+
+			bool stolen = false;
+			if(!queue.m_jobs.empty())
+			{
+				outJob = std::move(queue.m_jobs.front());
+				queue.m_jobs.pop_front();
+				--m_pendingJobCount;
+				stolen = true;
+			}
+			queue.m_mutex.Unlock();
+
+			if(stolen) return true;
+		}
+
+		return false;
+	}
+
+	uint32_t JobSystem::GetCurrentQueueIndex() const
+	{
+		return (t_ownerJobSystem == this)? t_queueIndex : 0;
+	}
+
+} // namespace SI
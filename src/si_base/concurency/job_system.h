@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include "si_base/core/non_copyable.h"
+#include "si_base/concurency/atomic.h"
+#include "si_base/concurency/mutex.h"
+
+namespace SI
+{
+	// Jobの完了待ち用のカウンタ.
+	// Runで積んだ時に増えて、Jobが終わった時に減る.
+	class JobCounter : private NonCopyable
+	{
+	public:
+		JobCounter()
+			: m_count(0)
+		{
+		}
+
+		bool IsDone() const{ return (int32_t)m_count == 0; }
+
+	private:
+		friend class JobSystem;
+		AtomicInt32 m_count;
+	};
+
+	// スレッド毎にJobのdequeを持ち、自分のdequeが空になったら他のスレッドから盗むJobシステム.
+	// 自分のdequeは後ろから取り出し(LIFO)、盗む時は前から取り出す(FIFO).
+	class JobSystem : private NonCopyable
+	{
+	public:
+		using JobFunc         = std::function<void(void)>;
+		using ParallelForFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+	public:
+		JobSystem();
+		~JobSystem();
+
+		// threadCountは呼び出しスレッドも含めたスレッド数. 0ならhardware_concurrencyに合わせる.
+		void Initialize(uint32_t threadCount = 0);
+		void Terminate();
+
+		void Run(const JobFunc& func, JobCounter* counter = nullptr);
+
+		// 完了するまで、呼び出しスレッドもJobを処理する.
+		void Wait(JobCounter& counter);
+
+		// isDoneがtrueを返すまで、呼び出しスレッドもJobを処理する.
+		// I/Oスレッドなど、JobSystemの外で進むものを待つ時に使う.
+		void WaitUntil(const std::function<bool(void)>& isDone);
+
+		// [0, count)をgrainSize毎のJobに分けて実行し、全て終わるまで待つ.
+		void ParallelFor(uint32_t count, uint32_t grainSize, const ParallelForFunc& func);
+
+		uint32_t GetThreadCount() const{ return (uint32_t)m_queues.size(); }
+
+	private:
+		struct Job
+		{
+			JobFunc     m_func;
+			JobCounter* m_counter;
+		};
+
+		// キャッシュラインを共有しないようにしておく.
+		struct alignas(64) JobQueue
+		{
+			Mutex           m_mutex;
+			std::deque<Job> m_jobs;
+		};
+
+	private:
+		void WorkerMain(uint32_t queueIndex);
+		bool TryExecuteJob(uint32_t queueIndex);
+		bool PopJob(uint32_t queueIndex, Job& outJob);
+		bool StealJob(uint32_t thiefIndex, Job& outJob);
+		uint32_t GetCurrentQueueIndex() const;
+
+	private:
+		std::vector<JobQueue*>    m_queues;  // [0]は呼び出しスレッド(とワーカー以外のスレッド)用.
+		std::vector<std::thread>  m_workers;
+		std::mutex                m_wakeMutex;
+		std::condition_variable   m_wakeCondition;
+		AtomicInt32               m_pendingJobCount;
+		bool                      m_exit;
+	};
+
+} // namespace SI
@@ -0,0 +1,548 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#include "si_base/core/assert.h"
+#include "si_base/core/new_delete.h"
+#include "si_base/core/non_copyable.h"
+#include "si_base/memory/allocator_base.h"
+#include "si_base/misc/hash.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// SwissTable方式のオープンアドレスのハッシュマップ.
+// 要素ごとに1byteの制御バイト(空き/削除済み/ハッシュの下位7bit)を持ち、
+// 16個分の制御バイトをSIMDでまとめて比較して、キーを比較する候補を絞る.
+
+namespace SI
+{
+	// 既定のハッシュ関数. misc/hash.hのハッシュを使う.
+	template<typename Key>
+	struct HashMapHasher
+	{
+		Hash64 operator()(const Key& key) const
+		{
+			return GetHash64(key);
+		}
+	};
+
+	template<>
+	struct HashMapHasher<std::string>
+	{
+		Hash64 operator()(const std::string& key) const
+		{
+			return InternalHash64(key.data(), key.size());
+		}
+	};
+
+	template<typename Key, typename Value>
+	struct HashMapItem
+	{
+		template<typename K, typename... Args>
+		HashMapItem(K&& key, Args&&... args)
+			: m_key(std::forward<K>(key))
+			, m_value(std::forward<Args>(args)...)
+		{
+		}
+
+		HashMapItem(const HashMapItem&) = default;
+		HashMapItem(HashMapItem&&)      = default;
+
+		Key   m_key;
+		Value m_value;
+	};
+
+	namespace HashMapInternal
+	{
+		using Ctrl = int8_t;
+
+		// 負の値は空きか削除済み. 0~127はハッシュの下位7bitで、使用中を表す.
+		static const Ctrl   kEmpty      = -128;
+		static const Ctrl   kDeleted    = -2;
+		static const size_t kGroupWidth = 16;
+
+		inline uint32_t CountTrailingZeros(uint32_t mask)
+		{
+			SI_ASSERT(mask != 0);
+#if defined(_MSC_VER)
+			unsigned long index = 0;
+			_BitScanForward(&index, mask);
+			return (uint32_t)index;
+#else
+			return (uint32_t)__builtin_ctz(mask);
+#endif
+		}
+
+		// 制御バイト16個分. Match系は該当する位置のbitが立ったマスクを返す.
+		struct Group
+		{
+#if SI_HASH_SIMD != SI_HASH_SIMD_SCALAR
+			explicit Group(const Ctrl* ctrl)
+				: m_ctrl(_mm_load_si128((const __m128i*)ctrl))
+			{
+			}
+
+			uint32_t Match(Ctrl h2) const
+			{
+				return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl));
+			}
+
+			uint32_t MatchEmpty() const
+			{
+				return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(kEmpty), m_ctrl));
+			}
+
+			uint32_t MatchEmptyOrDeleted() const
+			{
+				// 空きと削除済みだけ最上位bitが立っている.
+				return (uint32_t)_mm_movemask_epi8(m_ctrl);
+			}
+
+			__m128i m_ctrl;
+#else
+			explicit Group(const Ctrl* ctrl)
+				: m_ctrl(ctrl)
+			{
+			}
+
+			uint32_t Match(Ctrl h2) const
+			{
+				uint32_t mask = 0;
+				for(uint32_t i=0; i<kGroupWidth; ++i)
+				{
+					mask |= (uint32_t)(m_ctrl[i] == h2) << i;
+				}
+				return mask;
+			}
+
+			uint32_t MatchEmpty() const
+			{
+				return Match(kEmpty);
+			}
+
+			uint32_t MatchEmptyOrDeleted() const
+			{
+				uint32_t mask = 0;
+				for(uint32_t i=0; i<kGroupWidth; ++i)
+				{
+					mask |= (uint32_t)(m_ctrl[i] < 0) << i;
+				}
+				return mask;
+			}
+
+			const Ctrl* m_ctrl;
+#endif
+		};
+
+		// 空のマップが指す制御バイト. 確保しなくても検索できるように、全部空きにしてある.
+		// 翻訳単位ごとに別の実体になり得るので、アドレスの比較には使わないこと.
+		alignas(16) static const Ctrl kEmptyGroup[kGroupWidth] =
+		{
+			kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+			kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+		};
+	} // namespace HashMapInternal
+
+	template<typename Key, typename Value, typename Hasher = HashMapHasher<Key>>
+	class HashMap : private NonCopyable
+	{
+	public:
+		using Item = HashMapItem<Key, Value>;
+
+		template<typename ItemT>
+		class IteratorBase
+		{
+		public:
+			IteratorBase(const HashMapInternal::Ctrl* ctrl, const HashMapInternal::Ctrl* ctrlEnd, ItemT* item)
+				: m_ctrl(ctrl)
+				, m_ctrlEnd(ctrlEnd)
+				, m_item(item)
+			{
+				SkipUnused();
+			}
+
+			ItemT& operator*()  const{ return *m_item; }
+			ItemT* operator->() const{ return m_item; }
+
+			IteratorBase& operator++()
+			{
+				++m_ctrl;
+				++m_item;
+				SkipUnused();
+				return *this;
+			}
+
+			bool operator==(const IteratorBase& it) const{ return m_ctrl == it.m_ctrl; }
+			bool operator!=(const IteratorBase& it) const{ return m_ctrl != it.m_ctrl; }
+
+		private:
+			void SkipUnused()
+			{
+				while(m_ctrl != m_ctrlEnd && *m_ctrl < 0)
+				{
+					++m_ctrl;
+					++m_item;
+				}
+			}
+
+		private:
+			const HashMapInternal::Ctrl* m_ctrl;
+			const HashMapInternal::Ctrl* m_ctrlEnd;
+			ItemT*                       m_item;
+		};
+
+		using Iterator      = IteratorBase<Item>;
+		using ConstIterator = IteratorBase<const Item>;
+
+	public:
+		// allocatorがnullptrならSI_ALIGNED_MALLOCで確保する.
+		explicit HashMap(AllocatorBase* allocator = nullptr)
+			: m_allocator(allocator)
+			, m_ctrl(const_cast<HashMapInternal::Ctrl*>(HashMapInternal::kEmptyGroup))
+			, m_items(nullptr)
+			, m_capacity(0)
+			, m_itemCount(0)
+			, m_growthLeft(0)
+		{
+		}
+
+		HashMap(HashMap&& map) noexcept
+			: HashMap(map.m_allocator)
+		{
+			Swap(map);
+		}
+
+		~HashMap()
+		{
+			Reset();
+		}
+
+		HashMap& operator=(HashMap&& map) noexcept
+		{
+			if(this == &map) return (*this);
+
+			Reset();
+			m_allocator = map.m_allocator;
+			Swap(map);
+			return (*this);
+		}
+
+		void Swap(HashMap& map)
+		{
+			std::swap(m_allocator,  map.m_allocator);
+			std::swap(m_ctrl,       map.m_ctrl);
+			std::swap(m_items,      map.m_items);
+			std::swap(m_capacity,   map.m_capacity);
+			std::swap(m_itemCount,  map.m_itemCount);
+			std::swap(m_growthLeft, map.m_growthLeft);
+		}
+
+		// 全要素を破棄して、メモリも解放する.
+		void Reset()
+		{
+			DestroyItems();
+			if(0 < m_capacity)
+			{
+				Deallocate(m_ctrl);
+			}
+			m_ctrl       = const_cast<HashMapInternal::Ctrl*>(HashMapInternal::kEmptyGroup);
+			m_items      = nullptr;
+			m_capacity   = 0;
+			m_itemCount  = 0;
+			m_growthLeft = 0;
+		}
+
+		// 全要素を破棄する. メモリは再利用するために残す.
+		void Clear()
+		{
+			if(m_capacity == 0) return;
+
+			DestroyItems();
+			memset(m_ctrl, HashMapInternal::kEmpty, m_capacity);
+			m_itemCount  = 0;
+			m_growthLeft = GetMaxLoad(m_capacity);
+		}
+
+		// itemCount個まで再確保なしで追加できるようにする.
+		void Reserve(size_t itemCount)
+		{
+			size_t capacity = HashMapInternal::kGroupWidth;
+			while(GetMaxLoad(capacity) < itemCount)
+			{
+				capacity *= 2;
+			}
+
+			if(m_capacity < capacity)
+			{
+				Rehash(capacity);
+			}
+		}
+
+		// 無ければ追加する. 既にあった場合は上書きせずにfalseを返す.
+		template<typename K, typename... Args>
+		bool Emplace(K&& key, Args&&... args)
+		{
+			size_t index = 0;
+			if(FindOrPrepareInsert(key, index)) return false;
+
+			new(&m_items[index]) Item(std::forward<K>(key), std::forward<Args>(args)...);
+			return true;
+		}
+
+		bool Insert(const Key& key, const Value& value)
+		{
+			return Emplace(key, value);
+		}
+
+		// 無ければ既定値で追加して、値を返す.
+		Value& operator[](const Key& key)
+		{
+			size_t index = 0;
+			if(!FindOrPrepareInsert(key, index))
+			{
+				new(&m_items[index]) Item(key);
+			}
+			return m_items[index].m_value;
+		}
+
+		Value* Find(const Key& key)
+		{
+			size_t index = 0;
+			return FindIndex(key, index)? &m_items[index].m_value : nullptr;
+		}
+
+		const Value* Find(const Key& key) const
+		{
+			size_t index = 0;
+			return FindIndex(key, index)? &m_items[index].m_value : nullptr;
+		}
+
+		bool Contains(const Key& key) const
+		{
+			size_t index = 0;
+			return FindIndex(key, index);
+		}
+
+		bool Erase(const Key& key)
+		{
+			size_t index = 0;
+			if(!FindIndex(key, index)) return false;
+
+			m_items[index].~Item();
+			--m_itemCount;
+
+			// グループに空きがあれば、このグループを通り過ぎて探索が続くことは無いので空きに戻せる.
+			// 無ければ後ろのグループを探索が続けられるように削除済みにする.
+			HashMapInternal::Group group(m_ctrl + (index & ~(HashMapInternal::kGroupWidth - 1)));
+			if(group.MatchEmpty() != 0)
+			{
+				m_ctrl[index] = HashMapInternal::kEmpty;
+				++m_growthLeft;
+			}
+			else
+			{
+				m_ctrl[index] = HashMapInternal::kDeleted;
+			}
+			return true;
+		}
+
+		size_t GetItemCount() const{ return m_itemCount; }
+		size_t GetCapacity()  const{ return m_capacity; }
+		bool   IsEmpty()      const{ return m_itemCount == 0; }
+
+		Iterator      begin()      { return Iterator(m_ctrl, m_ctrl + m_capacity, m_items); }
+		Iterator      end()        { return Iterator(m_ctrl + m_capacity, m_ctrl + m_capacity, m_items + m_capacity); }
+		ConstIterator begin() const{ return ConstIterator(m_ctrl, m_ctrl + m_capacity, m_items); }
+		ConstIterator end()   const{ return ConstIterator(m_ctrl + m_capacity, m_ctrl + m_capacity, m_items + m_capacity); }
+
+	private:
+		// 上位57bitで最初のグループを決め、下位7bitを制御バイトに入れる.
+		static size_t GetH1(Hash64 hash){ return (size_t)(hash >> 7); }
+		static HashMapInternal::Ctrl GetH2(Hash64 hash){ return (HashMapInternal::Ctrl)(hash & 0x7f); }
+
+		// 7/8まで埋まったら拡張する.
+		static size_t GetMaxLoad(size_t capacity){ return capacity - capacity / 8; }
+
+		// グループ単位の三角数探索. グループ数が2のべき乗なら全グループを1回ずつ通る.
+		struct ProbeSequence
+		{
+			ProbeSequence(size_t h1, size_t groupMask)
+				: m_group(h1 & groupMask)
+				, m_groupMask(groupMask)
+				, m_step(0)
+			{
+			}
+
+			size_t GetOffset() const{ return m_group * HashMapInternal::kGroupWidth; }
+
+			void Next()
+			{
+				++m_step;
+				m_group = (m_group + m_step) & m_groupMask;
+			}
+
+			size_t m_group;
+			size_t m_groupMask;
+			size_t m_step;
+		};
+
+		ProbeSequence MakeProbe(Hash64 hash) const
+		{
+			size_t groupCount = m_capacity / HashMapInternal::kGroupWidth;
+			return ProbeSequence(GetH1(hash), (groupCount == 0)? 0 : groupCount - 1);
+		}
+
+		bool FindIndex(const Key& key, size_t& outIndex) const
+		{
+			Hash64 hash = m_hasher(key);
+			return FindIndex(key, hash, outIndex);
+		}
+
+		bool FindIndex(const Key& key, Hash64 hash, size_t& outIndex) const
+		{
+			HashMapInternal::Ctrl h2 = GetH2(hash);
+			ProbeSequence probe = MakeProbe(hash);
+			while(true)
+			{
+				HashMapInternal::Group group(m_ctrl + probe.GetOffset());
+				for(uint32_t mask = group.Match(h2); mask != 0; mask &= mask - 1)
+				{
+					size_t index = probe.GetOffset() + HashMapInternal::CountTrailingZeros(mask);
+					if(m_items[index].m_key == key)
+					{
+						outIndex = index;
+						return true;
+					}
+				}
+
+				// 空きがあるグループで見つからなければ、この先にも無い.
+				if(group.MatchEmpty() != 0) return false;
+
+				probe.Next();
+			}
+		}
+
+		size_t FindFirstNonFull(Hash64 hash) const
+		{
+			ProbeSequence probe = MakeProbe(hash);
+			while(true)
+			{
+				HashMapInternal::Group group(m_ctrl + probe.GetOffset());
+				uint32_t mask = group.MatchEmptyOrDeleted();
+				if(mask != 0)
+				{
+					return probe.GetOffset() + HashMapInternal::CountTrailingZeros(mask);
+				}
+				probe.Next();
+			}
+		}
+
+		// 見つかればtrue. 見つからなければ追加先の制御バイトを埋めて、outIndexに要素を構築してもらう.
+		bool FindOrPrepareInsert(const Key& key, size_t& outIndex)
+		{
+			Hash64 hash = m_hasher(key);
+			if(FindIndex(key, hash, outIndex)) return true;
+
+			size_t index = FindFirstNonFull(hash);
+			if(m_growthLeft == 0 && m_ctrl[index] != HashMapInternal::kDeleted)
+			{
+				// 削除済みが多いだけなら同じ容量で詰め直す.
+				size_t capacity = (m_capacity == 0)? HashMapInternal::kGroupWidth : m_capacity;
+				if(GetMaxLoad(capacity) / 2 <= m_itemCount)
+				{
+					capacity *= 2;
+				}
+				Rehash(capacity);
+				index = FindFirstNonFull(hash);
+			}
+
+			if(m_ctrl[index] == HashMapInternal::kEmpty)
+			{
+				--m_growthLeft;
+			}
+			m_ctrl[index] = GetH2(hash);
+			++m_itemCount;
+
+			outIndex = index;
+			return false;
+		}
+
+		void Rehash(size_t capacity)
+		{
+			SI_ASSERT(m_itemCount <= GetMaxLoad(capacity));
+
+			HashMapInternal::Ctrl* oldCtrl     = m_ctrl;
+			Item*                  oldItems    = m_items;
+			size_t                 oldCapacity = m_capacity;
+
+			// 制御バイトの後ろに要素を並べて、1回で確保する.
+			size_t itemsOffset = AlignUp(capacity, alignof(Item));
+			size_t alignment   = (alignof(Item) < HashMapInternal::kGroupWidth)? HashMapInternal::kGroupWidth : alignof(Item);
+			void*  buffer      = Allocate(itemsOffset + capacity * sizeof(Item), alignment);
+			SI_ASSERT(buffer);
+
+			m_ctrl       = (HashMapInternal::Ctrl*)buffer;
+			m_items      = (Item*)((uint8_t*)buffer + itemsOffset);
+			m_capacity   = capacity;
+			m_growthLeft = GetMaxLoad(capacity) - m_itemCount;
+			memset(m_ctrl, HashMapInternal::kEmpty, capacity);
+
+			for(size_t i=0; i<oldCapacity; ++i)
+			{
+				if(oldCtrl[i] < 0) continue;
+
+				Hash64 hash  = m_hasher(oldItems[i].m_key);
+				size_t index = FindFirstNonFull(hash);
+				m_ctrl[index] = GetH2(hash);
+				new(&m_items[index]) Item(std::move(oldItems[i]));
+				oldItems[i].~Item();
+			}
+
+			if(0 < oldCapacity)
+			{
+				Deallocate(oldCtrl);
+			}
+		}
+
+		void DestroyItems()
+		{
+			for(size_t i=0; i<m_capacity; ++i)
+			{
+				if(m_ctrl[i] < 0) continue;
+				m_items[i].~Item();
+			}
+		}
+
+		void* Allocate(size_t size, size_t alignment)
+		{
+			if(m_allocator) return m_allocator->Allocate(size, alignment);
+			return SI_ALIGNED_MALLOC(size, alignment);
+		}
+
+		void Deallocate(HashMapInternal::Ctrl* ctrl)
+		{
+			if(m_allocator) m_allocator->Deallocate(ctrl);
+			else            SI_ALIGNED_FREE(ctrl);
+		}
+
+		static size_t AlignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+	private:
+		AllocatorBase*          m_allocator;
+		HashMapInternal::Ctrl*  m_ctrl;       // m_capacity個の制御バイト.
+		Item*                   m_items;      // m_capacity個の要素. 使用中の所だけ構築されている.
+		size_t                  m_capacity;   // 0か、16以上の2のべき乗.
+		size_t                  m_itemCount;
+		size_t                  m_growthLeft; // 空きをあと何個埋めたら拡張するか.
+		Hasher                  m_hasher;
+	};
+
+} // namespace SI
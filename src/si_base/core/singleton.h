@@ -15,6 +15,11 @@ namespace SI
 			return s_instance;
 		}
 
+		static bool IsCreated()
+		{
+			return s_instance!=nullptr;
+		}
+
 	protected:
 		Singleton(T* ptr)
 		{
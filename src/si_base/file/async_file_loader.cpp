@@ -0,0 +1,225 @@
+﻿
+#include "si_base/file/async_file_loader.h"
+
+#include <string>
+#include "si_base/core/core.h"
+#include "si_base/concurency/job_system.h"
+
+namespace SI
+{
+	struct AsyncFileRequestState
+	{
+		std::string                  m_filePath;
+		MappedFileAccess             m_access;
+		AsyncFileLoader::ProcessFunc m_process;
+		JobSystem*                   m_jobSystem;
+
+		MappedFile                   m_file;
+		int                          m_result;
+		AtomicInt32                  m_status;
+
+		std::mutex                   m_mutex;
+		std::condition_variable      m_condition;
+
+		AsyncFileRequestState()
+			: m_access(MappedFileAccess::ReadOnly)
+			, m_jobSystem(nullptr)
+			, m_result(-1)
+			, m_status((int32_t)AsyncFileRequestStatus::Queued)
+		{
+		}
+
+		void Finish(int result)
+		{
+			m_process = nullptr; // キャプチャしているものを早めに解放する.
+			m_result  = result;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_status = (int32_t)AsyncFileRequestStatus::Done;
+			}
+			m_condition.notify_all();
+		}
+	};
+
+	//////////////////////////////////////////////////////////
+
+	bool AsyncFileRequest::IsDone() const
+	{
+		return GetStatus() == AsyncFileRequestStatus::Done;
+	}
+
+	AsyncFileRequestStatus AsyncFileRequest::GetStatus() const
+	{
+		SI_ASSERT(IsValid());
+		return (AsyncFileRequestStatus)(int32_t)m_state->m_status;
+	}
+
+	void AsyncFileRequest::Wait() const
+	{
+		SI_ASSERT(IsValid());
+		if(IsDone()) return;
+
+		if(m_state->m_jobSystem)
+		{
+			// processがJobSystemに積まれるので、寝ずに手伝う.
+			m_state->m_jobSystem->WaitUntil([this](){ return IsDone(); });
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(m_state->m_mutex);
+		m_state->m_condition.wait(lock, [this](){ return IsDone(); });
+	}
+
+	int AsyncFileRequest::GetResult() const
+	{
+		SI_ASSERT(IsDone());
+		return m_state->m_result;
+	}
+
+	const MappedFile& AsyncFileRequest::GetFile() const
+	{
+		SI_ASSERT(IsDone());
+		return m_state->m_file;
+	}
+
+	MappedFile& AsyncFileRequest::GetFile()
+	{
+		SI_ASSERT(IsDone());
+		return m_state->m_file;
+	}
+
+	//////////////////////////////////////////////////////////
+
+	AsyncFileLoader::AsyncFileLoader()
+		: m_jobSystem(nullptr)
+		, m_processingCount(0)
+		, m_exit(false)
+	{
+	}
+
+	AsyncFileLoader::~AsyncFileLoader()
+	{
+		Terminate();
+	}
+
+	void AsyncFileLoader::Initialize(uint32_t ioThreadCount, JobSystem* processJobSystem)
+	{
+		SI_ASSERT(!IsInitialized());
+
+		m_jobSystem       = processJobSystem;
+		m_processingCount = 0;
+		m_exit            = false;
+
+		ioThreadCount = SI::Max(ioThreadCount, 1u);
+		m_threads.reserve(ioThreadCount);
+		for(uint32_t i=0; i<ioThreadCount; ++i)
+		{
+			m_threads.emplace_back([this](){ ThreadMain(); });
+		}
+	}
+
+	void AsyncFileLoader::Terminate()
+	{
+		if(!IsInitialized()) return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exit = true;
+		}
+		m_condition.notify_all();
+
+		for(std::thread& thread : m_threads)
+		{
+			thread.join();
+		}
+		m_threads.clear();
+
+		if(m_jobSystem)
+		{
+			m_jobSystem->WaitUntil([this](){ return (int32_t)m_processingCount == 0; });
+			m_jobSystem = nullptr;
+		}
+	}
+
+	AsyncFileRequest AsyncFileLoader::Load(
+		const char*        filePath,
+		const ProcessFunc& process,
+		MappedFileAccess   access)
+	{
+		SI_ASSERT(IsInitialized());
+		SI_ASSERT(filePath);
+
+		std::shared_ptr<AsyncFileRequestState> state = std::make_shared<AsyncFileRequestState>();
+		state->m_filePath  = filePath;
+		state->m_access    = access;
+		state->m_process   = process;
+		state->m_jobSystem = process? m_jobSystem : nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			SI_ASSERT(!m_exit);
+			m_requests.push_back(state);
+		}
+		m_condition.notify_one();
+
+		return AsyncFileRequest(state);
+	}
+
+	void AsyncFileLoader::ThreadMain()
+	{
+		while(true)
+		{
+			std::shared_ptr<AsyncFileRequestState> state;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this](){ return m_exit || !m_requests.empty(); });
+
+				// 終了する時も、積まれている分は読み切る.
+				if(m_requests.empty()) break;
+
+				state = std::move(m_requests.front());
+				m_requests.pop_front();
+			}
+
+			Execute(state);
+		}
+	}
+
+	void AsyncFileLoader::Execute(const std::shared_ptr<AsyncFileRequestState>& state)
+	{
+		state->m_status = (int32_t)AsyncFileRequestStatus::Reading;
+
+		int ret = state->m_file.Open(state->m_filePath.c_str(), state->m_access);
+		if(ret != 0)
+		{
+			state->Finish(ret);
+			return;
+		}
+
+		// マップしただけでは読まれないので、このスレッドでページを読み込んでおく.
+		state->m_file.Prefetch();
+
+		if(!state->m_process)
+		{
+			state->Finish(0);
+			return;
+		}
+
+		state->m_status = (int32_t)AsyncFileRequestStatus::Processing;
+
+		if(m_jobSystem)
+		{
+			// processを渡したらすぐに次のファイルの読み込みに移る.
+			++m_processingCount;
+			m_jobSystem->Run([this, state]()
+			{
+				state->Finish(state->m_process(state->m_file));
+				--m_processingCount;
+			});
+			return;
+		}
+
+		state->Finish(state->m_process(state->m_file));
+	}
+
+} // namespace SI
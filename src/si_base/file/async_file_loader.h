@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include "si_base/core/non_copyable.h"
+#include "si_base/concurency/atomic.h"
+#include "si_base/file/mapped_file.h"
+
+namespace SI
+{
+	class JobSystem;
+	struct AsyncFileRequestState;
+
+	enum class AsyncFileRequestStatus
+	{
+		Queued,      // I/Oスレッドの空き待ち.
+		Reading,
+		Processing,  // processを実行中.
+		Done,
+	};
+
+	// AsyncFileLoader::Loadで積んだリクエストのハンドル.
+	// コピーしても同じリクエストを指し、最後のハンドルが無くなった時に読み込んだファイルも閉じる.
+	class AsyncFileRequest
+	{
+	public:
+		AsyncFileRequest()
+		{
+		}
+
+		bool IsValid() const{ return (bool)m_state; }
+		bool IsDone() const;
+		AsyncFileRequestStatus GetStatus() const;
+
+		// 完了するまで待つ. processをJobSystemで実行している時は、待っている間Jobを手伝う.
+		void Wait() const;
+
+		// 以下は完了してから呼ぶ. 結果は0なら成功.
+		int GetResult() const;
+		const MappedFile& GetFile() const;
+		MappedFile& GetFile();
+
+		const uint8_t* GetData() const{ return GetFile().GetData(); }
+		size_t GetSize() const{ return GetFile().GetSize(); }
+
+		void Reset(){ m_state.reset(); }
+
+	private:
+		friend class AsyncFileLoader;
+
+		explicit AsyncFileRequest(const std::shared_ptr<AsyncFileRequestState>& state)
+			: m_state(state)
+		{
+		}
+
+	private:
+		std::shared_ptr<AsyncFileRequestState> m_state;
+	};
+
+	// 決まった数のI/Oスレッドでファイルを読み込むサービス.
+	// 読み込みが終わったファイルはprocess(デコードなど)に渡され、その間に次のファイルの読み込みを進める.
+	class AsyncFileLoader : private NonCopyable
+	{
+	public:
+		// 読み込んだファイルに対する処理. 0以外を返すとリクエストの失敗になる.
+		using ProcessFunc = std::function<int(MappedFile& file)>;
+
+	public:
+		AsyncFileLoader();
+		~AsyncFileLoader();
+
+		// ioThreadCountは同時に読み込むファイルの数. 増やしてもディスクの帯域以上には速くならない.
+		// processJobSystemを渡すと、processはそのJobSystemで実行する. nullptrならI/Oスレッドで実行する.
+		void Initialize(uint32_t ioThreadCount = 2, JobSystem* processJobSystem = nullptr);
+
+		// 積まれているリクエストを全て終わらせてから止める.
+		void Terminate();
+
+		bool IsInitialized() const{ return !m_threads.empty(); }
+
+		AsyncFileRequest Load(
+			const char*        filePath,
+			const ProcessFunc& process = ProcessFunc(),
+			MappedFileAccess   access  = MappedFileAccess::ReadOnly);
+
+	private:
+		void ThreadMain();
+		void Execute(const std::shared_ptr<AsyncFileRequestState>& state);
+
+	private:
+		std::vector<std::thread>                            m_threads;
+		std::deque<std::shared_ptr<AsyncFileRequestState>>  m_requests;
+		std::mutex                                          m_mutex;
+		std::condition_variable                             m_condition;
+		JobSystem*                                          m_jobSystem;
+		AtomicInt32                                         m_processingCount; // JobSystemで実行中のprocessの数.
+		bool                                                m_exit;
+	};
+
+} // namespace SI
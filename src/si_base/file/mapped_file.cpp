@@ -0,0 +1,215 @@
+﻿
+#include "si_base/file/mapped_file.h"
+
+#include <utility>
+#include "si_base/core/core.h"
+#include "si_base/core/new_delete.h"
+#include "si_base/file/file.h"
+
+#if _WIN32
+#include "si_base/platform/windows_proxy.h"
+#include "Shlwapi.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SI
+{
+	namespace
+	{
+#if _WIN32
+		void* MapFile(uint8_t*& outData, size_t& outSize, const char* filePath, MappedFileAccess access)
+		{
+			char canonnicalizedFilePath[MAX_PATH];
+			PathCanonicalizeA(canonnicalizedFilePath, filePath);
+
+			HANDLE file = CreateFileA(
+				canonnicalizedFilePath,
+				GENERIC_READ,
+				FILE_SHARE_READ,
+				NULL,
+				OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+				NULL);
+			if(file == INVALID_HANDLE_VALUE) return nullptr;
+
+			LARGE_INTEGER fileSize;
+			if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+			{
+				CloseHandle(file);
+				return nullptr;
+			}
+
+			// マッピングが残っていればファイルのハンドルは閉じてよい.
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			CloseHandle(file);
+			if(!mapping) return nullptr;
+
+			DWORD viewAccess = (access == MappedFileAccess::CopyOnWrite)? FILE_MAP_COPY : FILE_MAP_READ;
+			void* view = MapViewOfFile(mapping, viewAccess, 0, 0, 0);
+			if(!view)
+			{
+				CloseHandle(mapping);
+				return nullptr;
+			}
+
+			outData = (uint8_t*)view;
+			outSize = (size_t)fileSize.QuadPart;
+			return mapping;
+		}
+
+		void UnmapFile(void* mapping, uint8_t* data, size_t size)
+		{
+			UnmapViewOfFile(data);
+			CloseHandle((HANDLE)mapping);
+		}
+#else
+		void* MapFile(uint8_t*& outData, size_t& outSize, const char* filePath, MappedFileAccess access)
+		{
+			int fd = open(filePath, O_RDONLY);
+			if(fd < 0) return nullptr;
+
+			struct stat st;
+			if(fstat(fd, &st) != 0 || st.st_size <= 0)
+			{
+				close(fd);
+				return nullptr;
+			}
+
+			int prot = PROT_READ;
+			if(access == MappedFileAccess::CopyOnWrite) prot |= PROT_WRITE;
+
+			void* view = mmap(nullptr, (size_t)st.st_size, prot, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if(view == MAP_FAILED) return nullptr;
+
+			outData = (uint8_t*)view;
+			outSize = (size_t)st.st_size;
+			return view;
+		}
+
+		void UnmapFile(void* mapping, uint8_t* data, size_t size)
+		{
+			munmap(data, size);
+		}
+#endif
+	}
+
+	MappedFile::MappedFile()
+		: m_data(nullptr)
+		, m_size(0)
+		, m_mapping(nullptr)
+		, m_writable(false)
+	{
+	}
+
+	MappedFile::MappedFile(MappedFile&& src)
+		: m_data(nullptr)
+		, m_size(0)
+		, m_mapping(nullptr)
+		, m_writable(false)
+	{
+		*this = std::move(src);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& src)
+	{
+		if(this == &src) return *this;
+
+		Close();
+
+		m_data     = src.m_data;
+		m_size     = src.m_size;
+		m_mapping  = src.m_mapping;
+		m_writable = src.m_writable;
+
+		src.m_data     = nullptr;
+		src.m_size     = 0;
+		src.m_mapping  = nullptr;
+		src.m_writable = false;
+
+		return *this;
+	}
+
+	int MappedFile::Open(const char* filePath, MappedFileAccess access)
+	{
+		SI_ASSERT(!IsValid());
+
+		m_mapping = MapFile(m_data, m_size, filePath, access);
+		if(m_mapping)
+		{
+			m_writable = (access == MappedFileAccess::CopyOnWrite);
+			return 0;
+		}
+
+		// マップできなかったので普通に読む.
+		m_data = nullptr;
+		m_size = 0;
+		return OpenByRead(filePath, access);
+	}
+
+	void MappedFile::Close()
+	{
+		if(!m_data) return;
+
+		if(m_mapping)
+		{
+			UnmapFile(m_mapping, m_data, m_size);
+		}
+		else
+		{
+			SI_FREE(m_data);
+		}
+
+		m_data     = nullptr;
+		m_size     = 0;
+		m_mapping  = nullptr;
+		m_writable = false;
+	}
+
+	void MappedFile::Prefetch() const
+	{
+		if(!m_mapping) return; // 読み込んだ時はもうメモリにある.
+
+		// 各ページを1byteずつ触る.
+		static const size_t kPageSize = 4096;
+		volatile uint8_t sum = 0;
+		for(size_t offset=0; offset<m_size; offset+=kPageSize)
+		{
+			sum += m_data[offset];
+		}
+		sum += m_data[m_size-1];
+	}
+
+	int MappedFile::OpenByRead(const char* filePath, MappedFileAccess access)
+	{
+		File file;
+		if(file.Open(filePath) != 0) return -1;
+
+		int64_t fileSize = file.GetFileSize();
+		if(fileSize <= 0) return -1;
+
+		uint8_t* data = (uint8_t*)SI_MALLOC((size_t)fileSize);
+
+		int64_t readSize = 0;
+		if(file.Read(data, fileSize, &readSize) != 0 || readSize != fileSize)
+		{
+			SI_FREE(data);
+			return -1;
+		}
+
+		m_data     = data;
+		m_size     = (size_t)fileSize;
+		m_writable = (access == MappedFileAccess::CopyOnWrite);
+		return 0;
+	}
+
+} // namespace SI
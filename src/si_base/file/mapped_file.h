@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "si_base/core/non_copyable.h"
+
+namespace SI
+{
+	enum class MappedFileAccess
+	{
+		ReadOnly,
+		CopyOnWrite, // 書き換えられるが、ファイルには反映されない.
+	};
+
+	// ファイルをメモリにマップして、コピーせずに中身を参照する.
+	// マップできない場合は、確保したメモリに読み込んで同じように扱う.
+	// 中身が無いと参照するものが無いので、空のファイルはOpenが失敗する(-1を返す).
+	class MappedFile : private NonCopyable
+	{
+	public:
+		MappedFile();
+		MappedFile(MappedFile&& src);
+		~MappedFile();
+
+		MappedFile& operator=(MappedFile&& src);
+
+		int Open(const char* filePath, MappedFileAccess access = MappedFileAccess::ReadOnly);
+		void Close();
+
+		// マップしたページを実際に読み込ませておく.
+		// 参照する側のスレッドでページフォルトによるI/O待ちが起きないようにしたい時に使う.
+		void Prefetch() const;
+
+		bool IsValid() const{ return m_data != nullptr; }
+		bool IsMapped() const{ return m_mapping != nullptr; }
+
+		const uint8_t* GetData() const{ return m_data; }
+		uint8_t* GetWritableData() const{ return m_writable? m_data : nullptr; }
+		size_t GetSize() const{ return m_size; }
+
+	private:
+		int OpenByRead(const char* filePath, MappedFileAccess access);
+
+	private:
+		uint8_t* m_data;
+		size_t   m_size;
+		void*    m_mapping;  // マップしている時のハンドル. 読み込んだ時はnullptr.
+		bool     m_writable;
+	};
+
+} // namespace SI
@@ -122,6 +122,8 @@ namespace SI
 	{
 		if(!m_initialized) return 0;
 		
+		TerminatePipelineLibrary();
+
 #if 0 // DX12のmemory leakがあるときにこのコメントアウトを外すと詳細がわかる.
 #if defined(_DEBUG)
 		{
@@ -389,7 +391,7 @@ namespace SI
 	BaseGraphicsState* BaseDevice::CreateGraphicsState(const GfxGraphicsStateDesc& desc)
 	{
 		BaseGraphicsState* s = SI_NEW(BaseGraphicsState);
-		int ret = s->Initialize(*m_device.Get(), desc);
+		int ret = s->Initialize(*m_device.Get(), desc, m_pipelineLibrary.Get());
 		if(ret != 0)
 		{
 			SI_ASSERT(0, "error CreateGraphicsState");
@@ -404,6 +406,65 @@ namespace SI
 	{
 		SI_DELETE(s);
 	}
+
+	int BaseDevice::InitializePipelineLibrary(const void* data, size_t dataSize)
+	{
+		TerminatePipelineLibrary();
+
+		if(data && 0<dataSize)
+		{
+			m_pipelineLibraryData.assign((const uint8_t*)data, (const uint8_t*)data + dataSize);
+
+			HRESULT hr = m_device->CreatePipelineLibrary(
+				m_pipelineLibraryData.data(),
+				m_pipelineLibraryData.size(),
+				IID_PPV_ARGS(&m_pipelineLibrary));
+			if(SUCCEEDED(hr))
+			{
+				return 0;
+			}
+
+			// D3D12_ERROR_DRIVER_VERSION_MISMATCH等. 古いキャッシュは捨てる.
+			m_pipelineLibrary.Reset();
+			m_pipelineLibraryData.clear();
+		}
+
+		HRESULT hr = m_device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_pipelineLibrary));
+		if(FAILED(hr))
+		{
+			// 対応していない環境もあるので、その場合はキャッシュ無しで動かす.
+			m_pipelineLibrary.Reset();
+			return -1;
+		}
+
+		return 0;
+	}
+
+	void BaseDevice::TerminatePipelineLibrary()
+	{
+		m_pipelineLibrary.Reset();
+		m_pipelineLibraryData.clear();
+		m_pipelineLibraryData.shrink_to_fit();
+	}
+
+	int BaseDevice::SerializePipelineLibrary(std::vector<uint8_t>& outData)
+	{
+		outData.clear();
+		if(!m_pipelineLibrary) return -1;
+
+		SIZE_T size = m_pipelineLibrary->GetSerializedSize();
+		outData.resize(size);
+
+		HRESULT hr = m_pipelineLibrary->Serialize(outData.data(), size);
+		if(FAILED(hr))
+		{
+			SI_ASSERT(0, "error Serialize PipelineLibrary\n%s", _com_error(hr).ErrorMessage());
+			outData.clear();
+			return -1;
+		}
+
+		return 0;
+	}
 	
 	BaseComputeState* BaseDevice::CreateComputeState(const GfxComputeStateDesc& desc)
 	{
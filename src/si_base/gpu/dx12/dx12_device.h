@@ -60,6 +60,14 @@ namespace SI
 		BaseGraphicsState* CreateGraphicsState(const GfxGraphicsStateDesc& desc);
 		void ReleaseGraphicsState(BaseGraphicsState* s);
 
+		// PSOのディスクキャッシュ(ID3D12PipelineLibrary).
+		// 初期化後に作成したGraphicsStateはライブラリから読み込まれ、無ければ登録される.
+		// dataはnullptrなら空のライブラリを作る. ドライバが変わった等で読めないときも空で作り直す.
+		int  InitializePipelineLibrary(const void* data, size_t dataSize);
+		void TerminatePipelineLibrary();
+		bool IsPipelineLibraryEnable() const{ return m_pipelineLibrary != nullptr; }
+		int  SerializePipelineLibrary(std::vector<uint8_t>& outData);
+
 		BaseComputeState* CreateComputeState(const GfxComputeStateDesc& desc);
 		void ReleaseComputeState(BaseComputeState* s);
 
@@ -243,6 +251,8 @@ namespace SI
 		ComPtr<IDXGIFactory4>             m_dxgiFactory; // 持ちたくないが、DX12ではdeviceから参照出来ないので持つ.
 		ComPtr<ID3D12Device5>             m_device;
 		ComPtr<ID3D12PipelineState>       m_pipelineState;
+		ComPtr<ID3D12PipelineLibrary>     m_pipelineLibrary;
+		std::vector<uint8_t>              m_pipelineLibraryData; // ライブラリの生存中は保持しておく必要がある.
 		PoolAllocatorEx*                  m_objectAllocator;
 		PoolAllocatorEx*                  m_tempAllocator;
 		bool                              m_initialized;
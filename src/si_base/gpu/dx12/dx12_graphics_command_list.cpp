@@ -113,8 +113,12 @@ namespace SI
 	BaseGraphicsCommandList::BaseGraphicsCommandList()
 		: m_uploadHeapArrayIndex(0)
 		, m_currentRootSignature(nullptr)
+		, m_currentPipelineState(nullptr)
+		, m_currentDescriptorHeapCount(0)
+		, m_currentTopology(D3D_PRIMITIVE_TOPOLOGY_UNDEFINED)
 		, m_buildingScene(nullptr)
 	{
+		ResetStateCache(nullptr);
 	}
 
 	
@@ -69,6 +69,7 @@ namespace SI
 			}
 
 			m_currentRootSignature = nullptr;
+			ResetStateCache(pipelineState);
 
 			return 0;
 		}
@@ -85,19 +86,22 @@ namespace SI
 			return 0;
 		}
 		
-		void SetPipelineState(BaseGraphicsState& graphicsState)
+		bool SetPipelineState(BaseGraphicsState& graphicsState)
 		{
-			m_graphicsCommandList->SetPipelineState(graphicsState.GetComPtrGraphicsState().Get());
+			return SetPipelineStateIfChanged(graphicsState.GetComPtrGraphicsState().Get());
 		}
 
-		void SetPipelineState(BaseComputeState& computeState)
+		bool SetPipelineState(BaseComputeState& computeState)
 		{
-			m_graphicsCommandList->SetPipelineState(computeState.GetComPtrComputeState().Get());
+			return SetPipelineStateIfChanged(computeState.GetComPtrComputeState().Get());
 		}
 
 		void SetPipelineState(BaseRaytracingState& raytracingState)
 		{
 			m_graphicsCommandList->SetPipelineState1(raytracingState.GetComPtrState().Get());
+
+			// StateObjectをセットするとPSOの状態は不定になるのでキャッシュを無効にする.
+			m_currentPipelineState = nullptr;
 		}
 
 		inline void ClearRenderTarget(const GfxCpuDescriptor& tex, const float* clearColor)
@@ -209,7 +213,20 @@ namespace SI
 			{
 				heaps[i] = descriptorHeaps[i]->GetBaseDescriptorHeap()->GetDx12DescriptorHeap();
 			}
-			m_graphicsCommandList->SetDescriptorHeaps(descriptorHeapCount, heaps);
+
+			// heapの切り替えはGPUのflushを伴うことがあるので、同じ組み合わせなら積まない.
+			if( count == m_currentDescriptorHeapCount &&
+				heaps[0] == m_currentDescriptorHeaps[0] &&
+				heaps[1] == m_currentDescriptorHeaps[1])
+			{
+				return;
+			}
+
+			m_graphicsCommandList->SetDescriptorHeaps(count, heaps);
+
+			m_currentDescriptorHeapCount = count;
+			m_currentDescriptorHeaps[0]  = heaps[0];
+			m_currentDescriptorHeaps[1]  = heaps[1];
 		}
 
 		inline void SetGraphicsDescriptorTable(
@@ -332,7 +349,14 @@ namespace SI
 		
 		inline void SetPrimitiveTopology(GfxPrimitiveTopology topology)
 		{
-			m_graphicsCommandList->IASetPrimitiveTopology(GetDx12PrimitiveTopology(topology));
+			D3D12_PRIMITIVE_TOPOLOGY d3dTopology = GetDx12PrimitiveTopology(topology);
+			if(d3dTopology == m_currentTopology)
+			{
+				return;
+			}
+
+			m_graphicsCommandList->IASetPrimitiveTopology(d3dTopology);
+			m_currentTopology = d3dTopology;
 		}
 
 		inline void SetIndexBuffer(const GfxIndexBufferView* indexBufferView)
@@ -340,6 +364,7 @@ namespace SI
 			if(indexBufferView == nullptr)
 			{
 				m_graphicsCommandList->IASetIndexBuffer(nullptr);
+				m_currentIndexBufferView = D3D12_INDEX_BUFFER_VIEW{};
 				return;
 			}
 
@@ -350,7 +375,15 @@ namespace SI
 			d3View.Format         = GetDx12Format(indexBufferView->GetFormat());
 			d3View.SizeInBytes    = (UINT)indexBufferView->GetSize();
 
+			if( d3View.BufferLocation == m_currentIndexBufferView.BufferLocation &&
+				d3View.Format         == m_currentIndexBufferView.Format &&
+				d3View.SizeInBytes    == m_currentIndexBufferView.SizeInBytes)
+			{
+				return;
+			}
+
 			m_graphicsCommandList->IASetIndexBuffer(&d3View);
+			m_currentIndexBufferView = d3View;
 		}
 		
 		inline void SetVertexBuffers(uint32_t inputSlot, uint32_t viewCount, const GfxVertexBufferView* bufferViews)
@@ -358,6 +391,11 @@ namespace SI
 			if(bufferViews == nullptr)
 			{
 				m_graphicsCommandList->IASetVertexBuffers(inputSlot, viewCount, nullptr);
+				uint32_t endSlot = Min(inputSlot + viewCount, (uint32_t)kMaxVertexBufferSlot);
+				for(uint32_t v=inputSlot; v<endSlot; ++v)
+				{
+					m_currentVertexBufferViews[v] = D3D12_VERTEX_BUFFER_VIEW{};
+				}
 				return;
 			}
 
@@ -377,7 +415,26 @@ namespace SI
 				outV.StrideInBytes  = (uint32_t)inV.GetStride();
 			}
 
+			// 既にバインドされているviewと全て同じなら積まない.
+			bool isSame = (inputSlot + d3dViewCount) <= kMaxVertexBufferSlot;
+			for(uint32_t v=0; isSame && v<d3dViewCount; ++v)
+			{
+				const D3D12_VERTEX_BUFFER_VIEW& curV = m_currentVertexBufferViews[inputSlot + v];
+				isSame = curV.BufferLocation == d3Views[v].BufferLocation &&
+					curV.SizeInBytes   == d3Views[v].SizeInBytes &&
+					curV.StrideInBytes == d3Views[v].StrideInBytes;
+			}
+			if(isSame)
+			{
+				return;
+			}
+
 			m_graphicsCommandList->IASetVertexBuffers(inputSlot, d3dViewCount, d3Views);
+
+			for(uint32_t v=0; v<d3dViewCount && (inputSlot + v)<kMaxVertexBufferSlot; ++v)
+			{
+				m_currentVertexBufferViews[inputSlot + v] = d3Views[v];
+			}
 		}
 
 		inline void Dispatch(
@@ -498,6 +555,35 @@ namespace SI
 		}
 
 	private:
+		inline bool SetPipelineStateIfChanged(ID3D12PipelineState* pipelineState)
+		{
+			if(pipelineState == m_currentPipelineState)
+			{
+				return false;
+			}
+
+			m_graphicsCommandList->SetPipelineState(pipelineState);
+			m_currentPipelineState = pipelineState;
+			return true;
+		}
+
+		inline void ResetStateCache(ID3D12PipelineState* pipelineState)
+		{
+			m_currentPipelineState       = pipelineState;
+			m_currentDescriptorHeapCount = 0;
+			m_currentDescriptorHeaps[0]  = nullptr;
+			m_currentDescriptorHeaps[1]  = nullptr;
+			m_currentTopology            = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+			m_currentIndexBufferView     = D3D12_INDEX_BUFFER_VIEW{};
+			for(D3D12_VERTEX_BUFFER_VIEW& view : m_currentVertexBufferViews)
+			{
+				view = D3D12_VERTEX_BUFFER_VIEW{};
+			}
+		}
+
+	private:
+		static const uint32_t kMaxVertexBufferSlot = D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
 		ComPtr<ID3D12CommandAllocator>    m_commandAllocator;
 		ComPtr<ID3D12GraphicsCommandList4> m_graphicsCommandList;
 
@@ -506,6 +592,14 @@ namespace SI
 		uint32_t                            m_uploadHeapArrayIndex;
 		BaseRootSignature*                  m_currentRootSignature;
 
+		// 冗長なステート変更を省くため、現在バインドされている状態を覚えておく.
+		ID3D12PipelineState*                m_currentPipelineState;
+		ID3D12DescriptorHeap*               m_currentDescriptorHeaps[2];
+		uint32_t                            m_currentDescriptorHeapCount;
+		D3D12_PRIMITIVE_TOPOLOGY            m_currentTopology;
+		D3D12_INDEX_BUFFER_VIEW             m_currentIndexBufferView;
+		D3D12_VERTEX_BUFFER_VIEW            m_currentVertexBufferViews[kMaxVertexBufferSlot];
+
 		BaseRaytracingScene*                m_buildingScene;
 	};
 } // namespace SI
@@ -30,7 +30,10 @@ namespace SI
 	{
 	}
 
-	int BaseGraphicsState::Initialize(ID3D12Device& device, const GfxGraphicsStateDesc& desc)
+	int BaseGraphicsState::Initialize(
+		ID3D12Device& device,
+		const GfxGraphicsStateDesc& desc,
+		ID3D12PipelineLibrary* library)
 	{
 		D3D12_INPUT_ELEMENT_DESC elements[32];
 		SI_ASSERT(desc.m_inputElementCount < ArraySize(elements));
@@ -111,11 +114,39 @@ namespace SI
 		}
 		psoDesc.DSVFormat = GetDx12Format(desc.m_dsvFormat);
 
-		HRESULT hr = device.CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState));
-		if(FAILED(hr))
+		// ライブラリ内のPSOは記述の128bitハッシュを名前にして引く.
+		// ID3D12PipelineLibraryはfree-threadedなのでロックは不要.
+		wchar_t libraryName[40];
+		libraryName[0] = 0;
+		if(library)
 		{
-			SI_ASSERT(0);
-			return -1;
+			Hash128 hash = desc.GenerateHash128();
+			swprintf_s(libraryName, L"%016llx%016llx", (unsigned long long)hash.m_high, (unsigned long long)hash.m_low);
+
+			// 見つからない場合や記述が一致しない場合はE_INVALIDARGが返るので、作り直す.
+			HRESULT hr = library->LoadGraphicsPipeline(libraryName, &psoDesc, IID_PPV_ARGS(&m_pipelineState));
+			if(FAILED(hr))
+			{
+				m_pipelineState.Reset();
+			}
+		}
+
+		if(!m_pipelineState)
+		{
+			HRESULT hr = device.CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState));
+			if(FAILED(hr))
+			{
+				SI_ASSERT(0);
+				return -1;
+			}
+
+			if(library)
+			{
+				// 同名が既に登録されている(記述が変わって古いPSOが残っている)と失敗する.
+				// ライブラリからは消せないので、今回作ったPSOをそのまま使い、次に保存し直すまで作り直しになる.
+				HRESULT storeHr = library->StorePipeline(libraryName, m_pipelineState.Get());
+				SI_WARNING(SUCCEEDED(storeHr), "PipelineLibraryに古いPSOが残っています. キャッシュファイルを削除してください.");
+			}
 		}
 		
 		if(desc.m_name)
@@ -21,7 +21,11 @@ namespace SI
 		BaseGraphicsState();
 		~BaseGraphicsState();
 
-		int Initialize(ID3D12Device& device, const GfxGraphicsStateDesc& desc);
+		// libraryが指定されていれば、そこから読み込みを試みて、無ければ作成して登録する.
+		int Initialize(
+			ID3D12Device& device,
+			const GfxGraphicsStateDesc& desc,
+			ID3D12PipelineLibrary* library = nullptr);
 		
 	public:
 		ComPtr<ID3D12PipelineState>& GetComPtrGraphicsState()
@@ -4,6 +4,7 @@
 #include <comdef.h>
 #include "si_base/core/core.h"
 #include "si_base/core/scope_exit.h"
+#include "si_base/misc/hash.h"
 #include "si_base/memory/pool_allocator.h"
 #include "si_base/gpu/gfx_root_signature.h"
 #include "si_base/gpu/dx12/dx12_enum.h"
@@ -13,6 +14,7 @@
 namespace SI
 {
 	BaseRootSignature::BaseRootSignature()
+		: m_hash(0)
 	{
 	}
 
@@ -108,6 +110,10 @@ namespace SI
 			return -1;
 		}
 
+		Hash64Generator hashGenerator;
+		hashGenerator.Add(signature->GetBufferPointer(), signature->GetBufferSize());
+		m_hash = hashGenerator.Generate();
+
 		hr = d3dDevice.CreateRootSignature(
 			0,
 			signature->GetBufferPointer(),
@@ -137,6 +143,7 @@ namespace SI
 	int BaseRootSignature::Terminate()
 	{
 		m_rootSignature.Reset();
+		m_hash = 0;
 		return 0;
 	}
 
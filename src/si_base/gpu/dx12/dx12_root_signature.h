@@ -5,6 +5,7 @@
 #if SI_USE_DX12
 #include <d3d12.h>
 #include <wrl/client.h>
+#include "si_base/misc/hash_declare.h"
 
 namespace SI
 {
@@ -23,6 +24,9 @@ namespace SI
 
 		void* GetNative(){ return m_rootSignature.Get(); }
 
+		// シリアライズしたルートシグネチャのハッシュ. 同じレイアウトなら同じ値になる.
+		Hash64 GetHash() const{ return m_hash; }
+
 	public:
 		ComPtr<ID3D12RootSignature>& GetComPtrRootSignature()
 		{
@@ -31,6 +35,7 @@ namespace SI
 
 	private:
 		ComPtr<ID3D12RootSignature> m_rootSignature;
+		Hash64                      m_hash;
 	};
 
 } // namespace SI
@@ -6,6 +6,8 @@ namespace SI
 {
 	GfxCore::GfxCore()
 		: Singleton<GfxCore>(this)
+		, m_frameFenceValue(0)
+		, m_queueBufferCount(0)
 		, m_initialized(false)
 	{
 	}
@@ -35,13 +37,27 @@ namespace SI
 		m_cpuLinearAllocatorPageManager.Initialize(desc.m_queueBufferCount, true);
 		m_gpuLinearAllocatorPageManager.Initialize(desc.m_queueBufferCount, false);
 
+		GfxGraphicsStateCacheDesc graphicsStateCacheDesc;
+		graphicsStateCacheDesc.m_filePath = desc.m_graphicsStateCachePath;
+		m_graphicsStateCache.Initialize(graphicsStateCacheDesc);
+
+		// 完了済みのフェンス値が負にならないよう、queueBufferCountから始める.
+		m_frameFenceValue  = desc.m_queueBufferCount;
+		m_queueBufferCount = desc.m_queueBufferCount;
+		for(uint32_t i=0; i<ArraySize(m_descriptorAllocators); ++i)
+		{
+			m_descriptorAllocators[i].Flip(m_frameFenceValue, 0);
+		}
+
 		m_initialized = true;
 	}
 
 	void GfxCore::Terminate()
 	{
 		if(!m_initialized) return;
-				
+		
+		m_graphicsStateCache.Terminate();
+
 		m_gpuLinearAllocatorPageManager.Terminate();
 		m_cpuLinearAllocatorPageManager.Terminate();
 
@@ -66,6 +82,14 @@ namespace SI
 		
 		m_cpuLinearAllocatorPageManager.Flip();
 		m_gpuLinearAllocatorPageManager.Flip();
+
+		// 他のリソースと同じく、queueBufferCountフレーム前のGPU処理は終わっているものとして扱う.
+		++m_frameFenceValue;
+		uint64_t completedFenceValue = m_frameFenceValue - m_queueBufferCount;
+		for(uint32_t i=0; i<ArraySize(m_descriptorAllocators); ++i)
+		{
+			m_descriptorAllocators[i].Flip(m_frameFenceValue, completedFenceValue);
+		}
 	}
 	
 } // namespace SI
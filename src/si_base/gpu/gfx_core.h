@@ -5,6 +5,7 @@
 #include "si_base/gpu/gfx_resource_states_pool.h"
 #include "si_base/gpu/gfx_descriptor_heap_pool.h"
 #include "si_base/gpu/gfx_linear_allocator_page.h"
+#include "si_base/gpu/gfx_graphics_state_cache.h"
 
 namespace SI
 {
@@ -15,6 +16,7 @@ namespace SI
 		uint32_t m_queueBufferCount   = 3;
 		uint32_t m_maxViewDescriptorHeapCount    = 1024;
 		uint32_t m_maxSamplerDescriptorHeapCount = 512;
+		const char* m_graphicsStateCachePath     = nullptr; // PSOのディスクキャッシュの保存先.
 	};
 
 	class GfxCore : public Singleton<GfxCore>
@@ -58,6 +60,11 @@ namespace SI
 			return m_gpuLinearAllocatorPageManager;
 		}
 
+		GfxGraphicsStateCache& GetGraphicsStateCache()
+		{
+			return m_graphicsStateCache;
+		}
+
 	private:
 		GfxDescriptorAllocator          m_descriptorAllocators[(uint32_t)GfxDescriptorHeapType::Max];
 		GfxResourceStatesPool           m_resourceStatePool;
@@ -65,6 +72,9 @@ namespace SI
 		GfxDescriptorHeapPool           m_samplerDescriptorHeapPool;
 		GfxLinearAllocatorPageManager   m_cpuLinearAllocatorPageManager;
 		GfxLinearAllocatorPageManager   m_gpuLinearAllocatorPageManager;
+		GfxGraphicsStateCache           m_graphicsStateCache;
+		uint64_t                        m_frameFenceValue;  // Flip毎に進める. 開放待ちのディスクリプタの判定に使う.
+		uint32_t                        m_queueBufferCount;
 		bool                            m_initialized;
 	};
 
@@ -76,3 +86,4 @@ namespace SI
 #define SI_SAMPLER_DESCRIPTOR_HEAP_POOL()  (GfxCore::GetInstance()->GetSamplerDescriptorHeapPool())
 #define SI_CPU_LA_PAGE_MANAGER()           (GfxCore::GetInstance()->GetCpuLinearAllocatorPageManager())
 #define SI_GPU_LA_PAGE_MANAGER()           (GfxCore::GetInstance()->GetGpuLinearAllocatorPageManager())
+#define SI_GRAPHICS_STATE_CACHE()          (GfxCore::GetInstance()->GetGraphicsStateCache())
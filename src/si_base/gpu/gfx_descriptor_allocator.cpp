@@ -8,7 +8,6 @@ namespace SI
 {
 	GfxDescriptorAllocator::GfxDescriptorAllocator()
 		: m_maxDescriptorCount(0)
-		, m_allocatedDescriptorCount(0)
 		, m_typeSize(0)
 	{
 	}
@@ -29,17 +28,17 @@ namespace SI
 		desc.m_flag = GfxDescriptorHeapFlag::None;
 		m_heap = SI_DEVICE().CreateDescriptorHeap(desc);
 		m_baseDescriptor = GfxDescriptor(m_heap.GetCpuDescriptor(0), m_heap.GetGpuDescriptor(0));
-		m_endDescriptor = m_baseDescriptor + m_typeSize * m_maxDescriptorCount;
-		m_currentDescriptor = m_baseDescriptor;
+
+		m_slotAllocator.Initialize(maxDescriptorCount);
 	}
 	
 	void GfxDescriptorAllocator::Terminate()
 	{
 		if(m_heap.IsValid())
 		{
+			m_slotAllocator.Terminate();
 			SI_DEVICE().ReleaseDescriptorHeap(m_heap);
 			m_baseDescriptor = GfxDescriptor();
-			m_endDescriptor = GfxDescriptor();
 			m_maxDescriptorCount = 0;
 			m_typeSize = 0;
 		}
@@ -47,24 +46,28 @@ namespace SI
 	
 	GfxDescriptor GfxDescriptorAllocator::Allocate(uint32_t count)
 	{
-		MutexLocker locker(m_mutex);
-
-		if(m_maxDescriptorCount <= m_allocatedDescriptorCount+count)
+		uint32_t slot = m_slotAllocator.Allocate(count);
+		if(slot == kInvalidHandle)
 		{
-			SI_ASSERT(0);
+			SI_ASSERT(0, "ディスクリプタが足りない");
 			return GfxDescriptor();
 		}
-		m_allocatedDescriptorCount += count;
 
-		GfxDescriptor ret = m_currentDescriptor;
-		m_currentDescriptor += m_typeSize * count;
-		return ret;
+		return m_baseDescriptor + m_typeSize * slot;
 	}
 
 	void GfxDescriptorAllocator::Deallocate(GfxDescriptor descriptor)
 	{
-		MutexLocker locker(m_mutex);
-		// TODO: きちんと開放する...
+		size_t offset = descriptor.GetCpuDescriptor().m_ptr - m_baseDescriptor.GetCpuDescriptor().m_ptr;
+		SI_ASSERT(offset % m_typeSize == 0);
+
+		uint32_t slot = (uint32_t)(offset / m_typeSize);
+		m_slotAllocator.Deallocate(slot);
+	}
+
+	void GfxDescriptorAllocator::Flip(uint64_t currentFenceValue, uint64_t completedFenceValue)
+	{
+		m_slotAllocator.Flip(currentFenceValue, completedFenceValue);
 	}
 
 } // namespace SI
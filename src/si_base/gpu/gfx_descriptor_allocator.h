@@ -4,10 +4,11 @@
 #include "si_base/gpu/gfx_config.h"
 #include "si_base/memory/handle_allocator.h"
 #include "si_base/gpu/gfx_descriptor_heap.h"
-#include "si_base/concurency/mutex.h"
+#include "si_base/gpu/gfx_descriptor_slot_allocator.h"
 
 namespace SI
 {
+	// 開放されたディスクリプタは、そのフレームのGPU処理が終わるまで再利用しない.
 	class GfxDescriptorAllocator
 	{
 	public:
@@ -18,17 +19,20 @@ namespace SI
 		void Terminate();
 
 		GfxDescriptor Allocate(uint32_t count);
-		void Deallocate(GfxDescriptor descriptor);		
+		void Deallocate(GfxDescriptor descriptor);
+
+		// currentFenceValue: これから開放されるものに付けるフェンス値.
+		// completedFenceValue: GPU処理が終わったフェンス値. これ以下で開放されたものを再利用する.
+		void Flip(uint64_t currentFenceValue, uint64_t completedFenceValue);
+
+		uint32_t GetAllocatedDescriptorCount() const{ return m_slotAllocator.GetAllocatedSlotCount(); }
 
 	private:
-		uint32_t              m_maxDescriptorCount;
-		uint32_t              m_allocatedDescriptorCount;
-		GfxDescriptorHeap     m_heap;
-		GfxDescriptor         m_baseDescriptor;
-		GfxDescriptor         m_currentDescriptor;
-		GfxDescriptor         m_endDescriptor;
-		size_t                m_typeSize;
-		Mutex                 m_mutex;
+		uint32_t                    m_maxDescriptorCount;
+		GfxDescriptorHeap           m_heap;
+		GfxDescriptor               m_baseDescriptor;
+		size_t                      m_typeSize;
+		GfxDescriptorSlotAllocator  m_slotAllocator;
 	};
 
 } // namespace SI
@@ -0,0 +1,388 @@
+﻿
+#include "si_base/gpu/gfx_descriptor_slot_allocator.h"
+
+#include "si_base/core/core.h"
+
+namespace SI
+{
+	namespace
+	{
+		// アロケータのIDからキャッシュの番号を引く表. IDで比べて線形探索する.
+		struct DescriptorThreadCacheSlot
+		{
+			uint32_t m_allocatorId = 0;
+			uint32_t m_cacheIndex  = 0;
+		};
+
+		static const uint32_t kDescriptorThreadCacheSlotCount  = 16; // 2の累乗.
+		static const uint32_t kDescriptorThreadCacheProbeCount = 4;  // 探す範囲. 見つからず空きも無ければ先頭を上書きする.
+
+		thread_local DescriptorThreadCacheSlot t_descriptorCacheSlots[kDescriptorThreadCacheSlotCount];
+		AtomicUint32                           s_descriptorAllocatorIdCounter;
+	}
+
+	GfxDescriptorSlotAllocator::GfxDescriptorSlotAllocator()
+		: m_slotCount(0)
+		, m_id(0)
+		, m_allocatedSlotCount(0)
+		, m_currentFenceValue(0)
+		, m_threadCaches(nullptr)
+		, m_threadCacheCount(0)
+	{
+		for(uint32_t& head : m_freeHeads)
+		{
+			head = kInvalidHandle;
+		}
+	}
+
+	GfxDescriptorSlotAllocator::~GfxDescriptorSlotAllocator()
+	{
+		Terminate();
+	}
+
+	void GfxDescriptorSlotAllocator::Initialize(uint32_t slotCount)
+	{
+		SI_ASSERT(m_slotCount == 0);
+		SI_ASSERT(0 < slotCount && slotCount < kInvalidHandle);
+
+		m_slotCount = slotCount;
+		m_allocatedSlotCount.Store(0);
+		m_currentFenceValue = 0;
+
+		m_blockStates.assign(slotCount, (uint8_t)kNotBlock);
+		m_prevLinks.assign(slotCount, kInvalidHandle);
+		m_nextLinks.assign(slotCount, kInvalidHandle);
+		for(uint32_t& head : m_freeHeads)
+		{
+			head = kInvalidHandle;
+		}
+
+		// 2のべき乗でない場合は、先頭から取れる一番大きい整列したブロックに分けて空きにする.
+		uint32_t slot = 0;
+		while(slot < slotCount)
+		{
+			uint32_t order = 0;
+			while(order < kMaxOrder &&
+				(slot & ((2u << order) - 1)) == 0 &&
+				(uint64_t)slot + (2ull << order) <= slotCount)
+			{
+				++order;
+			}
+
+			PushFreeList(slot, order);
+			slot += 1u << order;
+		}
+
+		m_threadCaches = SI_NEW_ARRAY(ThreadCache, kMaxThreadCacheCount);
+		m_threadCacheCount.Store(0);
+
+		// 0は未登録の意味で使うので飛ばす.
+		uint32_t id = ++s_descriptorAllocatorIdCounter;
+		if(id == 0) id = ++s_descriptorAllocatorIdCounter;
+		m_id = id;
+	}
+
+	void GfxDescriptorSlotAllocator::Terminate()
+	{
+		if(m_slotCount == 0) return;
+
+		SI_DELETE_ARRAY(m_threadCaches);
+		m_threadCaches = nullptr;
+		m_threadCacheCount.Store(0);
+
+		m_pendingFrees.clear();
+		m_blockStates.clear();
+		m_prevLinks.clear();
+		m_nextLinks.clear();
+		for(uint32_t& head : m_freeHeads)
+		{
+			head = kInvalidHandle;
+		}
+
+		m_slotCount = 0;
+		m_id = 0;
+		m_allocatedSlotCount.Store(0);
+	}
+
+	uint32_t GfxDescriptorSlotAllocator::Allocate(uint32_t count)
+	{
+		SI_ASSERT(0 < m_slotCount);
+		SI_ASSERT(0 < count);
+
+		// 1スロットはスレッド毎のキャッシュから.
+		ThreadCache* cache = (count == 1)? GetThreadCache() : nullptr;
+		if(cache)
+		{
+			MutexLocker cacheLocker(cache->m_mutex);
+			if(cache->m_slots.empty())
+			{
+				MutexLocker locker(m_mutex);
+				for(uint32_t i=0; i<kThreadCacheRefill; ++i)
+				{
+					uint32_t slot = AllocateBlock(0);
+					if(slot == kInvalidHandle) break;
+					cache->m_slots.push_back(slot);
+				}
+			}
+
+			if(!cache->m_slots.empty())
+			{
+				uint32_t slot = cache->m_slots.back();
+				cache->m_slots.pop_back();
+				m_allocatedSlotCount += 1;
+				return slot;
+			}
+		}
+
+		uint32_t order = GetOrder(count);
+		if(kMaxOrder < order) return kInvalidHandle;
+
+		uint32_t slot = kInvalidHandle;
+		{
+			MutexLocker locker(m_mutex);
+			slot = AllocateBlock(order);
+		}
+
+		// 他のスレッドのキャッシュに残っている分を戻して、もう一度試す.
+		if(slot == kInvalidHandle && ReclaimThreadCaches() != 0)
+		{
+			MutexLocker locker(m_mutex);
+			slot = AllocateBlock(order);
+		}
+
+		if(slot == kInvalidHandle) return kInvalidHandle;
+
+		m_allocatedSlotCount += 1u << order;
+		return slot;
+	}
+
+	void GfxDescriptorSlotAllocator::Deallocate(uint32_t slot, uint64_t fenceValue)
+	{
+		if(!MarkPendingFree(slot)) return;
+
+		MutexLocker locker(m_pendingMutex);
+		SI_ASSERT(m_pendingFrees.empty() || m_pendingFrees.back().m_fenceValue <= fenceValue, "フェンス値は増えていく前提");
+
+		PendingFree pending;
+		pending.m_slot       = slot;
+		pending.m_fenceValue = fenceValue;
+		m_pendingFrees.push_back(pending);
+	}
+
+	void GfxDescriptorSlotAllocator::Deallocate(uint32_t slot)
+	{
+		if(!MarkPendingFree(slot)) return;
+
+		// Flipと同じロックの中でフェンス値を読むので、古い値が新しい値の後ろに積まれることはない.
+		MutexLocker locker(m_pendingMutex);
+
+		PendingFree pending;
+		pending.m_slot       = slot;
+		pending.m_fenceValue = m_currentFenceValue;
+		m_pendingFrees.push_back(pending);
+	}
+
+	void GfxDescriptorSlotAllocator::Retire(uint64_t completedFenceValue)
+	{
+		MutexLocker pendingLocker(m_pendingMutex);
+		if(m_pendingFrees.empty() || completedFenceValue < m_pendingFrees.front().m_fenceValue) return;
+
+		MutexLocker locker(m_mutex);
+		while(!m_pendingFrees.empty() && m_pendingFrees.front().m_fenceValue <= completedFenceValue)
+		{
+			uint32_t slot = m_pendingFrees.front().m_slot;
+			m_pendingFrees.pop_front();
+
+			uint32_t order = m_blockStates[slot] & kOrderMask;
+			m_blockStates[slot] = (uint8_t)order;
+			m_allocatedSlotCount -= 1u << order;
+			FreeBlock(slot);
+		}
+	}
+
+	void GfxDescriptorSlotAllocator::Flip(uint64_t currentFenceValue, uint64_t completedFenceValue)
+	{
+		{
+			MutexLocker locker(m_pendingMutex);
+			SI_ASSERT(m_currentFenceValue <= currentFenceValue, "フェンス値は増えていく前提");
+			m_currentFenceValue = currentFenceValue;
+		}
+
+		Retire(completedFenceValue);
+	}
+
+	uint32_t GfxDescriptorSlotAllocator::GetPendingCount()
+	{
+		MutexLocker locker(m_pendingMutex);
+		return (uint32_t)m_pendingFrees.size();
+	}
+
+	bool GfxDescriptorSlotAllocator::MarkPendingFree(uint32_t slot)
+	{
+		// Retireではスロットの状態からorderを取るので、おかしなスロットは積む前に落とす.
+		// 積んだ時点で印を付けておけば、Retire前の二重開放も分かる.
+		if(m_slotCount <= slot)
+		{
+			SI_WARNING(0, "範囲外のスロットを開放しようとした. slot=%u", slot);
+			return false;
+		}
+
+		MutexLocker locker(m_mutex);
+		uint8_t state = m_blockStates[slot];
+		if(state == kNotBlock || (state & (kFreeBit | kPendingBit)) != 0)
+		{
+			SI_WARNING(0, "確保したブロックの先頭でないか、開放済みのスロット. slot=%u", slot);
+			return false;
+		}
+
+		m_blockStates[slot] = (uint8_t)(state | kPendingBit);
+		return true;
+	}
+
+	uint32_t GfxDescriptorSlotAllocator::AllocateBlock(uint32_t order)
+	{
+		// 足りる大きさの空きブロックを探して、半分ずつに割っていく.
+		uint32_t foundOrder = order;
+		while(foundOrder <= kMaxOrder && m_freeHeads[foundOrder] == kInvalidHandle)
+		{
+			++foundOrder;
+		}
+		if(kMaxOrder < foundOrder) return kInvalidHandle;
+
+		uint32_t slot = m_freeHeads[foundOrder];
+		RemoveFreeList(slot, foundOrder);
+
+		while(order < foundOrder)
+		{
+			--foundOrder;
+			PushFreeList(slot + (1u << foundOrder), foundOrder);
+		}
+
+		m_blockStates[slot] = (uint8_t)order;
+		return slot;
+	}
+
+	void GfxDescriptorSlotAllocator::FreeBlock(uint32_t slot)
+	{
+		uint8_t state = m_blockStates[slot];
+		SI_ASSERT(state != kNotBlock && (state & kFreeBit) == 0, "開放済み");
+
+		// 相方も空いていれば、まとめて大きいブロックに戻す.
+		uint32_t order = state & kOrderMask;
+		while(order < kMaxOrder)
+		{
+			uint32_t buddy = slot ^ (1u << order);
+			if(m_slotCount <= buddy) break;
+			if(m_blockStates[buddy] != (kFreeBit | order)) break;
+
+			RemoveFreeList(buddy, order);
+			m_blockStates[Max(slot, buddy)] = kNotBlock;
+			slot = Min(slot, buddy);
+			++order;
+		}
+
+		PushFreeList(slot, order);
+	}
+
+	void GfxDescriptorSlotAllocator::PushFreeList(uint32_t slot, uint32_t order)
+	{
+		uint32_t head = m_freeHeads[order];
+		m_prevLinks[slot] = kInvalidHandle;
+		m_nextLinks[slot] = head;
+		if(head != kInvalidHandle)
+		{
+			m_prevLinks[head] = slot;
+		}
+		m_freeHeads[order] = slot;
+		m_blockStates[slot] = (uint8_t)(kFreeBit | order);
+	}
+
+	void GfxDescriptorSlotAllocator::RemoveFreeList(uint32_t slot, uint32_t order)
+	{
+		uint32_t prev = m_prevLinks[slot];
+		uint32_t next = m_nextLinks[slot];
+		if(prev != kInvalidHandle)
+		{
+			m_nextLinks[prev] = next;
+		}
+		else
+		{
+			m_freeHeads[order] = next;
+		}
+
+		if(next != kInvalidHandle)
+		{
+			m_prevLinks[next] = prev;
+		}
+
+		m_prevLinks[slot] = kInvalidHandle;
+		m_nextLinks[slot] = kInvalidHandle;
+		m_blockStates[slot] = (uint8_t)order;
+	}
+
+	uint32_t GfxDescriptorSlotAllocator::ReclaimThreadCaches()
+	{
+		uint32_t reclaimedCount = 0;
+
+		uint32_t cacheCount = Min(m_threadCacheCount.Load(), (uint32_t)kMaxThreadCacheCount);
+		for(uint32_t i=0; i<cacheCount; ++i)
+		{
+			ThreadCache& cache = m_threadCaches[i];
+			MutexLocker cacheLocker(cache.m_mutex);
+			if(cache.m_slots.empty()) continue;
+
+			MutexLocker locker(m_mutex);
+			for(uint32_t slot : cache.m_slots)
+			{
+				FreeBlock(slot);
+			}
+			reclaimedCount += (uint32_t)cache.m_slots.size();
+			cache.m_slots.clear();
+		}
+
+		return reclaimedCount;
+	}
+
+	GfxDescriptorSlotAllocator::ThreadCache* GfxDescriptorSlotAllocator::GetThreadCache()
+	{
+		const uint32_t mask = kDescriptorThreadCacheSlotCount - 1;
+		DescriptorThreadCacheSlot* emptySlot = nullptr;
+		for(uint32_t i=0; i<kDescriptorThreadCacheProbeCount; ++i)
+		{
+			DescriptorThreadCacheSlot& slot = t_descriptorCacheSlots[(m_id + i) & mask];
+			if(slot.m_allocatorId == m_id)
+			{
+				return &m_threadCaches[slot.m_cacheIndex];
+			}
+			if(slot.m_allocatorId == 0)
+			{
+				emptySlot = &slot;
+				break;
+			}
+		}
+
+		// このスレッドで初めて使うのでキャッシュを割り当てる.
+		uint32_t cacheIndex = m_threadCacheCount.FetchAdd(1);
+		if(kMaxThreadCacheCount <= cacheIndex)
+		{
+			m_threadCacheCount -= 1;
+			return nullptr;
+		}
+
+		DescriptorThreadCacheSlot& slot = emptySlot? *emptySlot : t_descriptorCacheSlots[m_id & mask];
+		slot.m_allocatorId = m_id;
+		slot.m_cacheIndex  = cacheIndex;
+		return &m_threadCaches[cacheIndex];
+	}
+
+	uint32_t GfxDescriptorSlotAllocator::GetOrder(uint32_t count)
+	{
+		uint32_t order = 0;
+		while(order <= kMaxOrder && (1u << order) < count)
+		{
+			++order;
+		}
+		return order;
+	}
+
+} // namespace SI
@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include "si_base/core/non_copyable.h"
+#include "si_base/concurency/atomic.h"
+#include "si_base/concurency/mutex.h"
+#include "si_base/memory/handle_allocator.h"
+
+namespace SI
+{
+	// ディスクリプタのスロット番号を管理するバディアロケータ. GPUには触らないので単体でテストできる.
+	// 開放はフェンス値付きで積んでおき、Retireでそのフェンスが終わったと分かってから再利用する.
+	// 1スロットの確保はスレッド毎のキャッシュから取るので、普段は共有のロックを取らない.
+	class GfxDescriptorSlotAllocator : private NonCopyable
+	{
+	public:
+		static const uint32_t kMaxOrder            = 31;
+		static const uint32_t kMaxThreadCacheCount = 16; // これを超えたスレッドはキャッシュを使わない.
+		static const uint32_t kThreadCacheRefill   = 16; // 1スロットのキャッシュに一度に補充する数.
+
+	public:
+		GfxDescriptorSlotAllocator();
+		~GfxDescriptorSlotAllocator();
+
+		void Initialize(uint32_t slotCount);
+		void Terminate();
+
+		// count個連続したスロットを確保する. 確保できなければkInvalidHandle.
+		uint32_t Allocate(uint32_t count);
+
+		// fenceValueのGPU処理が終わるまでは再利用しない.
+		// 確保したブロックの先頭でないスロットや、開放済みのスロットは警告を出して無視する.
+		void Deallocate(uint32_t slot, uint64_t fenceValue);
+
+		// Flipで設定したフェンス値で開放する. フェンス値の読み出しと積むのは同じロックの中で行う.
+		void Deallocate(uint32_t slot);
+
+		// completedFenceValue以下のフェンスで開放されたスロットを空きに戻す.
+		void Retire(uint64_t completedFenceValue);
+
+		// これから開放されるものに付けるフェンス値をcurrentFenceValueにしてからRetireする.
+		void Flip(uint64_t currentFenceValue, uint64_t completedFenceValue);
+
+		uint32_t GetSlotCount() const{ return m_slotCount; }
+		// 開放待ちを含む. スレッド毎のキャッシュに補充されて、まだ渡していないものは含まない.
+		uint32_t GetAllocatedSlotCount() const{ return m_allocatedSlotCount.Load(); }
+		uint32_t GetPendingCount();
+
+	private:
+		struct PendingFree
+		{
+			uint32_t m_slot;
+			uint64_t m_fenceValue;
+		};
+
+		// キャッシュラインを共有しないようにしておく.
+		struct alignas(64) ThreadCache
+		{
+			Mutex                 m_mutex; // 持ち主以外が触るのは、空きが無くなって回収する時だけ.
+			std::vector<uint32_t> m_slots;
+		};
+
+		static const uint8_t kFreeBit    = 0x80;
+		static const uint8_t kPendingBit = 0x40; // 開放待ちに積んである.
+		static const uint8_t kOrderMask  = 0x3f;
+		static const uint8_t kNotBlock   = 0x7f; // ブロックの先頭ではない.
+
+	private:
+		bool MarkPendingFree(uint32_t slot);
+		uint32_t AllocateBlock(uint32_t order);
+		void FreeBlock(uint32_t slot);
+		void PushFreeList(uint32_t slot, uint32_t order);
+		void RemoveFreeList(uint32_t slot, uint32_t order);
+		uint32_t ReclaimThreadCaches();
+		ThreadCache* GetThreadCache();
+
+		static uint32_t GetOrder(uint32_t count);
+
+	private:
+		uint32_t                 m_slotCount;
+		uint32_t                 m_id;              // スレッド側でキャッシュの割り当てを覚えておくためのID.
+		AtomicUint32             m_allocatedSlotCount;
+
+		Mutex                    m_mutex;           // バディの管理情報用.
+		std::vector<uint8_t>     m_blockStates;     // ブロック先頭のorderと空きフラグ.
+		std::vector<uint32_t>    m_prevLinks;       // 空きリストの双方向リンク.
+		std::vector<uint32_t>    m_nextLinks;
+		uint32_t                 m_freeHeads[kMaxOrder+1];
+
+		Mutex                    m_pendingMutex;
+		std::deque<PendingFree>  m_pendingFrees;    // フェンス値の順に並ぶ.
+		uint64_t                 m_currentFenceValue; // Deallocate(slot)で付けるフェンス値. m_pendingMutexで守る.
+
+		ThreadCache*             m_threadCaches;
+		AtomicUint32             m_threadCacheCount;
+	};
+
+} // namespace SI
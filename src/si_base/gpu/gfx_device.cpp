@@ -98,6 +98,21 @@ namespace SI
 		m_base->ReleaseGraphicsState(state.GetBaseGraphicsState());
 		state = GfxGraphicsState();
 	}
+
+	int GfxDevice::InitializePipelineLibrary(const void* data, size_t dataSize)
+	{
+		return m_base->InitializePipelineLibrary(data, dataSize);
+	}
+
+	void GfxDevice::TerminatePipelineLibrary()
+	{
+		m_base->TerminatePipelineLibrary();
+	}
+
+	int GfxDevice::SerializePipelineLibrary(std::vector<uint8_t>& outData)
+	{
+		return m_base->SerializePipelineLibrary(outData);
+	}
 	
 	GfxComputeState GfxDevice::CreateComputeState(const GfxComputeStateDesc& desc)
 	{
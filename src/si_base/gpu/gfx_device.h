@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <cstdint>
+#include <vector>
 #include "si_base/core/singleton.h"
 #include "si_base/gpu/gfx_declare.h"
 #include "si_base/gpu/gfx_descriptor_allocator.h"
@@ -35,6 +36,11 @@ namespace SI
 		GfxGraphicsState CreateGraphicsState(const GfxGraphicsStateDesc& desc);
 		void ReleaseGraphicsState(GfxGraphicsState& state);
 
+		// PSOのディスクキャッシュ. GfxGraphicsStateCacheから使う.
+		int  InitializePipelineLibrary(const void* data, size_t dataSize);
+		void TerminatePipelineLibrary();
+		int  SerializePipelineLibrary(std::vector<uint8_t>& outData);
+
 		GfxComputeState CreateComputeState(const GfxComputeStateDesc& desc);
 		void ReleaseComputeState(GfxComputeState& state);
 
@@ -435,6 +435,11 @@ namespace SI
 		SetVertexBuffer(slot, view);
 	}
 
+	GfxLinearAllocatorMemory GfxGraphicsContext::AllocateDynamicMemory(size_t size, size_t alignment)
+	{
+		return m_cpuLinearAllocator.Allocate(size, alignment);
+	}
+
 	void GfxGraphicsContext::SetDynamicIB16(size_t indexCount, const uint16_t* data)
 	{
 		size_t size = indexCount * sizeof(uint16_t);
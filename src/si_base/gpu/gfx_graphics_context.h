@@ -140,6 +140,10 @@ namespace SI
 		void SetDynamicVB    (uint32_t slot, size_t vertexCount, size_t stride, const void* data);
 		void SetDynamicIB16(size_t indexCount, const uint16_t* data);
 		void SetDynamicIB32(size_t indexCount, const uint32_t* data);
+
+		// このコンテキスト専用のCPU書き込み可能なメモリ. Resetまで有効.
+		// コンテキスト毎にページを持つので、別スレッドで別コンテキストを使う分にはロック不要.
+		GfxLinearAllocatorMemory AllocateDynamicMemory(size_t size, size_t alignment = 256);
 		
 		void Dispatch(
 		uint32_t threadGroupCountX,
@@ -6,49 +6,69 @@
 
 namespace SI
 {
-	uint64_t GfxGraphicsStateDescCore::GenerateHash() const
+	namespace
 	{
-		Hash64Generator hashGenerator;
-		if(m_name)          hashGenerator.Add(m_name);
-		// m_rootSignature 何かやる.
-		if(m_vertexShader)  hashGenerator.Add(m_vertexShader->GetHash());
-		if(m_pixelShader)   hashGenerator.Add(m_pixelShader->GetHash());
-		
-		for(int i=0; i<m_inputElementCount; ++i)
+		void AddDescToHash(Hash64Generator& hashGenerator, const GfxGraphicsStateDescCore& desc)
 		{
-			const GfxInputElement& e = m_inputElements[i];
-			if(e.m_semanticsName) hashGenerator.Add(e.m_semanticsName);
-			hashGenerator.Add(e.m_semanticsId);
-			hashGenerator.Add(e.m_format);
-			hashGenerator.Add(e.m_inputSlot);
-			hashGenerator.Add(e.m_alignedByteOffset);
-		}
+			if(desc.m_name)          hashGenerator.Add(desc.m_name);
+			if(desc.m_rootSignature) hashGenerator.Add(desc.m_rootSignature->GetHash());
+			if(desc.m_vertexShader)  hashGenerator.Add(desc.m_vertexShader->GetHash());
+			if(desc.m_pixelShader)   hashGenerator.Add(desc.m_pixelShader->GetHash());
 		
-		hashGenerator.Add(m_fillMode);
-		hashGenerator.Add(m_cullMode);
-		for(uint32_t i=0; i<m_renderTargetCount; ++i)
-		{
-			hashGenerator.Add(m_rtvFormats[i]);
-			hashGenerator.Add(m_rtvBlend[i]);
-		}
+			for(int i=0; i<desc.m_inputElementCount; ++i)
+			{
+				const GfxInputElement& e = desc.m_inputElements[i];
+				if(e.m_semanticsName) hashGenerator.Add(e.m_semanticsName);
+				hashGenerator.Add(e.m_semanticsId);
+				hashGenerator.Add(e.m_format);
+				hashGenerator.Add(e.m_inputSlot);
+				hashGenerator.Add(e.m_alignedByteOffset);
+			}
+		
+			hashGenerator.Add(desc.m_fillMode);
+			hashGenerator.Add(desc.m_cullMode);
+			for(uint32_t i=0; i<desc.m_renderTargetCount; ++i)
+			{
+				hashGenerator.Add(desc.m_rtvFormats[i]);
+				hashGenerator.Add(desc.m_rtvBlend[i]);
+			}
 		
-		hashGenerator.Add(m_dsvFormat);
-		hashGenerator.Add(m_primitiveTopologyType);
-		hashGenerator.Add(m_depthWriteMask);
-		hashGenerator.Add(m_depthFunc);
+			hashGenerator.Add(desc.m_dsvFormat);
+			hashGenerator.Add(desc.m_primitiveTopologyType);
+			hashGenerator.Add(desc.m_depthWriteMask);
+			hashGenerator.Add(desc.m_depthFunc);
 		
-		hashGenerator.Add(m_depthBias);
-		hashGenerator.Add(m_depthBiasClamp);
-		hashGenerator.Add(m_slopeScaledDepthBias);
+			hashGenerator.Add(desc.m_depthBias);
+			hashGenerator.Add(desc.m_depthBiasClamp);
+			hashGenerator.Add(desc.m_slopeScaledDepthBias);
 		
-		hashGenerator.Add(m_depthEnable);
-		hashGenerator.Add(m_stencilEnable);
-		hashGenerator.Add(m_alphaToCoverageEnable);
-		hashGenerator.Add(m_independentBlendEnable);
-		hashGenerator.Add(m_frontCounterClockwise);
+			hashGenerator.Add(desc.m_depthEnable);
+			hashGenerator.Add(desc.m_stencilEnable);
+			hashGenerator.Add(desc.m_alphaToCoverageEnable);
+			hashGenerator.Add(desc.m_independentBlendEnable);
+			hashGenerator.Add(desc.m_frontCounterClockwise);
+		}
+	}
 
+	uint64_t GfxGraphicsStateDescCore::GenerateHash() const
+	{
+		Hash64Generator hashGenerator;
+		AddDescToHash(hashGenerator, *this);
 		return hashGenerator.Generate();
 	}
+
+	Hash128 GfxGraphicsStateDescCore::GenerateHash128() const
+	{
+		// 下位はGenerateHashと同じ値. 上位は先頭に別の値を混ぜて、独立した64bitにする.
+		static const uint64_t kHighSalt = 0x9e3779b97f4a7c15ull;
+
+		Hash64Generator lowGenerator;
+		Hash64Generator highGenerator;
+		highGenerator.Add(kHighSalt);
+		AddDescToHash(lowGenerator,  *this);
+		AddDescToHash(highGenerator, *this);
+		return Hash128{ lowGenerator.Generate(), highGenerator.Generate() };
+	}
 	
 	bool GfxGraphicsStateDescCore::operator==(const GfxGraphicsStateDescCore& desc) const
 	{
@@ -62,7 +82,15 @@ namespace SI
 			if(desc.m_name) return false;
 		}
 		
-		// m_rootSignature 何かやる.
+		if(m_rootSignature)
+		{
+			if(!desc.m_rootSignature) return false;
+			if(m_rootSignature->GetHash() != desc.m_rootSignature->GetHash()) return false;
+		}
+		else
+		{
+			if(desc.m_rootSignature) return false;
+		}
 		
 		if(m_vertexShader)
 		{
@@ -78,6 +78,9 @@ namespace SI
 		bool                     m_frontCounterClockwise  = false;
 
 		Hash64 GenerateHash() const;
+
+		// キャッシュのキー用. 64bitの衝突で別のPSOを返さないように128bitにしたもの.
+		Hash128 GenerateHash128() const;
 		
 		bool operator==(const GfxGraphicsStateDescCore& desc) const;
 		bool operator!=(const GfxGraphicsStateDescCore& desc) const{ return !(*this==desc); }
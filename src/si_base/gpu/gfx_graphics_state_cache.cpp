@@ -0,0 +1,182 @@
+﻿
+#include "si_base/gpu/gfx_graphics_state_cache.h"
+
+#include <vector>
+#include "si_base/core/core.h"
+#include "si_base/file/file.h"
+#include "si_base/file/file_utility.h"
+#include "si_base/gpu/gfx_device.h"
+
+namespace SI
+{
+	GfxGraphicsStateCache::GfxGraphicsStateCache()
+		: m_hitCount(0)
+		, m_missCount(0)
+		, m_initialized(false)
+	{
+	}
+
+	GfxGraphicsStateCache::~GfxGraphicsStateCache()
+	{
+		Terminate();
+	}
+
+	void GfxGraphicsStateCache::Initialize(const GfxGraphicsStateCacheDesc& desc)
+	{
+		SI_ASSERT(!m_initialized);
+
+		GfxDevice& device = *GfxDevice::GetInstance();
+
+		if(desc.m_filePath)
+		{
+			m_filePath = desc.m_filePath;
+
+			// 無ければ空のライブラリから始める.
+			std::vector<uint8_t> data;
+			if(FileUtility::Load(data, desc.m_filePath) != 0)
+			{
+				data.clear();
+			}
+
+			device.InitializePipelineLibrary(data.empty()? nullptr : data.data(), data.size());
+		}
+
+		m_hitCount    = 0;
+		m_missCount   = 0;
+		m_initialized = true;
+	}
+
+	void GfxGraphicsStateCache::Terminate()
+	{
+		if(!m_initialized) return;
+
+		Save();
+
+		GfxDevice& device = *GfxDevice::GetInstance();
+		for(auto& pair : m_entries)
+		{
+			Entry& entry = pair.second;
+			SI_ASSERT(entry.m_refCount == 0, "GraphicsStateの解放漏れ");
+			device.ReleaseGraphicsState(entry.m_state);
+		}
+		m_entries.clear();
+		m_stateHashes.clear();
+
+		if(!m_filePath.empty())
+		{
+			device.TerminatePipelineLibrary();
+			m_filePath.clear();
+		}
+
+		m_initialized = false;
+	}
+
+	GfxGraphicsState GfxGraphicsStateCache::Acquire(const GfxGraphicsStateDesc& desc)
+	{
+		SI_ASSERT(m_initialized);
+
+		Hash128 hash = desc.GenerateHash128();
+		{
+			MutexLocker locker(m_mutex);
+			auto it = m_entries.find(hash);
+			if(it != m_entries.end())
+			{
+				++it->second.m_refCount;
+				++m_hitCount;
+				return it->second.m_state;
+			}
+		}
+
+		// PSOの作成は重いので、ロックの外で行う.
+		GfxDevice& device = *GfxDevice::GetInstance();
+		GfxGraphicsState created = device.CreateGraphicsState(desc);
+		if(!created.IsValid()) return created;
+
+		GfxGraphicsState result;
+		bool isDuplicated = false;
+		{
+			MutexLocker locker(m_mutex);
+			auto inserted = m_entries.emplace(hash, Entry());
+			Entry& entry = inserted.first->second;
+			if(inserted.second)
+			{
+				entry.m_state = created;
+				m_stateHashes[created.GetBaseGraphicsState()] = hash;
+				++m_missCount;
+			}
+			else
+			{
+				// 他のスレッドが先に登録した.
+				isDuplicated = true;
+				++m_hitCount;
+			}
+
+			++entry.m_refCount;
+			result = entry.m_state;
+		}
+
+		if(isDuplicated)
+		{
+			device.ReleaseGraphicsState(created);
+		}
+
+		return result;
+	}
+
+	void GfxGraphicsStateCache::Release(GfxGraphicsState& state)
+	{
+		if(!state.IsValid()) return;
+
+		MutexLocker locker(m_mutex);
+
+		auto hashIt = m_stateHashes.find(state.GetBaseGraphicsState());
+		SI_ASSERT(hashIt != m_stateHashes.end(), "キャッシュから取得したGraphicsStateではない");
+		if(hashIt != m_stateHashes.end())
+		{
+			Entry& entry = m_entries[hashIt->second];
+			SI_ASSERT(0 < entry.m_refCount);
+			--entry.m_refCount;
+		}
+
+		state = GfxGraphicsState();
+	}
+
+	int GfxGraphicsStateCache::Save()
+	{
+		if(m_filePath.empty()) return 0;
+
+		GfxDevice& device = *GfxDevice::GetInstance();
+		std::vector<uint8_t> data;
+		if(device.SerializePipelineLibrary(data) != 0) return -1;
+		if(data.empty()) return 0;
+
+		File file;
+		if(file.Open(m_filePath.c_str(), FileAccessType::Write) != 0) return -1;
+
+		int64_t writtenSize = 0;
+		int ret = file.Write(data.data(), (int64_t)data.size(), &writtenSize);
+		file.Close();
+		if(ret != 0 || writtenSize != (int64_t)data.size()) return -1;
+
+		return 0;
+	}
+
+	uint32_t GfxGraphicsStateCache::GetStateCount() const
+	{
+		MutexLocker locker(m_mutex);
+		return (uint32_t)m_entries.size();
+	}
+
+	uint32_t GfxGraphicsStateCache::GetHitCount() const
+	{
+		MutexLocker locker(m_mutex);
+		return m_hitCount;
+	}
+
+	uint32_t GfxGraphicsStateCache::GetMissCount() const
+	{
+		MutexLocker locker(m_mutex);
+		return m_missCount;
+	}
+
+} // namespace SI
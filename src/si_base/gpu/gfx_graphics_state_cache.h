@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "si_base/core/non_copyable.h"
+#include "si_base/concurency/mutex.h"
+#include "si_base/misc/hash_declare.h"
+#include "si_base/gpu/gfx_graphics_state.h"
+
+namespace SI
+{
+	struct GfxGraphicsStateCacheDesc
+	{
+		const char* m_filePath = nullptr; // PSOのディスクキャッシュ. nullptrなら保存しない.
+	};
+
+	// 記述(GfxGraphicsStateDescCore::GenerateHash128)が同じPSOを共有するキャッシュ.
+	// Acquire/Releaseはどのスレッドから呼んでも良い.
+	// 参照が無くなってもGPUが使っている可能性があるので、Terminateまで破棄しない.
+	class GfxGraphicsStateCache : private NonCopyable
+	{
+	public:
+		GfxGraphicsStateCache();
+		~GfxGraphicsStateCache();
+
+		void Initialize(const GfxGraphicsStateCacheDesc& desc);
+		void Terminate();
+		bool IsInitialized() const{ return m_initialized; }
+
+		GfxGraphicsState Acquire(const GfxGraphicsStateDesc& desc);
+		void Release(GfxGraphicsState& state);
+
+		// ディスクキャッシュを書き出す. Terminateからも呼ばれる.
+		int Save();
+
+		uint32_t GetStateCount() const;
+		uint32_t GetHitCount()   const;
+		uint32_t GetMissCount()  const;
+
+	private:
+		struct Entry
+		{
+			GfxGraphicsState m_state;
+			uint32_t         m_refCount = 0;
+		};
+
+		struct KeyHasher
+		{
+			size_t operator()(const Hash128& key) const{ return (size_t)key.m_low; }
+		};
+
+		mutable Mutex                                   m_mutex;
+		std::unordered_map<Hash128, Entry, KeyHasher>   m_entries;
+		std::unordered_map<const void*, Hash128>        m_stateHashes; // Release時にEntryを引くため.
+		std::string                                     m_filePath;
+		uint32_t                                        m_hitCount;
+		uint32_t                                        m_missCount;
+		bool                                            m_initialized;
+	};
+
+} // namespace SI
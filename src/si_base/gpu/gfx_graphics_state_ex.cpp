@@ -1,7 +1,7 @@
 ﻿
 #include "si_base/gpu/gfx_graphics_state_ex.h"
 
-#include "si_base/gpu/gfx_device.h"
+#include "si_base/gpu/gfx_core.h"
 
 namespace SI
 {
@@ -17,14 +17,17 @@ namespace SI
 
 	void GfxGraphicsStateEx::Initialize(const GfxGraphicsStateDesc& desc)
 	{
-		GfxDevice& device = *GfxDevice::GetInstance();
-		m_state = device.CreateGraphicsState(desc);
+		// 同じ記述のPSOは共有する.
+		GfxGraphicsState state = SI_GRAPHICS_STATE_CACHE().Acquire(desc);
+		Terminate();
+		m_state = state;
 	}
 
 	void GfxGraphicsStateEx::Terminate()
 	{
-		GfxDevice& device = *GfxDevice::GetInstance();
-		device.ReleaseGraphicsState(m_state);
+		if(!m_state.IsValid()) return;
+
+		SI_GRAPHICS_STATE_CACHE().Release(m_state);
 	}
 
 } // namespace SI
@@ -9,7 +9,6 @@ namespace SI
 {
 	GfxResourceStatesPool::GfxResourceStatesPool()
 		: m_maxStateCount(0)
-		, m_allocatedStateCount(0)
 		, m_handleAllocator()
 		, m_stateItemArray(nullptr)
 		, m_maxAllocatedStateCount(0)
@@ -28,7 +27,7 @@ namespace SI
 		SI_ASSERT(m_stateItemArray==nullptr);
 
 		m_maxStateCount = maxStateCount;
-		m_allocatedStateCount = 0;
+		m_maxAllocatedStateCount.Store(0);
 
 		m_handleAllocator.Initialize(m_maxStateCount);
 
@@ -39,7 +38,7 @@ namespace SI
 	{
 		if(m_stateItemArray)
 		{
-			SI_ASSERT(m_allocatedStateCount==0, "開放忘れ");
+			SI_ASSERT(m_handleAllocator.GetAllocatedCount()==0, "開放忘れ");
 
 			SI_DELETE_ARRAY(m_stateItemArray);
 			m_stateItemArray = nullptr;
@@ -47,7 +46,6 @@ namespace SI
 			m_handleAllocator.Terminate();
 
 			m_maxStateCount = 0;
-			m_allocatedStateCount = 0;
 		}
 	}
 
@@ -63,9 +61,10 @@ namespace SI
 
 		m_stateItemArray[handle] = StatesItem(gpuResource, initialStates);
 
-		m_maxAllocatedStateCount = Max(m_maxAllocatedStateCount, handle+1);
-
-		++m_allocatedStateCount;
+		uint32_t maxCount = m_maxAllocatedStateCount.Load();
+		while(maxCount < handle+1 && !m_maxAllocatedStateCount.CompareExchange(maxCount, handle+1))
+		{
+		}
 	}
 	
 	void GfxResourceStatesPool::DeallocateHandle(GfxGpuResource* gpuResource)
@@ -77,8 +76,6 @@ namespace SI
 
 		m_handleAllocator.Deallocate(handle);
 		gpuResource->SetResourceStateHandle(kInvalidHandle);
-
-		--m_allocatedStateCount;
 	}
 	
 	void GfxResourceStatesPool::SetResourceStates(uint32_t resourceStateHanlde, GfxResourceStates states)
@@ -1,13 +1,14 @@
 ﻿#pragma once
 
 #include "si_base/gpu/gfx_enum.h"
-#include "si_base/memory/handle_allocator.h"
+#include "si_base/memory/concurrent_handle_allocator.h"
 
 namespace SI
 {
 	class GfxGpuResource;
 
 	// 今のGpuResourceのStateを管理するためのPool
+	// ハンドルの確保・開放は複数スレッドから同時に呼んでもよい.
 	class GfxResourceStatesPool
 	{
 	public:
@@ -27,7 +28,7 @@ namespace SI
 		GfxGpuResource*   GetGpuResource(uint32_t resourceStateHanlde);
 		
 		uint32_t GetMaxStateCount() const{ return m_maxStateCount; }
-		uint32_t GetMaxAllocatedStateCount() const{ return m_maxAllocatedStateCount; }
+		uint32_t GetMaxAllocatedStateCount() const{ return m_maxAllocatedStateCount.Load(); }
 
 	private:
 		class StatesItem
@@ -50,11 +51,10 @@ namespace SI
 		};
 
 	private:
-		uint32_t              m_maxStateCount;
-		uint32_t              m_allocatedStateCount;
-		HandleAllocator       m_handleAllocator;
-		StatesItem*           m_stateItemArray;
-		uint32_t              m_maxAllocatedStateCount;
+		uint32_t                   m_maxStateCount;
+		ConcurrentHandleAllocator  m_handleAllocator;
+		StatesItem*                m_stateItemArray;
+		AtomicUint32               m_maxAllocatedStateCount;
 	};
 
 } // namespace SI
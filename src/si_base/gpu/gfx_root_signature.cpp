@@ -13,4 +13,9 @@ namespace SI
 		return m_base->GetNative();
 	}
 
+	Hash64 GfxRootSignature::GetHash() const
+	{
+		return m_base->GetHash();
+	}
+
 } // namespace SI
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include "si_base/gpu/gfx_enum.h"
 #include "si_base/core/assert.h"
+#include "si_base/misc/hash_declare.h"
 
 namespace SI
 {
@@ -131,6 +132,7 @@ namespace SI
 
 
 		void* GetNative();
+		Hash64 GetHash() const;
 
 	public:
 		BaseRootSignature*       GetBaseRootSignature()      { return m_base; }
@@ -1,10 +1,12 @@
 ﻿#pragma once
 
-#include <xmmintrin.h>
 #include <cstdint>
 
 #include "si_base/core/constant.h"
+#include "si_base/core/assert.h"
 #include "si_base/math/vfloat3.h"
+#include "si_base/math/vfloat4.h"
+#include "si_base/math/vfloat4x4.h"
 
 namespace SI
 {
@@ -22,9 +24,10 @@ namespace SI
 
 		void SetMinMax(Vfloat3_arg aabbMin, Vfloat3_arg aabbMax)
 		{
-			SI_ASSERT(aabbMin.Xf() < aabbMax.Xf());
-			SI_ASSERT(aabbMin.Yf() < aabbMax.Yf());
-			SI_ASSERT(aabbMin.Zf() < aabbMax.Zf());
+			// 平面のメッシュもあるので、厚さ0は許可する.
+			SI_ASSERT(aabbMin.Xf() <= aabbMax.Xf());
+			SI_ASSERT(aabbMin.Yf() <= aabbMax.Yf());
+			SI_ASSERT(aabbMin.Zf() <= aabbMax.Zf());
 
 			m_min = aabbMin;
 			m_max = aabbMax;
@@ -32,9 +35,9 @@ namespace SI
 
 		void SetCenterExtend(Vfloat3_arg aabbCenter, Vfloat3_arg aabbExtend)
 		{
-			SI_ASSERT(0.0f < aabbExtend.Xf());
-			SI_ASSERT(0.0f < aabbExtend.Yf());
-			SI_ASSERT(0.0f < aabbExtend.Zf());
+			SI_ASSERT(0.0f <= aabbExtend.Xf());
+			SI_ASSERT(0.0f <= aabbExtend.Yf());
+			SI_ASSERT(0.0f <= aabbExtend.Zf());
 
 			m_min = aabbCenter - aabbExtend;
 			m_max = aabbCenter + aabbExtend;
@@ -45,6 +48,24 @@ namespace SI
 		Vfloat3 GetCenter() const{ return Vfloat(0.5f) * (m_min + m_max); }
 		Vfloat3 GetExtend() const{ return Vfloat(0.5f) * (m_max - m_min); }
 
+		// mで変換した箱を囲むAABBを返す.
+		Aabb Transform(Vfloat4x4_arg m) const
+		{
+			Vfloat3 center = Math::Multiply(GetCenter(), m);
+			Vfloat3 extend = GetExtend();
+
+			// 各軸の半径を、行列の各行の絶対値で広げる.
+			Vfloat3 newExtend =
+				extend.X() * Math::Abs(m.GetRow(0).XYZ()) +
+				extend.Y() * Math::Abs(m.GetRow(1).XYZ()) +
+				extend.Z() * Math::Abs(m.GetRow(2).XYZ());
+
+			Aabb ret;
+			ret.m_min = center - newExtend;
+			ret.m_max = center + newExtend;
+			return ret;
+		}
+
 	private:
 		Vfloat3 m_min;
 		Vfloat3 m_max;
@@ -0,0 +1,127 @@
+﻿#pragma once
+
+#include <cstdint>
+#include "si_base/core/assert.h"
+#include "si_base/math/math_internal.h"
+#include "si_base/math/vfloat3.h"
+#include "si_base/math/vfloat4.h"
+#include "si_base/math/vfloat4x4.h"
+#include "si_base/math/aabb.h"
+
+namespace SI
+{
+	// 視錐台. ビュー射影行列から6平面を取り出して、AABBとの判定をする.
+	class Frustum
+	{
+	public:
+		enum PlaneType
+		{
+			kPlane_Left = 0,
+			kPlane_Right,
+			kPlane_Bottom,
+			kPlane_Top,
+			kPlane_Near,
+			kPlane_Far,
+
+			kPlane_Max
+		};
+
+	public:
+		Frustum()
+		{
+			Set(Vfloat4x4::Identity());
+		}
+
+		// 行ベクトル(v * viewProj)で、クリップ空間が-w<=x<=w, -w<=y<=w, 0<=z<=wのもの.
+		// 平面は内側が正になる向き.
+		void Set(Vfloat4x4_arg viewProj)
+		{
+			Vfloat4 c0 = viewProj.GetColumn(0);
+			Vfloat4 c1 = viewProj.GetColumn(1);
+			Vfloat4 c2 = viewProj.GetColumn(2);
+			Vfloat4 c3 = viewProj.GetColumn(3);
+
+			m_planes[kPlane_Left]   = c3 + c0;
+			m_planes[kPlane_Right]  = c3 - c0;
+			m_planes[kPlane_Bottom] = c3 + c1;
+			m_planes[kPlane_Top]    = c3 - c1;
+			m_planes[kPlane_Near]   = c2;
+			m_planes[kPlane_Far]    = c3 - c2;
+
+			// 判定用に4平面ずつSoAに並べ替える. 2組目の余りはLeft/Rightで埋める.
+			static const uint32_t kOrder[kGroupCount * 4] =
+			{
+				kPlane_Left, kPlane_Right, kPlane_Bottom, kPlane_Top,
+				kPlane_Near, kPlane_Far,   kPlane_Left,   kPlane_Right,
+			};
+
+			for(uint32_t g=0; g<kGroupCount; ++g)
+			{
+				_SiFloat128 nx, ny, nz, d;
+				for(uint32_t i=0; i<4; ++i)
+				{
+					const Vfloat4& plane = m_planes[kOrder[g*4 + i]];
+					nx.m_f[i] = plane.Xf();
+					ny.m_f[i] = plane.Yf();
+					nz.m_f[i] = plane.Zf();
+					d.m_f[i]  = plane.Wf();
+				}
+
+				m_nx[g] = nx;
+				m_ny[g] = ny;
+				m_nz[g] = nz;
+				m_d[g]  = d;
+				m_absNx[g] = _si_mm_and_ps(nx, kSiUint128_AbsMask);
+				m_absNy[g] = _si_mm_and_ps(ny, kSiUint128_AbsMask);
+				m_absNz[g] = _si_mm_and_ps(nz, kSiUint128_AbsMask);
+			}
+		}
+
+		// 箱が一部でも内側にあればtrue. 判定は保守的で、角の外側にある箱をtrueにすることはある.
+		bool IsVisible(Vfloat3_arg center, Vfloat3_arg extend) const
+		{
+			__si128 cx = _si_mm_shuffle_ps(center.Get128(), center.Get128(), _SI_MM_SHUFFLE(0,0,0,0));
+			__si128 cy = _si_mm_shuffle_ps(center.Get128(), center.Get128(), _SI_MM_SHUFFLE(1,1,1,1));
+			__si128 cz = _si_mm_shuffle_ps(center.Get128(), center.Get128(), _SI_MM_SHUFFLE(2,2,2,2));
+			__si128 ex = _si_mm_shuffle_ps(extend.Get128(), extend.Get128(), _SI_MM_SHUFFLE(0,0,0,0));
+			__si128 ey = _si_mm_shuffle_ps(extend.Get128(), extend.Get128(), _SI_MM_SHUFFLE(1,1,1,1));
+			__si128 ez = _si_mm_shuffle_ps(extend.Get128(), extend.Get128(), _SI_MM_SHUFFLE(2,2,2,2));
+
+			__si128 outside = kSiFloat128_0000;
+			for(uint32_t g=0; g<kGroupCount; ++g)
+			{
+				// 平面までの距離 + 平面の法線方向への箱の半径 が負なら完全に外側.
+				__si128 dist = _si_mm_fmadd_ps(cx, m_nx[g], _si_mm_fmadd_ps(cy, m_ny[g], _si_mm_fmadd_ps(cz, m_nz[g], m_d[g])));
+				__si128 dr   = _si_mm_fmadd_ps(ex, m_absNx[g], _si_mm_fmadd_ps(ey, m_absNy[g], _si_mm_fmadd_ps(ez, m_absNz[g], dist)));
+				outside = _si_mm_or_ps(outside, _si_mm_cmplt_ps(dr, kSiFloat128_0000));
+			}
+
+			return _si_mm_movemask_epi8(_si_mm_castps_si128(outside)) == 0;
+		}
+
+		bool IsVisible(const Aabb& aabb) const
+		{
+			return IsVisible(aabb.GetCenter(), aabb.GetExtend());
+		}
+
+		const Vfloat4& GetPlane(PlaneType type) const
+		{
+			SI_ASSERT(type < kPlane_Max);
+			return m_planes[type];
+		}
+
+	private:
+		static const uint32_t kGroupCount = 2;
+
+		Vfloat4 m_planes[kPlane_Max];
+
+		__si128 m_nx[kGroupCount];
+		__si128 m_ny[kGroupCount];
+		__si128 m_nz[kGroupCount];
+		__si128 m_d [kGroupCount];
+		__si128 m_absNx[kGroupCount];
+		__si128 m_absNy[kGroupCount];
+		__si128 m_absNz[kGroupCount];
+	};
+
+} // namespace SI
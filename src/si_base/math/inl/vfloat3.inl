@@ -1,6 +1,5 @@
 ﻿#pragma once
 
-#include <smmintrin.h>
 
 #include "si_base/math/vfloat3.h"
 
@@ -28,21 +27,21 @@ namespace SI
 		
 	inline Vfloat3::Vfloat3(Vfloat x, Vfloat y, Vfloat z)
 		: m_v(
-			_mm_shuffle_ps(
-				_mm_shuffle_ps(x.Get128(), y.Get128(), _MM_SHUFFLE(0,0,0,0)),
-				_mm_shuffle_ps(z.Get128(), z.Get128(), _MM_SHUFFLE(0,0,0,0)),
-				_MM_SHUFFLE(2,0,2,0))
+			_si_mm_shuffle_ps(
+				_si_mm_shuffle_ps(x.Get128(), y.Get128(), _SI_MM_SHUFFLE(0,0,0,0)),
+				_si_mm_shuffle_ps(z.Get128(), z.Get128(), _SI_MM_SHUFFLE(0,0,0,0)),
+				_SI_MM_SHUFFLE(2,0,2,0))
 		)
 	{
 	}
 	
 	inline Vfloat3::Vfloat3(float value)
-		: m_v(_mm_set1_ps(value))
+		: m_v(_si_mm_set1_ps(value))
 	{
 	}
 	
 	inline Vfloat3::Vfloat3(Vfloat_arg value)
-		: m_v(_mm_shuffle_ps(value.Get128(), value.Get128(), 0))
+		: m_v(_si_mm_shuffle_ps(value.Get128(), value.Get128(), 0))
 	{
 	}
 	
@@ -51,43 +50,43 @@ namespace SI
 	{
 	}
 
-	inline Vfloat3::Vfloat3(__m128 v)
+	inline Vfloat3::Vfloat3(__si128 v)
 		: m_v(v)
 	{
 	}
 
 	inline void Vfloat3::SetX(Vfloat_arg x)
 	{
-		m_v = _mm_blend_ps(m_v, x.Get128(), 0b0001);
+		m_v = _si_mm_blend_ps(m_v, x.Get128(), 0b0001);
 	}
 
 	inline void Vfloat3::SetY(Vfloat_arg y)
 	{
-		__m128 _y = _mm_shuffle_ps(y.Get128(), y.Get128(), 0);
-		m_v = _mm_blend_ps(m_v, _y, 0b0010);
+		__si128 _y = _si_mm_shuffle_ps(y.Get128(), y.Get128(), 0);
+		m_v = _si_mm_blend_ps(m_v, _y, 0b0010);
 	}
 		
 	inline void Vfloat3::SetZ(Vfloat_arg z)
 	{
-		__m128 _z = _mm_shuffle_ps(z.Get128(), z.Get128(), 0);
-		m_v = _mm_blend_ps(m_v, _z, 0b0100);
+		__si128 _z = _si_mm_shuffle_ps(z.Get128(), z.Get128(), 0);
+		m_v = _si_mm_blend_ps(m_v, _z, 0b0100);
 	}
 
 	inline void Vfloat3::SetElement(uint32_t elementIndex, Vfloat_arg e)
 	{
 		SI_ASSERT(elementIndex<3);
-		__m128 _e = _mm_shuffle_ps(e.Get128(), e.Get128(), 0);
+		__si128 _e = _si_mm_shuffle_ps(e.Get128(), e.Get128(), 0);
 		m_v = _si_mm_blend(m_v, _e, 1<<elementIndex);
 	}
 
 	inline void Vfloat3::Set(float value)
 	{
-		m_v = _mm_set1_ps(value);
+		m_v = _si_mm_set1_ps(value);
 	}
 
 	inline void Vfloat3::Set(Vfloat_arg value)
 	{
-		m_v = _mm_shuffle_ps(value.Get128(), value.Get128(), 0);
+		m_v = _si_mm_shuffle_ps(value.Get128(), value.Get128(), 0);
 	}
 		
 	inline void Vfloat3::Set(const float* v)
@@ -102,10 +101,10 @@ namespace SI
 
 	inline void Vfloat3::Set(Vfloat_arg x, Vfloat_arg y, Vfloat_arg z)
 	{
-		__m128 xxyy = _mm_shuffle_ps(x.Get128(), y.Get128(), _MM_SHUFFLE(0,0,0,0));
-		__m128 zzzz = _mm_shuffle_ps(z.Get128(), z.Get128(), _MM_SHUFFLE(0,0,0,0));
+		__si128 xxyy = _si_mm_shuffle_ps(x.Get128(), y.Get128(), _SI_MM_SHUFFLE(0,0,0,0));
+		__si128 zzzz = _si_mm_shuffle_ps(z.Get128(), z.Get128(), _SI_MM_SHUFFLE(0,0,0,0));
 
-		m_v = _mm_shuffle_ps(xxyy, zzzz, _MM_SHUFFLE(2,0,2,0));
+		m_v = _si_mm_shuffle_ps(xxyy, zzzz, _SI_MM_SHUFFLE(2,0,2,0));
 	}
 
 	inline Vfloat Vfloat3::X() const
@@ -115,12 +114,12 @@ namespace SI
 
 	inline Vfloat Vfloat3::Y() const
 	{
-		return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1,1,1,1)) );
+		return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(1,1,1,1)) );
 	}
 
 	inline Vfloat Vfloat3::Z() const
 	{
-		return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2,2,2,2)) );
+		return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(2,2,2,2)) );
 	}
 	
 	inline float Vfloat3::Xf() const
@@ -144,11 +143,11 @@ namespace SI
 		switch(elementIndex)
 		{
 		case 0:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(0,0,0,0)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(0,0,0,0)) );
 		case 1:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1,1,1,1)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(1,1,1,1)) );
 		case 2:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2,2,2,2)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(2,2,2,2)) );
 		}
 
 		return Vfloat(kSiFloat128_0000);
@@ -156,33 +155,33 @@ namespace SI
 	template<uint32_t xIndex, uint32_t yIndex, uint32_t zIndex>
 	inline Vfloat3 Vfloat3::Swizzle() const
 	{
-		return Vfloat3( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(0, zIndex, yIndex, xIndex)) );
+		return Vfloat3( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(0, zIndex, yIndex, xIndex)) );
 	}
 
 	inline Vfloat3 Vfloat3::Swizzle(uint32_t xIndex, uint32_t yIndex, uint32_t zIndex) const
 	{
-		__m128 xyzwArray[3] = 
+		__si128 xyzwArray[3] = 
 		{
 			m_v,
-			_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1,1,1,1)),
-			_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2,2,2,2)),
+			_si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(1,1,1,1)),
+			_si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(2,2,2,2)),
 		};
 
 		return Vfloat3(
-			_mm_shuffle_ps(
-				_mm_shuffle_ps(xyzwArray[xIndex], xyzwArray[yIndex], 0),
-				_mm_shuffle_ps(xyzwArray[zIndex], kSiFloat128_0000, 0),
-				_MM_SHUFFLE(2,0,2,0)));
+			_si_mm_shuffle_ps(
+				_si_mm_shuffle_ps(xyzwArray[xIndex], xyzwArray[yIndex], 0),
+				_si_mm_shuffle_ps(xyzwArray[zIndex], kSiFloat128_0000, 0),
+				_SI_MM_SHUFFLE(2,0,2,0)));
 	}
 
 	inline Vfloat4 Vfloat3::XYZ0() const
 	{
-		Vfloat4(_mm_blend_ps(m_v, kSiFloat128_0000, 0b1000));
+		return Vfloat4(_si_mm_blend_ps(m_v, kSiFloat128_0000, 0b1000));
 	}
 
 	inline Vfloat4 Vfloat3::XYZ1() const
 	{
-		Vfloat4(_mm_blend_ps(m_v, kSiFloat128_1111, 0b1000));
+		return Vfloat4(_si_mm_blend_ps(m_v, kSiFloat128_1111, 0b1000));
 	}
 
 	inline Vfloat Vfloat3::LengthSqr() const
@@ -211,6 +210,7 @@ namespace SI
 		p.m_v[0] = X().AsFloat();
 		p.m_v[1] = Y().AsFloat();
 		p.m_v[2] = Z().AsFloat();
+		return p;
 	}
 	
 	inline Vfloat3& Vfloat3::operator=(const Vfloat3& v)
@@ -221,7 +221,7 @@ namespace SI
 
 	inline Vfloat3 Vfloat3::operator-() const
 	{
-		return Vfloat3( _mm_sub_ps( kSiFloat128_0000, Get128() ) );
+		return Vfloat3( _si_mm_sub_ps( kSiFloat128_0000, Get128() ) );
 	}
 
 	inline const Vfloat Vfloat3::operator[](size_t i) const // [] operatorは代入を許可しないようにしておく.
@@ -231,22 +231,22 @@ namespace SI
 
 	inline Vfloat3 Vfloat3::operator+(Vfloat3_arg v) const
 	{
-		return Vfloat3(_mm_add_ps(m_v, v.m_v));
+		return Vfloat3(_si_mm_add_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat3 Vfloat3::operator-(Vfloat3_arg v) const
 	{
-		return Vfloat3(_mm_sub_ps(m_v, v.m_v));
+		return Vfloat3(_si_mm_sub_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat3 Vfloat3::operator*(Vfloat3_arg v) const
 	{
-		return Vfloat3(_mm_mul_ps(m_v, v.m_v));
+		return Vfloat3(_si_mm_mul_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat3 Vfloat3::operator/(Vfloat3_arg v) const
 	{
-		return Vfloat3(_mm_div_ps(m_v, v.m_v));
+		return Vfloat3(_si_mm_div_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat3 Vfloat3::operator*(Vfloat_arg f) const
@@ -317,8 +317,8 @@ namespace SI
 
 	inline bool Vfloat3::operator==(const Vfloat3& v) const
 	{
-		__m128 cmp = _mm_cmpeq_ps(m_v, v.m_v);
-		uint16_t mask = (uint16_t)_mm_movemask_epi8(_mm_castps_si128(cmp));
+		__si128 cmp = _si_mm_cmpeq_ps(m_v, v.m_v);
+		uint16_t mask = (uint16_t)_si_mm_movemask_epi8(_si_mm_castps_si128(cmp));
 		return ((mask&0x0fff) == 0x0fff);
 	}
 
@@ -352,7 +352,7 @@ namespace SI
 		return Vfloat3(kSiFloat128_0010.m_v);
 	}
 	
-	inline __m128 Vfloat3::Get128() const
+	inline __si128 Vfloat3::Get128() const
 	{
 		return m_v;
 	}
@@ -383,89 +383,89 @@ namespace SI
 	{
 		inline Vfloat3 Min(Vfloat3_arg a, Vfloat3_arg b)
 		{
-			return Vfloat3(_mm_min_ps(a.Get128(), b.Get128()));
+			return Vfloat3(_si_mm_min_ps(a.Get128(), b.Get128()));
 		}
 
 		inline Vfloat3 Max(Vfloat3_arg a, Vfloat3_arg b)
 		{
-			return Vfloat3(_mm_max_ps(a.Get128(), b.Get128()));
+			return Vfloat3(_si_mm_max_ps(a.Get128(), b.Get128()));
 		}		
 
 		inline Vfloat HorizontalMin(Vfloat3_arg a)
 		{
-			__m128 zzzz = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(2, 2, 2, 2));
-			__m128 xz_yz_zz  = _mm_min_ps(a.Get128(), zzzz);
-			__m128 yyyy = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_min_ss(xz_yz_zz, yyyy));
+			__si128 zzzz = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(2, 2, 2, 2));
+			__si128 xz_yz_zz  = _si_mm_min_ps(a.Get128(), zzzz);
+			__si128 yyyy = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_min_ss(xz_yz_zz, yyyy));
 		}
 
 		inline Vfloat HorizontalMax(Vfloat3_arg a)
 		{
-			__m128 zzzz = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(2, 2, 2, 2));
-			__m128 xz_yz_zz  = _mm_max_ps(a.Get128(), zzzz);
-			__m128 yyyy = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_max_ss(xz_yz_zz, yyyy));
+			__si128 zzzz = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(2, 2, 2, 2));
+			__si128 xz_yz_zz  = _si_mm_max_ps(a.Get128(), zzzz);
+			__si128 yyyy = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_max_ss(xz_yz_zz, yyyy));
 		}
 
 		inline Vfloat HorizontalAdd(Vfloat3_arg a)
 		{
-			__m128 zzzz = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(2, 2, 2, 2));
-			__m128 xz_yz_xz_yz = _mm_add_ps(a.Get128(), zzzz);
-			__m128 yyyy = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_add_ss(xz_yz_xz_yz, yyyy));
+			__si128 zzzz = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(2, 2, 2, 2));
+			__si128 xz_yz_xz_yz = _si_mm_add_ps(a.Get128(), zzzz);
+			__si128 yyyy = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_add_ss(xz_yz_xz_yz, yyyy));
 		}
 
 		inline Vfloat HorizontalMul(Vfloat3_arg a)
 		{
-			__m128 zzzz = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(2, 2, 2, 2));
-			__m128 xz_yz_xz_yz = _mm_mul_ps(a.Get128(), zzzz);
-			__m128 yyyy = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_mul_ss(xz_yz_xz_yz, yyyy));
+			__si128 zzzz = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(2, 2, 2, 2));
+			__si128 xz_yz_xz_yz = _si_mm_mul_ps(a.Get128(), zzzz);
+			__si128 yyyy = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_mul_ss(xz_yz_xz_yz, yyyy));
 		}
 
 		inline Vfloat3 Abs(Vfloat3_arg a)
 		{
-			return Vfloat3(_mm_and_ps(a.Get128(), kSiUint128_AbsMask));
+			return Vfloat3(_si_mm_and_ps(a.Get128(), kSiUint128_AbsMask));
 		}
 
 		inline Vfloat3 Sqrt(Vfloat3_arg a)
 		{
-			return Vfloat3(_mm_sqrt_ps(a.Get128()));
+			return Vfloat3(_si_mm_sqrt_ps(a.Get128()));
 		}
 
 		inline Vfloat3 Rsqrt(Vfloat3_arg a)
 		{
-			return Vfloat3(_mm_rsqrt_ps(a.Get128()));
+			return Vfloat3(_si_mm_rsqrt_ps(a.Get128()));
 		}
 
 		inline Vfloat3 Rcp(Vfloat3_arg a)
 		{
-			return Vfloat3(_mm_rcp_ps(a.Get128()));
+			return Vfloat3(_si_mm_rcp_ps(a.Get128()));
 		}
 		
 		inline Vfloat Dot(Vfloat3_arg a, Vfloat3_arg b)
 		{
-			return Vfloat(_mm_dp_ps( a.Get128(), b.Get128(), 0b01111111)); // 0b01111111 = w無視したdot
+			return Vfloat(_si_mm_dp_ps( a.Get128(), b.Get128(), 0b01111111)); // 0b01111111 = w無視したdot
 		}
 
 		inline Vfloat3 Cross(Vfloat3_arg a, Vfloat3_arg b)
 		{
-			__m128 yzxw0 = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(3, 0, 2, 1));
-			__m128 zxyw1 = _mm_shuffle_ps(b.Get128(), b.Get128(), _MM_SHUFFLE(3, 1, 0, 2));
+			__si128 yzxw0 = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(3, 0, 2, 1));
+			__si128 zxyw1 = _si_mm_shuffle_ps(b.Get128(), b.Get128(), _SI_MM_SHUFFLE(3, 1, 0, 2));
 
-			__m128 p = _mm_mul_ps(yzxw0, zxyw1);
+			__si128 p = _si_mm_mul_ps(yzxw0, zxyw1);
 		
-			__m128 zxyw0 = _mm_shuffle_ps(a.Get128(), a.Get128(), _MM_SHUFFLE(3, 1, 0, 2));
-			__m128 yzxw1 = _mm_shuffle_ps(b.Get128(), b.Get128(), _MM_SHUFFLE(3, 0, 2, 1));
+			__si128 zxyw0 = _si_mm_shuffle_ps(a.Get128(), a.Get128(), _SI_MM_SHUFFLE(3, 1, 0, 2));
+			__si128 yzxw1 = _si_mm_shuffle_ps(b.Get128(), b.Get128(), _SI_MM_SHUFFLE(3, 0, 2, 1));
 		
-			__m128 m = _mm_mul_ps(zxyw0, yzxw1);
+			__si128 m = _si_mm_mul_ps(zxyw0, yzxw1);
 
-			return Vfloat3(_mm_sub_ps(p, m));
+			return Vfloat3(_si_mm_sub_ps(p, m));
 		}
 
 		inline Vfloat LengthSqr(Vfloat3_arg a)
 		{
-			return Vfloat( _mm_dp_ps(a.Get128(), a.Get128(), 0b01111111) ); // 0b01111111 = w無視したdot
+			return Vfloat( _si_mm_dp_ps(a.Get128(), a.Get128(), 0b01111111) ); // 0b01111111 = w無視したdot
 		}
 
 		inline Vfloat Length   (Vfloat3_arg a)
@@ -476,13 +476,13 @@ namespace SI
 
 		inline Vfloat3 Normalize (Vfloat3_arg a)
 		{
-			__m128 lengthSqrA = _mm_dp_ps(a.Get128(), a.Get128(), 0b01111111);
+			__si128 lengthSqrA = _si_mm_dp_ps(a.Get128(), a.Get128(), 0b01111111);
 
 			static const _SiFloat128 kSmallValue = {{{0.00001f, 0.00001f, 0.00001f, 0.00001f}}};
-			lengthSqrA = _mm_max_ps(lengthSqrA, kSmallValue); // 0割りerror対策.
-			__m128 lengthA = _mm_sqrt_ps(lengthSqrA);
+			lengthSqrA = _si_mm_max_ps(lengthSqrA, kSmallValue); // 0割りerror対策.
+			__si128 lengthA = _si_mm_sqrt_ps(lengthSqrA);
 
-			return Vfloat3( _mm_div_ps(a.Get128(), lengthA) );
+			return Vfloat3( _si_mm_div_ps(a.Get128(), lengthA) );
 		}
 
 		inline Vfloat3 NormalizeFast(Vfloat3_arg a)
@@ -493,9 +493,9 @@ namespace SI
 
 		inline Vfloat3 Floor(Vfloat3_arg a)
 		{
-			__m128i int128 = _mm_cvtps_epi32(a.Get128());
-			__m128 float128 = _mm_cvtepi32_ps(int128);
-			__m128 floor128 = _mm_sub_ps(float128, _mm_and_ps(_mm_cmplt_ps(a.Get128(), float128), kSiFloat128_1111));
+			__si128i int128 = _si_mm_cvtps_epi32(a.Get128());
+			__si128 float128 = _si_mm_cvtepi32_ps(int128);
+			__si128 floor128 = _si_mm_sub_ps(float128, _si_mm_and_ps(_si_mm_cmplt_ps(a.Get128(), float128), kSiFloat128_1111));
 
 			return Vfloat3(floor128);
 		}
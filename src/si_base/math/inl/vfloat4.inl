@@ -2,8 +2,6 @@
 
 #include "si_base/math/vfloat4.h"
 
-#include <xmmintrin.h>
-#include <smmintrin.h>
 #include "si_base/math/vfloat.h"
 #include "si_base/math/vfloat3.h"
 #include "si_base/math/vfloat4x4.h"
@@ -28,94 +26,94 @@ namespace SI
 		
 	inline Vfloat4::Vfloat4(Vfloat x, Vfloat y, Vfloat z, Vfloat w)
 		: m_v(
-			_mm_shuffle_ps(
-				_mm_shuffle_ps(x.Get128(), y.Get128(), 0),
-				_mm_shuffle_ps(z.Get128(), w.Get128(), 0),
-				_MM_SHUFFLE(2,0,2,0))
+			_si_mm_shuffle_ps(
+				_si_mm_shuffle_ps(x.Get128(), y.Get128(), 0),
+				_si_mm_shuffle_ps(z.Get128(), w.Get128(), 0),
+				_SI_MM_SHUFFLE(2,0,2,0))
 		)
 	{
 	}
 	
 	inline Vfloat4::Vfloat4(Vfloat3 xyz, Vfloat w)
 		: m_v(
-			_mm_blend_ps(
+			_si_mm_blend_ps(
 				xyz.Get128(),
-				_mm_shuffle_ps(w.Get128(), w.Get128(), 0),
+				_si_mm_shuffle_ps(w.Get128(), w.Get128(), 0),
 				0b1000))
 	{
 	}
 	
 	inline Vfloat4::Vfloat4(Vfloat3 xyz, float w)
 		: m_v(
-			_mm_blend_ps(
+			_si_mm_blend_ps(
 				xyz.Get128(),
-				_mm_set1_ps(w),
+				_si_mm_set1_ps(w),
 				0b1000))
 	{
 	}
 		
 	inline Vfloat4::Vfloat4(float value)
-		: m_v(_mm_set1_ps(value))
+		: m_v(_si_mm_set1_ps(value))
 	{
 	}
 		
 	inline Vfloat4::Vfloat4(Vfloat_arg value)
-		: m_v(_mm_shuffle_ps(value.Get128(), value.Get128(), 0))
+		: m_v(_si_mm_shuffle_ps(value.Get128(), value.Get128(), 0))
 	{
 	}
 		
 	inline Vfloat4::Vfloat4(const float* v)
-		: m_v(_mm_load_ps(v))
+		: m_v(_si_mm_load_ps(v))
 	{
 	}
 
-	inline Vfloat4::Vfloat4(__m128 v)
+	inline Vfloat4::Vfloat4(__si128 v)
 		: m_v(v)
 	{
 	}
 		
 	inline void Vfloat4::SetX(Vfloat_arg x)
 	{
-		m_v = _mm_blend_ps(m_v, x.Get128(), 0b0001);
+		m_v = _si_mm_blend_ps(m_v, x.Get128(), 0b0001);
 	}
 
 	inline void Vfloat4::SetY(Vfloat_arg y)
 	{
-		__m128 _y = _mm_shuffle_ps(y.Get128(), y.Get128(), 0);
-		m_v = _mm_blend_ps(m_v, _y, 0b0010);
+		__si128 _y = _si_mm_shuffle_ps(y.Get128(), y.Get128(), 0);
+		m_v = _si_mm_blend_ps(m_v, _y, 0b0010);
 	}
 		
 	inline void Vfloat4::SetZ(Vfloat_arg z)
 	{
-		__m128 _z = _mm_shuffle_ps(z.Get128(), z.Get128(), 0);
-		m_v = _mm_blend_ps(m_v, _z, 0b0100);
+		__si128 _z = _si_mm_shuffle_ps(z.Get128(), z.Get128(), 0);
+		m_v = _si_mm_blend_ps(m_v, _z, 0b0100);
 	}
 
 	inline void Vfloat4::SetW(Vfloat_arg w)
 	{
-		__m128 _w = _mm_shuffle_ps(w.Get128(), w.Get128(), 0);
-		m_v = _mm_blend_ps(m_v, _w, 0b1000);
+		__si128 _w = _si_mm_shuffle_ps(w.Get128(), w.Get128(), 0);
+		m_v = _si_mm_blend_ps(m_v, _w, 0b1000);
 	}
 
 	inline void Vfloat4::SetElement(uint32_t elementIndex, Vfloat_arg e)
 	{
-		__m128 _e = _mm_shuffle_ps(e.Get128(), e.Get128(), 0);
+		__si128 _e = _si_mm_shuffle_ps(e.Get128(), e.Get128(), 0);
 		m_v = _si_mm_blend(m_v, _e, 1<<elementIndex);
 	}
 
 	inline void Vfloat4::Set(float value)
 	{
-		m_v = _mm_set1_ps(value);
+		m_v = _si_mm_set1_ps(value);
 	}
 
 	inline void Vfloat4::Set(Vfloat_arg value)
 	{
-		m_v = _mm_shuffle_ps(value.Get128(), value.Get128(), 0);
+		m_v = _si_mm_shuffle_ps(value.Get128(), value.Get128(), 0);
 	}
 		
 	inline void Vfloat4::Set(const float* v)
 	{
-		m_v = _mm_load_ps(v);
+		m_v = _si_mm_load_ps(v);
 	}
 
 	inline void Vfloat4::Set(float x, float y, float z, float w)
@@ -125,10 +123,10 @@ namespace SI
 
 	inline void Vfloat4::Set(Vfloat_arg x, Vfloat_arg y, Vfloat_arg z, Vfloat_arg w)
 	{
-		__m128 xxyy = _mm_shuffle_ps(x.Get128(), y.Get128(), _MM_SHUFFLE(0,0,0,0));
-		__m128 zzww = _mm_shuffle_ps(z.Get128(), w.Get128(), _MM_SHUFFLE(0,0,0,0));
+		__si128 xxyy = _si_mm_shuffle_ps(x.Get128(), y.Get128(), _SI_MM_SHUFFLE(0,0,0,0));
+		__si128 zzww = _si_mm_shuffle_ps(z.Get128(), w.Get128(), _SI_MM_SHUFFLE(0,0,0,0));
 
-		m_v = _mm_shuffle_ps(xxyy, zzww, _MM_SHUFFLE(2,0,2,0));
+		m_v = _si_mm_shuffle_ps(xxyy, zzww, _SI_MM_SHUFFLE(2,0,2,0));
 	}
 	
 	inline Vfloat Vfloat4::X() const
@@ -138,17 +136,17 @@ namespace SI
 
 	inline Vfloat Vfloat4::Y() const
 	{
-		return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1,1,1,1)) );
+		return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(1,1,1,1)) );
 	}
 
 	inline Vfloat Vfloat4::Z() const
 	{
-		return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2,2,2,2)) );
+		return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(2,2,2,2)) );
 	}
 
 	inline Vfloat Vfloat4::W() const
 	{
-		return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(3,3,3,3)) );
+		return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(3,3,3,3)) );
 	}
 	
 	inline float Vfloat4::Xf() const
@@ -177,13 +175,13 @@ namespace SI
 		switch(elementIndex)
 		{
 		case 0:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(0,0,0,0)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(0,0,0,0)) );
 		case 1:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1,1,1,1)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(1,1,1,1)) );
 		case 2:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2,2,2,2)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(2,2,2,2)) );
 		case 3:
-			return Vfloat( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(3,3,3,3)) );
+			return Vfloat( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(3,3,3,3)) );
 		}
 
 		return Vfloat(kSiFloat128_0000);
@@ -192,24 +190,24 @@ namespace SI
 	template<uint32_t xIndex, uint32_t yIndex, uint32_t zIndex, uint32_t wIndex>
 	inline Vfloat4 Vfloat4::Swizzle() const
 	{
-		return Vfloat4( _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(wIndex, zIndex, yIndex, xIndex)) );
+		return Vfloat4( _si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(wIndex, zIndex, yIndex, xIndex)) );
 	}
 
 	inline Vfloat4 Vfloat4::Swizzle(uint32_t xIndex, uint32_t yIndex, uint32_t zIndex, uint32_t wIndex) const
 	{
-		__m128 xyzwArray[4] = 
+		__si128 xyzwArray[4] = 
 		{
 			m_v,
-			_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1,1,1,1)),
-			_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2,2,2,2)),
-			_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(3,3,3,3))
+			_si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(1,1,1,1)),
+			_si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(2,2,2,2)),
+			_si_mm_shuffle_ps(m_v, m_v, _SI_MM_SHUFFLE(3,3,3,3))
 		};
 
 		return Vfloat4(
-			_mm_shuffle_ps(
-				_mm_shuffle_ps(xyzwArray[xIndex], xyzwArray[yIndex], 0),
-				_mm_shuffle_ps(xyzwArray[zIndex], xyzwArray[wIndex], 0),
-				_MM_SHUFFLE(2,0,2,0)));
+			_si_mm_shuffle_ps(
+				_si_mm_shuffle_ps(xyzwArray[xIndex], xyzwArray[yIndex], 0),
+				_si_mm_shuffle_ps(xyzwArray[zIndex], xyzwArray[wIndex], 0),
+				_SI_MM_SHUFFLE(2,0,2,0)));
 	}
 
 	inline Vfloat3 Vfloat4::XYZ() const
@@ -219,12 +217,12 @@ namespace SI
 	
 	inline Vfloat4 Vfloat4::XYZ0() const
 	{
-		Vfloat4(_mm_blend_ps(m_v, kSiFloat128_0000, 0b1000));
+		return Vfloat4(_si_mm_blend_ps(m_v, kSiFloat128_0000, 0b1000));
 	}
 
 	inline Vfloat4 Vfloat4::XYZ1() const
 	{
-		Vfloat4(_mm_blend_ps(m_v, kSiFloat128_1111, 0b1000));
+		return Vfloat4(_si_mm_blend_ps(m_v, kSiFloat128_1111, 0b1000));
 	}
 	
 	inline Vfloat4 Vfloat4::Multiply(Vfloat4x4_arg m) const
@@ -260,7 +258,7 @@ namespace SI
 	
 	inline Vfloat4 Vfloat4::operator-() const
 	{
-		return Vfloat4( _mm_sub_ps( kSiFloat128_0000, Get128() ) );
+		return Vfloat4( _si_mm_sub_ps( kSiFloat128_0000, Get128() ) );
 	}
 
 	inline const Vfloat Vfloat4::operator[](size_t i) const // [] operatorは代入を許可しないようにしておく.
@@ -270,22 +268,22 @@ namespace SI
 
 	inline Vfloat4 Vfloat4::operator+(Vfloat4_arg v) const
 	{
-		return Vfloat4(_mm_add_ps(m_v, v.m_v));
+		return Vfloat4(_si_mm_add_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat4 Vfloat4::operator-(Vfloat4_arg v) const
 	{
-		return Vfloat4(_mm_sub_ps(m_v, v.m_v));
+		return Vfloat4(_si_mm_sub_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat4 Vfloat4::operator*(Vfloat4_arg v) const
 	{
-		return Vfloat4(_mm_mul_ps(m_v, v.m_v));
+		return Vfloat4(_si_mm_mul_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat4 Vfloat4::operator/(Vfloat4_arg v) const
 	{
-		return Vfloat4(_mm_div_ps(m_v, v.m_v));
+		return Vfloat4(_si_mm_div_ps(m_v, v.m_v));
 	}
 
 	inline Vfloat4 Vfloat4::operator*(Vfloat_arg f) const
@@ -356,8 +354,8 @@ namespace SI
 	
 	inline bool Vfloat4::operator==(const Vfloat4& v) const
 	{
-		__m128 cmp = _mm_cmpeq_ps(m_v, v.m_v);
-		uint16_t mask = (uint16_t)_mm_movemask_epi8(_mm_castps_si128(cmp));
+		__si128 cmp = _si_mm_cmpeq_ps(m_v, v.m_v);
+		uint16_t mask = (uint16_t)_si_mm_movemask_epi8(_si_mm_castps_si128(cmp));
 		return (mask == 0xffff);
 	}
 
@@ -396,7 +394,7 @@ namespace SI
 		return Vfloat4(kSiFloat128_0001.m_v);
 	}
 
-	inline __m128 Vfloat4::Get128() const
+	inline __si128 Vfloat4::Get128() const
 	{
 		return m_v;
 	}
@@ -427,69 +425,74 @@ namespace SI
 	{
 		inline Vfloat4 Min(Vfloat4_arg a, Vfloat4_arg b)
 		{
-			return Vfloat4(_mm_min_ps(a.Get128(), b.Get128()));
+			return Vfloat4(_si_mm_min_ps(a.Get128(), b.Get128()));
 		}
 
 		inline Vfloat4 Max(Vfloat4_arg a, Vfloat4_arg b)
 		{
-			return Vfloat4(_mm_max_ps(a.Get128(), b.Get128()));
+			return Vfloat4(_si_mm_max_ps(a.Get128(), b.Get128()));
 		}
 
 		inline Vfloat HorizontalMin(Vfloat4_arg a)
 		{
-			__m128 zwzw = _mm_movehl_ps(a.Get128(), a.Get128());
-			__m128 xz_yw  = _mm_min_ps(a.Get128(), zwzw);
-			__m128 yw_yw_yw_yw = _mm_shuffle_ps(xz_yw, xz_yw, _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_min_ss(xz_yw, yw_yw_yw_yw));
+			__si128 zwzw = _si_mm_movehl_ps(a.Get128(), a.Get128());
+			__si128 xz_yw  = _si_mm_min_ps(a.Get128(), zwzw);
+			__si128 yw_yw_yw_yw = _si_mm_shuffle_ps(xz_yw, xz_yw, _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_min_ss(xz_yw, yw_yw_yw_yw));
 		}
 
 		inline Vfloat HorizontalMax(Vfloat4_arg a)
 		{
-			__m128 zwzw = _mm_movehl_ps(a.Get128(), a.Get128());
-			__m128 xz_yw  = _mm_max_ps(a.Get128(), zwzw);
-			__m128 yw_yw_yw_yw = _mm_shuffle_ps(xz_yw, xz_yw, _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_max_ss(xz_yw, yw_yw_yw_yw));
+			__si128 zwzw = _si_mm_movehl_ps(a.Get128(), a.Get128());
+			__si128 xz_yw  = _si_mm_max_ps(a.Get128(), zwzw);
+			__si128 yw_yw_yw_yw = _si_mm_shuffle_ps(xz_yw, xz_yw, _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_max_ss(xz_yw, yw_yw_yw_yw));
 		}
 
 		inline Vfloat HorizontalAdd(Vfloat4_arg a)
 		{
-			__m128 zwzw = _mm_movehl_ps(a.Get128(), a.Get128());
-			__m128 xz_yw_xz_yw = _mm_add_ps(a.Get128(), zwzw);
-			__m128 yw_yw_yw_yw = _mm_shuffle_ps(xz_yw_xz_yw, xz_yw_xz_yw, _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_add_ss(xz_yw_xz_yw, yw_yw_yw_yw));
+			__si128 zwzw = _si_mm_movehl_ps(a.Get128(), a.Get128());
+			__si128 xz_yw_xz_yw = _si_mm_add_ps(a.Get128(), zwzw);
+			__si128 yw_yw_yw_yw = _si_mm_shuffle_ps(xz_yw_xz_yw, xz_yw_xz_yw, _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_add_ss(xz_yw_xz_yw, yw_yw_yw_yw));
 		}
 
 		inline Vfloat HorizontalMul(Vfloat4_arg a)
 		{
-			__m128 zwzw = _mm_movehl_ps(a.Get128(), a.Get128());
-			__m128 xz_yw_xz_yw = _mm_mul_ps(a.Get128(), zwzw);
-			__m128 yw_yw_yw_yw = _mm_shuffle_ps(xz_yw_xz_yw, xz_yw_xz_yw, _MM_SHUFFLE(1, 1, 1, 1));
-			return Vfloat(_mm_mul_ss(xz_yw_xz_yw, yw_yw_yw_yw));
+			__si128 zwzw = _si_mm_movehl_ps(a.Get128(), a.Get128());
+			__si128 xz_yw_xz_yw = _si_mm_mul_ps(a.Get128(), zwzw);
+			__si128 yw_yw_yw_yw = _si_mm_shuffle_ps(xz_yw_xz_yw, xz_yw_xz_yw, _SI_MM_SHUFFLE(1, 1, 1, 1));
+			return Vfloat(_si_mm_mul_ss(xz_yw_xz_yw, yw_yw_yw_yw));
 		}
 
 		inline Vfloat4 Abs(Vfloat4_arg a)
 		{
-			return Vfloat4(_mm_and_ps(a.Get128(), kSiUint128_AbsMask));
+			return Vfloat4(_si_mm_and_ps(a.Get128(), kSiUint128_AbsMask));
 		}
 
 		inline Vfloat4 Sqrt(Vfloat4_arg a)
 		{
-			return Vfloat4(_mm_sqrt_ps(a.Get128()));
+			return Vfloat4(_si_mm_sqrt_ps(a.Get128()));
 		}
 
 		inline Vfloat4 Rsqrt(Vfloat4_arg a)
 		{
-			return Vfloat4(_mm_rsqrt_ps(a.Get128()));
+			return Vfloat4(_si_mm_rsqrt_ps(a.Get128()));
 		}
 
 		inline Vfloat4 Rcp(Vfloat4_arg a)
 		{
-			return Vfloat4(_mm_rcp_ps(a.Get128()));
+			return Vfloat4(_si_mm_rcp_ps(a.Get128()));
 		}
 
 		inline Vfloat LengthSqr(Vfloat4_arg a)
 		{
-			return Vfloat( _mm_dp_ps(a.Get128(), a.Get128(), 0xff) );
+			return Vfloat( _si_mm_dp_ps(a.Get128(), a.Get128(), 0xff) );
+		}
+
+		inline Vfloat Dot(Vfloat4_arg a, Vfloat4_arg b)
+		{
+			return Vfloat( _si_mm_dp_ps(a.Get128(), b.Get128(), 0xff) );
 		}
 
 		inline Vfloat Length(Vfloat4_arg a)
@@ -500,13 +503,13 @@ namespace SI
 
 		inline Vfloat4 Normalize(Vfloat4_arg a)
 		{
-			__m128 lengthSqrA = _mm_dp_ps(a.Get128(), a.Get128(), 0xff);
+			__si128 lengthSqrA = _si_mm_dp_ps(a.Get128(), a.Get128(), 0xff);
 
 			static const _SiFloat128 kSmallValue = {{{0.00001f, 0.00001f, 0.00001f, 0.00001f}}};
-			lengthSqrA = _mm_max_ps(lengthSqrA, kSmallValue); // 0割りerror対策.
-			__m128 lengthA = _mm_sqrt_ps(lengthSqrA);
+			lengthSqrA = _si_mm_max_ps(lengthSqrA, kSmallValue); // 0割りerror対策.
+			__si128 lengthA = _si_mm_sqrt_ps(lengthSqrA);
 
-			return Vfloat4( _mm_div_ps(a.Get128(), lengthA) );
+			return Vfloat4( _si_mm_div_ps(a.Get128(), lengthA) );
 		}
 
 		inline Vfloat4 NormalizeFast(Vfloat4_arg a)
@@ -517,9 +520,9 @@ namespace SI
 
 		inline Vfloat4 Floor(Vfloat4_arg a)
 		{
-			__m128i int128 = _mm_cvtps_epi32(a.Get128());
-			__m128 float128 = _mm_cvtepi32_ps(int128);
-			__m128 floor128 = _mm_sub_ps(float128, _mm_and_ps(_mm_cmplt_ps(a.Get128(), float128), kSiFloat128_1111));
+			__si128i int128 = _si_mm_cvtps_epi32(a.Get128());
+			__si128 float128 = _si_mm_cvtepi32_ps(int128);
+			__si128 floor128 = _si_mm_sub_ps(float128, _si_mm_and_ps(_si_mm_cmplt_ps(a.Get128(), float128), kSiFloat128_1111));
 
 			return Vfloat4(floor128);
 		}
@@ -3,8 +3,6 @@
 #include "si_base/math/vfloat4x4.h"
 
 #include <cstdint>
-#include <xmmintrin.h>
-#include <smmintrin.h>
 #include "si_base/core/assert.h"
 #include "si_base/math/vfloat.h"
 #include "si_base/math/vfloat4.h"
@@ -44,29 +42,29 @@ namespace SI
 	inline Vfloat4x4::Vfloat4x4(
 		Vfloat4x3_arg m)
 	{
-		const __m128 zero = kSiFloat128_0000;
-		m_row[0] = _mm_blend_ps(m.GetRow128(0), zero, 0b1000);
-		m_row[1] = _mm_blend_ps(m.GetRow128(1), zero, 0b1000);
-		m_row[2] = _mm_blend_ps(m.GetRow128(2), zero, 0b1000);
-		m_row[3] = _mm_blend_ps(m.GetRow128(3), kSiFloat128_1111, 0b1000);
+		const __si128 zero = kSiFloat128_0000;
+		m_row[0] = _si_mm_blend_ps(m.GetRow128(0), zero, 0b1000);
+		m_row[1] = _si_mm_blend_ps(m.GetRow128(1), zero, 0b1000);
+		m_row[2] = _si_mm_blend_ps(m.GetRow128(2), zero, 0b1000);
+		m_row[3] = _si_mm_blend_ps(m.GetRow128(3), kSiFloat128_1111, 0b1000);
 	}
 
 	inline Vfloat4x4::Vfloat4x4(
 		Vfloat3x3_arg rot,
 		Vfloat3_arg trans)
 	{
-		const __m128 zero = kSiFloat128_0000;
-		m_row[0] = _mm_blend_ps(rot.GetRow128(0), zero, 0b1000);
-		m_row[1] = _mm_blend_ps(rot.GetRow128(1), zero, 0b1000);
-		m_row[2] = _mm_blend_ps(rot.GetRow128(2), zero, 0b1000);
-		m_row[3] = _mm_blend_ps(trans.Get128(), kSiFloat128_1111, 0b1000);
+		const __si128 zero = kSiFloat128_0000;
+		m_row[0] = _si_mm_blend_ps(rot.GetRow128(0), zero, 0b1000);
+		m_row[1] = _si_mm_blend_ps(rot.GetRow128(1), zero, 0b1000);
+		m_row[2] = _si_mm_blend_ps(rot.GetRow128(2), zero, 0b1000);
+		m_row[3] = _si_mm_blend_ps(trans.Get128(), kSiFloat128_1111, 0b1000);
 	}
 
 	inline Vfloat4x4::Vfloat4x4(
-		__m128 row0,
-		__m128 row1,
-		__m128 row2,
-		__m128 row3)
+		__si128 row0,
+		__si128 row1,
+		__si128 row2,
+		__si128 row3)
 	{
 		m_row[0] = row0;
 		m_row[1] = row1;
@@ -76,10 +74,10 @@ namespace SI
 
 	inline Vfloat4x4::Vfloat4x4(const float* m)
 	{
-		m_row[0] = _mm_load_ps(m);
-		m_row[1] = _mm_load_ps(&m[4]);
-		m_row[2] = _mm_load_ps(&m[8]);
-		m_row[3] = _mm_load_ps(&m[12]);
+		m_row[0] = _si_mm_load_ps(m);
+		m_row[1] = _si_mm_load_ps(&m[4]);
+		m_row[2] = _si_mm_load_ps(&m[8]);
+		m_row[3] = _si_mm_load_ps(&m[12]);
 	}
 
 	inline void Vfloat4x4::SetRow(uint32_t rowIndex, Vfloat4_arg row)
@@ -91,7 +89,7 @@ namespace SI
 	inline void Vfloat4x4::SetColumn(uint32_t columnIndex, Vfloat4_arg column)
 	{
 		SI_ASSERT(columnIndex<4);
-		__m128 mask = _si_mm_get_mask(1<<columnIndex);
+		__si128 mask = _si_mm_get_mask(1<<columnIndex);
 		m_row[0] = _si_mm_blend(m_row[0], column.Get128(), mask);
 		m_row[1] = _si_mm_blend(m_row[1], column.Get128(), mask);
 		m_row[2] = _si_mm_blend(m_row[2], column.Get128(), mask);
@@ -104,16 +102,16 @@ namespace SI
 		SI_ASSERT(columnIndex<4);
 
 		uint32_t mask = 1<<columnIndex;
-		__m128 element0000 = _mm_shuffle_ps(element.Get128(), element.Get128(), 0x00); // element.xxxx
+		__si128 element0000 = _si_mm_shuffle_ps(element.Get128(), element.Get128(), 0x00); // element.xxxx
 		m_row[rowIndex] = _si_mm_blend(m_row[rowIndex], element0000, mask);
 	}
 	
 	inline void Vfloat4x4::SetUpper3x3(Vfloat3x3_arg m)
 	{
-		const __m128 zero = kSiFloat128_0000;
-		m_row[0] = _mm_blend_ps(m.GetRow128(0), zero, 0b1000);
-		m_row[1] = _mm_blend_ps(m.GetRow128(1), zero, 0b1000);
-		m_row[2] = _mm_blend_ps(m.GetRow128(2), zero, 0b1000);
+		const __si128 zero = kSiFloat128_0000;
+		m_row[0] = _si_mm_blend_ps(m.GetRow128(0), zero, 0b1000);
+		m_row[1] = _si_mm_blend_ps(m.GetRow128(1), zero, 0b1000);
+		m_row[2] = _si_mm_blend_ps(m.GetRow128(2), zero, 0b1000);
 	}
 
 	inline Vfloat4 Vfloat4x4::GetRow(uint32_t rowIndex) const
@@ -129,24 +127,28 @@ namespace SI
 		{
 		case 0:
 			return Vfloat4(
-				_mm_unpacklo_ps(
-					_mm_shuffle_ps(m_row[0], m_row[2], _MM_SHUFFLE(0,0,0,0)),
-					_mm_shuffle_ps(m_row[1], m_row[3], _MM_SHUFFLE(0,0,0,0))));
+				_si_mm_blend_ps(
+					_si_mm_shuffle_ps(m_row[0], m_row[2], _SI_MM_SHUFFLE(0,0,0,0)),
+					_si_mm_shuffle_ps(m_row[1], m_row[3], _SI_MM_SHUFFLE(0,0,0,0)),
+					0b1010));
 		case 1:
 			return Vfloat4(
-				_mm_unpacklo_ps(
-					_mm_shuffle_ps(m_row[0], m_row[2], _MM_SHUFFLE(1,1,1,1)),
-					_mm_shuffle_ps(m_row[1], m_row[3], _MM_SHUFFLE(1,1,1,1))));
+				_si_mm_blend_ps(
+					_si_mm_shuffle_ps(m_row[0], m_row[2], _SI_MM_SHUFFLE(1,1,1,1)),
+					_si_mm_shuffle_ps(m_row[1], m_row[3], _SI_MM_SHUFFLE(1,1,1,1)),
+					0b1010));
 		case 2:
 			return Vfloat4(
-				_mm_unpacklo_ps(
-					_mm_shuffle_ps(m_row[0], m_row[2], _MM_SHUFFLE(2,2,2,2)),
-					_mm_shuffle_ps(m_row[1], m_row[3], _MM_SHUFFLE(2,2,2,2))));
+				_si_mm_blend_ps(
+					_si_mm_shuffle_ps(m_row[0], m_row[2], _SI_MM_SHUFFLE(2,2,2,2)),
+					_si_mm_shuffle_ps(m_row[1], m_row[3], _SI_MM_SHUFFLE(2,2,2,2)),
+					0b1010));
 		case 3:
 			return Vfloat4(
-				_mm_unpacklo_ps(
-					_mm_shuffle_ps(m_row[0], m_row[2], _MM_SHUFFLE(3,3,3,3)),
-					_mm_shuffle_ps(m_row[1], m_row[3], _MM_SHUFFLE(3,3,3,3))));
+				_si_mm_blend_ps(
+					_si_mm_shuffle_ps(m_row[0], m_row[2], _SI_MM_SHUFFLE(3,3,3,3)),
+					_si_mm_shuffle_ps(m_row[1], m_row[3], _SI_MM_SHUFFLE(3,3,3,3)),
+					0b1010));
 		default:
 			break;
 		}
@@ -162,13 +164,13 @@ namespace SI
 		switch(columnIndex)
 		{
 		case 0:
-			return Vfloat(_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _MM_SHUFFLE(0,0,0,0)));
+			return Vfloat(_si_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _SI_MM_SHUFFLE(0,0,0,0)));
 		case 1:
-			return Vfloat(_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _MM_SHUFFLE(1,1,1,1)));
+			return Vfloat(_si_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _SI_MM_SHUFFLE(1,1,1,1)));
 		case 2:
-			return Vfloat(_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _MM_SHUFFLE(2,2,2,2)));
+			return Vfloat(_si_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _SI_MM_SHUFFLE(2,2,2,2)));
 		case 3:
-			return Vfloat(_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _MM_SHUFFLE(3,3,3,3)));
+			return Vfloat(_si_mm_shuffle_ps(m_row[rowIndex], m_row[rowIndex], _SI_MM_SHUFFLE(3,3,3,3)));
 		}
 
 		return Vfloat(0.0f);
@@ -246,7 +248,7 @@ namespace SI
 			kSiFloat128_0001);
 	}
 	
-	inline __m128 Vfloat4x4::GetRow128(uint32_t rowIndex) const
+	inline __si128 Vfloat4x4::GetRow128(uint32_t rowIndex) const
 	{
 		SI_ASSERT(rowIndex<4);
 		return m_row[rowIndex];
@@ -271,22 +273,21 @@ namespace SI
 	{
 		inline Vfloat4x4 Multiply(Vfloat4x4_arg m0, Vfloat4x4_arg m1)
 		{
-			__m128 result[4];
+			__si128 result[4];
 
 			for(uint32_t i=0; i<4; ++i)
 			{
-				__m128 mi = m0.GetRow128(i);
-				__m128 x = _mm_shuffle_ps(mi, mi, _MM_SHUFFLE(0,0,0,0));
-				__m128 y = _mm_shuffle_ps(mi, mi, _MM_SHUFFLE(1,1,1,1));
-				__m128 z = _mm_shuffle_ps(mi, mi, _MM_SHUFFLE(2,2,2,2));
-				__m128 w = _mm_shuffle_ps(mi, mi, _MM_SHUFFLE(3,3,3,3));
-			
-				x = _mm_mul_ps(x, m1.GetRow128(0));
-				y = _mm_mul_ps(y, m1.GetRow128(1));
-				z = _mm_mul_ps(z, m1.GetRow128(2));
-				w = _mm_mul_ps(w, m1.GetRow128(3));
+				__si128 mi = m0.GetRow128(i);
+				__si128 x = _si_mm_shuffle_ps(mi, mi, _SI_MM_SHUFFLE(0,0,0,0));
+				__si128 y = _si_mm_shuffle_ps(mi, mi, _SI_MM_SHUFFLE(1,1,1,1));
+				__si128 z = _si_mm_shuffle_ps(mi, mi, _SI_MM_SHUFFLE(2,2,2,2));
+				__si128 w = _si_mm_shuffle_ps(mi, mi, _SI_MM_SHUFFLE(3,3,3,3));
+
+				// 依存を短くするため、xyとzwの2本に分けて積和する.
+				__si128 xy = _si_mm_fmadd_ps(y, m1.GetRow128(1), _si_mm_mul_ps(x, m1.GetRow128(0)));
+				__si128 zw = _si_mm_fmadd_ps(w, m1.GetRow128(3), _si_mm_mul_ps(z, m1.GetRow128(2)));
 
-				result[i] = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w));
+				result[i] = _si_mm_add_ps(xy, zw);
 			}
 
 			return Vfloat4x4(
@@ -308,47 +309,44 @@ namespace SI
 
 		inline Vfloat4 Multiply(Vfloat4_arg v, Vfloat4x4_arg m)
 		{
-			__m128 vi = v.Get128();
-			__m128 x = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(0,0,0,0));
-			__m128 y = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(1,1,1,1));
-			__m128 z = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(2,2,2,2));
-			__m128 w = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(3,3,3,3));
-			
-			x = _mm_mul_ps(x, m.GetRow128(0));
-			y = _mm_mul_ps(y, m.GetRow128(1));
-			z = _mm_mul_ps(z, m.GetRow128(2));
-			w = _mm_mul_ps(w, m.GetRow128(3));
+			__si128 vi = v.Get128();
+			__si128 x = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(0,0,0,0));
+			__si128 y = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(1,1,1,1));
+			__si128 z = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(2,2,2,2));
+			__si128 w = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(3,3,3,3));
 
-			Vfloat4(_mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+			__si128 xy = _si_mm_fmadd_ps(y, m.GetRow128(1), _si_mm_mul_ps(x, m.GetRow128(0)));
+			__si128 zw = _si_mm_fmadd_ps(w, m.GetRow128(3), _si_mm_mul_ps(z, m.GetRow128(2)));
+
+			return Vfloat4(_si_mm_add_ps(xy, zw));
 		}
 
 		inline Vfloat3 Multiply(Vfloat3_arg v, Vfloat4x4_arg m)
 		{
-			__m128 vi = v.Get128();
-			__m128 x = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(0,0,0,0));
-			__m128 y = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(1,1,1,1));
-			__m128 z = _mm_shuffle_ps(vi, vi, _MM_SHUFFLE(2,2,2,2));
-			
-			       x = _mm_mul_ps(x, m.GetRow128(0));
-			       y = _mm_mul_ps(y, m.GetRow128(1));
-			       z = _mm_mul_ps(z, m.GetRow128(2));
-			__m128 w = m.GetRow128(3);
+			__si128 vi = v.Get128();
+			__si128 x = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(0,0,0,0));
+			__si128 y = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(1,1,1,1));
+			__si128 z = _si_mm_shuffle_ps(vi, vi, _SI_MM_SHUFFLE(2,2,2,2));
+
+			// w=1として扱う.
+			__si128 xy = _si_mm_fmadd_ps(y, m.GetRow128(1), _si_mm_mul_ps(x, m.GetRow128(0)));
+			__si128 zw = _si_mm_fmadd_ps(z, m.GetRow128(2), m.GetRow128(3));
 
-			Vfloat4(_mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+			return Vfloat3(_si_mm_add_ps(xy, zw));
 		}
 
 		inline Vfloat4x4 Transpose(Vfloat4x4_arg m)
 		{
-			__m128 tmp0 = _mm_shuffle_ps((m.GetRow128(0)), (m.GetRow128(1)), _MM_SHUFFLE(1,0,1,0));
-			__m128 tmp1 = _mm_shuffle_ps((m.GetRow128(0)), (m.GetRow128(1)), _MM_SHUFFLE(3,2,3,2));
-			__m128 tmp2 = _mm_shuffle_ps((m.GetRow128(2)), (m.GetRow128(3)), _MM_SHUFFLE(1,0,1,0));
-			__m128 tmp3 = _mm_shuffle_ps((m.GetRow128(2)), (m.GetRow128(3)), _MM_SHUFFLE(3,2,3,2));
+			__si128 tmp0 = _si_mm_shuffle_ps((m.GetRow128(0)), (m.GetRow128(1)), _SI_MM_SHUFFLE(1,0,1,0));
+			__si128 tmp1 = _si_mm_shuffle_ps((m.GetRow128(0)), (m.GetRow128(1)), _SI_MM_SHUFFLE(3,2,3,2));
+			__si128 tmp2 = _si_mm_shuffle_ps((m.GetRow128(2)), (m.GetRow128(3)), _SI_MM_SHUFFLE(1,0,1,0));
+			__si128 tmp3 = _si_mm_shuffle_ps((m.GetRow128(2)), (m.GetRow128(3)), _SI_MM_SHUFFLE(3,2,3,2));
 
 			return Vfloat4x4(
-				_mm_shuffle_ps(tmp0, tmp2, _MM_SHUFFLE(2,0,2,0)),
-				_mm_shuffle_ps(tmp0, tmp2, _MM_SHUFFLE(3,1,3,1)),
-				_mm_shuffle_ps(tmp1, tmp3, _MM_SHUFFLE(2,0,2,0)),
-				_mm_shuffle_ps(tmp1, tmp3, _MM_SHUFFLE(3,1,3,1)));
+				_si_mm_shuffle_ps(tmp0, tmp2, _SI_MM_SHUFFLE(2,0,2,0)),
+				_si_mm_shuffle_ps(tmp0, tmp2, _SI_MM_SHUFFLE(3,1,3,1)),
+				_si_mm_shuffle_ps(tmp1, tmp3, _SI_MM_SHUFFLE(2,0,2,0)),
+				_si_mm_shuffle_ps(tmp1, tmp3, _SI_MM_SHUFFLE(3,1,3,1)));
 		}
 		
 		inline Vfloat4x4 Perspective(float width, float height, float nearPlane, float farPlane)
@@ -361,13 +359,13 @@ namespace SI
 			// 0.0f,         0.0f,          far/farNear,        1.0f
 			// 0.0f,         0.0f,          -near*far/farNear,  0.0f
 			
-			__m128 values = _si_mm_set(near2/width, near2/height, farPlane/farNear, -nearPlane*farPlane/farNear);
-			__m128 r0 = _mm_mul_ps(values, kSiFloat128_1000);
-			__m128 r1 = _mm_mul_ps(values, kSiFloat128_0100);
-			__m128 r2 = _mm_mul_ps(values, kSiFloat128_0010);
-			r2 = _mm_add_ps(r2, kSiFloat128_0001);
-			__m128 r3 = _mm_mul_ps(values, kSiFloat128_0001);
-			r3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 3, 0, 0));
+			__si128 values = _si_mm_set(near2/width, near2/height, farPlane/farNear, -nearPlane*farPlane/farNear);
+			__si128 r0 = _si_mm_mul_ps(values, kSiFloat128_1000);
+			__si128 r1 = _si_mm_mul_ps(values, kSiFloat128_0100);
+			__si128 r2 = _si_mm_mul_ps(values, kSiFloat128_0010);
+			r2 = _si_mm_add_ps(r2, kSiFloat128_0001);
+			__si128 r3 = _si_mm_mul_ps(values, kSiFloat128_0001);
+			r3 = _si_mm_shuffle_ps(r3, r3, _SI_MM_SHUFFLE(0, 3, 0, 0));
 
 			return Vfloat4x4(r0, r1, r2, r3);
 		}		
@@ -382,13 +380,13 @@ namespace SI
 			// 0.0f,         0.0f,          1.0f/farNear,       1.0f
 			// 0.0f,         0.0f,          -near/farNear,      0.0f
 			
-			__m128 values = _si_mm_set(2.0f/width, 2.0f/height, 1.0f/farNear, -nearPlane/farNear);
-			__m128 r0 = _mm_mul_ps(values, kSiFloat128_1000);
-			__m128 r1 = _mm_mul_ps(values, kSiFloat128_0100);
-			__m128 r2 = _mm_mul_ps(values, kSiFloat128_0010);
-			r2 = _mm_add_ps(r2, kSiFloat128_0001);
-			__m128 r3 = _mm_mul_ps(values, kSiFloat128_0001);
-			r3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 3, 0, 0));
+			__si128 values = _si_mm_set(2.0f/width, 2.0f/height, 1.0f/farNear, -nearPlane/farNear);
+			__si128 r0 = _si_mm_mul_ps(values, kSiFloat128_1000);
+			__si128 r1 = _si_mm_mul_ps(values, kSiFloat128_0100);
+			__si128 r2 = _si_mm_mul_ps(values, kSiFloat128_0010);
+			r2 = _si_mm_add_ps(r2, kSiFloat128_0001);
+			__si128 r3 = _si_mm_mul_ps(values, kSiFloat128_0001);
+			r3 = _si_mm_shuffle_ps(r3, r3, _SI_MM_SHUFFLE(0, 3, 0, 0));
 
 			return Vfloat4x4(r0, r1, r2, r3);
 		}
@@ -399,15 +397,15 @@ namespace SI
 				kSiFloat128_1000,
 				kSiFloat128_0100,
 				kSiFloat128_0010,
-				_mm_blend_ps(translate.Get128(), kSiFloat128_1111, 0b1000) );
+				_si_mm_blend_ps(translate.Get128(), kSiFloat128_1111, 0b1000) );
 		}
 
 		inline Vfloat4x4 Scale4x4(Vfloat3_arg scale)
 		{
 			return Vfloat4x4(
-				_mm_mul_ps( scale.Get128(), kSiFloat128_1000 ),
-				_mm_mul_ps( scale.Get128(), kSiFloat128_0100 ),
-				_mm_mul_ps( scale.Get128(), kSiFloat128_0010 ),
+				_si_mm_mul_ps( scale.Get128(), kSiFloat128_1000 ),
+				_si_mm_mul_ps( scale.Get128(), kSiFloat128_0100 ),
+				_si_mm_mul_ps( scale.Get128(), kSiFloat128_0010 ),
 				kSiFloat128_0001);
 		}
 
@@ -415,16 +413,16 @@ namespace SI
 		{
 			float s = sinf(radian);
 			float c = cosf(radian);
-			__m128 scsc = _si_mm_set(s,c,s,c);
-			__m128 cscs = _mm_shuffle_ps(scsc, scsc, _MM_SHUFFLE(0, 1, 0, 1));
+			__si128 scsc = _si_mm_set(s,c,s,c);
+			__si128 cscs = _si_mm_shuffle_ps(scsc, scsc, _SI_MM_SHUFFLE(0, 1, 0, 1));
 			
 			static const _SiFloat128 kSiFloat128_0110  = {{{ 0.0f,  1.0f, 1.0f, 0.0f }}};
 			static const _SiFloat128 kSiFloat128_0_110 = {{{ 0.0f, -1.0f, 1.0f, 0.0f }}};
 
 			return Vfloat4x4(
 				kSiFloat128_1000,
-				_mm_mul_ps( scsc, kSiFloat128_0110),
-				_mm_mul_ps( cscs, kSiFloat128_0_110),
+				_si_mm_mul_ps( scsc, kSiFloat128_0110),
+				_si_mm_mul_ps( cscs, kSiFloat128_0_110),
 				kSiFloat128_0001);
 		}
 
@@ -432,16 +430,16 @@ namespace SI
 		{
 			float s = sinf(radian);
 			float c = cosf(radian);
-			__m128 sscc = _si_mm_set(s,s,c,c);
-			__m128 ccss = _mm_shuffle_ps(sscc, sscc, _MM_SHUFFLE(0, 0, 2, 2));
+			__si128 sscc = _si_mm_set(s,s,c,c);
+			__si128 ccss = _si_mm_shuffle_ps(sscc, sscc, _SI_MM_SHUFFLE(0, 0, 2, 2));
 			
 			static const _SiFloat128 kSiFloat128_10_10 = {{{  1.0f, 0.0f,-1.0f, 0.0f }}};
 			static const _SiFloat128 kSiFloat128_1010  = {{{  1.0f, 0.0f, 1.0f, 0.0f }}};
 
 			return Vfloat4x4(
-				_mm_mul_ps( ccss, kSiFloat128_10_10),
+				_si_mm_mul_ps( ccss, kSiFloat128_10_10),
 				kSiFloat128_0100,
-				_mm_mul_ps( sscc, kSiFloat128_1010),
+				_si_mm_mul_ps( sscc, kSiFloat128_1010),
 				kSiFloat128_0001);
 		}
 
@@ -449,15 +447,15 @@ namespace SI
 		{
 			float s = sinf(radian);
 			float c = cosf(radian);
-			__m128 scsc = _si_mm_set(s,c,s,c);
-			__m128 cscs = _mm_shuffle_ps(scsc, scsc, _MM_SHUFFLE(0, 1, 0, 1));
+			__si128 scsc = _si_mm_set(s,c,s,c);
+			__si128 cscs = _si_mm_shuffle_ps(scsc, scsc, _SI_MM_SHUFFLE(0, 1, 0, 1));
 			
 			static const _SiFloat128 kSiFloat128_1100  = {{{  1.0f, 1.0f, 0.0f, 0.0f }}};
 			static const _SiFloat128 kSiFloat128__1100 = {{{ -1.0f, 1.0f, 0.0f, 0.0f }}};
 
 			return Vfloat4x4(
-				_mm_mul_ps( cscs, kSiFloat128_1100),
-				_mm_mul_ps( scsc, kSiFloat128__1100),
+				_si_mm_mul_ps( cscs, kSiFloat128_1100),
+				_si_mm_mul_ps( scsc, kSiFloat128__1100),
 				kSiFloat128_0010,
 				kSiFloat128_0001);
 		}
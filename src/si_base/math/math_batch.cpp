@@ -0,0 +1,310 @@
+﻿#include "si_base/math/math_batch.h"
+
+#include <cfloat>
+#include "si_base/core/assert.h"
+#include "si_base/math/vfloat.h"
+#include "si_base/math/vfloat3.h"
+#include "si_base/math/vfloat4.h"
+#include "si_base/math/vfloat4x4.h"
+
+namespace SI
+{
+namespace Math
+{
+	namespace
+	{
+		static const size_t kWidth = Vfloat3x8Soa::kWidth;
+
+		// 行列の各要素を8要素に複製しておく. splat[row][column].
+		struct MatrixSplat
+		{
+			explicit MatrixSplat(Vfloat4x4_arg m)
+			{
+				for(uint32_t r=0; r<4; ++r)
+				{
+					for(uint32_t c=0; c<3; ++c)
+					{
+						m_e[r][c] = _si_mm256_set1_ps(m.Get(r, c).AsFloat());
+					}
+				}
+			}
+
+			__si256 m_e[4][3];
+		};
+
+		// outとinは同じでもよい.
+		inline void TransformPoint8(Vfloat3x8Soa& out, const Vfloat3x8Soa& in, const MatrixSplat& s)
+		{
+			__si256 x = _si_mm256_fmadd_ps(in.m_x, s.m_e[0][0], _si_mm256_fmadd_ps(in.m_y, s.m_e[1][0], _si_mm256_fmadd_ps(in.m_z, s.m_e[2][0], s.m_e[3][0])));
+			__si256 y = _si_mm256_fmadd_ps(in.m_x, s.m_e[0][1], _si_mm256_fmadd_ps(in.m_y, s.m_e[1][1], _si_mm256_fmadd_ps(in.m_z, s.m_e[2][1], s.m_e[3][1])));
+			__si256 z = _si_mm256_fmadd_ps(in.m_x, s.m_e[0][2], _si_mm256_fmadd_ps(in.m_y, s.m_e[1][2], _si_mm256_fmadd_ps(in.m_z, s.m_e[2][2], s.m_e[3][2])));
+			out.m_x = x;
+			out.m_y = y;
+			out.m_z = z;
+		}
+
+		inline void TransformNormal8(Vfloat3x8Soa& out, const Vfloat3x8Soa& in, const MatrixSplat& s)
+		{
+			__si256 x = _si_mm256_fmadd_ps(in.m_x, s.m_e[0][0], _si_mm256_fmadd_ps(in.m_y, s.m_e[1][0], _si_mm256_mul_ps(in.m_z, s.m_e[2][0])));
+			__si256 y = _si_mm256_fmadd_ps(in.m_x, s.m_e[0][1], _si_mm256_fmadd_ps(in.m_y, s.m_e[1][1], _si_mm256_mul_ps(in.m_z, s.m_e[2][1])));
+			__si256 z = _si_mm256_fmadd_ps(in.m_x, s.m_e[0][2], _si_mm256_fmadd_ps(in.m_y, s.m_e[1][2], _si_mm256_mul_ps(in.m_z, s.m_e[2][2])));
+			out.m_x = x;
+			out.m_y = y;
+			out.m_z = z;
+		}
+
+		inline void Normalize8(Vfloat3x8Soa& inout)
+		{
+			const __si256 kSmallValue = _si_mm256_set1_ps(0.00001f); // 0割りerror対策. Math::Normalizeと同じ値.
+
+			__si256 lengthSqr = _si_mm256_fmadd_ps(inout.m_x, inout.m_x, _si_mm256_fmadd_ps(inout.m_y, inout.m_y, _si_mm256_mul_ps(inout.m_z, inout.m_z)));
+			__si256 length    = _si_mm256_sqrt_ps(_si_mm256_max_ps(lengthSqr, kSmallValue));
+
+			// 割り算は重いので、逆数を1回だけ求めて掛ける. 誤差は1ulp程度増える.
+			__si256 invLength = _si_mm256_div_ps(_si_mm256_set1_ps(1.0f), length);
+			inout.m_x = _si_mm256_mul_ps(inout.m_x, invLength);
+			inout.m_y = _si_mm256_mul_ps(inout.m_y, invLength);
+			inout.m_z = _si_mm256_mul_ps(inout.m_z, invLength);
+		}
+
+		// Vfloat3配列を2要素ずつ256bitに入れて、128bitごとにx,y,zを並べて変換する.
+		// SoAへの並べ替えは変換より重いので、積和だけで済む変換はこちらで処理する.
+		// rows[k]は上下128bitともmのk行目. addRowはw=1なら3行目, w=0なら0.
+		inline void TransformAos2(Vfloat3* out, const Vfloat3* in, size_t count, const __si256 (&rows)[4], __si256 addRow)
+		{
+			size_t i = 0;
+			for(; i+2<=count; i+=2)
+			{
+				__si256 v = _si_mm256_set_m128(in[i+1].Get128(), in[i].Get128());
+				__si256 x = _si_mm256_shuffle_ps(v, v, _SI_MM_SHUFFLE(0,0,0,0));
+				__si256 y = _si_mm256_shuffle_ps(v, v, _SI_MM_SHUFFLE(1,1,1,1));
+				__si256 z = _si_mm256_shuffle_ps(v, v, _SI_MM_SHUFFLE(2,2,2,2));
+
+				__si256 r = _si_mm256_fmadd_ps(x, rows[0], _si_mm256_fmadd_ps(y, rows[1], _si_mm256_fmadd_ps(z, rows[2], addRow)));
+				out[i]   = Vfloat3(_si_mm256_lo128(r));
+				out[i+1] = Vfloat3(_si_mm256_hi128(r));
+			}
+
+			if(i < count)
+			{
+				__si128 v = in[i].Get128();
+				__si128 x = _si_mm_shuffle_ps(v, v, _SI_MM_SHUFFLE(0,0,0,0));
+				__si128 y = _si_mm_shuffle_ps(v, v, _SI_MM_SHUFFLE(1,1,1,1));
+				__si128 z = _si_mm_shuffle_ps(v, v, _SI_MM_SHUFFLE(2,2,2,2));
+
+				__si128 r = _si_mm_fmadd_ps(x, _si_mm256_lo128(rows[0]), _si_mm_fmadd_ps(y, _si_mm256_lo128(rows[1]), _si_mm_fmadd_ps(z, _si_mm256_lo128(rows[2]), _si_mm256_lo128(addRow))));
+				out[i] = Vfloat3(r);
+			}
+		}
+
+		// Vfloat3配列を8要素ずつSoAにして処理する. 端数は0で埋めた一時領域で処理する.
+		template<typename Func>
+		inline void ForEachAos8(Vfloat3* out, const Vfloat3* in, size_t count, const Func& func)
+		{
+			size_t blockCount = count / kWidth;
+			for(size_t b=0; b<blockCount; ++b)
+			{
+				Vfloat3x8Soa soa;
+				soa.Load(in + b * kWidth);
+				func(soa);
+				soa.Store(out + b * kWidth);
+			}
+
+			size_t rest = count - blockCount * kWidth;
+			if(rest == 0) return;
+
+			Vfloat3 tmp[kWidth];
+			for(size_t i=0; i<kWidth; ++i)
+			{
+				tmp[i] = (i < rest)? in[blockCount * kWidth + i] : Vfloat3(0.0f);
+			}
+
+			Vfloat3x8Soa soa;
+			soa.Load(tmp);
+			func(soa);
+			soa.Store(tmp);
+
+			for(size_t i=0; i<rest; ++i)
+			{
+				out[blockCount * kWidth + i] = tmp[i];
+			}
+		}
+
+		// 2行分(r)にm1を掛ける. m1Rows[k]は上下128bitともm1のk行目.
+		inline __si256 MultiplyRows2(__si256 r, const __si256 (&m1Rows)[4])
+		{
+			__si256 x = _si_mm256_shuffle_ps(r, r, _SI_MM_SHUFFLE(0,0,0,0));
+			__si256 y = _si_mm256_shuffle_ps(r, r, _SI_MM_SHUFFLE(1,1,1,1));
+			__si256 z = _si_mm256_shuffle_ps(r, r, _SI_MM_SHUFFLE(2,2,2,2));
+			__si256 w = _si_mm256_shuffle_ps(r, r, _SI_MM_SHUFFLE(3,3,3,3));
+
+			__si256 xy = _si_mm256_fmadd_ps(y, m1Rows[1], _si_mm256_mul_ps(x, m1Rows[0]));
+			__si256 zw = _si_mm256_fmadd_ps(w, m1Rows[3], _si_mm256_mul_ps(z, m1Rows[2]));
+			return _si_mm256_add_ps(xy, zw);
+		}
+
+		inline void SplatRows(__si256 (&outRows)[4], Vfloat4x4_arg m)
+		{
+			for(uint32_t i=0; i<4; ++i)
+			{
+				outRows[i] = _si_mm256_set_m128(m.GetRow128(i), m.GetRow128(i));
+			}
+		}
+
+		// 1行分(m0の要素をメモリから複製して読む)にm1を掛ける.
+		inline __si128 MultiplyRow1(const float* row, const __si256 (&m1Rows)[4])
+		{
+			__si128 xy = _si_mm_fmadd_ps(_si_mm_set1_ps(row[1]), _si_mm256_lo128(m1Rows[1]), _si_mm_mul_ps(_si_mm_set1_ps(row[0]), _si_mm256_lo128(m1Rows[0])));
+			__si128 zw = _si_mm_fmadd_ps(_si_mm_set1_ps(row[3]), _si_mm256_lo128(m1Rows[3]), _si_mm_mul_ps(_si_mm_set1_ps(row[2]), _si_mm256_lo128(m1Rows[2])));
+			return _si_mm_add_ps(xy, zw);
+		}
+
+		// 0,1行目は256bitの並べ替えで、2,3行目は要素を複製して読み込んで計算する.
+		// 並べ替えだけだと同じ演算器に偏るので、半分を読み込み側に逃がす.
+		inline Vfloat4x4 Multiply4x4(Vfloat4x4_arg m0, const __si256 (&m1Rows)[4])
+		{
+			const float* e = reinterpret_cast<const float*>(&m0);
+			__si256 r01 = MultiplyRows2(_si_mm256_set_m128(m0.GetRow128(1), m0.GetRow128(0)), m1Rows);
+
+			return Vfloat4x4(
+				_si_mm256_lo128(r01),
+				_si_mm256_hi128(r01),
+				MultiplyRow1(e + 8,  m1Rows),
+				MultiplyRow1(e + 12, m1Rows));
+		}
+
+	} // namespace
+
+	void TransformPoints(Vfloat3x8Soa* out, const Vfloat3x8Soa* in, size_t blockCount, Vfloat4x4_arg m)
+	{
+		MatrixSplat s(m);
+		for(size_t b=0; b<blockCount; ++b)
+		{
+			TransformPoint8(out[b], in[b], s);
+		}
+	}
+
+	void TransformPoints(Vfloat3* out, const Vfloat3* in, size_t count, Vfloat4x4_arg m)
+	{
+		__si256 rows[4];
+		SplatRows(rows, m);
+		TransformAos2(out, in, count, rows, rows[3]);
+	}
+
+	void TransformNormals(Vfloat3x8Soa* out, const Vfloat3x8Soa* in, size_t blockCount, Vfloat4x4_arg m)
+	{
+		MatrixSplat s(m);
+		for(size_t b=0; b<blockCount; ++b)
+		{
+			TransformNormal8(out[b], in[b], s);
+		}
+	}
+
+	void TransformNormals(Vfloat3* out, const Vfloat3* in, size_t count, Vfloat4x4_arg m)
+	{
+		__si256 rows[4];
+		SplatRows(rows, m);
+		TransformAos2(out, in, count, rows, _si_mm256_set1_ps(0.0f));
+	}
+
+	void Normalize(Vfloat3x8Soa* inout, size_t blockCount)
+	{
+		for(size_t b=0; b<blockCount; ++b)
+		{
+			Normalize8(inout[b]);
+		}
+	}
+
+	void Normalize(Vfloat3* inout, size_t count)
+	{
+		ForEachAos8(inout, inout, count, [](Vfloat3x8Soa& soa){ Normalize8(soa); });
+	}
+
+	void Multiply(Vfloat4x4* out, const Vfloat4x4* m0, const Vfloat4x4* m1, size_t count)
+	{
+		for(size_t i=0; i<count; ++i)
+		{
+			__si256 m1Rows[4];
+			SplatRows(m1Rows, m1[i]);
+			out[i] = Multiply4x4(m0[i], m1Rows);
+		}
+	}
+
+	void Multiply(Vfloat4x4* out, const Vfloat4x4* m0, Vfloat4x4_arg m1, size_t count)
+	{
+		__si256 m1Rows[4];
+		SplatRows(m1Rows, m1);
+		for(size_t i=0; i<count; ++i)
+		{
+			out[i] = Multiply4x4(m0[i], m1Rows);
+		}
+	}
+
+	void ComputeAabb(Vfloat3& outMin, Vfloat3& outMax, const Vfloat3x8Soa* points, size_t count)
+	{
+		SI_ASSERT(0 < count);
+
+		__si256 minX = _si_mm256_set1_ps( FLT_MAX), minY = minX, minZ = minX;
+		__si256 maxX = _si_mm256_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+
+		size_t blockCount = count / kWidth;
+		for(size_t b=0; b<blockCount; ++b)
+		{
+			minX = _si_mm256_min_ps(minX, points[b].m_x);
+			minY = _si_mm256_min_ps(minY, points[b].m_y);
+			minZ = _si_mm256_min_ps(minZ, points[b].m_z);
+			maxX = _si_mm256_max_ps(maxX, points[b].m_x);
+			maxY = _si_mm256_max_ps(maxY, points[b].m_y);
+			maxZ = _si_mm256_max_ps(maxZ, points[b].m_z);
+		}
+
+		Vfloat3 resultMin(
+			HorizontalMin(Vfloat4(_si_mm_min_ps(_si_mm256_lo128(minX), _si_mm256_hi128(minX)))),
+			HorizontalMin(Vfloat4(_si_mm_min_ps(_si_mm256_lo128(minY), _si_mm256_hi128(minY)))),
+			HorizontalMin(Vfloat4(_si_mm_min_ps(_si_mm256_lo128(minZ), _si_mm256_hi128(minZ)))));
+		Vfloat3 resultMax(
+			HorizontalMax(Vfloat4(_si_mm_max_ps(_si_mm256_lo128(maxX), _si_mm256_hi128(maxX)))),
+			HorizontalMax(Vfloat4(_si_mm_max_ps(_si_mm256_lo128(maxY), _si_mm256_hi128(maxY)))),
+			HorizontalMax(Vfloat4(_si_mm_max_ps(_si_mm256_lo128(maxZ), _si_mm256_hi128(maxZ)))));
+
+		size_t rest = count - blockCount * kWidth;
+		for(uint32_t i=0; i<(uint32_t)rest; ++i)
+		{
+			Vfloat3 p = points[blockCount].Get(i);
+			resultMin = Min(resultMin, p);
+			resultMax = Max(resultMax, p);
+		}
+
+		outMin = resultMin;
+		outMax = resultMax;
+	}
+
+	void ComputeAabb(Vfloat3& outMin, Vfloat3& outMax, const Vfloat3* points, size_t count)
+	{
+		SI_ASSERT(0 < count);
+
+		// AoSのままでも1点あたりmin/max 1回ずつで済むので、並べ替えずに処理する.
+		// 依存を切るために2系統に分ける.
+		Vfloat3 min0 = points[0], max0 = points[0];
+		Vfloat3 min1 = points[0], max1 = points[0];
+
+		size_t i = 1;
+		for(; i+1<count; i+=2)
+		{
+			min0 = Min(min0, points[i]);
+			max0 = Max(max0, points[i]);
+			min1 = Min(min1, points[i+1]);
+			max1 = Max(max1, points[i+1]);
+		}
+		if(i < count)
+		{
+			min0 = Min(min0, points[i]);
+			max0 = Max(max0, points[i]);
+		}
+
+		outMin = Min(min0, min1);
+		outMax = Max(max0, max1);
+	}
+
+} // namespace Math
+} // namespace SI
@@ -4,13 +4,11 @@
 // このファイルは基本的にユーザが見る必要はない.
 
 #include <cstdint>
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 #include "si_base/core/basic_macro.h"
 
 namespace SI
 {
-	using __si128 = __m128;
-
 	struct alignas(16) _SiFloat128
 	{
 		union
@@ -43,9 +41,9 @@ namespace SI
 	SI_GLOBAL_CONST _SiFloat128 kSiFloat128_0010 = {{{ 0.0f, 0.0f, 1.0f, 0.0f }}};
 	SI_GLOBAL_CONST _SiFloat128 kSiFloat128_0001 = {{{ 0.0f, 0.0f, 0.0f, 1.0f }}};
 	
-	SI_GLOBAL_CONST _SiUint128  kSiUint128_AbsMask = {{{ 0x8fffffff, 0x8fffffff, 0x8fffffff, 0x8fffffff }}};
+	SI_GLOBAL_CONST _SiUint128  kSiUint128_AbsMask = {{{ 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff }}};
 
-	inline __m128 _si_mm_get_mask(int ctrl)
+	inline __si128 _si_mm_get_mask(int ctrl)
 	{
 		static const _SiUint128 kMaskTable[] =
 		{
@@ -67,24 +65,24 @@ namespace SI
 			{{{ UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX }}},
 		};
 
-		return (__m128)kMaskTable[ctrl];
+		return (__si128)kMaskTable[ctrl];
 	}
 
-	// _mm_blend_psはマスクが即値じゃないといけないので、別途用意する. 
-	inline __m128 _si_mm_blend(__si128 a, __si128 b, int ctrl)
+	// _si_mm_blend_psはマスクが即値じゃないといけないので、別途用意する. 
+	inline __si128 _si_mm_blend(__si128 a, __si128 b, int ctrl)
 	{
 		__si128 mask = _si_mm_get_mask(ctrl);
-		return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(b, mask));
+		return _si_mm_or_ps(_si_mm_andnot_ps(mask, a), _si_mm_and_ps(b, mask));
 	}
-	inline __m128 _si_mm_blend(__si128 a, __si128 b, __si128 mask)
+	inline __si128 _si_mm_blend(__si128 a, __si128 b, __si128 mask)
 	{
-		return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(b, mask));
+		return _si_mm_or_ps(_si_mm_andnot_ps(mask, a), _si_mm_and_ps(b, mask));
 	}
 
 	// 順番が逆で分かりにくいので、別途用意する.
-	inline __m128 _si_mm_set(float x, float y, float z, float w)
+	inline __si128 _si_mm_set(float x, float y, float z, float w)
 	{
-		return _mm_set_ps(w, z, y, x);
+		return _si_mm_set_ps(w, z, y, x);
 	}
 
 
@@ -0,0 +1,351 @@
+﻿#pragma once
+
+// 数学ライブラリが使うSIMD命令のバックエンド.
+// SI_MATH_SIMDで、スカラーの参照実装、SSE4.1、AVX2(FMA)のどれを使うかをコンパイル時に選ぶ.
+// 命令の名前と引数の並びはSSEのintrinsicsに合わせて、頭に_si_を付けている.
+
+#include <cstdint>
+
+#define SI_MATH_SIMD_SCALAR 0
+#define SI_MATH_SIMD_SSE41  1
+#define SI_MATH_SIMD_AVX2   2
+
+// 指定がなければコンパイラの設定から選ぶ. MSVCのx86/x64は元々SSE4.1前提だったのでそのまま.
+#if !defined(SI_MATH_SIMD)
+	#if defined(__AVX2__)
+		#define SI_MATH_SIMD SI_MATH_SIMD_AVX2
+	#elif defined(__SSE4_1__) || defined(_M_X64) || defined(_M_IX86)
+		#define SI_MATH_SIMD SI_MATH_SIMD_SSE41
+	#else
+		#define SI_MATH_SIMD SI_MATH_SIMD_SCALAR
+	#endif
+#endif
+
+// _MM_SHUFFLEと同じ並び.
+#define _SI_MM_SHUFFLE(z, y, x, w) (((z) << 6) | ((y) << 4) | ((x) << 2) | (w))
+
+#if SI_MATH_SIMD == SI_MATH_SIMD_SCALAR
+
+#include <cmath>
+#include <cstring>
+
+namespace SI
+{
+	struct alignas(16) __si128
+	{
+		float m_f[4];
+	};
+
+	struct alignas(16) __si128i
+	{
+		int32_t m_i[4];
+	};
+
+	static const char* const kSiMathSimdName = "Scalar";
+
+	namespace SimdScalar
+	{
+		inline uint32_t AsUint(float f)
+		{
+			uint32_t u;
+			memcpy(&u, &f, sizeof(u));
+			return u;
+		}
+
+		inline float AsFloat(uint32_t u)
+		{
+			float f;
+			memcpy(&f, &u, sizeof(f));
+			return f;
+		}
+
+		inline __si128 Make(float x, float y, float z, float w)
+		{
+			__si128 r = {{ x, y, z, w }};
+			return r;
+		}
+	}
+
+	inline __si128 _si_mm_load_ps (const float* p)    { return SimdScalar::Make(p[0], p[1], p[2], p[3]); }
+	inline void    _si_mm_store_ps(float* p, __si128 a){ memcpy(p, a.m_f, sizeof(a.m_f)); }
+	inline __si128 _si_mm_set1_ps (float f)           { return SimdScalar::Make(f, f, f, f); }
+	inline __si128 _si_mm_set_ss  (float f)           { return SimdScalar::Make(f, 0.0f, 0.0f, 0.0f); }
+	inline __si128 _si_mm_set_ps  (float w, float z, float y, float x){ return SimdScalar::Make(x, y, z, w); }
+	inline float   _si_mm_cvtss_f32(__si128 a)        { return a.m_f[0]; }
+
+#define SI_SIMD_SCALAR_OP_PS(name, expr) \
+	inline __si128 name(__si128 a, __si128 b) \
+	{ \
+		__si128 r; \
+		for(int i=0; i<4; ++i){ float x = a.m_f[i]; float y = b.m_f[i]; r.m_f[i] = (expr); } \
+		return r; \
+	}
+
+#define SI_SIMD_SCALAR_OP_SS(name, expr) \
+	inline __si128 name(__si128 a, __si128 b) \
+	{ \
+		__si128 r = a; \
+		float x = a.m_f[0]; float y = b.m_f[0]; r.m_f[0] = (expr); \
+		return r; \
+	}
+
+	SI_SIMD_SCALAR_OP_PS(_si_mm_add_ps, x + y)
+	SI_SIMD_SCALAR_OP_PS(_si_mm_sub_ps, x - y)
+	SI_SIMD_SCALAR_OP_PS(_si_mm_mul_ps, x * y)
+	SI_SIMD_SCALAR_OP_PS(_si_mm_div_ps, x / y)
+	SI_SIMD_SCALAR_OP_PS(_si_mm_min_ps, (x < y)? x : y) // NaNの扱いもSSEに合わせて第2引数を返す.
+	SI_SIMD_SCALAR_OP_PS(_si_mm_max_ps, (x > y)? x : y)
+	SI_SIMD_SCALAR_OP_PS(_si_mm_and_ps,    SimdScalar::AsFloat(SimdScalar::AsUint(x) & SimdScalar::AsUint(y)))
+	SI_SIMD_SCALAR_OP_PS(_si_mm_andnot_ps, SimdScalar::AsFloat(~SimdScalar::AsUint(x) & SimdScalar::AsUint(y)))
+	SI_SIMD_SCALAR_OP_PS(_si_mm_or_ps,     SimdScalar::AsFloat(SimdScalar::AsUint(x) | SimdScalar::AsUint(y)))
+	SI_SIMD_SCALAR_OP_PS(_si_mm_xor_ps,    SimdScalar::AsFloat(SimdScalar::AsUint(x) ^ SimdScalar::AsUint(y)))
+	SI_SIMD_SCALAR_OP_PS(_si_mm_cmplt_ps,  SimdScalar::AsFloat((x < y)?  UINT32_MAX : 0u))
+	SI_SIMD_SCALAR_OP_PS(_si_mm_cmpeq_ps,  SimdScalar::AsFloat((x == y)? UINT32_MAX : 0u))
+
+	SI_SIMD_SCALAR_OP_SS(_si_mm_add_ss, x + y)
+	SI_SIMD_SCALAR_OP_SS(_si_mm_sub_ss, x - y)
+	SI_SIMD_SCALAR_OP_SS(_si_mm_mul_ss, x * y)
+	SI_SIMD_SCALAR_OP_SS(_si_mm_div_ss, x / y)
+	SI_SIMD_SCALAR_OP_SS(_si_mm_min_ss, (x < y)? x : y)
+	SI_SIMD_SCALAR_OP_SS(_si_mm_max_ss, (x > y)? x : y)
+
+#undef SI_SIMD_SCALAR_OP_PS
+#undef SI_SIMD_SCALAR_OP_SS
+
+	// rcp/rsqrtは近似ではなく正確な値を返す.
+	inline __si128 _si_mm_sqrt_ps (__si128 a){ return SimdScalar::Make(sqrtf(a.m_f[0]), sqrtf(a.m_f[1]), sqrtf(a.m_f[2]), sqrtf(a.m_f[3])); }
+	inline __si128 _si_mm_rsqrt_ps(__si128 a){ return SimdScalar::Make(1.0f/sqrtf(a.m_f[0]), 1.0f/sqrtf(a.m_f[1]), 1.0f/sqrtf(a.m_f[2]), 1.0f/sqrtf(a.m_f[3])); }
+	inline __si128 _si_mm_rcp_ps  (__si128 a){ return SimdScalar::Make(1.0f/a.m_f[0], 1.0f/a.m_f[1], 1.0f/a.m_f[2], 1.0f/a.m_f[3]); }
+	inline __si128 _si_mm_sqrt_ss (__si128 a){ __si128 r = a; r.m_f[0] = sqrtf(a.m_f[0]);      return r; }
+	inline __si128 _si_mm_rsqrt_ss(__si128 a){ __si128 r = a; r.m_f[0] = 1.0f/sqrtf(a.m_f[0]); return r; }
+	inline __si128 _si_mm_rcp_ss  (__si128 a){ __si128 r = a; r.m_f[0] = 1.0f/a.m_f[0];        return r; }
+
+	inline __si128 _si_mm_fmadd_ps(__si128 a, __si128 b, __si128 c)
+	{
+		return SimdScalar::Make(
+			a.m_f[0] * b.m_f[0] + c.m_f[0],
+			a.m_f[1] * b.m_f[1] + c.m_f[1],
+			a.m_f[2] * b.m_f[2] + c.m_f[2],
+			a.m_f[3] * b.m_f[3] + c.m_f[3]);
+	}
+
+	inline __si128 _si_mm_movehl_ps(__si128 a, __si128 b)
+	{
+		return SimdScalar::Make(b.m_f[2], b.m_f[3], a.m_f[2], a.m_f[3]);
+	}
+
+	inline __si128 _si_mm_unpacklo_ps(__si128 a, __si128 b)
+	{
+		return SimdScalar::Make(a.m_f[0], b.m_f[0], a.m_f[1], b.m_f[1]);
+	}
+
+	inline __si128 _si_mm_unpackhi_ps(__si128 a, __si128 b)
+	{
+		return SimdScalar::Make(a.m_f[2], b.m_f[2], a.m_f[3], b.m_f[3]);
+	}
+
+	inline __si128 _si_mm_shuffle_ps(__si128 a, __si128 b, int imm)
+	{
+		return SimdScalar::Make(a.m_f[imm & 3], a.m_f[(imm >> 2) & 3], b.m_f[(imm >> 4) & 3], b.m_f[(imm >> 6) & 3]);
+	}
+
+	inline __si128 _si_mm_blend_ps(__si128 a, __si128 b, int imm)
+	{
+		__si128 r;
+		for(int i=0; i<4; ++i){ r.m_f[i] = (imm & (1 << i))? b.m_f[i] : a.m_f[i]; }
+		return r;
+	}
+
+	// 上位4bitで掛けて足す要素を、下位4bitで結果を書き込む要素を選ぶ.
+	inline __si128 _si_mm_dp_ps(__si128 a, __si128 b, int imm)
+	{
+		float sum = 0.0f;
+		for(int i=0; i<4; ++i){ if(imm & (0x10 << i)) sum += a.m_f[i] * b.m_f[i]; }
+
+		__si128 r;
+		for(int i=0; i<4; ++i){ r.m_f[i] = (imm & (1 << i))? sum : 0.0f; }
+		return r;
+	}
+
+	inline __si128i _si_mm_castps_si128(__si128 a)
+	{
+		__si128i r;
+		memcpy(r.m_i, a.m_f, sizeof(r.m_i));
+		return r;
+	}
+
+	// 丸めはSSEの既定と同じ最近接偶数.
+	inline __si128i _si_mm_cvtps_epi32(__si128 a)
+	{
+		__si128i r;
+		for(int i=0; i<4; ++i){ r.m_i[i] = (int32_t)nearbyintf(a.m_f[i]); }
+		return r;
+	}
+
+	inline __si128 _si_mm_cvtepi32_ps(__si128i a)
+	{
+		return SimdScalar::Make((float)a.m_i[0], (float)a.m_i[1], (float)a.m_i[2], (float)a.m_i[3]);
+	}
+
+	inline int _si_mm_movemask_epi8(__si128i a)
+	{
+		uint8_t bytes[16];
+		memcpy(bytes, a.m_i, sizeof(bytes));
+
+		int mask = 0;
+		for(int i=0; i<16; ++i){ mask |= (bytes[i] >> 7) << i; }
+		return mask;
+	}
+
+} // namespace SI
+
+#else // SI_MATH_SIMD == SI_MATH_SIMD_SCALAR
+
+#include <smmintrin.h>
+#if SI_MATH_SIMD == SI_MATH_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+namespace SI
+{
+	using __si128  = __m128;
+	using __si128i = __m128i;
+
+#if SI_MATH_SIMD == SI_MATH_SIMD_AVX2
+	static const char* const kSiMathSimdName = "AVX2/FMA";
+#else
+	static const char* const kSiMathSimdName = "SSE4.1";
+#endif
+
+	inline __si128 _si_mm_load_ps (const float* p)    { return _mm_load_ps(p); }
+	inline void    _si_mm_store_ps(float* p, __si128 a){ _mm_store_ps(p, a); }
+	inline __si128 _si_mm_set1_ps (float f)           { return _mm_set1_ps(f); }
+	inline __si128 _si_mm_set_ss  (float f)           { return _mm_set_ss(f); }
+	inline __si128 _si_mm_set_ps  (float w, float z, float y, float x){ return _mm_set_ps(w, z, y, x); }
+	inline float   _si_mm_cvtss_f32(__si128 a)        { return _mm_cvtss_f32(a); }
+
+	inline __si128 _si_mm_add_ps   (__si128 a, __si128 b){ return _mm_add_ps(a, b); }
+	inline __si128 _si_mm_sub_ps   (__si128 a, __si128 b){ return _mm_sub_ps(a, b); }
+	inline __si128 _si_mm_mul_ps   (__si128 a, __si128 b){ return _mm_mul_ps(a, b); }
+	inline __si128 _si_mm_div_ps   (__si128 a, __si128 b){ return _mm_div_ps(a, b); }
+	inline __si128 _si_mm_min_ps   (__si128 a, __si128 b){ return _mm_min_ps(a, b); }
+	inline __si128 _si_mm_max_ps   (__si128 a, __si128 b){ return _mm_max_ps(a, b); }
+	inline __si128 _si_mm_and_ps   (__si128 a, __si128 b){ return _mm_and_ps(a, b); }
+	inline __si128 _si_mm_andnot_ps(__si128 a, __si128 b){ return _mm_andnot_ps(a, b); }
+	inline __si128 _si_mm_or_ps    (__si128 a, __si128 b){ return _mm_or_ps(a, b); }
+	inline __si128 _si_mm_xor_ps   (__si128 a, __si128 b){ return _mm_xor_ps(a, b); }
+	inline __si128 _si_mm_cmplt_ps (__si128 a, __si128 b){ return _mm_cmplt_ps(a, b); }
+	inline __si128 _si_mm_cmpeq_ps (__si128 a, __si128 b){ return _mm_cmpeq_ps(a, b); }
+
+	inline __si128 _si_mm_add_ss(__si128 a, __si128 b){ return _mm_add_ss(a, b); }
+	inline __si128 _si_mm_sub_ss(__si128 a, __si128 b){ return _mm_sub_ss(a, b); }
+	inline __si128 _si_mm_mul_ss(__si128 a, __si128 b){ return _mm_mul_ss(a, b); }
+	inline __si128 _si_mm_div_ss(__si128 a, __si128 b){ return _mm_div_ss(a, b); }
+	inline __si128 _si_mm_min_ss(__si128 a, __si128 b){ return _mm_min_ss(a, b); }
+	inline __si128 _si_mm_max_ss(__si128 a, __si128 b){ return _mm_max_ss(a, b); }
+
+	inline __si128 _si_mm_sqrt_ps (__si128 a){ return _mm_sqrt_ps(a); }
+	inline __si128 _si_mm_rsqrt_ps(__si128 a){ return _mm_rsqrt_ps(a); }
+	inline __si128 _si_mm_rcp_ps  (__si128 a){ return _mm_rcp_ps(a); }
+	inline __si128 _si_mm_sqrt_ss (__si128 a){ return _mm_sqrt_ss(a); }
+	inline __si128 _si_mm_rsqrt_ss(__si128 a){ return _mm_rsqrt_ss(a); }
+	inline __si128 _si_mm_rcp_ss  (__si128 a){ return _mm_rcp_ss(a); }
+
+	// a*b+c. FMAが使えれば1命令で、丸めも1回になる.
+	inline __si128 _si_mm_fmadd_ps(__si128 a, __si128 b, __si128 c)
+	{
+#if SI_MATH_SIMD == SI_MATH_SIMD_AVX2
+		return _mm_fmadd_ps(a, b, c);
+#else
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+	}
+
+	inline __si128 _si_mm_movehl_ps  (__si128 a, __si128 b){ return _mm_movehl_ps(a, b); }
+	inline __si128 _si_mm_unpacklo_ps(__si128 a, __si128 b){ return _mm_unpacklo_ps(a, b); }
+	inline __si128 _si_mm_unpackhi_ps(__si128 a, __si128 b){ return _mm_unpackhi_ps(a, b); }
+
+	inline __si128i _si_mm_castps_si128(__si128 a) { return _mm_castps_si128(a); }
+	inline __si128i _si_mm_cvtps_epi32 (__si128 a) { return _mm_cvtps_epi32(a); }
+	inline __si128  _si_mm_cvtepi32_ps (__si128i a){ return _mm_cvtepi32_ps(a); }
+	inline int      _si_mm_movemask_epi8(__si128i a){ return _mm_movemask_epi8(a); }
+
+} // namespace SI
+
+// 即値を取る命令は、関数で包むと定数にならないのでマクロにする.
+#define _si_mm_shuffle_ps(a, b, imm) _mm_shuffle_ps((a), (b), (imm))
+#define _si_mm_blend_ps(a, b, imm)   _mm_blend_ps((a), (b), (imm))
+#define _si_mm_dp_ps(a, b, imm)      _mm_dp_ps((a), (b), (imm))
+
+#endif // SI_MATH_SIMD == SI_MATH_SIMD_SCALAR
+
+// 8要素をまとめて扱う256bitの型. 配列をまとめて処理するときに使う.
+// AVX2以外では128bitを2つ並べて代用する.
+#if SI_MATH_SIMD == SI_MATH_SIMD_AVX2
+
+namespace SI
+{
+	using __si256 = __m256;
+
+	inline __si256 _si_mm256_set1_ps(float f)                    { return _mm256_set1_ps(f); }
+	inline __si256 _si_mm256_add_ps (__si256 a, __si256 b)       { return _mm256_add_ps(a, b); }
+	inline __si256 _si_mm256_sub_ps (__si256 a, __si256 b)       { return _mm256_sub_ps(a, b); }
+	inline __si256 _si_mm256_mul_ps (__si256 a, __si256 b)       { return _mm256_mul_ps(a, b); }
+	inline __si256 _si_mm256_div_ps (__si256 a, __si256 b)       { return _mm256_div_ps(a, b); }
+	inline __si256 _si_mm256_min_ps (__si256 a, __si256 b)       { return _mm256_min_ps(a, b); }
+	inline __si256 _si_mm256_max_ps (__si256 a, __si256 b)       { return _mm256_max_ps(a, b); }
+	inline __si256 _si_mm256_sqrt_ps(__si256 a)                  { return _mm256_sqrt_ps(a); }
+	inline __si256 _si_mm256_fmadd_ps(__si256 a, __si256 b, __si256 c){ return _mm256_fmadd_ps(a, b, c); }
+
+	// 下位128bitがlo, 上位128bitがhi.
+	inline __si256 _si_mm256_set_m128(__si128 hi, __si128 lo){ return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
+	inline __si128 _si_mm256_lo128(__si256 a)                { return _mm256_castps256_ps128(a); }
+	inline __si128 _si_mm256_hi128(__si256 a)                { return _mm256_extractf128_ps(a, 1); }
+
+} // namespace SI
+
+// 128bitごとに_si_mm_shuffle_psと同じ並べ替えをする.
+#define _si_mm256_shuffle_ps(a, b, imm) _mm256_shuffle_ps((a), (b), (imm))
+
+#else // SI_MATH_SIMD == SI_MATH_SIMD_AVX2
+
+namespace SI
+{
+	struct alignas(32) __si256
+	{
+		__si128 m_lo;
+		__si128 m_hi;
+	};
+
+	inline __si256 _si_mm256_set_m128(__si128 hi, __si128 lo)
+	{
+		__si256 r;
+		r.m_lo = lo;
+		r.m_hi = hi;
+		return r;
+	}
+
+	inline __si128 _si_mm256_lo128(__si256 a){ return a.m_lo; }
+	inline __si128 _si_mm256_hi128(__si256 a){ return a.m_hi; }
+
+	inline __si256 _si_mm256_set1_ps(float f)             { __si128 v = _si_mm_set1_ps(f); return _si_mm256_set_m128(v, v); }
+	inline __si256 _si_mm256_add_ps (__si256 a, __si256 b){ return _si_mm256_set_m128(_si_mm_add_ps(a.m_hi, b.m_hi), _si_mm_add_ps(a.m_lo, b.m_lo)); }
+	inline __si256 _si_mm256_sub_ps (__si256 a, __si256 b){ return _si_mm256_set_m128(_si_mm_sub_ps(a.m_hi, b.m_hi), _si_mm_sub_ps(a.m_lo, b.m_lo)); }
+	inline __si256 _si_mm256_mul_ps (__si256 a, __si256 b){ return _si_mm256_set_m128(_si_mm_mul_ps(a.m_hi, b.m_hi), _si_mm_mul_ps(a.m_lo, b.m_lo)); }
+	inline __si256 _si_mm256_div_ps (__si256 a, __si256 b){ return _si_mm256_set_m128(_si_mm_div_ps(a.m_hi, b.m_hi), _si_mm_div_ps(a.m_lo, b.m_lo)); }
+	inline __si256 _si_mm256_min_ps (__si256 a, __si256 b){ return _si_mm256_set_m128(_si_mm_min_ps(a.m_hi, b.m_hi), _si_mm_min_ps(a.m_lo, b.m_lo)); }
+	inline __si256 _si_mm256_max_ps (__si256 a, __si256 b){ return _si_mm256_set_m128(_si_mm_max_ps(a.m_hi, b.m_hi), _si_mm_max_ps(a.m_lo, b.m_lo)); }
+	inline __si256 _si_mm256_sqrt_ps(__si256 a)           { return _si_mm256_set_m128(_si_mm_sqrt_ps(a.m_hi), _si_mm_sqrt_ps(a.m_lo)); }
+
+	inline __si256 _si_mm256_fmadd_ps(__si256 a, __si256 b, __si256 c)
+	{
+		return _si_mm256_set_m128(_si_mm_fmadd_ps(a.m_hi, b.m_hi, c.m_hi), _si_mm_fmadd_ps(a.m_lo, b.m_lo, c.m_lo));
+	}
+
+} // namespace SI
+
+// 引数は2回評価されるので、副作用のある式を渡さないこと.
+#define _si_mm256_shuffle_ps(a, b, imm) \
+	SI::_si_mm256_set_m128(_si_mm_shuffle_ps((a).m_hi, (b).m_hi, (imm)), _si_mm_shuffle_ps((a).m_lo, (b).m_lo, (imm)))
+
+#endif // SI_MATH_SIMD == SI_MATH_SIMD_AVX2
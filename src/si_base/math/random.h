@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <cstdint>
+
+namespace SI
+{
+	// 32bitの整数をよく混ぜたハッシュ値にする(lowbias32).
+	inline uint32_t HashUint32(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	inline uint32_t HashCombineUint32(uint32_t seed, uint32_t value)
+	{
+		return HashUint32(seed ^ (HashUint32(value) + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+	}
+
+	// シード値を広げるためのSplitMix64. stateを進めて64bitを返す.
+	inline uint64_t SplitMix64(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// 上位24bitを使って[0,1)のfloatにする.
+	inline float UintToUnitFloat(uint32_t x)
+	{
+		return (float)(x >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// PCG32(XSH-RR). 64bitの状態と、streamで選べる系列を持つ.
+	class Pcg32
+	{
+	public:
+		explicit Pcg32(uint64_t seed = 0x853c49e6748fea9bull, uint64_t stream = 0xda3e39cb94b95bdbull)
+		{
+			Seed(seed, stream);
+		}
+
+		void Seed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbull)
+		{
+			m_state = 0;
+			m_inc   = (stream << 1u) | 1u;
+			NextUint32();
+			m_state += seed;
+			NextUint32();
+		}
+
+		uint32_t NextUint32()
+		{
+			uint64_t oldState = m_state;
+			m_state = oldState * 6364136223846793005ull + m_inc;
+			uint32_t xorShifted = (uint32_t)(((oldState >> 18u) ^ oldState) >> 27u);
+			uint32_t rot = (uint32_t)(oldState >> 59u);
+			return (xorShifted >> rot) | (xorShifted << ((~rot + 1u) & 31u));
+		}
+
+		// [0,1)
+		float NextFloat()
+		{
+			return UintToUnitFloat(NextUint32());
+		}
+
+	private:
+		uint64_t m_state;
+		uint64_t m_inc;
+	};
+
+	// xoshiro128+. 状態が128bitと小さく、floatを作るだけならPCG32より速い.
+	class Xoshiro128Plus
+	{
+	public:
+		explicit Xoshiro128Plus(uint64_t seed = 0)
+		{
+			Seed(seed);
+		}
+
+		void Seed(uint64_t seed)
+		{
+			uint64_t a = SplitMix64(seed);
+			uint64_t b = SplitMix64(seed);
+			m_s[0] = (uint32_t)a;
+			m_s[1] = (uint32_t)(a >> 32);
+			m_s[2] = (uint32_t)b;
+			m_s[3] = (uint32_t)(b >> 32);
+		}
+
+		uint32_t NextUint32()
+		{
+			uint32_t result = m_s[0] + m_s[3];
+			uint32_t t = m_s[1] << 9;
+
+			m_s[2] ^= m_s[0];
+			m_s[3] ^= m_s[1];
+			m_s[1] ^= m_s[2];
+			m_s[0] ^= m_s[3];
+			m_s[2] ^= t;
+			m_s[3] = (m_s[3] << 11) | (m_s[3] >> 21);
+
+			return result;
+		}
+
+		// [0,1). 下位bitの質が低いので上位bitだけを使う.
+		float NextFloat()
+		{
+			return UintToUnitFloat(NextUint32());
+		}
+
+	private:
+		uint32_t m_s[4];
+	};
+}
@@ -0,0 +1,149 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#include "si_base/core/constant.h"
+#include "si_base/math/vfloat3.h"
+#include "si_base/math/random.h"
+
+namespace SI
+{
+namespace Sampling
+{
+	inline uint32_t ReverseBits32(uint32_t x)
+	{
+		x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+		x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+		x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+		x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+		return (x >> 16) | (x << 16);
+	}
+
+	// Sobol列の1次元目(van der Corput列).
+	inline uint32_t Sobol0(uint32_t index)
+	{
+		return ReverseBits32(index);
+	}
+
+	// Sobol列の2次元目. 1次元目と合わせて(0,2)列になる.
+	inline uint32_t Sobol1(uint32_t index)
+	{
+		uint32_t result = 0;
+		for(uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+		{
+			if(index & 1) result ^= v;
+		}
+		return result;
+	}
+
+	// 上位bitから順に入れ子で並べ替えるOwenスクランブル(Laine-Karrasの置換).
+	// 小さい区間ごとの層別を保ったまま、点の並びを乱数化する.
+	inline uint32_t NestedUniformScramble(uint32_t x, uint32_t seed)
+	{
+		x = ReverseBits32(x);
+		x += seed;
+		x ^= x * 0x6c50b47cu;
+		x ^= x * 0xb82f1e52u;
+		x ^= x * 0xc7afe638u;
+		x ^= x * 0x8d22f6e6u;
+		return ReverseBits32(x);
+	}
+
+	// スクランブル済みの2次元Sobol点. indexを0から2^n-1まで使うと各層に1点ずつ入る.
+	inline void Sobol02(uint32_t index, uint32_t seed, float& outU, float& outV)
+	{
+		outU = UintToUnitFloat(NestedUniformScramble(Sobol0(index), HashCombineUint32(seed, 0)));
+		outV = UintToUnitFloat(NestedUniformScramble(Sobol1(index), HashCombineUint32(seed, 1)));
+	}
+
+	// strataX * strataY の格子で層別したサンプル. jitterは層の中の位置[0,1).
+	inline void Stratified2D(uint32_t index, uint32_t strataX, uint32_t strataY, float jitterU, float jitterV, float& outU, float& outV)
+	{
+		uint32_t x = index % strataX;
+		uint32_t y = (index / strataX) % strataY;
+		outU = ((float)x + jitterU) / (float)strataX;
+		outV = ((float)y + jitterV) / (float)strataY;
+	}
+
+	// 単位球面上の一様な点.
+	inline Vfloat3 UniformSampleSphere(float u, float v)
+	{
+		float z   = 1.0f - 2.0f * u;
+		float r   = sqrtf(fmaxf(0.0f, 1.0f - z * z));
+		float phi = 2.0f * kPi * v;
+		return Vfloat3(r * cosf(phi), r * sinf(phi), z);
+	}
+
+	// 単位球の内部の一様な点. 棄却法を使わずに半径を3乗根で決める.
+	inline Vfloat3 UniformSampleBall(float u, float v, float w)
+	{
+		return cbrtf(w) * UniformSampleSphere(u, v);
+	}
+
+	// 単位円盤(xy平面)の一様な点. Shirley-Chiuの同心円写像で層別を保つ.
+	inline Vfloat3 ConcentricSampleDisk(float u, float v)
+	{
+		float a = 2.0f * u - 1.0f;
+		float b = 2.0f * v - 1.0f;
+		if(a == 0.0f && b == 0.0f) return Vfloat3(0.0f);
+
+		float r, phi;
+		if(fabsf(a) > fabsf(b))
+		{
+			r   = a;
+			phi = (0.25f * kPi) * (b / a);
+		}
+		else
+		{
+			r   = b;
+			phi = (0.5f * kPi) - (0.25f * kPi) * (a / b);
+		}
+
+		return Vfloat3(r * cosf(phi), r * sinf(phi), 0.0f);
+	}
+
+	// 画素とサンプル番号から決まる低食い違い量サンプラ.
+	// 次元ごとにサンプル番号をシャッフルしたSobol列を使う(padded Sobol).
+	class SobolSampler
+	{
+	public:
+		SobolSampler()
+			: m_seed(0)
+			, m_sampleIndex(0)
+			, m_dimension(0)
+		{
+		}
+
+		void Start(uint32_t pixelIndex, uint32_t sampleIndex, uint32_t seed = 0)
+		{
+			m_seed        = HashCombineUint32(HashUint32(seed), pixelIndex);
+			m_sampleIndex = sampleIndex;
+			m_dimension   = 0;
+		}
+
+		float Get1D()
+		{
+			uint32_t dimensionSeed = HashCombineUint32(m_seed, m_dimension++);
+			uint32_t index = NestedUniformScramble(m_sampleIndex, dimensionSeed);
+			return UintToUnitFloat(NestedUniformScramble(Sobol0(index), HashUint32(dimensionSeed)));
+		}
+
+		void Get2D(float& outU, float& outV)
+		{
+			uint32_t dimensionSeed = HashCombineUint32(m_seed, m_dimension++);
+			uint32_t index = NestedUniformScramble(m_sampleIndex, dimensionSeed);
+			Sobol02(index, dimensionSeed, outU, outV);
+		}
+
+		uint32_t GetSampleIndex() const{ return m_sampleIndex; }
+		uint32_t GetDimension()   const{ return m_dimension; }
+
+	private:
+		uint32_t m_seed;
+		uint32_t m_sampleIndex;
+		uint32_t m_dimension;
+	};
+
+} // namespace Sampling
+} // namespace SI
@@ -1,6 +1,6 @@
 ﻿#pragma once
 
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 
 namespace SI
 {
@@ -10,7 +10,7 @@ namespace SI
 		Vfloat();
 		Vfloat(const Vfloat& v);
 		Vfloat(float value); // no explicit
-		explicit Vfloat(const __m128& v);
+		explicit Vfloat(const __si128& v);
 		
 	public:
 		void Set(float v);
@@ -28,10 +28,10 @@ namespace SI
 		Vfloat operator/(Vfloat_arg r) const;
 
 	public:
-		__m128 Get128() const;
+		__si128 Get128() const;
 
 	private:
-		__m128 m_v;
+		__si128 m_v;
 	};
 	
 	Vfloat operator+(float f, Vfloat_arg vf);	
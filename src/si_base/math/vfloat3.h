@@ -1,6 +1,6 @@
 ﻿#pragma once
 
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 #include <cstdint>
 
 #include "si_base/math/math_declare.h"
@@ -22,7 +22,7 @@ namespace SI
 		explicit Vfloat3(float value);		
 		explicit Vfloat3(Vfloat_arg value);		
 		explicit Vfloat3(const float* v);
-		explicit Vfloat3(__m128 v);
+		explicit Vfloat3(__si128 v);
 		
 	public:
 		void SetX(Vfloat_arg x);
@@ -92,10 +92,10 @@ namespace SI
 		static Vfloat3 AxisZ();
 
 	public:
-		__m128 Get128() const;
+		__si128 Get128() const;
 
 	private:
-		__m128 m_v;
+		__si128 m_v;
 	};
 	
 	Vfloat3 operator*(Vfloat f, Vfloat3_arg v);
@@ -1,7 +1,7 @@
 ﻿#pragma once
 
 #include <cstdint>
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 
 #include "si_base/math/math_declare.h"
 
@@ -23,9 +23,9 @@ namespace SI
 			Vquat_arg q);
 
 		Vfloat3x3(
-			__m128 row0,
-			__m128 row1,
-			__m128 row2);
+			__si128 row0,
+			__si128 row1,
+			__si128 row2);
 
 	public:
 		void SetRow   (uint32_t rowIndex,    Vfloat3_arg row);
@@ -61,10 +61,10 @@ namespace SI
 		static Vfloat3x3 Identity();
 
 	public:
-		__m128 GetRow128(uint32_t rowIndex) const;
+		__si128 GetRow128(uint32_t rowIndex) const;
 
 	private:
-		__m128   m_row[3];
+		__si128   m_row[3];
 	};
 	
 	Vfloat4 operator*(Vfloat4_arg v, Vfloat3x3_arg m);
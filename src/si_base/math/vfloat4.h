@@ -1,6 +1,6 @@
 ﻿#pragma once
 
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 #include <cstdint>
 
 #include "si_base/math/math_declare.h"
@@ -19,7 +19,7 @@ namespace SI
 		explicit Vfloat4(float value);		
 		explicit Vfloat4(Vfloat_arg value);
 		explicit Vfloat4(const float* v);
-		explicit Vfloat4(__m128 v);
+		explicit Vfloat4(__si128 v);
 		
 	public:
 		void SetX(Vfloat_arg x);
@@ -92,10 +92,10 @@ namespace SI
 		static Vfloat4 AxisW();
 
 	public:
-		__m128 Get128() const;
+		__si128 Get128() const;
 
 	private:
-		__m128 m_v;
+		__si128 m_v;
 	};
 	
 	Vfloat4 operator*(Vfloat f, Vfloat4_arg v);
@@ -117,6 +117,7 @@ namespace SI
 		Vfloat4 Rcp           (Vfloat4_arg a);
 		Vfloat  LengthSqr     (Vfloat4_arg a);
 		Vfloat  Length        (Vfloat4_arg a);
+		Vfloat  Dot           (Vfloat4_arg a, Vfloat4_arg b);
 		Vfloat4 Normalize     (Vfloat4_arg a);
 		Vfloat4 NormalizeFast (Vfloat4_arg a);
 		Vfloat4 Floor         (Vfloat4_arg a);
@@ -1,7 +1,7 @@
 ﻿#pragma once
 
 #include <cstdint>
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 
 #include "si_base/math/math_declare.h"
 namespace SI
@@ -27,10 +27,10 @@ namespace SI
 			Vfloat3_arg trans);
 
 		Vfloat4x4(
-			__m128 row0,
-			__m128 row1,
-			__m128 row2,
-			__m128 row3);
+			__si128 row0,
+			__si128 row1,
+			__si128 row2,
+			__si128 row3);
 
 		explicit Vfloat4x4(const float* m);
 
@@ -73,10 +73,10 @@ namespace SI
 		static Vfloat4x4 Identity();
 				
 	public:
-		__m128 GetRow128(uint32_t rowIndex) const;
+		__si128 GetRow128(uint32_t rowIndex) const;
 
 	private:
-		__m128   m_row[4];
+		__si128   m_row[4];
 	};
 	
 	Vfloat4   operator*(Vfloat4_arg v,    Vfloat4x4_arg m);
@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include <cstdint>
+#include "si_base/core/assert.h"
+#include "si_base/math/math_internal.h"
+#include "si_base/math/vfloat3.h"
+
+namespace SI
+{
+	// Vfloat3を4つ、x,y,zごとにまとめたもの.
+	struct alignas(16) Vfloat3x4Soa
+	{
+		__si128 m_x;
+		__si128 m_y;
+		__si128 m_z;
+
+		// v[0]～v[3]を読み込む.
+		inline void Load(const Vfloat3* v)
+		{
+			__si128 xy01 = _si_mm_shuffle_ps(v[0].Get128(), v[1].Get128(), _SI_MM_SHUFFLE(1,0,1,0));
+			__si128 xy23 = _si_mm_shuffle_ps(v[2].Get128(), v[3].Get128(), _SI_MM_SHUFFLE(1,0,1,0));
+			__si128 zw01 = _si_mm_shuffle_ps(v[0].Get128(), v[1].Get128(), _SI_MM_SHUFFLE(3,2,3,2));
+			__si128 zw23 = _si_mm_shuffle_ps(v[2].Get128(), v[3].Get128(), _SI_MM_SHUFFLE(3,2,3,2));
+
+			m_x = _si_mm_shuffle_ps(xy01, xy23, _SI_MM_SHUFFLE(2,0,2,0));
+			m_y = _si_mm_shuffle_ps(xy01, xy23, _SI_MM_SHUFFLE(3,1,3,1));
+			m_z = _si_mm_shuffle_ps(zw01, zw23, _SI_MM_SHUFFLE(2,0,2,0));
+		}
+
+		// v[0]～v[3]に書き出す. wは0になる.
+		inline void Store(Vfloat3* v) const
+		{
+			__si128 xy01 = _si_mm_unpacklo_ps(m_x, m_y);              // x0 y0 x1 y1
+			__si128 xy23 = _si_mm_unpackhi_ps(m_x, m_y);              // x2 y2 x3 y3
+			__si128 z0z1 = _si_mm_unpacklo_ps(m_z, kSiFloat128_0000); // z0 0 z1 0
+			__si128 z2z3 = _si_mm_unpackhi_ps(m_z, kSiFloat128_0000); // z2 0 z3 0
+
+			v[0] = Vfloat3(_si_mm_shuffle_ps(xy01, z0z1, _SI_MM_SHUFFLE(1,0,1,0)));
+			v[1] = Vfloat3(_si_mm_shuffle_ps(xy01, z0z1, _SI_MM_SHUFFLE(3,2,3,2)));
+			v[2] = Vfloat3(_si_mm_shuffle_ps(xy23, z2z3, _SI_MM_SHUFFLE(1,0,1,0)));
+			v[3] = Vfloat3(_si_mm_shuffle_ps(xy23, z2z3, _SI_MM_SHUFFLE(3,2,3,2)));
+		}
+	};
+
+	// Vfloat3を8つ、x,y,zごとにまとめたもの.
+	// 配列の一括処理(Math::TransformPointsなど)はこの単位で行う.
+	struct alignas(32) Vfloat3x8Soa
+	{
+		static const uint32_t kWidth = 8;
+
+		__si256 m_x;
+		__si256 m_y;
+		__si256 m_z;
+
+		// v[0]～v[7]を読み込む.
+		inline void Load(const Vfloat3* v)
+		{
+			Vfloat3x4Soa lo, hi;
+			lo.Load(v);
+			hi.Load(v + 4);
+			m_x = _si_mm256_set_m128(hi.m_x, lo.m_x);
+			m_y = _si_mm256_set_m128(hi.m_y, lo.m_y);
+			m_z = _si_mm256_set_m128(hi.m_z, lo.m_z);
+		}
+
+		// v[0]～v[7]に書き出す.
+		inline void Store(Vfloat3* v) const
+		{
+			Vfloat3x4Soa lo = { _si_mm256_lo128(m_x), _si_mm256_lo128(m_y), _si_mm256_lo128(m_z) };
+			Vfloat3x4Soa hi = { _si_mm256_hi128(m_x), _si_mm256_hi128(m_y), _si_mm256_hi128(m_z) };
+			lo.Store(v);
+			hi.Store(v + 4);
+		}
+
+		inline Vfloat3 Get(uint32_t i) const
+		{
+			SI_ASSERT(i < kWidth);
+			const float* x = reinterpret_cast<const float*>(&m_x);
+			const float* y = reinterpret_cast<const float*>(&m_y);
+			const float* z = reinterpret_cast<const float*>(&m_z);
+			return Vfloat3(x[i], y[i], z[i]);
+		}
+
+		inline void Set(uint32_t i, Vfloat3_arg v)
+		{
+			SI_ASSERT(i < kWidth);
+			reinterpret_cast<float*>(&m_x)[i] = v.Xf();
+			reinterpret_cast<float*>(&m_y)[i] = v.Yf();
+			reinterpret_cast<float*>(&m_z)[i] = v.Zf();
+		}
+	};
+
+	// count個の要素を格納するのに必要なVfloat3x8Soaの数.
+	inline size_t GetVfloat3x8SoaCount(size_t count)
+	{
+		return (count + Vfloat3x8Soa::kWidth - 1) / Vfloat3x8Soa::kWidth;
+	}
+
+} // namespace SI
@@ -1,6 +1,6 @@
 ﻿#pragma once
 
-#include <xmmintrin.h>
+#include "si_base/math/math_simd.h"
 #include <cstdint>
 
 #include "si_base/math/math_declare.h"
@@ -17,7 +17,7 @@ namespace SI
 		Vquat(Vfloat3 axis, float angle);
 		Vquat(Vfloat3 axis, Vfloat angle);
 		explicit Vquat(const float* v);
-		explicit Vquat(__m128 v);
+		explicit Vquat(__si128 v);
 		
 	public:
 		void SetX(Vfloat_arg x);
@@ -54,10 +54,10 @@ namespace SI
 		Vquat& operator*=(Vquat_arg q);
 
 	public:
-		__m128 Get128() const;
+		__si128 Get128() const;
 
 	private:
-		__m128 m_v;
+		__si128 m_v;
 	};
 
 	namespace Math
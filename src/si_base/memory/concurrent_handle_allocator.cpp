@@ -0,0 +1,336 @@
+﻿
+#include "si_base/memory/concurrent_handle_allocator.h"
+
+#include "si_base/core/core.h"
+
+namespace SI
+{
+	namespace
+	{
+		// アロケータのIDからキャッシュの番号を引く表. IDで比べて線形探索する.
+		// 同じスレッドで複数のアロケータを交互に使っても、登録し直してキャッシュを使い切らないようにする.
+		struct ThreadCacheSlot
+		{
+			uint32_t m_allocatorId = 0;
+			uint32_t m_cacheIndex  = 0;
+		};
+
+		static const uint32_t kThreadCacheSlotCount = 64; // 2の累乗.
+		static const uint32_t kThreadCacheProbeCount = 8; // 探す範囲. 見つからず空きも無ければ先頭を上書きする.
+
+		thread_local ThreadCacheSlot t_cacheSlots[kThreadCacheSlotCount];
+		AtomicUint32                 s_allocatorIdCounter;
+	}
+
+	ConcurrentHandleAllocator::ConcurrentHandleAllocator()
+		: m_maxItemCount(0)
+		, m_id(0)
+		, m_nextHandles(nullptr)
+		, m_head(MakeHead(kInvalidHandle, 0))
+		, m_allocatedCount(0)
+		, m_threadCacheCount(0)
+		, m_threadCaches(nullptr)
+	{
+	}
+
+	ConcurrentHandleAllocator::~ConcurrentHandleAllocator()
+	{
+		Terminate();
+	}
+
+	void ConcurrentHandleAllocator::Initialize(uint32_t itemCount)
+	{
+		SI_ASSERT(m_nextHandles==nullptr);
+		SI_ASSERT(0<itemCount && itemCount<kInvalidHandle);
+
+		m_maxItemCount = itemCount;
+		m_allocatedCount.Store(0);
+
+		m_nextHandles = SI_NEW_ARRAY(AtomicUint32, m_maxItemCount);
+		for(uint32_t i=0; i<m_maxItemCount; ++i)
+		{
+			m_nextHandles[i].Store((i+1 < m_maxItemCount)? i+1 : kInvalidHandle);
+		}
+		m_head.Store(MakeHead(0, 0));
+
+		m_threadCaches = SI_NEW_ARRAY(ThreadCache, kMaxThreadCacheCount);
+		for(uint32_t i=0; i<kMaxThreadCacheCount; ++i)
+		{
+			m_threadCaches[i].m_head.Store(kInvalidHandle);
+			m_threadCaches[i].m_count.Store(0);
+			m_threadCaches[i].m_allocatedCount.Store(0);
+		}
+		m_threadCacheCount.Store(0);
+
+		// 0は未登録の意味で使うので飛ばす.
+		uint32_t id = ++s_allocatorIdCounter;
+		if(id == 0) id = ++s_allocatorIdCounter;
+		m_id = id;
+	}
+
+	void ConcurrentHandleAllocator::Terminate()
+	{
+		if(m_nextHandles==nullptr) return;
+
+		SI_ASSERT(GetAllocatedCount() == 0, "開放忘れ");
+
+		SI_DELETE_ARRAY(m_threadCaches);
+		m_threadCaches = nullptr;
+		m_threadCacheCount.Store(0);
+
+		SI_DELETE_ARRAY(m_nextHandles);
+		m_nextHandles = nullptr;
+		m_head.Store(MakeHead(kInvalidHandle, 0));
+
+		m_maxItemCount = 0;
+		m_id = 0;
+	}
+
+	uint32_t ConcurrentHandleAllocator::Allocate()
+	{
+		SI_ASSERT(m_nextHandles);
+
+		ThreadCache* cache = GetThreadCache();
+		uint32_t handle = kInvalidHandle;
+		if(cache)
+		{
+			handle = PopCache(*cache);
+			if(handle == kInvalidHandle)
+			{
+				// まとめて取ってきて、残りは手元に置いておく.
+				uint32_t last = kInvalidHandle;
+				handle = PopGlobal(kRefillCount, last);
+				if(handle != kInvalidHandle && handle != last)
+				{
+					uint32_t next = m_nextHandles[handle].Load(std::memory_order_relaxed);
+					cache->m_head.Store(next);
+					cache->m_count.Store(kRefillCount - 1, std::memory_order_relaxed);
+				}
+			}
+		}
+		else
+		{
+			uint32_t last = kInvalidHandle;
+			handle = PopGlobal(1, last);
+		}
+
+		// 共有リストが空なら、他のスレッドが持っている分をもらう.
+		if(handle == kInvalidHandle)
+		{
+			handle = StealCache(cache);
+			if(handle == kInvalidHandle) return kInvalidHandle;
+		}
+
+		// 共有のカウンタを毎回更新すると、そこで競合するのでスレッド毎に数える.
+		if(cache)
+		{
+			cache->m_allocatedCount.Store(cache->m_allocatedCount.Load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		else
+		{
+			++m_allocatedCount;
+		}
+		return handle;
+	}
+
+	void ConcurrentHandleAllocator::Deallocate(uint32_t handle)
+	{
+		SI_ASSERT(m_nextHandles);
+
+		if(m_maxItemCount <= handle)
+		{
+			SI_ASSERT(0, "開放済み");
+			return;
+		}
+
+		ThreadCache* cache = GetThreadCache();
+		if(!cache)
+		{
+			--m_allocatedCount;
+			PushGlobal(handle, handle);
+			return;
+		}
+
+		cache->m_allocatedCount.Store(cache->m_allocatedCount.Load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		PushCache(*cache, handle);
+		if(kThreadCacheSize < cache->m_count.Load(std::memory_order_relaxed))
+		{
+			FlushCache(*cache);
+		}
+	}
+
+	ConcurrentHandleAllocator::ThreadCache* ConcurrentHandleAllocator::GetThreadCache()
+	{
+		// IDは連番なので、そのまま下位ビットを使えば散らばる.
+		const uint32_t mask = kThreadCacheSlotCount - 1;
+		ThreadCacheSlot* emptySlot = nullptr;
+		for(uint32_t i=0; i<kThreadCacheProbeCount; ++i)
+		{
+			ThreadCacheSlot& slot = t_cacheSlots[(m_id + i) & mask];
+			if(slot.m_allocatorId == m_id)
+			{
+				return &m_threadCaches[slot.m_cacheIndex];
+			}
+			if(slot.m_allocatorId == 0)
+			{
+				emptySlot = &slot;
+				break;
+			}
+		}
+
+		// このスレッドで初めて使うのでキャッシュを割り当てる.
+		uint32_t cacheIndex = m_threadCacheCount.FetchAdd(1);
+		if(kMaxThreadCacheCount <= cacheIndex)
+		{
+			m_threadCacheCount -= 1;
+			return nullptr;
+		}
+
+		// 表が埋まっている(Terminate済みのアロケータが残っている)場合は先頭を上書きする.
+		ThreadCacheSlot& slot = emptySlot? *emptySlot : t_cacheSlots[m_id & mask];
+		slot.m_allocatorId = m_id;
+		slot.m_cacheIndex  = cacheIndex;
+		return &m_threadCaches[cacheIndex];
+	}
+
+	uint32_t ConcurrentHandleAllocator::PopGlobal(uint32_t maxCount, uint32_t& outLast)
+	{
+		SI_ASSERT(0<maxCount);
+
+		uint64_t head = m_head.Load();
+		while(true)
+		{
+			uint32_t first = GetHeadIndex(head);
+			if(first == kInvalidHandle)
+			{
+				outLast = kInvalidHandle;
+				return kInvalidHandle;
+			}
+
+			// 途中で他のスレッドが触っていたら、タグが変わっているのでCASが失敗する.
+			uint32_t last = first;
+			uint32_t next = m_nextHandles[last].Load(std::memory_order_relaxed);
+			for(uint32_t i=1; i<maxCount && next != kInvalidHandle && next < m_maxItemCount; ++i)
+			{
+				last = next;
+				next = m_nextHandles[last].Load(std::memory_order_relaxed);
+			}
+
+			if(m_head.CompareExchange(head, MakeHead(next, GetHeadTag(head) + 1)))
+			{
+				m_nextHandles[last].Store(kInvalidHandle, std::memory_order_relaxed);
+				outLast = last;
+				return first;
+			}
+		}
+	}
+
+	void ConcurrentHandleAllocator::PushGlobal(uint32_t first, uint32_t last)
+	{
+		uint64_t head = m_head.Load();
+		while(true)
+		{
+			m_nextHandles[last].Store(GetHeadIndex(head), std::memory_order_relaxed);
+			if(m_head.CompareExchange(head, MakeHead(first, GetHeadTag(head) + 1)))
+			{
+				return;
+			}
+		}
+	}
+
+	uint32_t ConcurrentHandleAllocator::PopCache(ThreadCache& cache)
+	{
+		uint32_t handle = cache.m_head.Load();
+		while(handle != kInvalidHandle)
+		{
+			uint32_t next = m_nextHandles[handle].Load(std::memory_order_relaxed);
+			if(cache.m_head.CompareExchange(handle, next))
+			{
+				uint32_t count = cache.m_count.Load(std::memory_order_relaxed);
+				cache.m_count.Store((0<count)? count-1 : 0, std::memory_order_relaxed);
+				return handle;
+			}
+		}
+
+		return kInvalidHandle;
+	}
+
+	void ConcurrentHandleAllocator::PushCache(ThreadCache& cache, uint32_t handle)
+	{
+		uint32_t head = cache.m_head.Load();
+		while(true)
+		{
+			m_nextHandles[handle].Store(head, std::memory_order_relaxed);
+			if(cache.m_head.CompareExchange(head, handle))
+			{
+				cache.m_count.Store(cache.m_count.Load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return;
+			}
+		}
+	}
+
+	void ConcurrentHandleAllocator::FlushCache(ThreadCache& cache)
+	{
+		uint32_t first = cache.m_head.Exchange(kInvalidHandle);
+		cache.m_count.Store(0);
+		if(first == kInvalidHandle) return;
+
+		// 取り出したリストはこのスレッドだけのものなので、普通にたどれる.
+		uint32_t last = first;
+		uint32_t next = m_nextHandles[last].Load(std::memory_order_relaxed);
+		while(next != kInvalidHandle)
+		{
+			last = next;
+			next = m_nextHandles[last].Load(std::memory_order_relaxed);
+		}
+
+		PushGlobal(first, last);
+	}
+
+	uint32_t ConcurrentHandleAllocator::GetAllocatedCount() const
+	{
+		int64_t count = m_allocatedCount.Load();
+
+		uint32_t cacheCount = Min(m_threadCacheCount.Load(), kMaxThreadCacheCount);
+		for(uint32_t i=0; i<cacheCount; ++i)
+		{
+			count += m_threadCaches[i].m_allocatedCount.Load(std::memory_order_relaxed);
+		}
+
+		return (uint32_t)Max(count, (int64_t)0);
+	}
+
+	uint32_t ConcurrentHandleAllocator::StealCache(ThreadCache* thief)
+	{
+		uint32_t cacheCount = Min(m_threadCacheCount.Load(), kMaxThreadCacheCount);
+		for(uint32_t i=0; i<cacheCount; ++i)
+		{
+			ThreadCache& victim = m_threadCaches[i];
+			if(&victim == thief) continue;
+
+			uint32_t first = victim.m_head.Exchange(kInvalidHandle);
+			if(first == kInvalidHandle) continue;
+			victim.m_count.Store(0);
+
+			// 1つだけ使って、残りは共有リストに戻す.
+			uint32_t rest = m_nextHandles[first].Load(std::memory_order_relaxed);
+			if(rest != kInvalidHandle)
+			{
+				uint32_t last = rest;
+				uint32_t next = m_nextHandles[last].Load(std::memory_order_relaxed);
+				while(next != kInvalidHandle)
+				{
+					last = next;
+					next = m_nextHandles[last].Load(std::memory_order_relaxed);
+				}
+
+				PushGlobal(rest, last);
+			}
+
+			return first;
+		}
+
+		return kInvalidHandle;
+	}
+
+} // namespace SI
@@ -0,0 +1,67 @@
+﻿#pragma once
+
+#include <cstdint>
+#include "si_base/core/non_copyable.h"
+#include "si_base/concurency/atomic.h"
+#include "si_base/memory/handle_allocator.h"
+
+namespace SI
+{
+	// 複数スレッドから同時に確保・開放できるハンドルアロケータ.
+	// 空きリストの先頭はインデックスとタグ(更新毎に増やす)を64bitにまとめてCASするので、ABAが起きない.
+	// スレッド毎に少しだけ空きハンドルを手元に持っておき、共有の空きリストへのアクセスを減らす.
+	class ConcurrentHandleAllocator : private NonCopyable
+	{
+	public:
+		static constexpr uint32_t kMaxThreadCacheCount = 64;  // これを超えたスレッドはキャッシュを使わない.
+		static constexpr uint32_t kThreadCacheSize     = 32;  // 超えたらまとめて共有リストに返す.
+		static constexpr uint32_t kRefillCount         = 16;  // 共有リストから一度に取ってくる数.
+
+	public:
+		ConcurrentHandleAllocator();
+		~ConcurrentHandleAllocator();
+
+		void Initialize(uint32_t itemCount);
+		void Terminate();
+
+		uint32_t Allocate();
+		void Deallocate(uint32_t handle);
+
+		// 各スレッドの数を足すので、他のスレッドが確保・開放している最中はおおよその値になる.
+		uint32_t GetAllocatedCount() const;
+		uint32_t GetMaxItemCount() const{ return m_maxItemCount; }
+
+	private:
+		// キャッシュラインを共有しないようにしておく.
+		struct alignas(64) ThreadCache
+		{
+			AtomicUint32 m_head;           // 他のスレッドからは丸ごと盗むだけ(Exchange)なので、持ち主のCASでもABAは起きない.
+			AtomicUint32 m_count;          // おおよその数. 持ち主以外は0にするだけ.
+			AtomicInt32  m_allocatedCount; // このスレッドでの確保数-開放数. 持ち主しか書かない.
+		};
+
+	private:
+		ThreadCache* GetThreadCache();
+
+		uint32_t PopGlobal(uint32_t maxCount, uint32_t& outLast);
+		void PushGlobal(uint32_t first, uint32_t last);
+		uint32_t PopCache(ThreadCache& cache);
+		void PushCache(ThreadCache& cache, uint32_t handle);
+		void FlushCache(ThreadCache& cache);
+		uint32_t StealCache(ThreadCache* thief);
+
+		static uint64_t MakeHead(uint32_t index, uint32_t tag){ return ((uint64_t)tag << 32) | index; }
+		static uint32_t GetHeadIndex(uint64_t head){ return (uint32_t)head; }
+		static uint32_t GetHeadTag  (uint64_t head){ return (uint32_t)(head >> 32); }
+
+	private:
+		uint32_t         m_maxItemCount;
+		uint32_t         m_id;             // スレッド側でキャッシュの割り当てを覚えておくためのID.
+		AtomicUint32*    m_nextHandles;    // 空きリストのリンク.
+		alignas(64) AtomicUint64 m_head;   // 共有の空きリスト. 下位32bitがインデックス, 上位がタグ.
+		alignas(64) AtomicInt32  m_allocatedCount; // キャッシュを持たないスレッドの分.
+		AtomicUint32     m_threadCacheCount;
+		ThreadCache*     m_threadCaches;
+	};
+
+} // namespace SI
@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include "si_base/memory/concurrent_handle_allocator.h"
+#include "si_base/core/new_delete.h"
+
+namespace SI
+{
+	// 複数スレッドから同時にAllocate/Deallocateできるオブジェクトプール.
+	// オブジェクト自体へのアクセスは使う側で守ること.
+	template<typename T>
+	class ConcurrentObjectPool
+	{
+	public:
+		ConcurrentObjectPool()
+			: m_objects(nullptr)
+			, m_objectCount(0)
+		{
+		}
+
+		~ConcurrentObjectPool()
+		{
+			Terminate();
+		}
+
+		void Initialize(uint32_t maxObjectCount)
+		{
+			SI_ASSERT(m_objects == nullptr);
+			SI_ASSERT(maxObjectCount != 0);
+			
+			m_objectCount = maxObjectCount;
+			m_objects = SI_NEW_ARRAY(T, m_objectCount);
+			m_handleAllocator.Initialize(m_objectCount);
+		}
+
+		void Terminate()
+		{
+			if(m_objects==nullptr) return;
+			SI_ASSERT(m_handleAllocator.GetAllocatedCount()==0, "開放忘れ");
+
+			m_handleAllocator.Terminate();
+			SI_DELETE_ARRAY(m_objects);
+			m_objects = nullptr;
+			m_objectCount = 0;
+		}
+
+		T* Allocate()
+		{
+			SI_ASSERT(m_objects);
+
+			uint32_t handle = m_handleAllocator.Allocate();
+			if(handle == kInvalidHandle) return nullptr;
+
+			return &m_objects[handle];
+		}
+
+		void Deallocate(T* obj)
+		{
+			if(obj == nullptr) return;
+			SI_ASSERT(m_objects);
+			
+			uintptr_t diff = ((uintptr_t)obj) - ((uintptr_t)m_objects);
+			SI_ASSERT((diff % sizeof(T)) == 0);
+			uint32_t handle = (uint32_t)(diff / sizeof(T));
+
+			m_handleAllocator.Deallocate(handle);
+		}
+
+		T* GetObjectArray()
+		{
+			return m_objects;
+		}
+
+		uint32_t GetObjectCount() const
+		{
+			return m_objectCount;
+		}
+
+		uint32_t GetAllocatedObjectCount() const
+		{
+			return m_handleAllocator.GetAllocatedCount();
+		}
+
+	private:
+		T*                         m_objects;
+		uint32_t                   m_objectCount;
+		ConcurrentHandleAllocator  m_handleAllocator;
+	};
+
+} // namespace SI
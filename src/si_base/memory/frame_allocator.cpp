@@ -0,0 +1,123 @@
+﻿
+#include "si_base/memory/frame_allocator.h"
+
+#include <atomic>
+
+namespace SI
+{
+	namespace
+	{
+		struct FrameAllocatorThreadCache
+		{
+			uint32_t m_generation = 0;
+			void*    m_arena      = nullptr;
+		};
+
+		thread_local FrameAllocatorThreadCache t_threadCache;
+		std::atomic<uint32_t>                  s_generationCounter(0);
+	}
+
+	////////////////////////////////////////////////////////////////
+
+	FrameAllocator::FrameAllocator()
+		: Singleton<FrameAllocator>(this)
+		, m_pageSize(65536)
+		, m_frameIndex(0)
+		, m_generation(0)
+	{
+	}
+
+	FrameAllocator::~FrameAllocator()
+	{
+		Terminate();
+	}
+
+	void FrameAllocator::Initialize(const FrameAllocatorDesc& desc)
+	{
+		SI_ASSERT(!IsInitialized());
+
+		m_pageSize   = desc.m_pageSize;
+		m_frameIndex = 0;
+
+		// 前回の初期化時にスレッドがキャッシュしたアリーナを使わないように.
+		uint32_t generation = ++s_generationCounter;
+		if(generation == 0) generation = ++s_generationCounter;
+		m_generation = generation;
+	}
+
+	void FrameAllocator::Terminate()
+	{
+		MutexLocker locker(m_mutex);
+
+		for(ThreadArena* arena : m_arenas)
+		{
+			SI_DELETE(arena);
+		}
+		m_arenas.clear();
+		m_generation = 0;
+	}
+
+	void FrameAllocator::Flip()
+	{
+		SI_ASSERT(IsInitialized());
+
+		++m_frameIndex;
+
+		MutexLocker locker(m_mutex);
+
+		uint32_t writeIndex = GetWriteIndex();
+		for(ThreadArena* arena : m_arenas)
+		{
+			arena->m_allocators[writeIndex].Reset();
+		}
+	}
+
+	LinearAllocator& FrameAllocator::GetThreadAllocator()
+	{
+		return GetThreadArena().m_allocators[GetWriteIndex()];
+	}
+
+	uint32_t FrameAllocator::GetThreadCount()
+	{
+		MutexLocker locker(m_mutex);
+		return (uint32_t)m_arenas.size();
+	}
+
+	FrameAllocator::ThreadArena& FrameAllocator::GetThreadArena()
+	{
+		SI_ASSERT(IsInitialized());
+
+		if(t_threadCache.m_generation == m_generation)
+		{
+			return *(ThreadArena*)t_threadCache.m_arena;
+		}
+
+		// このスレッドで初めて使うので登録する.
+		ThreadArena* arena = SI_NEW(ThreadArena);
+		for(LinearAllocator& allocator : arena->m_allocators)
+		{
+			allocator.Initialize(m_pageSize);
+		}
+
+		{
+			MutexLocker locker(m_mutex);
+			m_arenas.push_back(arena);
+		}
+
+		t_threadCache.m_generation = m_generation;
+		t_threadCache.m_arena      = arena;
+
+		return *arena;
+	}
+
+	LinearAllocator* FrameAllocator::GetCurrentThreadAllocator()
+	{
+		if(!Singleton<FrameAllocator>::IsCreated()) return nullptr;
+
+		FrameAllocator* frameAllocator = GetInstance();
+		if(!frameAllocator->IsInitialized()) return nullptr;
+
+		return &frameAllocator->GetThreadAllocator();
+	}
+
+} // namespace SI
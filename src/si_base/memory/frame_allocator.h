@@ -0,0 +1,126 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "si_base/core/singleton.h"
+#include "si_base/core/new_delete.h"
+#include "si_base/concurency/mutex.h"
+#include "si_base/memory/linear_allocator.h"
+
+namespace SI
+{
+	struct FrameAllocatorDesc
+	{
+		size_t m_pageSize = 65536;
+	};
+
+	// スレッド毎にLinearAllocatorを持つ、フレーム単位の一時メモリ.
+	// フレームの数だけ(kBufferCount)バッファリングするので、確保したメモリは次のフレームの終わりまで有効.
+	// 何フレームもかかる処理(非同期ロードなど)では使わないこと.
+	class FrameAllocator : public Singleton<FrameAllocator>
+	{
+	public:
+		static const uint32_t kBufferCount = 2;
+
+	public:
+		FrameAllocator();
+		~FrameAllocator();
+
+		void Initialize(const FrameAllocatorDesc& desc = FrameAllocatorDesc());
+		void Terminate();
+		bool IsInitialized() const{ return m_generation != 0; }
+
+		// フレームの区切りで呼ぶ. 次に書き込むバッファを全スレッド分リセットする.
+		// 他のスレッドが確保している最中に呼ばないこと.
+		void Flip();
+
+		void* Allocate(size_t size, size_t alignment = 16){ return GetThreadAllocator().Allocate(size, alignment); }
+
+		// 呼び出したスレッドの、現在のフレーム用のアロケータ.
+		LinearAllocator& GetThreadAllocator();
+
+		uint32_t GetWriteIndex() const{ return (uint32_t)(m_frameIndex % kBufferCount); }
+		uint32_t GetThreadCount();
+
+	public:
+		// FrameAllocatorが無ければnullptrを返す.
+		static LinearAllocator* GetCurrentThreadAllocator();
+
+	private:
+		struct ThreadArena
+		{
+			LinearAllocator m_allocators[kBufferCount];
+		};
+
+		ThreadArena& GetThreadArena();
+
+	private:
+		std::vector<ThreadArena*>  m_arenas;
+		Mutex                      m_mutex;
+		size_t                     m_pageSize;
+		uint64_t                   m_frameIndex;
+		uint32_t                   m_generation; // 0なら未初期化. スレッド側のキャッシュを無効化するのに使う.
+	};
+
+	// FrameAllocatorから確保するSTL用のアロケータ. 解放は何もしない.
+	// FrameAllocatorが無い時(ツールやテストなど)は通常のヒープを使う.
+	template<typename T>
+	class FrameStlAllocator
+	{
+	public:
+		using value_type = T;
+
+		template<typename U>
+		struct rebind{ using other = FrameStlAllocator<U>; };
+
+	public:
+		FrameStlAllocator()
+			: m_allocator(FrameAllocator::GetCurrentThreadAllocator())
+		{
+		}
+
+		explicit FrameStlAllocator(LinearAllocator* allocator)
+			: m_allocator(allocator)
+		{
+		}
+
+		template<typename U>
+		FrameStlAllocator(const FrameStlAllocator<U>& other)
+			: m_allocator(other.GetAllocator())
+		{
+		}
+
+		T* allocate(size_t count)
+		{
+			size_t size = count * sizeof(T);
+			if(m_allocator)
+			{
+				return (T*)m_allocator->Allocate(size, Max(alignof(T), (size_t)16));
+			}
+
+			return (T*)SI_MALLOC(size);
+		}
+
+		void deallocate(T* p, size_t count)
+		{
+			if(m_allocator) return;
+
+			SI_FREE(p);
+		}
+
+		LinearAllocator* GetAllocator() const{ return m_allocator; }
+
+		template<typename U>
+		bool operator==(const FrameStlAllocator<U>& other) const{ return m_allocator == other.GetAllocator(); }
+		template<typename U>
+		bool operator!=(const FrameStlAllocator<U>& other) const{ return m_allocator != other.GetAllocator(); }
+
+	private:
+		LinearAllocator* m_allocator;
+	};
+
+	// フレーム内で使い捨てる配列.
+	template<typename T>
+	using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+
+} // namespace SI
@@ -122,7 +122,7 @@ namespace SI
 			for(auto itr = m_unusedLargePages.begin(); itr!=m_unusedLargePages.end(); ++itr)
 			{
 				LinearAllocatorPage* page = (*itr);
-				if(minimumPageSize < page->GetSize()) continue;
+				if(page->GetSize() < minimumPageSize) continue;
 
 				// 必要なサイズ以上のPageを見つけたので再利用.
 				m_unusedLargePages.erase(itr);
@@ -51,6 +51,27 @@ namespace SI
 		return InternalHash64(str, SIZE-1, seed);
 	}
 
+	// 普通の型の128bitハッシュ. 衝突させたくないキャッシュのキーなどに使う.
+	template<typename T>
+	inline Hash128 GetHash128(const T& value, uint64_t seed = kDefaultHashSeed64)
+	{
+		return Xxh3Hash128(&value, sizeof(T), seed);
+	}
+	
+	// 文字列の128bitハッシュ.
+	inline Hash128 GetHash128(const char* const& str, uint64_t seed = kDefaultHashSeed64)
+	{
+		SI_ASSERT(str);
+		return Xxh3Hash128(str, strlen(str), seed);
+	}
+	
+	// 定数文字列の128bitハッシュ.
+	template<size_t SIZE>
+	inline Hash128 GetHash128(const char (&str)[SIZE], uint64_t seed = kDefaultHashSeed64)
+	{
+		return Xxh3Hash128(str, SIZE-1, seed);
+	}
+
 	////////////////////////////////////////////////////////////////////////////////////
 	
 #if USE_STATIC_HASH
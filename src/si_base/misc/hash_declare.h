@@ -6,4 +6,13 @@ namespace SI
 {
 	using Hash32 = uint32_t;
 	using Hash64 = uint64_t;
+
+	struct Hash128
+	{
+		uint64_t m_low;
+		uint64_t m_high;
+
+		constexpr bool operator==(const Hash128& h) const{ return m_low == h.m_low && m_high == h.m_high; }
+		constexpr bool operator!=(const Hash128& h) const{ return !(*this == h); }
+	};
 } // namespace SI
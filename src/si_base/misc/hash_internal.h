@@ -1,13 +1,15 @@
 ﻿#pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include "si_base/misc/hash_declare.h"
 
 #pragma warning(disable:4307) // '*': 整数定数がオーバーフローしました。
 
 #define USE_FNV_HASH 0
-#define USE_MURMUR2A_HASH 1
+#define USE_MURMUR2A_HASH 0
+#define USE_XXH3_HASH 1
 
 #if _MSC_VER >=1910 // VC2017
 #define USE_STATIC_HASH 1
@@ -15,6 +17,31 @@
 #define USE_STATIC_HASH 0
 #endif
 
+// XXH3の長い入力の累積に使う命令セット.
+#define SI_HASH_SIMD_SCALAR 0
+#define SI_HASH_SIMD_SSE2   1
+#define SI_HASH_SIMD_AVX2   2
+
+#if !defined(SI_HASH_SIMD)
+	#if defined(__AVX2__)
+		#define SI_HASH_SIMD SI_HASH_SIMD_AVX2
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+		#define SI_HASH_SIMD SI_HASH_SIMD_SSE2
+	#else
+		#define SI_HASH_SIMD SI_HASH_SIMD_SCALAR
+	#endif
+#endif
+
+#if SI_HASH_SIMD == SI_HASH_SIMD_AVX2
+#include <immintrin.h>
+#elif SI_HASH_SIMD == SI_HASH_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
 namespace SI
 {
 	////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,6 +55,14 @@ namespace SI
 
 	static const Hash32 kDefaultHashSeed32 = kFnvBasis32;
 	static const Hash64 kDefaultHashSeed64 = kFnvBasis64;
+
+#if SI_HASH_SIMD == SI_HASH_SIMD_AVX2
+	static const char* const kSiHashSimdName = "AVX2";
+#elif SI_HASH_SIMD == SI_HASH_SIMD_SSE2
+	static const char* const kSiHashSimdName = "SSE2";
+#else
+	static const char* const kSiHashSimdName = "Scalar";
+#endif
 	
 #if USE_FNV_HASH
 	inline Hash32 FnvHash32(const void* buffer, size_t bufferSizeInByte, uint32_t seed = kDefaultHashSeed32)
@@ -145,8 +180,8 @@ namespace SI
 #endif // USE_FNV_HASH
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////
- 
-#if USE_MURMUR2A_HASH
+	// Murmur2Aの実装. XXH3と比較できるように、選ばれていなくても定義しておく.
+
 	static const uint32_t kMurmur2APrime32 = 0x5bd1e995;
 	static const uint64_t kMurmur2APrime64 = 0xc6a4a7935bd1e995;
 	
@@ -585,7 +620,870 @@ namespace SI
 		uint64_t    m_tail;
 		uint32_t    m_tailCount;
 	};
-#endif // USE_MURMUR2A_HASH
+	///////////////////////////////////////////////////////////////////////////////////////////////////
+	// XXH3(xxHash v0.8)の実装. 値は本家のXXH3_64bits_withSeed/XXH3_128bits_withSeedと一致する.
+	// 16byteまでは数回の乗算で済ませ、240byteを超える入力は64byte単位でSIMDで累積する.
+	// 選ばれていなくても、比較できるように常に定義しておく.
+
+	namespace Xxh3
+	{
+		static const uint32_t kPrime32_1 = 0x9E3779B1u;
+		static const uint32_t kPrime32_2 = 0x85EBCA77u;
+		static const uint32_t kPrime32_3 = 0xC2B2AE3Du;
+
+		static const uint64_t kPrime64_1 = 0x9E3779B185EBCA87ull;
+		static const uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4Full;
+		static const uint64_t kPrime64_3 = 0x165667B19E3779F9ull;
+		static const uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ull;
+		static const uint64_t kPrime64_5 = 0x27D4EB2F165667C5ull;
+
+		static const uint64_t kPrimeMx1  = 0x165667919E3779F9ull;
+		static const uint64_t kPrimeMx2  = 0x9FB21C651E98DF25ull;
+
+		static const size_t kSecretSize          = 192;
+		static const size_t kSecretSizeMin       = 136;
+		static const size_t kStripeSize          = 64;
+		static const size_t kSecretConsumeRate   = 8;
+		static const size_t kAccCount            = 8;
+		static const size_t kStripesPerBlock     = (kSecretSize - kStripeSize) / kSecretConsumeRate;
+		static const size_t kBlockSize           = kStripeSize * kStripesPerBlock;
+		static const size_t kMidSizeMax          = 240;
+		static const size_t kMidSizeStartOffset  = 3;
+		static const size_t kMidSizeLastOffset   = 17;
+		static const size_t kSecretLastAccStart  = 7;
+		static const size_t kSecretMergeAccsStart = 11;
+		static const size_t kInternalBufferSize  = 256;
+		static const size_t kInternalBufferStripes = kInternalBufferSize / kStripeSize;
+
+		static constexpr uint8_t kSecret[kSecretSize] =
+		{
+			0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+			0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+			0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+			0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+			0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+			0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+			0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+			0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+			0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+			0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+			0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+			0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+		};
+
+		inline constexpr uint32_t Swap32(uint32_t x)
+		{
+			return ((x << 24) & 0xff000000u) | ((x <<  8) & 0x00ff0000u) |
+			       ((x >>  8) & 0x0000ff00u) | ((x >> 24) & 0x000000ffu);
+		}
+
+		inline constexpr uint64_t Swap64(uint64_t x)
+		{
+			return ((uint64_t)Swap32((uint32_t)x) << 32) | (uint64_t)Swap32((uint32_t)(x >> 32));
+		}
+
+		inline constexpr uint32_t Rotl32(uint32_t x, int r){ return (x << r) | (x >> (32 - r)); }
+		inline constexpr uint64_t Rotl64(uint64_t x, int r){ return (x << r) | (x >> (64 - r)); }
+
+		inline constexpr Hash128 Mult64To128Portable(uint64_t lhs, uint64_t rhs)
+		{
+			uint64_t loLo  = (lhs & 0xffffffff) * (rhs & 0xffffffff);
+			uint64_t hiLo  = (lhs >> 32)        * (rhs & 0xffffffff);
+			uint64_t loHi  = (lhs & 0xffffffff) * (rhs >> 32);
+			uint64_t hiHi  = (lhs >> 32)        * (rhs >> 32);
+			uint64_t cross = (loLo >> 32) + (hiLo & 0xffffffff) + loHi;
+			uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+			uint64_t lower = (cross << 32) | (loLo & 0xffffffff);
+			return Hash128{lower, upper};
+		}
+
+		inline constexpr uint64_t Xxh64Avalanche(uint64_t h)
+		{
+			h ^= h >> 33;
+			h *= kPrime64_2;
+			h ^= h >> 29;
+			h *= kPrime64_3;
+			h ^= h >> 32;
+			return h;
+		}
+
+		inline constexpr uint64_t Avalanche(uint64_t h)
+		{
+			h ^= h >> 37;
+			h *= kPrimeMx1;
+			h ^= h >> 32;
+			return h;
+		}
+
+		inline constexpr uint64_t Rrmxmx(uint64_t h, uint64_t len)
+		{
+			h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+			h *= kPrimeMx2;
+			h ^= (h >> 35) + len;
+			h *= kPrimeMx2;
+			h ^= h >> 28;
+			return h;
+		}
+
+		// 長い入力の64byte(stripe)毎の累積. Readerに依らずに使えるスカラー版.
+		template<typename Reader, typename T>
+		inline constexpr void AccumulateScalar(uint64_t* acc, const T* input, const uint8_t* secret, size_t stripeCount)
+		{
+			for(size_t s=0; s<stripeCount; ++s)
+			{
+				const T*       in  = input  + s * kStripeSize;
+				const uint8_t* key = secret + s * kSecretConsumeRate;
+				for(size_t i=0; i<kAccCount; ++i)
+				{
+					uint64_t dataVal = Reader::Read64(in + 8*i);
+					uint64_t dataKey = dataVal ^ Reader::Read64(key + 8*i);
+					acc[i ^ 1] += dataVal;
+					acc[i]     += (dataKey & 0xffffffff) * (dataKey >> 32);
+				}
+			}
+		}
+
+		template<typename Reader>
+		inline constexpr void ScrambleAccScalar(uint64_t* acc, const uint8_t* secret)
+		{
+			for(size_t i=0; i<kAccCount; ++i)
+			{
+				uint64_t a = acc[i];
+				a ^= a >> 47;
+				a ^= Reader::Read64(secret + 8*i);
+				a *= kPrime32_1;
+				acc[i] = a;
+			}
+		}
+
+#if SI_HASH_SIMD == SI_HASH_SIMD_AVX2
+		inline void AccumulateSimd(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripeCount)
+		{
+			__m256i a0 = _mm256_loadu_si256((const __m256i*)acc);
+			__m256i a1 = _mm256_loadu_si256((const __m256i*)acc + 1);
+			for(size_t s=0; s<stripeCount; ++s)
+			{
+				const uint8_t* in  = input  + s * kStripeSize;
+				const uint8_t* key = secret + s * kSecretConsumeRate;
+
+				__m256i d0 = _mm256_loadu_si256((const __m256i*)in);
+				__m256i d1 = _mm256_loadu_si256((const __m256i*)in + 1);
+				__m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i*)key));
+				__m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i*)key + 1));
+
+				// 上位32bitと下位32bitの積と、隣のレーンへの入力の加算.
+				__m256i p0 = _mm256_mul_epu32(k0, _mm256_shuffle_epi32(k0, _MM_SHUFFLE(0, 3, 0, 1)));
+				__m256i p1 = _mm256_mul_epu32(k1, _mm256_shuffle_epi32(k1, _MM_SHUFFLE(0, 3, 0, 1)));
+				a0 = _mm256_add_epi64(a0, _mm256_add_epi64(p0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+				a1 = _mm256_add_epi64(a1, _mm256_add_epi64(p1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+			}
+			_mm256_storeu_si256((__m256i*)acc,     a0);
+			_mm256_storeu_si256((__m256i*)acc + 1, a1);
+		}
+
+		inline void ScrambleAccSimd(uint64_t* acc, const uint8_t* secret)
+		{
+			const __m256i prime = _mm256_set1_epi32((int)kPrime32_1);
+			for(size_t i=0; i<2; ++i)
+			{
+				__m256i a = _mm256_loadu_si256((const __m256i*)acc + i);
+				a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+				a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i*)secret + i));
+
+				__m256i lo = _mm256_mul_epu32(a, prime);
+				__m256i hi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+				_mm256_storeu_si256((__m256i*)acc + i, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+			}
+		}
+#elif SI_HASH_SIMD == SI_HASH_SIMD_SSE2
+		inline void AccumulateSimd(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripeCount)
+		{
+			__m128i a[4];
+			for(size_t i=0; i<4; ++i){ a[i] = _mm_loadu_si128((const __m128i*)acc + i); }
+
+			for(size_t s=0; s<stripeCount; ++s)
+			{
+				const uint8_t* in  = input  + s * kStripeSize;
+				const uint8_t* key = secret + s * kSecretConsumeRate;
+				for(size_t i=0; i<4; ++i)
+				{
+					__m128i d = _mm_loadu_si128((const __m128i*)in + i);
+					__m128i k = _mm_xor_si128(d, _mm_loadu_si128((const __m128i*)key + i));
+
+					// 上位32bitと下位32bitの積と、隣のレーンへの入力の加算.
+					__m128i p = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+					a[i] = _mm_add_epi64(a[i], _mm_add_epi64(p, _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))));
+				}
+			}
+
+			for(size_t i=0; i<4; ++i){ _mm_storeu_si128((__m128i*)acc + i, a[i]); }
+		}
+
+		inline void ScrambleAccSimd(uint64_t* acc, const uint8_t* secret)
+		{
+			const __m128i prime = _mm_set1_epi32((int)kPrime32_1);
+			for(size_t i=0; i<4; ++i)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)acc + i);
+				a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+				a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)secret + i));
+
+				__m128i lo = _mm_mul_epu32(a, prime);
+				__m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+				_mm_storeu_si128((__m128i*)acc + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+			}
+		}
+#endif
+
+		// 実行時用. memcpyで読み、長い入力はSIMDで累積する.
+		struct RuntimeReader
+		{
+			template<typename T>
+			static uint32_t Read32(const T* p)
+			{
+				uint32_t v = 0;
+				memcpy(&v, p, sizeof(v));
+				return v;
+			}
+
+			template<typename T>
+			static uint64_t Read64(const T* p)
+			{
+				uint64_t v = 0;
+				memcpy(&v, p, sizeof(v));
+				return v;
+			}
+
+			static void Write64(uint8_t* p, uint64_t v)
+			{
+				memcpy(p, &v, sizeof(v));
+			}
+
+			static Hash128 Mult64To128(uint64_t lhs, uint64_t rhs)
+			{
+#if defined(_MSC_VER) && defined(_M_X64)
+				Hash128 r = {};
+				r.m_low = _umul128(lhs, rhs, &r.m_high);
+				return r;
+#elif defined(__SIZEOF_INT128__)
+				unsigned __int128 p = (unsigned __int128)lhs * rhs;
+				return Hash128{(uint64_t)p, (uint64_t)(p >> 64)};
+#else
+				return Mult64To128Portable(lhs, rhs);
+#endif
+			}
+
+			static void Accumulate(uint64_t* acc, const uint8_t* input, const uint8_t* secret, size_t stripeCount)
+			{
+#if SI_HASH_SIMD == SI_HASH_SIMD_SCALAR
+				AccumulateScalar<RuntimeReader>(acc, input, secret, stripeCount);
+#else
+				AccumulateSimd(acc, input, secret, stripeCount);
+#endif
+			}
+
+			static void ScrambleAcc(uint64_t* acc, const uint8_t* secret)
+			{
+#if SI_HASH_SIMD == SI_HASH_SIMD_SCALAR
+				ScrambleAccScalar<RuntimeReader>(acc, secret);
+#else
+				ScrambleAccSimd(acc, secret);
+#endif
+			}
+		};
+
+		// コンパイル時用. ポインタのキャストが出来ないので、const char*から1byteずつ組み立てる.
+		struct StaticReader
+		{
+			template<typename T>
+			static constexpr uint32_t Read32(const T* p)
+			{
+				return
+					((uint32_t)(uint8_t)p[0]      ) |
+					((uint32_t)(uint8_t)p[1] <<  8) |
+					((uint32_t)(uint8_t)p[2] << 16) |
+					((uint32_t)(uint8_t)p[3] << 24);
+			}
+
+			template<typename T>
+			static constexpr uint64_t Read64(const T* p)
+			{
+				return (uint64_t)Read32(p) | ((uint64_t)Read32(p + 4) << 32);
+			}
+
+			static constexpr void Write64(uint8_t* p, uint64_t v)
+			{
+				for(size_t i=0; i<8; ++i){ p[i] = (uint8_t)(v >> (8*i)); }
+			}
+
+			static constexpr Hash128 Mult64To128(uint64_t lhs, uint64_t rhs)
+			{
+				return Mult64To128Portable(lhs, rhs);
+			}
+
+			static constexpr void Accumulate(uint64_t* acc, const char* input, const uint8_t* secret, size_t stripeCount)
+			{
+				AccumulateScalar<StaticReader>(acc, input, secret, stripeCount);
+			}
+
+			static constexpr void ScrambleAcc(uint64_t* acc, const uint8_t* secret)
+			{
+				ScrambleAccScalar<StaticReader>(acc, secret);
+			}
+		};
+
+		// 以下はReaderで読み方だけを変えて、実行時とコンパイル時で同じ処理を使う.
+
+		template<typename Reader>
+		inline constexpr uint64_t Mul128Fold64(uint64_t lhs, uint64_t rhs)
+		{
+			Hash128 p = Reader::Mult64To128(lhs, rhs);
+			return p.m_low ^ p.m_high;
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr uint64_t Mix16B(const T* input, const uint8_t* secret, uint64_t seed)
+		{
+			uint64_t inputLo = Reader::Read64(input);
+			uint64_t inputHi = Reader::Read64(input + 8);
+			return Mul128Fold64<Reader>(
+				inputLo ^ (Reader::Read64(secret)     + seed),
+				inputHi ^ (Reader::Read64(secret + 8) - seed));
+		}
+
+		template<typename Reader>
+		inline constexpr void InitSecret(uint8_t* outSecret, uint64_t seed)
+		{
+			for(size_t i=0; i<kSecretSize/16; ++i)
+			{
+				Reader::Write64(outSecret + 16*i,     Reader::Read64(kSecret + 16*i)     + seed);
+				Reader::Write64(outSecret + 16*i + 8, Reader::Read64(kSecret + 16*i + 8) - seed);
+			}
+		}
+
+		struct Secret
+		{
+			uint8_t m_data[kSecretSize];
+		};
+
+		inline constexpr Secret MakeSecret(uint64_t seed)
+		{
+			Secret secret = {};
+			InitSecret<StaticReader>(secret.m_data, seed);
+			return secret;
+		}
+
+		// 既定のシードのsecretはコンパイル時に作っておく.
+		// 192byteを書き込むので、呼ぶたびに作ると短い入力ではハッシュ本体より重くなる.
+		static constexpr Secret kDefaultSeedSecret = MakeSecret(kDefaultHashSeed64);
+
+		// 作っておいたsecretがあるシードならそれを返す. 無ければnullptr.
+		inline constexpr const uint8_t* GetPrebuiltSecret(uint64_t seed)
+		{
+			return
+				(seed == 0)?                  kSecret :
+				(seed == kDefaultHashSeed64)? kDefaultSeedSecret.m_data :
+				nullptr;
+		}
+
+		// 作っておいたものが無いシードは、customSecretに作って返す.
+		template<typename Reader>
+		inline constexpr const uint8_t* SelectSecret(uint8_t* customSecret, uint64_t seed)
+		{
+			const uint8_t* prebuilt = GetPrebuiltSecret(seed);
+			if(prebuilt) return prebuilt;
+
+			InitSecret<Reader>(customSecret, seed);
+			return customSecret;
+		}
+
+		// 長い入力の、最後のstripeの手前まで. 最後のstripeは呼び出し側で処理する.
+		template<typename Reader, typename T>
+		inline constexpr void HashLongInternal(uint64_t* acc, const T* input, size_t len, const uint8_t* secret)
+		{
+			size_t blockCount = (len - 1) / kBlockSize;
+			for(size_t b=0; b<blockCount; ++b)
+			{
+				Reader::Accumulate(acc, input + b * kBlockSize, secret, kStripesPerBlock);
+				Reader::ScrambleAcc(acc, secret + kSecretSize - kStripeSize);
+			}
+
+			size_t stripeCount = ((len - 1) - kBlockSize * blockCount) / kStripeSize;
+			Reader::Accumulate(acc, input + blockCount * kBlockSize, secret, stripeCount);
+
+			Reader::Accumulate(acc, input + len - kStripeSize, secret + kSecretSize - kStripeSize - kSecretLastAccStart, 1);
+		}
+
+		template<typename Reader>
+		inline constexpr uint64_t MergeAccs(const uint64_t* acc, const uint8_t* secret, uint64_t start)
+		{
+			uint64_t result = start;
+			for(size_t i=0; i<4; ++i)
+			{
+				result += Mul128Fold64<Reader>(
+					acc[2*i]     ^ Reader::Read64(secret + 16*i),
+					acc[2*i + 1] ^ Reader::Read64(secret + 16*i + 8));
+			}
+			return Avalanche(result);
+		}
+
+		inline constexpr void InitAcc(uint64_t* acc)
+		{
+			acc[0] = kPrime32_3;
+			acc[1] = kPrime64_1;
+			acc[2] = kPrime64_2;
+			acc[3] = kPrime64_3;
+			acc[4] = kPrime64_4;
+			acc[5] = kPrime32_2;
+			acc[6] = kPrime64_5;
+			acc[7] = kPrime32_1;
+		}
+
+		////////////////////////////////////////////////////////////////////////////////
+		// 64bit
+
+		template<typename Reader, typename T>
+		inline constexpr uint64_t Hash64Len0To16(const T* input, size_t len, uint64_t seed)
+		{
+			const uint8_t* secret = kSecret;
+			if(8 < len)
+			{
+				uint64_t bitflip1 = (Reader::Read64(secret + 24) ^ Reader::Read64(secret + 32)) + seed;
+				uint64_t bitflip2 = (Reader::Read64(secret + 40) ^ Reader::Read64(secret + 48)) - seed;
+				uint64_t inputLo  = Reader::Read64(input)           ^ bitflip1;
+				uint64_t inputHi  = Reader::Read64(input + len - 8) ^ bitflip2;
+				uint64_t acc = len + Swap64(inputLo) + inputHi + Mul128Fold64<Reader>(inputLo, inputHi);
+				return Avalanche(acc);
+			}
+			if(4 <= len)
+			{
+				seed ^= (uint64_t)Swap32((uint32_t)seed) << 32;
+				uint32_t input1  = Reader::Read32(input);
+				uint32_t input2  = Reader::Read32(input + len - 4);
+				uint64_t bitflip = (Reader::Read64(secret + 8) ^ Reader::Read64(secret + 16)) - seed;
+				uint64_t input64 = input2 + ((uint64_t)input1 << 32);
+				return Rrmxmx(input64 ^ bitflip, len);
+			}
+			if(0 < len)
+			{
+				uint32_t c1 = (uint8_t)input[0];
+				uint32_t c2 = (uint8_t)input[len >> 1];
+				uint32_t c3 = (uint8_t)input[len - 1];
+				uint32_t combined = (c1 << 16) | (c2 << 24) | (c3 << 0) | ((uint32_t)len << 8);
+				uint64_t bitflip  = (Reader::Read32(secret) ^ Reader::Read32(secret + 4)) + seed;
+				return Xxh64Avalanche((uint64_t)combined ^ bitflip);
+			}
+			return Xxh64Avalanche(seed ^ (Reader::Read64(secret + 56) ^ Reader::Read64(secret + 64)));
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr uint64_t Hash64Len17To128(const T* input, size_t len, uint64_t seed)
+		{
+			const uint8_t* secret = kSecret;
+			uint64_t acc = len * kPrime64_1;
+			if(32 < len)
+			{
+				if(64 < len)
+				{
+					if(96 < len)
+					{
+						acc += Mix16B<Reader>(input + 48,       secret + 96,  seed);
+						acc += Mix16B<Reader>(input + len - 64, secret + 112, seed);
+					}
+					acc += Mix16B<Reader>(input + 32,       secret + 64, seed);
+					acc += Mix16B<Reader>(input + len - 48, secret + 80, seed);
+				}
+				acc += Mix16B<Reader>(input + 16,       secret + 32, seed);
+				acc += Mix16B<Reader>(input + len - 32, secret + 48, seed);
+			}
+			acc += Mix16B<Reader>(input,            secret,      seed);
+			acc += Mix16B<Reader>(input + len - 16, secret + 16, seed);
+			return Avalanche(acc);
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr uint64_t Hash64Len129To240(const T* input, size_t len, uint64_t seed)
+		{
+			const uint8_t* secret = kSecret;
+			uint64_t acc = len * kPrime64_1;
+			size_t roundCount = len / 16;
+			for(size_t i=0; i<8; ++i)
+			{
+				acc += Mix16B<Reader>(input + 16*i, secret + 16*i, seed);
+			}
+			acc = Avalanche(acc);
+
+			uint64_t accEnd = Mix16B<Reader>(input + len - 16, secret + kSecretSizeMin - kMidSizeLastOffset, seed);
+			for(size_t i=8; i<roundCount; ++i)
+			{
+				accEnd += Mix16B<Reader>(input + 16*i, secret + 16*(i - 8) + kMidSizeStartOffset, seed);
+			}
+			return Avalanche(acc + accEnd);
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr uint64_t Hash64Long(const T* input, size_t len, uint64_t seed)
+		{
+			uint8_t customSecret[kSecretSize] = {};
+			const uint8_t* secret = SelectSecret<Reader>(customSecret, seed);
+
+			uint64_t acc[kAccCount] = {};
+			InitAcc(acc);
+			HashLongInternal<Reader>(acc, input, len, secret);
+
+			return MergeAccs<Reader>(acc, secret + kSecretMergeAccsStart, (uint64_t)len * kPrime64_1);
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr uint64_t Compute64(const T* input, size_t len, uint64_t seed)
+		{
+			if(len <= 16)          return Hash64Len0To16   <Reader>(input, len, seed);
+			if(len <= 128)         return Hash64Len17To128 <Reader>(input, len, seed);
+			if(len <= kMidSizeMax) return Hash64Len129To240<Reader>(input, len, seed);
+			return Hash64Long<Reader>(input, len, seed);
+		}
+
+		////////////////////////////////////////////////////////////////////////////////
+		// 128bit
+
+		template<typename Reader, typename T>
+		inline constexpr Hash128 Mix32B(Hash128 acc, const T* input1, const T* input2, const uint8_t* secret, uint64_t seed)
+		{
+			acc.m_low  += Mix16B<Reader>(input1, secret, seed);
+			acc.m_low  ^= Reader::Read64(input2) + Reader::Read64(input2 + 8);
+			acc.m_high += Mix16B<Reader>(input2, secret + 16, seed);
+			acc.m_high ^= Reader::Read64(input1) + Reader::Read64(input1 + 8);
+			return acc;
+		}
+
+		inline constexpr Hash128 FinalizeMid128(Hash128 acc, size_t len, uint64_t seed)
+		{
+			Hash128 h = {};
+			h.m_low  = acc.m_low + acc.m_high;
+			h.m_high = (acc.m_low * kPrime64_1) + (acc.m_high * kPrime64_4) + ((len - seed) * kPrime64_2);
+			h.m_low  = Avalanche(h.m_low);
+			h.m_high = (uint64_t)0 - Avalanche(h.m_high);
+			return h;
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr Hash128 Hash128Len0To16(const T* input, size_t len, uint64_t seed)
+		{
+			const uint8_t* secret = kSecret;
+			if(8 < len)
+			{
+				uint64_t bitflipl = (Reader::Read64(secret + 32) ^ Reader::Read64(secret + 40)) - seed;
+				uint64_t bitfliph = (Reader::Read64(secret + 48) ^ Reader::Read64(secret + 56)) + seed;
+				uint64_t inputLo  = Reader::Read64(input);
+				uint64_t inputHi  = Reader::Read64(input + len - 8);
+
+				Hash128 m = Reader::Mult64To128(inputLo ^ inputHi ^ bitflipl, kPrime64_1);
+				m.m_low  += (uint64_t)(len - 1) << 54;
+				inputHi  ^= bitfliph;
+				m.m_high += inputHi + (uint64_t)(uint32_t)inputHi * (kPrime32_2 - 1);
+				m.m_low  ^= Swap64(m.m_high);
+
+				Hash128 h = Reader::Mult64To128(m.m_low, kPrime64_2);
+				h.m_high += m.m_high * kPrime64_2;
+				h.m_low   = Avalanche(h.m_low);
+				h.m_high  = Avalanche(h.m_high);
+				return h;
+			}
+			if(4 <= len)
+			{
+				seed ^= (uint64_t)Swap32((uint32_t)seed) << 32;
+				uint32_t inputLo = Reader::Read32(input);
+				uint32_t inputHi = Reader::Read32(input + len - 4);
+				uint64_t input64 = inputLo + ((uint64_t)inputHi << 32);
+				uint64_t bitflip = (Reader::Read64(secret + 16) ^ Reader::Read64(secret + 24)) + seed;
+
+				Hash128 m = Reader::Mult64To128(input64 ^ bitflip, kPrime64_1 + (len << 2));
+				m.m_high += m.m_low << 1;
+				m.m_low  ^= m.m_high >> 3;
+				m.m_low  ^= m.m_low >> 35;
+				m.m_low  *= kPrimeMx2;
+				m.m_low  ^= m.m_low >> 28;
+				m.m_high  = Avalanche(m.m_high);
+				return m;
+			}
+			if(0 < len)
+			{
+				uint32_t c1 = (uint8_t)input[0];
+				uint32_t c2 = (uint8_t)input[len >> 1];
+				uint32_t c3 = (uint8_t)input[len - 1];
+				uint32_t combinedl = (c1 << 16) | (c2 << 24) | (c3 << 0) | ((uint32_t)len << 8);
+				uint32_t combinedh = Rotl32(Swap32(combinedl), 13);
+				uint64_t bitflipl  = (Reader::Read32(secret)     ^ Reader::Read32(secret + 4))  + seed;
+				uint64_t bitfliph  = (Reader::Read32(secret + 8) ^ Reader::Read32(secret + 12)) - seed;
+				return Hash128{
+					Xxh64Avalanche((uint64_t)combinedl ^ bitflipl),
+					Xxh64Avalanche((uint64_t)combinedh ^ bitfliph)};
+			}
+			return Hash128{
+				Xxh64Avalanche(seed ^ Reader::Read64(secret + 64) ^ Reader::Read64(secret + 72)),
+				Xxh64Avalanche(seed ^ Reader::Read64(secret + 80) ^ Reader::Read64(secret + 88))};
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr Hash128 Hash128Len17To128(const T* input, size_t len, uint64_t seed)
+		{
+			const uint8_t* secret = kSecret;
+			Hash128 acc = {len * kPrime64_1, 0};
+			if(32 < len)
+			{
+				if(64 < len)
+				{
+					if(96 < len)
+					{
+						acc = Mix32B<Reader>(acc, input + 48, input + len - 64, secret + 96, seed);
+					}
+					acc = Mix32B<Reader>(acc, input + 32, input + len - 48, secret + 64, seed);
+				}
+				acc = Mix32B<Reader>(acc, input + 16, input + len - 32, secret + 32, seed);
+			}
+			acc = Mix32B<Reader>(acc, input, input + len - 16, secret, seed);
+			return FinalizeMid128(acc, len, seed);
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr Hash128 Hash128Len129To240(const T* input, size_t len, uint64_t seed)
+		{
+			const uint8_t* secret = kSecret;
+			Hash128 acc = {len * kPrime64_1, 0};
+			for(size_t i=32; i<160; i+=32)
+			{
+				acc = Mix32B<Reader>(acc, input + i - 32, input + i - 16, secret + i - 32, seed);
+			}
+			acc.m_low  = Avalanche(acc.m_low);
+			acc.m_high = Avalanche(acc.m_high);
+
+			for(size_t i=160; i<=len; i+=32)
+			{
+				acc = Mix32B<Reader>(acc, input + i - 32, input + i - 16, secret + kMidSizeStartOffset + i - 160, seed);
+			}
+
+			acc = Mix32B<Reader>(acc, input + len - 16, input + len - 32, secret + kSecretSizeMin - kMidSizeLastOffset - 16, (uint64_t)0 - seed);
+			return FinalizeMid128(acc, len, seed);
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr Hash128 Hash128Long(const T* input, size_t len, uint64_t seed)
+		{
+			uint8_t customSecret[kSecretSize] = {};
+			const uint8_t* secret = SelectSecret<Reader>(customSecret, seed);
+
+			uint64_t acc[kAccCount] = {};
+			InitAcc(acc);
+			HashLongInternal<Reader>(acc, input, len, secret);
+
+			return Hash128{
+				MergeAccs<Reader>(acc, secret + kSecretMergeAccsStart, (uint64_t)len * kPrime64_1),
+				MergeAccs<Reader>(acc, secret + kSecretSize - kStripeSize - kSecretMergeAccsStart, ~((uint64_t)len * kPrime64_2))};
+		}
+
+		template<typename Reader, typename T>
+		inline constexpr Hash128 Compute128(const T* input, size_t len, uint64_t seed)
+		{
+			if(len <= 16)          return Hash128Len0To16   <Reader>(input, len, seed);
+			if(len <= 128)         return Hash128Len17To128 <Reader>(input, len, seed);
+			if(len <= kMidSizeMax) return Hash128Len129To240<Reader>(input, len, seed);
+			return Hash128Long<Reader>(input, len, seed);
+		}
+
+	} // namespace Xxh3
+
+	inline Hash32 Xxh3Hash32(const void* buffer, size_t bufferSizeInByte, uint32_t seed = kDefaultHashSeed32)
+	{
+		// XXH3に32bit版は無いので、64bit版の下位を使う.
+		return (Hash32)Xxh3::Compute64<Xxh3::RuntimeReader>((const uint8_t*)buffer, bufferSizeInByte, seed);
+	}
+
+	inline Hash64 Xxh3Hash64(const void* buffer, size_t bufferSizeInByte, uint64_t seed = kDefaultHashSeed64)
+	{
+		return Xxh3::Compute64<Xxh3::RuntimeReader>((const uint8_t*)buffer, bufferSizeInByte, seed);
+	}
+
+	inline Hash128 Xxh3Hash128(const void* buffer, size_t bufferSizeInByte, uint64_t seed = kDefaultHashSeed64)
+	{
+		return Xxh3::Compute128<Xxh3::RuntimeReader>((const uint8_t*)buffer, bufferSizeInByte, seed);
+	}
+
+#if USE_STATIC_HASH
+	inline constexpr Hash32 StaticXxh3Hash32(const char* buffer, size_t bufferSizeInByte, uint32_t seed = kDefaultHashSeed32)
+	{
+		return (Hash32)Xxh3::Compute64<Xxh3::StaticReader>(buffer, bufferSizeInByte, seed);
+	}
+
+	inline constexpr Hash64 StaticXxh3Hash64(const char* buffer, size_t bufferSizeInByte, uint64_t seed = kDefaultHashSeed64)
+	{
+		return Xxh3::Compute64<Xxh3::StaticReader>(buffer, bufferSizeInByte, seed);
+	}
+#endif
+
+	// XXH3のストリーミング版. 何回に分けてAddしても、まとめてXxh3Hash64した値と一致する.
+	class Xxh3Hash64Generator
+	{
+	public:
+		Xxh3Hash64Generator(uint64_t seed = kDefaultHashSeed64)
+		{
+			Reset(seed);
+		}
+
+		void Reset(uint64_t seed = kDefaultHashSeed64)
+		{
+			Xxh3::InitAcc(m_acc);
+			if(!Xxh3::GetPrebuiltSecret(seed))
+			{
+				Xxh3::InitSecret<Xxh3::RuntimeReader>(m_customSecret, seed);
+			}
+			m_seed         = seed;
+			m_totalSize    = 0;
+			m_bufferedSize = 0;
+			m_stripeCount  = 0;
+		}
+
+		void Add(const void* buffer, size_t bufferSizeInByte)
+		{
+			const uint8_t* data = (const uint8_t*)buffer;
+			const uint8_t* end  = data + bufferSizeInByte;
+			m_totalSize += bufferSizeInByte;
+
+			if(m_bufferedSize + bufferSizeInByte <= Xxh3::kInternalBufferSize)
+			{
+				if(0 < bufferSizeInByte)
+				{
+					memcpy(m_buffer + m_bufferedSize, data, bufferSizeInByte);
+				}
+				m_bufferedSize += bufferSizeInByte;
+				return;
+			}
+
+			// 最後のstripeはGenerateで扱いが変わるので、必ず1byte以上はバッファに残しておく.
+			if(0 < m_bufferedSize)
+			{
+				size_t loadSize = Xxh3::kInternalBufferSize - m_bufferedSize;
+				memcpy(m_buffer + m_bufferedSize, data, loadSize);
+				data += loadSize;
+				ConsumeStripes(m_acc, m_stripeCount, m_buffer, Xxh3::kInternalBufferStripes);
+				m_bufferedSize = 0;
+			}
+
+			if(Xxh3::kInternalBufferSize < (size_t)(end - data))
+			{
+				// 長い入力は、バッファを通さずに直接累積する.
+				do
+				{
+					ConsumeStripes(m_acc, m_stripeCount, data, Xxh3::kInternalBufferStripes);
+					data += Xxh3::kInternalBufferSize;
+				} while(Xxh3::kInternalBufferSize < (size_t)(end - data));
+
+				// バッファに残る分が1stripeに満たない時のために、直前のstripeを取っておく.
+				memcpy(m_buffer + Xxh3::kInternalBufferSize - Xxh3::kStripeSize, data - Xxh3::kStripeSize, Xxh3::kStripeSize);
+			}
+
+			m_bufferedSize = (size_t)(end - data);
+			memcpy(m_buffer, data, m_bufferedSize);
+		}
+
+		Hash64 Generate() const
+		{
+			if(m_totalSize <= Xxh3::kMidSizeMax)
+			{
+				return Xxh3Hash64(m_buffer, (size_t)m_totalSize, m_seed);
+			}
+
+			uint64_t acc[Xxh3::kAccCount];
+			memcpy(acc, m_acc, sizeof(acc));
+
+			const uint8_t* lastStripe = nullptr;
+			uint8_t lastStripeBuffer[Xxh3::kStripeSize];
+			if(Xxh3::kStripeSize <= m_bufferedSize)
+			{
+				size_t stripeCount = m_stripeCount;
+				ConsumeStripes(acc, stripeCount, m_buffer, (m_bufferedSize - 1) / Xxh3::kStripeSize);
+				lastStripe = m_buffer + m_bufferedSize - Xxh3::kStripeSize;
+			}
+			else
+			{
+				// 取っておいた直前のstripeの後ろと、バッファの中身をつなげる.
+				size_t catchupSize = Xxh3::kStripeSize - m_bufferedSize;
+				memcpy(lastStripeBuffer, m_buffer + Xxh3::kInternalBufferSize - catchupSize, catchupSize);
+				memcpy(lastStripeBuffer + catchupSize, m_buffer, m_bufferedSize);
+				lastStripe = lastStripeBuffer;
+			}
+
+			const uint8_t* secret = GetSecret();
+			Xxh3::RuntimeReader::Accumulate(acc, lastStripe, secret + Xxh3::kSecretSize - Xxh3::kStripeSize - Xxh3::kSecretLastAccStart, 1);
+			return Xxh3::MergeAccs<Xxh3::RuntimeReader>(acc, secret + Xxh3::kSecretMergeAccsStart, m_totalSize * Xxh3::kPrime64_1);
+		}
+
+	private:
+		// 既定のシードと0は作っておいたものを使うので、m_customSecretはそれ以外のシードの時だけ作る.
+		// コピーされても指す先が変わらないように、ポインタは持たずに毎回選ぶ.
+		const uint8_t* GetSecret() const
+		{
+			const uint8_t* prebuilt = Xxh3::GetPrebuiltSecret(m_seed);
+			return prebuilt? prebuilt : m_customSecret;
+		}
+
+		void ConsumeStripes(uint64_t* acc, size_t& stripeCountInBlock, const uint8_t* data, size_t stripeCount) const
+		{
+			const uint8_t* secret = GetSecret();
+			const uint8_t* scrambleSecret = secret + Xxh3::kSecretSize - Xxh3::kStripeSize;
+			if(Xxh3::kStripesPerBlock - stripeCountInBlock <= stripeCount)
+			{
+				// ブロックの終わりをまたぐ.
+				size_t toEnd = Xxh3::kStripesPerBlock - stripeCountInBlock;
+				size_t after = stripeCount - toEnd;
+				Xxh3::RuntimeReader::Accumulate(acc, data, secret + stripeCountInBlock * Xxh3::kSecretConsumeRate, toEnd);
+				Xxh3::RuntimeReader::ScrambleAcc(acc, scrambleSecret);
+				Xxh3::RuntimeReader::Accumulate(acc, data + toEnd * Xxh3::kStripeSize, secret, after);
+				stripeCountInBlock = after;
+			}
+			else
+			{
+				Xxh3::RuntimeReader::Accumulate(acc, data, secret + stripeCountInBlock * Xxh3::kSecretConsumeRate, stripeCount);
+				stripeCountInBlock += stripeCount;
+			}
+		}
+
+	private:
+		uint64_t    m_acc[Xxh3::kAccCount];
+		uint8_t     m_customSecret[Xxh3::kSecretSize];
+		uint8_t     m_buffer[Xxh3::kInternalBufferSize];
+		uint64_t    m_seed;
+		uint64_t    m_totalSize;
+		size_t      m_bufferedSize;
+		size_t      m_stripeCount;  // 今のブロックで累積したstripeの数.
+	};
+
+	class Xxh3Hash32Generator
+	{
+	public:
+		Xxh3Hash32Generator(uint32_t seed = kDefaultHashSeed32)
+			: m_generator(seed)
+		{
+		}
+
+		void Reset(uint32_t seed = kDefaultHashSeed32)
+		{
+			m_generator.Reset(seed);
+		}
+
+		void Add(const void* buffer, size_t bufferSizeInByte)
+		{
+			m_generator.Add(buffer, bufferSizeInByte);
+		}
+
+		Hash32 Generate() const
+		{
+			return (Hash32)m_generator.Generate();
+		}
+
+	private:
+		Xxh3Hash64Generator m_generator;
+	};
+
 	
 #if USE_FNV_HASH
 	inline Hash32 InternalHash32(const void* buffer, size_t bufferSizeInByte, uint32_t seed = kDefaultHashSeed32)
@@ -640,6 +1538,33 @@ namespace SI
 	using InternalHash32Generator = Murmur2AHash32Generator;
 	using InternalHash64Generator = Murmur2AHash64Generator;
 
+#elif USE_XXH3_HASH
+
+	inline Hash32 InternalHash32(const void* buffer, size_t bufferSizeInByte, uint32_t seed = kDefaultHashSeed32)
+	{ 
+		return Xxh3Hash32(buffer, bufferSizeInByte, seed);
+	}
+
+	inline Hash64 InternalHash64(const void* buffer, size_t bufferSizeInByte, uint64_t seed = kDefaultHashSeed64)
+	{
+		return Xxh3Hash64(buffer, bufferSizeInByte, seed);
+	}
+
+#if USE_STATIC_HASH
+	inline constexpr Hash32 StaticInternalHash32(const char* buffer, size_t bufferSizeInByte, uint32_t seed = kDefaultHashSeed32)
+	{
+		return StaticXxh3Hash32(buffer, bufferSizeInByte, seed);
+	}
+	
+	inline constexpr Hash64 StaticInternalHash64(const char* buffer, size_t bufferSizeInByte, uint64_t seed = kDefaultHashSeed64)
+	{
+		return StaticXxh3Hash64(buffer, bufferSizeInByte, seed);
+	}
+#endif // USE_STATIC_HASH
+	
+	using InternalHash32Generator = Xxh3Hash32Generator;
+	using InternalHash64Generator = Xxh3Hash64Generator;
+
 #else
 #error "Hash algorithm required."
 #endif
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace SI
+{
+	// 64bitキーでのLSD基数ソート(8bit x 8パス). 安定ソート.
+	// itemsとworkは同じ要素数を持つこと. 結果はitemsに入る.
+	// getKeyは const T& から uint64_t を返す関数.
+	// 全要素で同じ値になる桁はパスごと省くので、上位ビットが揃っているキーは速い.
+	template<typename T, typename GetKey>
+	void RadixSort64(T* items, T* work, size_t count, GetKey getKey)
+	{
+		if(count <= 1) return;
+
+		static const uint32_t kRadixBits = 8;
+		static const uint32_t kRadix     = 1u << kRadixBits;
+		static const uint32_t kPassCount = 64 / kRadixBits;
+
+		// 全パスのヒストグラムを1回の走査で作る.
+		size_t histograms[kPassCount][kRadix];
+		memset(histograms, 0, sizeof(histograms));
+
+		for(size_t i=0; i<count; ++i)
+		{
+			uint64_t key = getKey(items[i]);
+			for(uint32_t p=0; p<kPassCount; ++p)
+			{
+				++histograms[p][(key >> (p * kRadixBits)) & (kRadix-1)];
+			}
+		}
+
+		T* src = items;
+		T* dst = work;
+		for(uint32_t p=0; p<kPassCount; ++p)
+		{
+			size_t* histogram = histograms[p];
+			uint32_t shift = p * kRadixBits;
+
+			// 全要素が同じ桁を持つなら並び替え不要.
+			uint32_t firstDigit = (uint32_t)((getKey(src[0]) >> shift) & (kRadix-1));
+			if(histogram[firstDigit] == count) continue;
+
+			size_t offset = 0;
+			for(uint32_t d=0; d<kRadix; ++d)
+			{
+				size_t c = histogram[d];
+				histogram[d] = offset;
+				offset += c;
+			}
+
+			for(size_t i=0; i<count; ++i)
+			{
+				uint32_t digit = (uint32_t)((getKey(src[i]) >> shift) & (kRadix-1));
+				dst[histogram[digit]++] = src[i];
+			}
+
+			T* tmp = src;
+			src = dst;
+			dst = tmp;
+		}
+
+		if(src != items)
+		{
+			for(size_t i=0; i<count; ++i)
+			{
+				items[i] = src[i];
+			}
+		}
+	}
+
+} // namespace SI
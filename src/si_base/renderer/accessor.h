@@ -5,6 +5,7 @@
 #include "si_base/core/assert.h"
 
 #include "si_base/gpu/gfx.h"
+#include "si_base/math/vfloat3.h"
 
 namespace SI
 {
@@ -15,6 +16,7 @@ namespace SI
 			: m_buffer()
 			, m_count(0)
 			, m_format(GfxFormat::Unknown)
+			, m_hasBounds(false)
 		{
 		}
 
@@ -25,6 +27,7 @@ namespace SI
 			: m_buffer(buffer)
 			, m_count(count)
 			, m_format(format)
+			, m_hasBounds(false)
 		{
 		}
 
@@ -53,10 +56,19 @@ namespace SI
 
 		uint32_t GetSizeInByte() const{ return (uint32_t)((m_count * GetFormatBits(m_format)) / 8); }
 
+		// 要素の最小値と最大値. glTFのaccessorのmin/max(3要素の時だけ)から設定する.
+		void SetBounds(Vfloat3_arg minValue, Vfloat3_arg maxValue){ m_min = minValue; m_max = maxValue; m_hasBounds = true; }
+		bool HasBounds() const{ return m_hasBounds; }
+		Vfloat3 GetMin() const{ return m_min; }
+		Vfloat3 GetMax() const{ return m_max; }
+
 	private:
 		GfxBuffer            m_buffer;
 		uint32_t             m_count;
 		GfxFormat            m_format;
+		bool                 m_hasBounds;
+		Vfloat3              m_min;
+		Vfloat3              m_max;
 	};
 
 } // namespace SI
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <chrono>
 
 #include <GLTFSDK/GLTF.h>
 #include <GLTFSDK/GLTFResourceReader.h>
@@ -12,7 +13,9 @@
 #include <GLTFSDK/ResourceReaderUtils.h>
 
 #include "si_base/file/path.h"
-#include "si_base/file/file_utility.h"
+#include "si_base/file/mapped_file.h"
+#include "si_base/file/async_file_loader.h"
+#include "si_base/concurency/job_system.h"
 #include "si_base/core/assert.h"
 #include "si_base/platform/windows_proxy.h"
 
@@ -156,6 +159,65 @@ namespace SI
 			return GfxSemantics();
 		}
 
+		// bufferの中身. 外部ファイルは読み込みのリクエストが持つマッピングを参照して、
+		// base64の時だけデコードしたものを持つ.
+		struct BufferData
+		{
+			AsyncFileRequest     m_request;
+			std::vector<uint8_t> m_decoded;
+
+			const uint8_t* GetData() const
+			{
+				return m_request.IsValid()? m_request.GetData() : m_decoded.data();
+			}
+
+			size_t GetSize() const
+			{
+				return m_request.IsValid()? m_request.GetSize() : m_decoded.size();
+			}
+		};
+
+		enum class ImageSource
+		{
+			Invalid,
+			Base64,
+			BufferView,
+			File,
+		};
+
+		// 段階の開始から、その段階の最後の処理が終わるまでの時間を測る.
+		// 処理は別々のスレッドで終わるので、終わった時刻の最大値を取る.
+		class PhaseTimer
+		{
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			PhaseTimer()
+				: m_start(Clock::now())
+				, m_endUs(0)
+			{
+			}
+
+			void Start()
+			{
+				m_start = Clock::now();
+				m_endUs = 0;
+			}
+
+			void Finish()
+			{
+				int64_t us = (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_start).count();
+				int64_t current = m_endUs.Load();
+				while(current < us && !m_endUs.CompareExchange(current, us)){}
+			}
+
+			float GetMs() const{ return (float)m_endUs.Load() / 1000.0f; }
+
+		private:
+			Clock::time_point m_start;
+			AtomicInt64       m_endUs;
+		};
+
 		int GetId(const std::string& str)
 		{
 			if(str.empty())
@@ -177,12 +239,33 @@ namespace SI
 	class GltfLoaderImpl
 	{
 	public:
-		GltfLoaderImpl()
+		GltfLoaderImpl(AsyncFileLoader* fileLoader, JobSystem* jobSystem)
+			: m_fileLoader(fileLoader)
+			, m_jobSystem(jobSystem)
 		{
 		}
 
+		// 外部ファイルなら読み込みを積むだけで、待たない.
+		void RequestBuffer(
+			BufferData& outBuffer,
+			const glTF::Document& document,
+			int bufferId,
+			AsyncFileLoader& fileLoader)
+		{
+			if(bufferId<0 || document.buffers.Size()<=bufferId) return;
+
+			const glTF::Buffer& gltfBuffer = document.buffers[bufferId];
+
+			std::string::const_iterator itBegin = gltfBuffer.uri.end();
+			std::string::const_iterator itEnd   = gltfBuffer.uri.end();
+			if(!glTF::IsUriBase64(gltfBuffer.uri, itBegin, itEnd))
+			{
+				outBuffer.m_request = fileLoader.Load(gltfBuffer.uri.c_str());
+			}
+		}
+
 		bool LoadBuffer(
-			std::vector<uint8_t>& outBuffer,
+			BufferData& outBuffer,
 			const glTF::Document& document,
 			int bufferId)
 		{
@@ -199,15 +282,21 @@ namespace SI
 			if(glTF::IsUriBase64(gltfBuffer.uri, itBegin, itEnd))
 			{
 				// embeded
-				outBuffer = std::move(glTF::Base64Decode(glTF::Base64StringView(itBegin, itEnd)));
+				outBuffer.m_decoded = std::move(glTF::Base64Decode(glTF::Base64StringView(itBegin, itEnd)));
 			}
-			else if(FileUtility::Load(outBuffer, gltfBuffer.uri.c_str()) != 0)
+			else
 			{
-				SI_ASSERT(false, "Failed to load buffer. %s is invalid URI", gltfBuffer.uri.c_str());
-				return false;
+				SI_ASSERT(outBuffer.m_request.IsValid());
+				outBuffer.m_request.Wait();
+				if(outBuffer.m_request.GetResult() != 0)
+				{
+					SI_ASSERT(false, "Failed to load buffer. %s is invalid URI", gltfBuffer.uri.c_str());
+					outBuffer.m_request.Reset();
+					return false;
+				}
 			}
 
-			return !outBuffer.empty();
+			return 0 < outBuffer.GetSize();
 		}
 
 		bool LoadBufferView(
@@ -247,11 +336,13 @@ namespace SI
 			return true;
 		}
 
-		bool LoadBufferFromBufferView(
-			std::vector<uint8_t>& outBuffer,
+		// コピーせずに、bufferの中のbufferViewの範囲を返す.
+		bool GetBufferViewData(
+			const uint8_t*& outData,
+			size_t& outSize,
 			const glTF::Document& document,
 			int bufferViewId,
-			const std::vector<std::vector<uint8_t>>& bufferDataArray)
+			const std::vector<BufferData>& bufferDataArray)
 		{
 			BufferView bufferView;
 			if(!LoadBufferView(bufferView, document, bufferViewId))
@@ -259,64 +350,120 @@ namespace SI
 				return false;
 			}
 
-			const std::vector<uint8_t>& buffer = bufferDataArray[bufferView.GetBufferId()];
-			outBuffer.resize(bufferView.GetSize());
-			memcpy_s(outBuffer.data(), outBuffer.size(), &buffer[bufferView.GetOffset()], bufferView.GetSize());
+			const BufferData& buffer = bufferDataArray[bufferView.GetBufferId()];
+			if(buffer.GetSize() < bufferView.GetOffset() + bufferView.GetSize())
+			{
+				SI_ASSERT(false, "Failed to load BufferView. BufferId(%d) is too small", bufferView.GetBufferId());
+				return false;
+			}
 
+			outData = buffer.GetData() + bufferView.GetOffset();
+			outSize = bufferView.GetSize();
 			return true;
 		}
 
-		bool LoadGfxImage(
-			GfxTexture& outTexture,
-			const glTF::Document& document,
-			const std::vector<std::vector<uint8_t>>& bufferDataArray,
-			int imageId)
+		ImageSource GetImageSource(const glTF::Document& document, int imageId)
 		{
 			if(imageId<0 || document.images.Size()<=imageId)
 			{
-				SI_ASSERT(false, "Failed to load image. ImageId(%d) is invalid", imageId);
-				return false;
+				return ImageSource::Invalid;
 			}
 
 			const glTF::Image& gltfImage = document.images[imageId];
 
-			SI_ASSERT(!outTexture.IsValid());
-			GfxDevice& device = *GfxDevice::GetInstance();
-
-			std::vector<uint8_t> bufferData;
-			int bufferViewId = GetId(gltfImage.bufferViewId);
-
 			std::string::const_iterator itBegin = gltfImage.uri.end();
 			std::string::const_iterator itEnd   = gltfImage.uri.end();
 			if(glTF::IsUriBase64(gltfImage.uri, itBegin, itEnd))
 			{
-				// embeded
-				bufferData = std::move(glTF::Base64Decode(glTF::Base64StringView(itBegin, itEnd)));
+				return ImageSource::Base64;
 			}
-			else if(0<=bufferViewId && bufferViewId<document.bufferViews.Size() )
+
+			int bufferViewId = GetId(gltfImage.bufferViewId);
+			if(0<=bufferViewId && bufferViewId<document.bufferViews.Size())
 			{
-				if(!LoadBufferFromBufferView(bufferData,document, bufferViewId, bufferDataArray))
-				{
-					return false;
-				}
+				return ImageSource::BufferView;
 			}
-			else if(!gltfImage.uri.empty())
+
+			return gltfImage.uri.empty()? ImageSource::Invalid : ImageSource::File;
+		}
+
+		bool CreateGfxImage(
+			GfxTexture& outTexture,
+			const glTF::Image& gltfImage,
+			const uint8_t* imageData,
+			size_t imageSize)
+		{
+			SI_ASSERT(!outTexture.IsValid());
+			SI_ASSERT(0 < imageSize);
+
+			GfxDevice& device = *GfxDevice::GetInstance();
+			outTexture = device.CreateTextureWICAndUpload(gltfImage.name.c_str(), imageData, imageSize);
+
+			return outTexture.IsValid();
+		}
+
+		// 外部ファイルの画像は読み込みを積み、読み込めた所でデコードとアップロードまで進める.
+		AsyncFileRequest RequestGfxImageFile(
+			GfxTexture& outTexture,
+			const glTF::Document& document,
+			int imageId,
+			AsyncFileLoader& fileLoader,
+			PhaseTimer& imageTimer)
+		{
+			const glTF::Image& gltfImage = document.images[imageId];
+
+			return fileLoader.Load(gltfImage.uri.c_str(), [this, &outTexture, &gltfImage, &imageTimer](MappedFile& file)
+			{
+				bool result = CreateGfxImage(outTexture, gltfImage, file.GetData(), file.GetSize());
+
+				// アップロードし終わったら、ファイルはもう要らない.
+				file.Close();
+				imageTimer.Finish();
+
+				return result? 0 : -1;
+			});
+		}
+
+		// base64かbufferViewの画像を読み込む. bufferViewの時はbufferを読み終わってから呼ぶ.
+		bool LoadGfxImage(
+			GfxTexture& outTexture,
+			const glTF::Document& document,
+			const std::vector<BufferData>& bufferDataArray,
+			int imageId)
+		{
+			const glTF::Image& gltfImage = document.images[imageId];
+
+			BufferData imageBuffer;
+			const uint8_t* imageData = nullptr;
+			size_t         imageSize = 0;
+
+			switch(GetImageSource(document, imageId))
 			{
-				if(FileUtility::Load(bufferData, gltfImage.uri.c_str()) != 0)
+			case ImageSource::Base64:
+				{
+					// embeded
+					std::string::const_iterator itBegin = gltfImage.uri.end();
+					std::string::const_iterator itEnd   = gltfImage.uri.end();
+					glTF::IsUriBase64(gltfImage.uri, itBegin, itEnd);
+
+					imageBuffer.m_decoded = std::move(glTF::Base64Decode(glTF::Base64StringView(itBegin, itEnd)));
+					imageData = imageBuffer.GetData();
+					imageSize = imageBuffer.GetSize();
+				}
+				break;
+			case ImageSource::BufferView:
+				// bufferの中を直接参照する.
+				if(!GetBufferViewData(imageData, imageSize, document, GetId(gltfImage.bufferViewId), bufferDataArray))
 				{
 					return false;
 				}
-			}
-			else
-			{
+				break;
+			default:
+				SI_ASSERT(false, "Failed to load image. ImageId(%d) is invalid", imageId);
 				return false;
 			}
 
-			SI_ASSERT(!bufferData.empty());
-
-			outTexture = device.CreateTextureWICAndUpload(gltfImage.name.c_str(), bufferData.data(), bufferData.size());
-
-			return true;
+			return CreateGfxImage(outTexture, gltfImage, imageData, imageSize);
 		}
 
 		void LoadTexture(
@@ -332,7 +479,7 @@ namespace SI
 			GfxBuffer& outBuffer,
 			int bufferViewId,
 			const glTF::Document& document,
-			const std::vector<std::vector<uint8_t>>& bufferDataArray)
+			const std::vector<BufferData>& bufferDataArray)
 		{
 			BufferView bufferView;
 			if(!LoadBufferView(bufferView, document, bufferViewId))
@@ -347,9 +494,9 @@ namespace SI
 				return false;
 			}
 
-			const std::vector<uint8_t>& bufferData = bufferDataArray[bufferId];
+			const BufferData& bufferData = bufferDataArray[bufferId];
 
-			SI_ASSERT( (bufferView.GetOffset() + bufferView.GetSize()) <= bufferData.size() );
+			SI_ASSERT( (bufferView.GetOffset() + bufferView.GetSize()) <= bufferData.GetSize() );
 
 			const glTF::Buffer& gltfBuffer = document.buffers[bufferId];
 
@@ -363,7 +510,7 @@ namespace SI
 			outBuffer = device.CreateBuffer(desc);
 			int ret = device.UploadBufferLater(
 				outBuffer,
-				&bufferData[bufferView.GetOffset()],
+				bufferData.GetData() + bufferView.GetOffset(),
 				bufferView.GetSize(),
 				GfxResourceState::CopyDest,
 				GfxResourceState::IndexBuffer | GfxResourceState::VertexAndConstantBuffer);
@@ -376,7 +523,7 @@ namespace SI
 			Scenes& rootScene,
 			const glTF::Document& document,
 			const glTF::Accessor& gltfAccessor,
-			const std::vector<std::vector<uint8_t>>& bufferDataArray)
+			const std::vector<BufferData>& bufferDataArray)
 		{
 			int bufferViewId = GetId(gltfAccessor.bufferViewId);
 
@@ -393,6 +540,14 @@ namespace SI
 
 			GfxFormat format = GetFormat(gltfAccessor.componentType, gltfAccessor.type);
 			outAccessor.SetFormat(format);
+
+			// POSITIONは仕様上min/maxが必須なので、カリング用のAABBに使う.
+			if(gltfAccessor.type == glTF::TYPE_VEC3 && gltfAccessor.min.size() == 3 && gltfAccessor.max.size() == 3)
+			{
+				outAccessor.SetBounds(
+					Vfloat3(gltfAccessor.min[0], gltfAccessor.min[1], gltfAccessor.min[2]),
+					Vfloat3(gltfAccessor.max[0], gltfAccessor.max[1], gltfAccessor.max[2]));
+			}
 			return true;
 		}
 
@@ -531,7 +686,7 @@ namespace SI
 				}
 
 				outNode.AddNodeId(childNodeId);
-				rootScene.GetNode(nodeId).SetParentId(nodeId);
+				rootScene.GetNode(childNodeId).SetParentId(nodeId);
 			}
 		}
 
@@ -550,8 +705,34 @@ namespace SI
 			}
 		}
 
+		void RunJob(const JobSystem::JobFunc& func, JobCounter& counter)
+		{
+			if(m_jobSystem)
+			{
+				m_jobSystem->Run(func, &counter);
+				return;
+			}
+
+			func();
+		}
+
+		void WaitJobs(JobCounter& counter)
+		{
+			if(m_jobSystem)
+			{
+				m_jobSystem->Wait(counter);
+			}
+		}
+
 		ScenesPtr Load(const char* filePath)
 		{
+			m_timings = GltfLoaderTimings();
+
+			PhaseTimer totalTimer;
+			PhaseTimer parseTimer;
+			totalTimer.Start();
+			parseTimer.Start();
+
 			String ext = PathUtility::GetExt(filePath).ToLower();
 
 			std::unique_ptr<StreamReader> streamReader = std::make_unique<StreamReader>(filePath);
@@ -589,6 +770,8 @@ namespace SI
 			glTF::Document document;
 			document = glTF::Deserialize(manifest, glTF::DeserializeFlags::IgnoreByteOrderMark);
 
+			parseTimer.Finish();
+
 			ScenesPtr rootScene = Scenes::Create();
 
 			size_t sceneCount       = document.scenes.Size();
@@ -601,22 +784,110 @@ namespace SI
 			size_t textureInfoCount = document.textures.Size();
 			size_t imageCount       = document.images.Size();
 
+			rootScene->AllocateImages(imageCount);
+			rootScene->AllocateAccessors(accessorCount);
+
+			// 画像のデコードもJobSystemで進むように、ファイルを読み込んだ後の処理はJobSystemに任せる.
+			AsyncFileLoader  localFileLoader;
+			AsyncFileLoader* fileLoader = m_fileLoader;
+			if(!fileLoader)
+			{
+				localFileLoader.Initialize(2, m_jobSystem);
+				fileLoader = &localFileLoader;
+			}
+
+			PhaseTimer bufferTimer;
+			PhaseTimer accessorTimer;
+			PhaseTimer imageTimer;
+			PhaseTimer sceneTimer;
+			bufferTimer.Start();
+			imageTimer.Start();
 
-			// 下の階層の要素からセットアップしていく.
-			std::vector<std::vector<uint8_t>> bufferDataArray;
+			// 外部ファイルの読み込みは最初に全て積んでおく.
+			// bufferはファイルをマップしたまま使い、GPUにアップロードし終わったら閉じる.
+			std::vector<BufferData> bufferDataArray;
 			bufferDataArray.resize(bufferCount);
 			for(int b=0; b<(int)bufferCount; ++b)
 			{
-				std::vector<uint8_t>& bufferData = bufferDataArray[b];
-				LoadBuffer(bufferData, document, b);
+				RequestBuffer(bufferDataArray[b], document, b, *fileLoader);
 			}
 
-			rootScene->AllocateImages(imageCount);
+			std::vector<AsyncFileRequest> imageFiles;
+			imageFiles.resize(imageCount);
 			for(size_t i=0; i<imageCount; ++i)
 			{
-				LoadGfxImage(rootScene->GetImage((uint32_t)i), document, bufferDataArray, (int)i);
+				if(GetImageSource(document, (int)i) != ImageSource::File) continue;
+
+				imageFiles[i] = RequestGfxImageFile(rootScene->GetImage((uint32_t)i), document, (int)i, *fileLoader, imageTimer);
 			}
 
+			// 読み込みを待つ間に、base64のbufferと、bufferに依存しない画像をJobで処理する.
+			JobCounter bufferCounter;
+			for(int b=0; b<(int)bufferCount; ++b)
+			{
+				if(bufferDataArray[b].m_request.IsValid()) continue;
+
+				RunJob([this, b, &bufferDataArray, &document, &bufferTimer]()
+				{
+					LoadBuffer(bufferDataArray[b], document, b);
+					bufferTimer.Finish();
+				}, bufferCounter);
+			}
+
+			JobCounter imageCounter;
+			for(size_t i=0; i<imageCount; ++i)
+			{
+				if(GetImageSource(document, (int)i) != ImageSource::Base64) continue;
+
+				RunJob([this, i, &rootScene, &bufferDataArray, &document, &imageTimer]()
+				{
+					LoadGfxImage(rootScene->GetImage((uint32_t)i), document, bufferDataArray, (int)i);
+					imageTimer.Finish();
+				}, imageCounter);
+			}
+
+			for(int b=0; b<(int)bufferCount; ++b)
+			{
+				if(!bufferDataArray[b].m_request.IsValid()) continue;
+
+				LoadBuffer(bufferDataArray[b], document, b);
+				bufferTimer.Finish();
+			}
+			WaitJobs(bufferCounter);
+
+			// bufferが揃ったので、accessorとbufferViewの画像をJobで作る.
+			accessorTimer.Start();
+			JobCounter accessorCounter;
+			static const size_t kAccessorGrainSize = 16;
+			for(size_t begin=0; begin<accessorCount; begin+=kAccessorGrainSize)
+			{
+				size_t end = SI::Min(begin + kAccessorGrainSize, accessorCount);
+				RunJob([this, begin, end, &rootScene, &bufferDataArray, &document, &accessorTimer]()
+				{
+					for(size_t a=begin; a<end; ++a)
+					{
+						const glTF::Accessor& gltfAccessor = document.accessors[a];
+						LoadAccessor(rootScene->GetAccessor((uint32_t)a), *rootScene, document, gltfAccessor, bufferDataArray);
+					}
+					accessorTimer.Finish();
+				}, accessorCounter);
+			}
+
+			for(size_t i=0; i<imageCount; ++i)
+			{
+				if(GetImageSource(document, (int)i) != ImageSource::BufferView) continue;
+
+				RunJob([this, i, &rootScene, &bufferDataArray, &document, &imageTimer]()
+				{
+					LoadGfxImage(rootScene->GetImage((uint32_t)i), document, bufferDataArray, (int)i);
+					imageTimer.Finish();
+				}, imageCounter);
+			}
+
+			// GPUのデータに依存しないものは、Jobを待たずにこのスレッドで作る.
+			// materialはシェーダのコンパイルがあるので、このスレッドに残しておく.
+			sceneTimer.Start();
+
 			rootScene->AllocateTextureInfos(textureInfoCount);
 			for(size_t t=0; t<textureInfoCount; ++t)
 			{
@@ -624,13 +895,6 @@ namespace SI
 				LoadTexture(rootScene->GetTextureInfo((uint32_t)t), *rootScene, document, gltfTexture);
 			}
 
-			rootScene->AllocateAccessors(accessorCount);
-			for(size_t a=0; a<accessorCount; ++a)
-			{
-				const glTF::Accessor& gltfAccessor = document.accessors[a];
-				LoadAccessor(rootScene->GetAccessor((uint32_t)a), *rootScene, document, gltfAccessor, bufferDataArray);
-			}
-
 			rootScene->AllocateMaterials(materialCount);
 			for(size_t m=0; m<materialCount; ++m)
 			{
@@ -658,12 +922,42 @@ namespace SI
 				LoadScene(rootScene->GetScene((uint32_t)s), *rootScene, document, gltfScene);
 			}
 
+			sceneTimer.Finish();
+
+			WaitJobs(accessorCounter);
+			WaitJobs(imageCounter);
+			for(AsyncFileRequest& imageFile : imageFiles)
+			{
+				if(!imageFile.IsValid()) continue;
+
+				imageFile.Wait();
+			}
+
+			totalTimer.Finish();
+
+			m_timings.m_parse     = parseTimer.GetMs();
+			m_timings.m_buffers   = bufferTimer.GetMs();
+			m_timings.m_accessors = accessorTimer.GetMs();
+			m_timings.m_images    = imageTimer.GetMs();
+			m_timings.m_scene     = sceneTimer.GetMs();
+			m_timings.m_total     = totalTimer.GetMs();
+
 			return rootScene;
 		}
+
+		const GltfLoaderTimings& GetTimings() const
+		{
+			return m_timings;
+		}
+
+	private:
+		AsyncFileLoader*  m_fileLoader;
+		JobSystem*        m_jobSystem;
+		GltfLoaderTimings m_timings;
 	};
 
-	GltfLoader::GltfLoader()
-		: m_impl(new GltfLoaderImpl)
+	GltfLoader::GltfLoader(AsyncFileLoader* fileLoader, JobSystem* jobSystem)
+		: m_impl(new GltfLoaderImpl(fileLoader, jobSystem))
 	{
 	}
 
@@ -677,4 +971,9 @@ namespace SI
 		return std::move(m_impl->Load(filePath));
 	}
 
+	const GltfLoaderTimings& GltfLoader::GetTimings() const
+	{
+		return m_impl->GetTimings();
+	}
+
 } // namespace SI
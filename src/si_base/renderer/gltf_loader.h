@@ -8,15 +8,36 @@
 
 namespace SI
 {
+	class AsyncFileLoader;
+	class JobSystem;
 	class GltfLoaderImpl;
+
+	// Loadの各段階にかかった時間(ms).
+	// 段階同士は並行して進むので、足してもm_totalにはならない.
+	struct GltfLoaderTimings
+	{
+		float m_parse     = 0.0f; // manifestの読み込みとパース.
+		float m_buffers   = 0.0f; // bufferの読み込みとbase64のデコード.
+		float m_accessors = 0.0f; // accessorのバッファ作成とアップロードの準備.
+		float m_images    = 0.0f; // 画像の読み込み、デコードとアップロード.
+		float m_scene     = 0.0f; // texture, material, mesh, node, sceneのセットアップ.
+		float m_total     = 0.0f;
+	};
+
 	class GltfLoader
 	{
 	public:
-		GltfLoader();
+		// bufferや画像のファイルはfileLoaderで並行して読み込む.
+		// nullptrならLoadの間だけI/Oスレッドを用意する.
+		// jobSystemがあれば、画像のデコードやaccessorの作成をJobに分けて並列に行う.
+		explicit GltfLoader(AsyncFileLoader* fileLoader = nullptr, JobSystem* jobSystem = nullptr);
 		~GltfLoader();
 
 		ScenesPtr Load(const char* filePath);
 
+		// 最後のLoadの段階毎の時間.
+		const GltfLoaderTimings& GetTimings() const;
+
 	private:
 		GltfLoaderImpl* m_impl;
 	};
@@ -3,24 +3,34 @@
 #include "si_base/renderer/material.h"
 #include "si_base/gpu/gfx_graphics_context.h"
 #include "si_base/renderer/scenes.h"
+#include "si_base/misc/hash.h"
 
 namespace SI
 {
 	bool RenderItem::NeedToCreatePSO(const RendererGraphicsStateDesc& renderDesc) const
 	{
 		if(m_graphicsStateDesc.GetHash() != renderDesc.GetHash()) return true;
-
-		// TODO: マテリアル側の変更もあるかチェックする.
+		if(m_materialStateHash != GenerateMaterialStateHash()) return true;
 
 		return false;
 	}
 
+	Hash64 RenderItem::GenerateMaterialStateHash() const
+	{
+		Hash64Generator hashGenerator;
+		hashGenerator.Add(m_renderMaterial->GetRootSignature().Get().GetHash());
+		hashGenerator.Add(m_renderMaterial->GetVertexShader().GetHash());
+		hashGenerator.Add(m_renderMaterial->GetPixelShader().GetHash());
+		return hashGenerator.Generate();
+	}
+
 	void RenderItem::SetupPSO(const RendererGraphicsStateDesc& renderDesc)
 	{
 		SI_ASSERT(renderDesc.GetHash()!=Hash64(0));
 		if(!NeedToCreatePSO(renderDesc)) return;
 
 		m_graphicsStateDesc = renderDesc;
+		m_materialStateHash = GenerateMaterialStateHash();
 		
 		GfxGraphicsStateDesc psoDesc;
 		psoDesc.m_fillMode               = renderDesc.m_fillMode;
@@ -68,9 +78,32 @@ namespace SI
 		psoDesc.m_inputElements = inputElements.data();
 		psoDesc.m_inputElementCount = vertexAttributeCount;
 
+		// 同じシェーダ, 入力レイアウト, ステートのPSOはキャッシュで共有される.
 		m_graphicsState.Initialize(psoDesc);
 	}
 
+	void RenderItem::UpdateWorldAabb()
+	{
+		if(!m_hasBounds) return;
+
+		m_worldAabb = m_localAabb.Transform(GetWorldMatrix());
+	}
+
+	bool RenderItem::CanInstanceWith(const RenderItem& other) const
+	{
+		if(m_scenes           != other.m_scenes)           return false;
+		if(m_material         != other.m_material)         return false;
+		if(m_renderMaterial   != other.m_renderMaterial)   return false;
+		if(m_subMesh          != other.m_subMesh)          return false;
+		if(m_indexAccessor    != other.m_indexAccessor)    return false;
+		if(m_vertexAttributes != other.m_vertexAttributes) return false;
+
+		// PSOはGfxGraphicsStateCacheで共有されているので、ポインタで比較できる.
+		if(m_graphicsState.Get().GetBaseGraphicsState() != other.m_graphicsState.Get().GetBaseGraphicsState()) return false;
+
+		return true;
+	}
+
 	bool RenderItem::IsValid() const
 	{
 		if(!m_scenes)           return false;
@@ -4,6 +4,8 @@
 #include "si_base/renderer/renderer_graphics_state.h"
 #include "si_base/gpu/gfx_graphics_state_ex.h"
 #include "si_base/renderer/submesh.h"
+#include "si_base/math/aabb.h"
+#include "si_base/renderer/transform_hierarchy.h"
 
 namespace SI
 {
@@ -21,10 +23,23 @@ namespace SI
 	struct RenderItem
 	{
 		bool NeedToCreatePSO(const RendererGraphicsStateDesc& renderDesc) const;
+		Hash64 GenerateMaterialStateHash() const;
 		void SetupPSO(const RendererGraphicsStateDesc& renderDesc);
 		bool IsValid() const;
 
-		Vfloat4x4                      m_worldMatrix;
+		// 同じPSO, マテリアル, ジオメトリで、ワールド行列だけ違うならインスタンシングで一緒に描ける.
+		bool CanInstanceWith(const RenderItem& other) const;
+
+		// m_localAabbとワールド行列からm_worldAabbを計算する. ワールド行列が変わったら呼ぶこと.
+		void UpdateWorldAabb();
+
+		const Vfloat4x4& GetWorldMatrix() const{ return m_transforms->GetWorldMatrix(m_transformIndex); }
+
+		const TransformHierarchy*      m_transforms = nullptr;  // ワールド行列はインデックスで参照する.
+		uint32_t                       m_transformIndex = TransformHierarchy::kInvalidIndex;
+		Aabb                           m_localAabb;
+		Aabb                           m_worldAabb;
+		bool                           m_hasBounds = false; // falseならカリングしない.
 
 		IScenes*                       m_scenes = nullptr;
 		Material*                      m_material = nullptr;
@@ -35,6 +50,7 @@ namespace SI
 
 		GfxGraphicsStateEx             m_graphicsState;
 		RendererGraphicsStateDesc      m_graphicsStateDesc;
+		Hash64                         m_materialStateHash = 0; // PSO作成時のシェーダとルートシグネチャ.
 	};
 
 } // namespace SI
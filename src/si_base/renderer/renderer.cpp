@@ -2,7 +2,10 @@
 #include "si_base/renderer/renderer.h"
 
 #include "si_base/math/vfloat4x4.h"
+#include "si_base/misc/radix_sort.h"
 #include "si_base/gpu/gfx_graphics_context.h"
+#include "si_base/gpu/gfx_context_manager.h"
+#include "si_base/concurency/job_system.h"
 
 namespace SI
 {
@@ -18,6 +21,11 @@ namespace SI
 	Renderer::Renderer()
 		: Singleton<Renderer>(this)
 		, m_frameIndex(0)
+		, m_cullingEnable(true)
+		, m_instancingEnable(true)
+		, m_visibleItemCount(0)
+		, m_culledItemCount(0)
+		, m_drawCallCount(0)
 	{
 	}
 	
@@ -35,51 +43,81 @@ namespace SI
 
 	void Renderer::Terminate()
 	{
-		SI_ASSERT(m_models.empty());
+		SI_ASSERT(m_models.IsEmpty());
 
 		m_whiteTex.TerminateStatic();
-		m_models.clear();
+		m_models.Reset();
+		m_visibleItems.clear();
+		m_visibleItems.shrink_to_fit();
+		m_sortWork.clear();
+		m_sortWork.shrink_to_fit();
+		m_drawGroups.clear();
+		m_drawGroups.shrink_to_fit();
 		m_constantAllocator.Terminate();
 	}
 		
 	void Renderer::Add(ScenesInstancePtr& modelInstance)
 	{
-		SI_ASSERT(m_models.find(modelInstance.get()) == m_models.end());
-		m_models[modelInstance.get()] = modelInstance;
+		bool inserted = m_models.Insert(modelInstance.get(), modelInstance);
+		SI_ASSERT(inserted);
 	}
 		
 	void Renderer::Remove(ScenesInstancePtr& modelInstance)
 	{
-		SI_ASSERT(m_models.find(modelInstance.get()) != m_models.end());
-		m_models.erase(modelInstance.get());
+		bool erased = m_models.Erase(modelInstance.get());
+		SI_ASSERT(erased);
 	}
 
 	void Renderer::Update()
 	{
 		++m_frameIndex; // flip. 64bitだから、桁あふれ気にしない.
 		m_constantAllocator.Reset();
+
+		// 動いたノードのワールド行列とAABBだけ更新する.
+		for(auto& item : m_models)
+		{
+			item.m_value->UpdateTransforms();
+		}
 	}
 
-	void Renderer::Render(
-		GfxGraphicsContext& context,
+	uint64_t Renderer::MakeSortKey(
 		RendererDrawStageType stageType,
-		const RendererGraphicsStateDesc& renderDesc)
+		Hash64 stateHash,
+		const void* renderMaterial,
+		const void* material,
+		const void* geometry,
+		float viewDepth)
 	{
-		RendererGraphicsStateDesc renderDescCopy = renderDesc;
-		renderDescCopy.GenerateHash();
+		// ポインタは下位ビットが揃いやすいので、乗算で混ぜてから上位ビットを使う.
+		const uint64_t kGoldenRatio = 0x9e3779b97f4a7c15ull;
 
-		uint32_t frameIndex = GetWriteFrameIndex();
-			
-		GfxLinearAllocatorMemory constant0 = m_constantAllocator.Allocate(sizeof(SceneCB), 256);
-		SceneCB* sceneCB = (SceneCB*)constant0.GetCpuAddr();
-		sceneCB->m_view     = m_viewMatrix;
-		sceneCB->m_proj     = m_projectionMatrix;
-		sceneCB->m_viewProj = m_viewMatrix * m_projectionMatrix;
-		size_t constant0GpuAddr = constant0.GetGpuAddr();
+		uint64_t stageBits    = (uint64_t)stageType & 0xf;
+		uint64_t psoBits      = (((uint64_t)stateHash ^ (uint64_t)(uintptr_t)renderMaterial) * kGoldenRatio) >> 44;
+		uint64_t materialBits = ((uint64_t)(uintptr_t)material * kGoldenRatio) >> 44;
+		uint64_t geometryBits = ((uint64_t)(uintptr_t)geometry * kGoldenRatio) >> 52;
+
+		// 正のfloatはビット列のまま比較しても大小関係が保たれるので、指数部(log2)を深度バケットに使う.
+		uint32_t depthBits = 0;
+		if(0.0f < viewDepth)
+		{
+			memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+		}
+		uint64_t depthBucket = (depthBits >> 23) & 0xff;
+
+		return (stageBits << 60) | (psoBits << 40) | (materialBits << 20) | (geometryBits << 8) | depthBucket;
+	}
 
-		for(auto& pair : m_models)
+	void Renderer::Cull(RendererDrawStageType stageType, const RendererGraphicsStateDesc& renderDesc)
+	{
+		m_visibleItems.clear();
+		m_culledItemCount = 0;
+
+		// ステートはこの呼び出しの間は変わらないので、ハッシュは一度だけ取る.
+		Hash64 stateHash = renderDesc.GetHash();
+
+		for(auto& item : m_models)
 		{
-			ScenesInstancePtr& modelIns = pair.second;
+			ScenesInstancePtr& modelIns = item.m_value;
 
 			RendererDrawStageList& drawStageList = modelIns->GetDrawStageList();
 			RendererDrawStage* drawStage = drawStageList.GetDrawStage(stageType);
@@ -90,81 +128,235 @@ namespace SI
 			{
 				RenderItem& renderItem = drawStage->m_renderItems[ri];
 
-				renderItem.SetupPSO(renderDescCopy);
-
-				SI_ASSERT(renderItem.IsValid());
-				
-				Material& material = *renderItem.m_material;
-				RenderMaterial& renderMaterial = *renderItem.m_renderMaterial;
-
-				material.UpdateRenderMaterial(frameIndex, *renderItem.m_scenes, &renderMaterial);
-		
-				context.SetPipelineState(renderItem.m_graphicsState.Get());
-				context.SetGraphicsRootSignature(renderMaterial.GetRootSignature());
-				
-				GfxDescriptorHeap& srvHeap = renderMaterial.GetSrvHeap(frameIndex).Get();
-				GfxDescriptorHeap& samplerHeap = renderMaterial.GetSamplerHeap(frameIndex).Get();
-
-				context.SetDescriptorHeaps(
-					&srvHeap,
-					&samplerHeap);
-
-				uint32_t instanceCount = 1;
-				GfxLinearAllocatorMemory constant1 = m_constantAllocator.Allocate(instanceCount*sizeof(Vfloat4x4), 256);
-				Vfloat4x4* worldMatrixArray = (Vfloat4x4*)constant1.GetCpuAddr();
-				for(uint32_t i=0; i<instanceCount; ++i)
+				// AABBが無いものは常に描画する.
+				if(m_cullingEnable && renderItem.m_hasBounds && !m_frustum.IsVisible(renderItem.m_worldAabb))
 				{
-					worldMatrixArray[i] = renderItem.m_worldMatrix;
+					++m_culledItemCount;
+					continue;
 				}
-				size_t constant1GpuAddr = constant1.GetGpuAddr();
 
-				GfxBuffer& constant2 = renderMaterial.GetConstantBuffer(frameIndex).Get();
-				
-				if(srvHeap.IsValid())
-				{
-					context.SetGraphicsDescriptorTable(0, srvHeap.GetGpuDescriptor(0));
-				}
-				
-				if(samplerHeap.IsValid())
-				{
-					context.SetGraphicsDescriptorTable(1, samplerHeap.GetGpuDescriptor(0));
-				}
-				
-				// コンスタントバッファをセットする.
-				uint32_t cbvRootIndexOffset = renderMaterial.GetRootSignature().GetTableCount();
-				context.SetGraphicsRootCBV(cbvRootIndexOffset  , constant0GpuAddr);
-				context.SetGraphicsRootCBV(cbvRootIndexOffset+1, constant1GpuAddr);
-				if(constant2.IsValid())
-				{
-					context.SetGraphicsRootCBV(cbvRootIndexOffset+2, constant2);
-				}
+				Vfloat3 center = renderItem.m_hasBounds?
+					renderItem.m_worldAabb.GetCenter() :
+					Math::Multiply(Vfloat3(0.0f), renderItem.GetWorldMatrix());
+				float viewDepth = Math::Multiply(center, m_viewMatrix).Z();
 
-				context.SetPrimitiveTopology(renderItem.m_subMesh->GetTopology());
-				
-				uint32_t vertexAttributeCount = (uint32_t)renderItem.m_vertexAttributes->size();
-				for(uint32_t v=0; v<vertexAttributeCount; ++v)
-				{
-					int accessorId = (*renderItem.m_vertexAttributes)[v].m_accessorId;
-					SI_ASSERT(0 <= accessorId);
-					Accessor& accessor = renderItem.m_scenes->GetAccessor(accessorId);
+				RenderSortItem sortItem;
+				sortItem.m_key  = MakeSortKey(
+					stageType,
+					stateHash,
+					renderItem.m_renderMaterial,
+					renderItem.m_material,
+					renderItem.m_subMesh,
+					viewDepth);
+				sortItem.m_item = &renderItem;
+				m_visibleItems.push_back(sortItem);
+			}
+		}
 
-					GfxVertexBufferView vertexView(
-						accessor.GetBuffer(),
-						accessor.GetSizeInByte(),
-						GetFormatBits(accessor.GetFormat()) / 8);
+		// 同じステートを使うものを連続させて、コンテキスト側で冗長なステート変更を省けるようにする.
+		m_sortWork.resize(m_visibleItems.size());
+		RadixSort64(
+			m_visibleItems.data(),
+			m_sortWork.data(),
+			m_visibleItems.size(),
+			[](const RenderSortItem& item){ return item.m_key; });
 
-					context.SetVertexBuffer(v, vertexView);
-				}
+		m_visibleItemCount = (uint32_t)m_visibleItems.size();
+	}
+
+	size_t Renderer::PrepareDraw(
+		RendererDrawStageType stageType,
+		const RendererGraphicsStateDesc& renderDesc)
+	{
+		uint32_t frameIndex = GetWriteFrameIndex();
+			
+		Vfloat4x4 viewProj = m_viewMatrix * m_projectionMatrix;
+		GfxLinearAllocatorMemory constant0 = m_constantAllocator.Allocate(sizeof(SceneCB), 256);
+		SceneCB* sceneCB = (SceneCB*)constant0.GetCpuAddr();
+		sceneCB->m_view     = m_viewMatrix;
+		sceneCB->m_proj     = m_projectionMatrix;
+		sceneCB->m_viewProj = viewProj;
+
+		// 描画するものを先に絞り込む. (アップロードヒープは読み戻さない)
+		m_frustum.Set(viewProj);
+		Cull(stageType, renderDesc);
+
+		// アイテムやマテリアルを書き換える処理はここで済ませて、記録は読むだけにする.
+		m_drawGroups.clear();
+		RenderMaterial* lastRenderMaterial = nullptr;
+		uint32_t maxInstanceCount = m_instancingEnable? kMaxInstanceCount : 1;
+		uint32_t visibleItemCount = (uint32_t)m_visibleItems.size();
+		for(uint32_t begin=0; begin<visibleItemCount; )
+		{
+			RenderItem& renderItem = *m_visibleItems[begin].m_item;
 
-				GfxIndexBufferView indexView(
-					renderItem.m_indexAccessor->GetBuffer(),
-					renderItem.m_indexAccessor->GetFormat(),
-					renderItem.m_indexAccessor->GetSizeInByte());
-				context.SetIndexBuffer(&indexView);
+			renderItem.SetupPSO(renderDesc);
 
-				context.DrawIndexedInstanced(renderItem.m_indexAccessor->GetCount(), instanceCount);
+			SI_ASSERT(renderItem.IsValid());
+
+			// ソートで隣接している、同じPSO, マテリアル, ジオメトリのものを1回のDrawにまとめる.
+			uint32_t end = begin + 1;
+			while(end < visibleItemCount && (end - begin) < maxInstanceCount)
+			{
+				RenderItem& otherItem = *m_visibleItems[end].m_item;
+				otherItem.SetupPSO(renderDesc);
+				if(!renderItem.CanInstanceWith(otherItem)) break;
+
+				++end;
 			}
+
+			// 同じマテリアルはソートで隣接しているので、変わった時だけ更新する.
+			if(renderItem.m_renderMaterial != lastRenderMaterial)
+			{
+				renderItem.m_material->UpdateRenderMaterial(frameIndex, *renderItem.m_scenes, renderItem.m_renderMaterial);
+				lastRenderMaterial = renderItem.m_renderMaterial;
+			}
+
+			RenderDrawGroup drawGroup;
+			drawGroup.m_begin = begin;
+			drawGroup.m_count = end - begin;
+			m_drawGroups.push_back(drawGroup);
+
+			begin = end;
 		}
+
+		m_drawCallCount = (uint32_t)m_drawGroups.size();
+
+		return constant0.GetGpuAddr();
+	}
+
+	void Renderer::RecordDrawGroups(
+		GfxGraphicsContext& context,
+		uint32_t groupBegin,
+		uint32_t groupEnd,
+		size_t sceneCBGpuAddr) const
+	{
+		uint32_t frameIndex = GetWriteFrameIndex();
+
+		for(uint32_t g=groupBegin; g<groupEnd; ++g)
+		{
+			const RenderDrawGroup& drawGroup = m_drawGroups[g];
+			RenderItem& renderItem = *m_visibleItems[drawGroup.m_begin].m_item;
+			uint32_t instanceCount = drawGroup.m_count;
+			
+			RenderMaterial& renderMaterial = *renderItem.m_renderMaterial;
+	
+			context.SetPipelineState(renderItem.m_graphicsState.Get());
+			context.SetGraphicsRootSignature(renderMaterial.GetRootSignature());
+			
+			GfxDescriptorHeap& srvHeap = renderMaterial.GetSrvHeap(frameIndex).Get();
+			GfxDescriptorHeap& samplerHeap = renderMaterial.GetSamplerHeap(frameIndex).Get();
+
+			context.SetDescriptorHeaps(
+				&srvHeap,
+				&samplerHeap);
+
+			// インスタンス毎のデータはコンテキストのメモリに置くので、スレッド間で共有しない.
+			GfxLinearAllocatorMemory constant1 = context.AllocateDynamicMemory(instanceCount*sizeof(Vfloat4x4), 256);
+			Vfloat4x4* worldMatrixArray = (Vfloat4x4*)constant1.GetCpuAddr();
+			for(uint32_t i=0; i<instanceCount; ++i)
+			{
+				worldMatrixArray[i] = m_visibleItems[drawGroup.m_begin + i].m_item->GetWorldMatrix();
+			}
+			size_t constant1GpuAddr = constant1.GetGpuAddr();
+
+			GfxBuffer& constant2 = renderMaterial.GetConstantBuffer(frameIndex).Get();
+			
+			if(srvHeap.IsValid())
+			{
+				context.SetGraphicsDescriptorTable(0, srvHeap.GetGpuDescriptor(0));
+			}
+			
+			if(samplerHeap.IsValid())
+			{
+				context.SetGraphicsDescriptorTable(1, samplerHeap.GetGpuDescriptor(0));
+			}
+			
+			// コンスタントバッファをセットする.
+			uint32_t cbvRootIndexOffset = renderMaterial.GetRootSignature().GetTableCount();
+			context.SetGraphicsRootCBV(cbvRootIndexOffset  , sceneCBGpuAddr);
+			context.SetGraphicsRootCBV(cbvRootIndexOffset+1, constant1GpuAddr);
+			if(constant2.IsValid())
+			{
+				context.SetGraphicsRootCBV(cbvRootIndexOffset+2, constant2);
+			}
+
+			context.SetPrimitiveTopology(renderItem.m_subMesh->GetTopology());
+			
+			uint32_t vertexAttributeCount = (uint32_t)renderItem.m_vertexAttributes->size();
+			for(uint32_t v=0; v<vertexAttributeCount; ++v)
+			{
+				int accessorId = (*renderItem.m_vertexAttributes)[v].m_accessorId;
+				SI_ASSERT(0 <= accessorId);
+				Accessor& accessor = renderItem.m_scenes->GetAccessor(accessorId);
+
+				GfxVertexBufferView vertexView(
+					accessor.GetBuffer(),
+					accessor.GetSizeInByte(),
+					GetFormatBits(accessor.GetFormat()) / 8);
+
+				context.SetVertexBuffer(v, vertexView);
+			}
+
+			GfxIndexBufferView indexView(
+				renderItem.m_indexAccessor->GetBuffer(),
+				renderItem.m_indexAccessor->GetFormat(),
+				renderItem.m_indexAccessor->GetSizeInByte());
+			context.SetIndexBuffer(&indexView);
+
+			context.DrawIndexedInstanced(renderItem.m_indexAccessor->GetCount(), instanceCount);
+		}
+	}
+
+	void Renderer::Render(
+		GfxGraphicsContext& context,
+		RendererDrawStageType stageType,
+		const RendererGraphicsStateDesc& renderDesc)
+	{
+		RendererGraphicsStateDesc renderDescCopy = renderDesc;
+		renderDescCopy.GenerateHash();
+
+		size_t sceneCBGpuAddr = PrepareDraw(stageType, renderDescCopy);
+
+		RecordDrawGroups(context, 0, (uint32_t)m_drawGroups.size(), sceneCBGpuAddr);
+	}
+
+	void Renderer::RenderParallel(
+		JobSystem& jobSystem,
+		GfxContextManager& contextManager,
+		uint32_t firstContextIndex,
+		uint32_t contextCount,
+		RendererDrawStageType stageType,
+		const RendererGraphicsStateDesc& renderDesc,
+		const ContextSetupFunc& setupContext)
+	{
+		SI_ASSERT(0 < contextCount);
+		SI_ASSERT(firstContextIndex + contextCount <= contextManager.GetGraphicsContextCount());
+
+		RendererGraphicsStateDesc renderDescCopy = renderDesc;
+		renderDescCopy.GenerateHash();
+
+		size_t sceneCBGpuAddr = PrepareDraw(stageType, renderDescCopy);
+
+		// 各コンテキストに連続した範囲を割り当てるので、Execute順に並べれば描画順は保たれる.
+		uint32_t groupCount = (uint32_t)m_drawGroups.size();
+		jobSystem.ParallelFor(contextCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			for(uint32_t c=begin; c<end; ++c)
+			{
+				uint32_t groupBegin = (uint32_t)((uint64_t)groupCount *  c      / contextCount);
+				uint32_t groupEnd   = (uint32_t)((uint64_t)groupCount * (c + 1) / contextCount);
+				if(groupBegin == groupEnd) continue;
+
+				GfxGraphicsContext& context = contextManager.GetGraphicsContext(firstContextIndex + c);
+				if(setupContext)
+				{
+					setupContext(context);
+				}
+
+				RecordDrawGroups(context, groupBegin, groupEnd, sceneCBGpuAddr);
+			}
+		});
 	}
 	
 } // namespace SI
@@ -1,17 +1,37 @@
 ﻿#pragma once
 
-#include <unordered_map>
+#include <vector>
+#include <functional>
 #include "si_base/container/array.h"
+#include "si_base/container/hash_map.h"
 #include "si_base/core/singleton.h"
 #include "si_base/renderer/renderer_common.h"
 #include "si_base/renderer/renderer_draw_stage.h"
 #include "si_base/renderer/scenes_instance.h"
 #include "si_base/gpu/gfx_linear_allocator.h"
+#include "si_base/math/frustum.h"
 
 namespace SI
 {
 	struct RenderDesc;
+	struct RenderItem;
 	class GfxGraphicsContext;
+	class GfxContextManager;
+	class JobSystem;
+
+	// 描画順ソート用. m_keyの昇順に描画する.
+	struct RenderSortItem
+	{
+		uint64_t    m_key;
+		RenderItem* m_item;
+	};
+
+	// インスタンシングでまとめて1回で描画する範囲. m_visibleItems[m_begin, m_begin+m_count).
+	struct RenderDrawGroup
+	{
+		uint32_t m_begin;
+		uint32_t m_count;
+	};
 
 	class Renderer : public Singleton<Renderer>
 	{
@@ -28,11 +48,31 @@ namespace SI
 		void SetViewMatrix(Vfloat4x4_arg view){ m_viewMatrix = view; }
 		void SetProjectionMatrix(Vfloat4x4_arg proj){ m_projectionMatrix = proj; }
 
+		void SetCullingEnable(bool enable){ m_cullingEnable = enable; }
+		bool IsCullingEnable() const{ return m_cullingEnable; }
+
+		void SetInstancingEnable(bool enable){ m_instancingEnable = enable; }
+		bool IsInstancingEnable() const{ return m_instancingEnable; }
+
 		void Update();
 		void Render(
 			GfxGraphicsContext& context,
 			RendererDrawStageType stageType,
 			const RendererGraphicsStateDesc& desc);
+
+		// 描画リストをcontextCount個に分割して、[firstContextIndex, firstContextIndex+contextCount)の
+		// コンテキストにjobSystemで並列に記録する. 各コンテキストは記録前にsetupContextが呼ばれるので、
+		// レンダーターゲットやビューポートはそこでセットすること.
+		// GfxContextManager::Executeはコンテキスト順に実行するので、描画順はRenderと同じになる.
+		using ContextSetupFunc = std::function<void(GfxGraphicsContext& context)>;
+		void RenderParallel(
+			JobSystem& jobSystem,
+			GfxContextManager& contextManager,
+			uint32_t firstContextIndex,
+			uint32_t contextCount,
+			RendererDrawStageType stageType,
+			const RendererGraphicsStateDesc& desc,
+			const ContextSetupFunc& setupContext);
 		
 		uint32_t GetReadFrameIndex()  const{ return (uint32_t)(m_frameIndex%(uint64_t)kFrameCount); }
 		uint32_t GetWriteFrameIndex() const{ return (uint32_t)((m_frameIndex+1)%(uint64_t)kFrameCount); }
@@ -42,15 +82,56 @@ namespace SI
 
 		const GfxTextureEx_Static& GetWhiteTexture() const{ return m_whiteTex; }
 
+		// 直前のRenderで描画した数と、カリングで省いた数と、発行したDraw数.
+		uint32_t GetVisibleItemCount() const{ return m_visibleItemCount; }
+		uint32_t GetCulledItemCount()  const{ return m_culledItemCount; }
+		uint32_t GetDrawCallCount()    const{ return m_drawCallCount; }
+
+		// ソートキーのレイアウト. 上位ほど切り替えコストの高いステート.
+		// [63:60] stage, [59:40] pso, [39:20] material, [19:8] geometry, [7:0] depth(手前から奥).
+		// geometryを深度より上に置いて、インスタンシングできるものを隣接させる.
+		// PSOはstateHash(RendererGraphicsStateDescのハッシュ)とrenderMaterialの組で決まる.
+		static uint64_t MakeSortKey(
+			RendererDrawStageType stageType,
+			Hash64 stateHash,
+			const void* renderMaterial,
+			const void* material,
+			const void* geometry,
+			float viewDepth);
+
+	private:
+		void Cull(RendererDrawStageType stageType, const RendererGraphicsStateDesc& renderDesc);
+
+		// カリング, ソート, PSOとマテリアルの更新, インスタンシングのグループ化をする.
+		// シーンのコンスタントバッファのGPUアドレスを返す.
+		size_t PrepareDraw(RendererDrawStageType stageType, const RendererGraphicsStateDesc& renderDesc);
+
+		// m_drawGroups[groupBegin, groupEnd)を記録する. Rendererの状態は書き換えないので、別スレッドから同時に呼べる.
+		void RecordDrawGroups(
+			GfxGraphicsContext& context,
+			uint32_t groupBegin,
+			uint32_t groupEnd,
+			size_t sceneCBGpuAddr) const;
+
 	private:
 		uint64_t               m_frameIndex;
 		//GfxBufferEx_Constant   m_sceneCB[kFrameCount];
 		//GfxBufferEx_Constant   m_dummyCB;
 		GfxLinearAllocator     m_constantAllocator;
 
-		std::unordered_map<void*, ScenesInstancePtr> m_models;
+		HashMap<void*, ScenesInstancePtr> m_models;
 		Vfloat4x4 m_viewMatrix;
 		Vfloat4x4 m_projectionMatrix;
+		Frustum   m_frustum;
+
+		bool                        m_cullingEnable;
+		bool                        m_instancingEnable;
+		std::vector<RenderSortItem> m_visibleItems; // Cullの結果. ソート済み. 毎回使いまわす.
+		std::vector<RenderSortItem> m_sortWork;     // 基数ソートの作業領域.
+		std::vector<RenderDrawGroup> m_drawGroups;  // PrepareDrawの結果.
+		uint32_t                    m_visibleItemCount;
+		uint32_t                    m_culledItemCount;
+		uint32_t                    m_drawCallCount;
 
 		GfxTextureEx_Static m_whiteTex;
 	};
@@ -5,5 +5,6 @@
 namespace SI
 {
 	static const uint32_t kFrameCount = 3;
+	static const uint32_t kMaxInstanceCount = 64; // 1回のDrawでまとめる最大数. シェーダのInstanceCB(cbWorlds)の要素数と合わせる.
 
 } // namespace SI
@@ -77,6 +77,9 @@ namespace SI
 			return nullptr;
 		}
 
+		uint32_t GetDrawStageCount() const{ return (uint32_t)m_drawStageList.size(); }
+		RendererDrawStage& GetDrawStageByIndex(uint32_t index){ return m_drawStageList[index]; }
+
 	private:
 		std::vector<RendererDrawStage> m_drawStageList;
 		RendererDrawStageMask          m_mask;
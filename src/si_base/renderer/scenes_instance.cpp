@@ -4,12 +4,41 @@
 #include "si_base/renderer/render_item.h"
 #include "si_base/gpu/gfx_utility.h"
 #include "si_base/gpu/gfx_input_layout.h"
+#include "si_base/memory/frame_allocator.h"
 
 namespace SI
 {
+	void ScenesInstance::SetNodeMatrix(int nodeId, Vfloat4x4_arg localMatrix)
+	{
+		uint32_t index = m_transforms.GetIndex(nodeId);
+		SI_ASSERT(index != TransformHierarchy::kInvalidIndex);
+
+		m_transforms.SetLocalMatrix(index, localMatrix);
+	}
+
+	void ScenesInstance::UpdateTransforms()
+	{
+		if(!m_transforms.Update()) return;
+
+		for(uint32_t index : m_transforms.GetChangedIndices())
+		{
+			uint32_t end = m_transformItemOffsets[index + 1];
+			for(uint32_t i=m_transformItemOffsets[index]; i<end; ++i)
+			{
+				m_transformItems[i]->UpdateWorldAabb();
+			}
+		}
+	}
+
 	void ScenesInstance::Setup()
 	{
 		m_drawStageList.Clear();
+		m_transformItemOffsets.clear();
+		m_transformItems.clear();
+
+		// 親子関係をたどってワールド行列を作っておく.
+		m_transforms.Build(*this);
+		m_transforms.Update();
 
 		// 使われているステージ数を数える.
 		uint32_t stageItemCounts[(int)RendererDrawStageType::Max] = {};
@@ -48,6 +77,7 @@ namespace SI
 
 		RenderItem renderItem;
 		renderItem.m_scenes = this;
+		renderItem.m_transforms = &m_transforms;
 
 		uint32_t nodeCount = GetNodeCount();
 		for(uint32_t n=0; n<nodeCount; ++n)
@@ -57,7 +87,7 @@ namespace SI
 			if(meshId < 0) continue;
 			SI_ASSERT((uint32_t)meshId < GetMeshCount());
 
-			renderItem.m_worldMatrix = node.GetMatrix();
+			renderItem.m_transformIndex = m_transforms.GetIndex((int)n);
 
 			Mesh& mesh = GetMesh(meshId);
 			uint32_t subMeshCount = mesh.GetSubMeshCount();
@@ -79,6 +109,22 @@ namespace SI
 				renderItem.m_indexAccessor = &indexAccessor;
 				renderItem.m_vertexAttributes = subMesh->GetVertexAttributes();
 
+				// 頂点座標のaccessorのmin/maxから、カリング用のAABBを作る.
+				renderItem.m_hasBounds = false;
+				for(const VertexAttribute& vertexAttribute : *renderItem.m_vertexAttributes)
+				{
+					if(vertexAttribute.m_semantics.m_semanticsType != GfxSemanticsType::Position) continue;
+					if(vertexAttribute.m_accessorId < 0) continue;
+
+					const Accessor& positionAccessor = GetAccessor((uint32_t)vertexAttribute.m_accessorId);
+					if(!positionAccessor.HasBounds()) continue;
+
+					renderItem.m_localAabb.SetMinMax(positionAccessor.GetMin(), positionAccessor.GetMax());
+					renderItem.m_hasBounds = true;
+					renderItem.UpdateWorldAabb();
+					break;
+				}
+
 				Material& material = GetMaterial((uint32_t)materialId);
 				renderItem.m_material = &material;
 
@@ -100,6 +146,32 @@ namespace SI
 				}
 			}
 		}
+
+		// 動いたトランスフォームから参照しているアイテムを引けるように、トランスフォーム順に並べる.
+		uint32_t transformCount = m_transforms.GetCount();
+		uint32_t drawStageCount = m_drawStageList.GetDrawStageCount();
+		m_transformItemOffsets.assign(transformCount + 1, 0);
+		for(uint32_t d=0; d<drawStageCount; ++d)
+		{
+			for(RenderItem& item : m_drawStageList.GetDrawStageByIndex(d).m_renderItems)
+			{
+				++m_transformItemOffsets[item.m_transformIndex + 1];
+			}
+		}
+		for(uint32_t t=0; t<transformCount; ++t)
+		{
+			m_transformItemOffsets[t + 1] += m_transformItemOffsets[t];
+		}
+
+		m_transformItems.resize(m_transformItemOffsets[transformCount]);
+		FrameVector<uint32_t> writeOffsets(m_transformItemOffsets.begin(), m_transformItemOffsets.end() - 1);
+		for(uint32_t d=0; d<drawStageCount; ++d)
+		{
+			for(RenderItem& item : m_drawStageList.GetDrawStageByIndex(d).m_renderItems)
+			{
+				m_transformItems[writeOffsets[item.m_transformIndex]++] = &item;
+			}
+		}
 	}
 
 } // namespace SI
@@ -7,6 +7,7 @@
 #include "si_base/renderer/scenes.h"
 #include "si_base/renderer/renderer_graphics_state.h"
 #include "si_base/renderer/renderer_draw_stage.h"
+#include "si_base/renderer/transform_hierarchy.h"
 
 namespace SI
 {
@@ -120,6 +121,15 @@ namespace SI
 
 		RendererDrawStageList& GetDrawStageList(){ return m_drawStageList; }
 
+		TransformHierarchy&       GetTransforms()      { return m_transforms; }
+		const TransformHierarchy& GetTransforms() const{ return m_transforms; }
+
+		// ノードのローカル行列を変更する. ワールド行列はUpdateTransformsでまとめて更新される.
+		void SetNodeMatrix(int nodeId, Vfloat4x4_arg localMatrix);
+
+		// 変更があったノードのワールド行列と、それを参照するレンダーアイテムのAABBを更新する.
+		void UpdateTransforms();
+
 		void Setup();
 
 	public:
@@ -145,6 +155,10 @@ namespace SI
 		ScenesInstancePtr                  m_originalIns;
 		ScenesPtr                          m_original;
 		RendererDrawStageList              m_drawStageList;
+
+		TransformHierarchy                 m_transforms;
+		std::vector<uint32_t>              m_transformItemOffsets; // トランスフォーム毎のm_transformItemsの開始位置.
+		std::vector<RenderItem*>           m_transformItems;       // トランスフォーム順に並べたレンダーアイテム.
 	};
 	
 } // namespace SI
@@ -0,0 +1,178 @@
+﻿
+#include "si_base/renderer/transform_hierarchy.h"
+
+#include "si_base/core/assert.h"
+#include "si_base/math/math_batch.h"
+#include "si_base/memory/frame_allocator.h"
+#include "si_base/renderer/scenes.h"
+
+namespace SI
+{
+	TransformHierarchy::TransformHierarchy()
+		: m_dirty(false)
+	{
+	}
+
+	TransformHierarchy::~TransformHierarchy()
+	{
+	}
+
+	void TransformHierarchy::Build(const IScenes& scenes)
+	{
+		Clear();
+
+		uint32_t nodeCount = scenes.GetNodeCount();
+		m_localMatrices.reserve(nodeCount);
+		m_worldMatrices.reserve(nodeCount);
+		m_parentIndices.reserve(nodeCount);
+		m_dirtyFlags.reserve(nodeCount);
+		m_nodeToIndex.resize(nodeCount, (uint32_t)kInvalidIndex);
+
+		// 子として参照されていないノードがルート.
+		FrameVector<uint8_t> isChild(nodeCount, 0);
+		for(uint32_t n=0; n<nodeCount; ++n)
+		{
+			const Node& node = scenes.GetNode(n);
+			int childCount = node.GetChildrenNodeCount();
+			for(int c=0; c<childCount; ++c)
+			{
+				int childId = node.GetChildrenNodeId(c);
+				SI_ASSERT(0 <= childId && (uint32_t)childId < nodeCount);
+				isChild[childId] = 1;
+			}
+		}
+
+		FrameVector<uint32_t> queue; // 追加順のノードID. 幅優先なので親は必ず前にある.
+		queue.reserve(nodeCount);
+		for(uint32_t n=0; n<nodeCount; ++n)
+		{
+			if(isChild[n]) continue;
+
+			m_nodeToIndex[n] = Add(kInvalidIndex, scenes.GetNode(n).GetMatrix());
+			queue.push_back(n);
+		}
+
+		for(size_t q=0; q<queue.size(); ++q)
+		{
+			const Node& node = scenes.GetNode(queue[q]);
+			uint32_t parentIndex = m_nodeToIndex[queue[q]];
+
+			int childCount = node.GetChildrenNodeCount();
+			for(int c=0; c<childCount; ++c)
+			{
+				uint32_t childId = (uint32_t)node.GetChildrenNodeId(c);
+				if(m_nodeToIndex[childId] != kInvalidIndex) continue; // 複数の親から参照されている.
+
+				m_nodeToIndex[childId] = Add(parentIndex, scenes.GetNode(childId).GetMatrix());
+				queue.push_back(childId);
+			}
+		}
+	}
+
+	void TransformHierarchy::Clear()
+	{
+		m_localMatrices.clear();
+		m_worldMatrices.clear();
+		m_parentIndices.clear();
+		m_dirtyFlags.clear();
+		m_changedIndices.clear();
+		m_nodeToIndex.clear();
+		m_dirty = false;
+	}
+
+	uint32_t TransformHierarchy::Add(uint32_t parentIndex, Vfloat4x4_arg localMatrix)
+	{
+		uint32_t index = GetCount();
+		SI_ASSERT(parentIndex == kInvalidIndex || parentIndex < index);
+
+		m_localMatrices.push_back(localMatrix);
+		m_worldMatrices.push_back(localMatrix);
+		m_parentIndices.push_back(parentIndex);
+		m_dirtyFlags.push_back(1);
+		m_dirty = true;
+
+		return index;
+	}
+
+	void TransformHierarchy::SetLocalMatrix(uint32_t index, Vfloat4x4_arg localMatrix)
+	{
+		SI_ASSERT(index < GetCount());
+
+		m_localMatrices[index] = localMatrix;
+		m_dirtyFlags[index] = 1;
+		m_dirty = true;
+	}
+
+	void TransformHierarchy::SetLocalTRS(uint32_t index, Vfloat3_arg translation, Vquat_arg rotation, Vfloat3_arg scale)
+	{
+		// 行ベクトルなので、スケール, 回転, 平行移動の順に掛かる.
+		Vfloat3x3 scaleRotation = Vfloat3x3::Scale(scale) * Vfloat3x3(rotation);
+		SetLocalMatrix(index, Vfloat4x4(scaleRotation, translation));
+	}
+
+	bool TransformHierarchy::Update()
+	{
+		m_changedIndices.clear();
+		if(!m_dirty) return false;
+
+		uint32_t count = GetCount();
+
+		// 親は子より前にあるので、1回なめれば子孫まで伝搬する.
+		for(uint32_t i=0; i<count; ++i)
+		{
+			uint32_t parentIndex = m_parentIndices[i];
+			if(parentIndex != kInvalidIndex && m_dirtyFlags[parentIndex])
+			{
+				m_dirtyFlags[i] = 1;
+			}
+		}
+
+		// 同じ親を持つ連続した要素は、親の行列をまとめて掛ける.
+		for(uint32_t begin=0; begin<count; )
+		{
+			if(!m_dirtyFlags[begin])
+			{
+				++begin;
+				continue;
+			}
+
+			uint32_t parentIndex = m_parentIndices[begin];
+			uint32_t end = begin + 1;
+			while(end < count && m_dirtyFlags[end] && m_parentIndices[end] == parentIndex)
+			{
+				++end;
+			}
+
+			if(parentIndex == kInvalidIndex)
+			{
+				for(uint32_t i=begin; i<end; ++i)
+				{
+					m_worldMatrices[i] = m_localMatrices[i];
+				}
+			}
+			else
+			{
+				Math::Multiply(&m_worldMatrices[begin], &m_localMatrices[begin], m_worldMatrices[parentIndex], end - begin);
+			}
+
+			for(uint32_t i=begin; i<end; ++i)
+			{
+				m_dirtyFlags[i] = 0;
+				m_changedIndices.push_back(i);
+			}
+
+			begin = end;
+		}
+
+		m_dirty = false;
+		return true;
+	}
+
+	uint32_t TransformHierarchy::GetIndex(int nodeId) const
+	{
+		if(nodeId < 0 || m_nodeToIndex.size() <= (size_t)nodeId) return kInvalidIndex;
+
+		return m_nodeToIndex[nodeId];
+	}
+
+} // namespace SI
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "si_base/math/math.h"
+
+namespace SI
+{
+	class IScenes;
+
+	// ノードのローカル行列とワールド行列を、親が子より前に来る順番で連続した配列に持つ.
+	// SetLocal*で変更したノードとその子孫だけをUpdateで再計算する.
+	class TransformHierarchy
+	{
+	public:
+		static const uint32_t kInvalidIndex = 0xffffffff;
+
+	public:
+		TransformHierarchy();
+		~TransformHierarchy();
+
+		// シーンのノードを幅優先で並べて登録する. 兄弟が連続するので、まとめて親の行列を掛けられる.
+		void Build(const IScenes& scenes);
+		void Clear();
+
+		// 末尾に追加する. parentIndexは追加済みのもの(kInvalidIndexならルート).
+		uint32_t Add(uint32_t parentIndex, Vfloat4x4_arg localMatrix);
+
+		void SetLocalMatrix(uint32_t index, Vfloat4x4_arg localMatrix);
+		void SetLocalTRS(uint32_t index, Vfloat3_arg translation, Vquat_arg rotation, Vfloat3_arg scale);
+
+		// 変更されたワールド行列を再計算する. 何か変わったらtrueを返す.
+		bool Update();
+
+		// 直前のUpdateでワールド行列が変わったインデックス(昇順).
+		const std::vector<uint32_t>& GetChangedIndices() const{ return m_changedIndices; }
+
+		uint32_t GetCount() const{ return (uint32_t)m_parentIndices.size(); }
+		uint32_t GetIndex(int nodeId) const;
+		uint32_t GetParentIndex(uint32_t index) const{ return m_parentIndices[index]; }
+
+		const Vfloat4x4& GetLocalMatrix(uint32_t index) const{ return m_localMatrices[index]; }
+		const Vfloat4x4& GetWorldMatrix(uint32_t index) const{ return m_worldMatrices[index]; }
+
+		bool IsDirty() const{ return m_dirty; }
+
+	private:
+		std::vector<Vfloat4x4> m_localMatrices;
+		std::vector<Vfloat4x4> m_worldMatrices;
+		std::vector<uint32_t>  m_parentIndices;
+		std::vector<uint8_t>   m_dirtyFlags;
+		std::vector<uint32_t>  m_changedIndices;
+		std::vector<uint32_t>  m_nodeToIndex;    // ノードIDからインデックスへ.
+		bool                   m_dirty;
+	};
+
+} // namespace SI
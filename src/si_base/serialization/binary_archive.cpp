@@ -0,0 +1,115 @@
+﻿
+#include "si_base/serialization/binary_archive.h"
+
+namespace SI
+{
+	Hash64 BinaryArchiveLayout::GetLayoutHash(const ReflectionType& type)
+	{
+		bool hasBackEdge = false;
+		return GetLayoutHash(type, hasBackEdge);
+	}
+
+	Hash64 BinaryArchiveLayout::GetLayoutHash(const ReflectionType& type, bool& outHasBackEdge)
+	{
+		auto itr = m_layoutHashes.find(&type);
+		if(itr != m_layoutHashes.end()) return itr->second;
+
+		// 循環している場合は名前だけで区別する.
+		if(m_visitingTypes.find(&type) != m_visitingTypes.end())
+		{
+			outHasBackEdge = true;
+			return type.GetNameHash();
+		}
+		m_visitingTypes.insert(&type);
+
+		bool hasBackEdge = false;
+		Hash64 hash = type.GetNameHash();
+		hash = GetHash64(type.GetSize(), hash);
+		hash = GetHash64(type.GetAlignment(), hash);
+
+		if(IsArrayType(type))
+		{
+			hash = GetHash64(GetLayoutHash(*type.GetTemplateArgType(), hasBackEdge), hash);
+			hash = GetHash64(type.GetTemplateArgPointerCount(), hash);
+		}
+
+		uint32_t memberCount = type.GetMemberCount();
+		for(uint32_t m=0; m<memberCount; ++m)
+		{
+			const ReflectionMember* member = type.GetMember(m);
+			if(!member) continue;
+
+			hash = GetHash64(member->GetNameHash(), hash);
+			hash = GetHash64(member->GetOffset(), hash);
+			hash = GetHash64(member->GetPointerCount(), hash);
+			hash = GetHash64(member->GetArrayCount(), hash);
+			hash = GetHash64(GetLayoutHash(member->GetType(), hasBackEdge), hash);
+		}
+
+		m_visitingTypes.erase(&type);
+
+		// 循環の途中で名前だけにした型を含むハッシュは、どの型から辿ったかで値が変わるのでキャッシュしない.
+		// 循環を含まない型だけキャッシュしておけば、同じ型はいつも同じハッシュになる.
+		if(hasBackEdge)
+		{
+			outHasBackEdge = true;
+		}
+		else
+		{
+			m_layoutHashes.insert(std::make_pair(&type, hash));
+		}
+		return hash;
+	}
+
+	bool BinaryArchiveLayout::HasPointer(const ReflectionType& type)
+	{
+		auto itr = m_hasPointers.find(&type);
+		if(itr != m_hasPointers.end()) return itr->second;
+
+		bool hasPointer = IsArrayType(type);
+
+		uint32_t memberCount = type.GetMemberCount();
+		for(uint32_t m=0; m<memberCount && !hasPointer; ++m)
+		{
+			const ReflectionMember* member = type.GetMember(m);
+			if(!member) continue;
+
+			// ポインタなら中身は見ないので、ここで再帰が止まる.
+			hasPointer = member->IsPointer() || HasPointer(member->GetType());
+		}
+
+		m_hasPointers.insert(std::make_pair(&type, hasPointer));
+		return hasPointer;
+	}
+
+	void BinaryArchiveLayout::Clear()
+	{
+		m_layoutHashes.clear();
+		m_hasPointers.clear();
+		m_visitingTypes.clear();
+	}
+
+	bool BinaryArchiveLayout::IsArrayType(const ReflectionType& type)
+	{
+		return type.GetTemplateName() && type.GetTemplateNameHash() == GetHash64S("SI::Array");
+	}
+
+	bool BinaryArchiveLayout::GetArrayMembers(ArrayMembers& outMembers, const ReflectionType& type)
+	{
+		SI_ASSERT(IsArrayType(type));
+		SI_ASSERT(type.GetMemberCount() == 2);
+
+		outMembers.m_items     = type.FindMember("m_items",     GetHash64S("m_items"));
+		outMembers.m_itemCount = type.FindMember("m_itemCount", GetHash64S("m_itemCount"));
+		if(!outMembers.m_items || !outMembers.m_itemCount)
+		{
+			SI_ASSERT(0);
+			return false;
+		}
+
+		SI_ASSERT(1 <= outMembers.m_items->GetPointerCount());
+		SI_ASSERT(outMembers.m_itemCount->GetType().GetNameHash() == GetHash64S("uint32_t"));
+		return true;
+	}
+
+} // namespace SI
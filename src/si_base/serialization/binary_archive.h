@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include "si_base/misc/hash.h"
+#include "si_base/serialization/reflection.h"
+
+namespace SI
+{
+	// BinarySerializer/BinaryDeserializerで使うファイル形式.
+	//
+	// [BinaryArchiveHeader][data]
+	// dataはルートのオブジェクトをそのままメモリに置いた状態のイメージ.
+	// ポインタはそのポインタ自身の位置からの相対オフセット(nullは0)にしてあるので、
+	// 読み込み時はdataを一度に読んで、ポインタを絶対アドレスに直すだけで使える.
+	// リトルエンディアン・64bitポインタ前提.
+	struct BinaryArchiveHeader
+	{
+		static const uint32_t kSignature = 0x41424953; // "SIBA"
+		static const uint16_t kVersion   = 1;
+		static const uint16_t kEndianTag = 0x0102;
+
+		uint32_t m_signature;
+		uint16_t m_version;
+		uint16_t m_endianTag;
+		uint64_t m_typeHash;      // ルートの型のレイアウトのハッシュ. 型が変わっていたら読めない.
+		uint64_t m_dataSize;
+		uint32_t m_dataAlignment; // dataの中で一番大きいアライメント.
+		uint32_t m_rootOffset;    // dataの先頭からルートのオブジェクトまでのオフセット.
+	};
+	static_assert(sizeof(BinaryArchiveHeader) == 32, "BinaryArchiveHeaderのサイズが変わった");
+
+	// リフレクションから、バイナリに必要な型の情報を調べてキャッシュしておく.
+	class BinaryArchiveLayout
+	{
+	public:
+		struct ArrayMembers
+		{
+			const ReflectionMember* m_items;
+			const ReflectionMember* m_itemCount;
+		};
+
+	public:
+		// 名前, サイズ, メンバのオフセットと型などから作るハッシュ. どこかが変わると値が変わる.
+		Hash64 GetLayoutHash(const ReflectionType& type);
+
+		// ポインタやSI::Arrayを(メンバの中も含めて)持っているか. 持っていなければmemcpyだけで済む.
+		bool HasPointer(const ReflectionType& type);
+
+		void Clear();
+
+	public:
+		static bool IsArrayType(const ReflectionType& type);
+		static bool GetArrayMembers(ArrayMembers& outMembers, const ReflectionType& type);
+
+		// 配列メンバの要素の間隔. ポインタの配列の時は型のサイズではない.
+		static uint32_t GetStride(const ReflectionType& type, uint32_t pointerCount)
+		{
+			return (0<pointerCount)? (uint32_t)sizeof(void*) : type.GetSize();
+		}
+
+	private:
+		// 辿った先で訪問中の型に戻った(循環があった)場合はoutHasBackEdgeをtrueにする.
+		Hash64 GetLayoutHash(const ReflectionType& type, bool& outHasBackEdge);
+
+	private:
+		std::unordered_map<const ReflectionType*, Hash64> m_layoutHashes;  // 循環を含まない型だけ入れる.
+		std::unordered_map<const ReflectionType*, bool>   m_hasPointers;
+		std::unordered_set<const ReflectionType*>         m_visitingTypes; // ポインタで互いを持つ型の循環よけ.
+	};
+
+} // namespace SI
@@ -0,0 +1,282 @@
+﻿
+#include "si_base/serialization/binary_deserializer.h"
+
+#include <cstring>
+#include "si_base/core/new_delete.h"
+#include "si_base/core/print.h"
+#include "si_base/file/mapped_file.h"
+#include "si_base/serialization/binary_archive.h"
+
+namespace SI
+{
+	class BinaryDeserializerImpl
+	{
+	public:
+		BinaryDeserializerImpl()
+			: m_data(nullptr)
+			, m_dataSize(0)
+		{
+		}
+
+		~BinaryDeserializerImpl()
+		{
+		}
+
+		bool DeserializeRoot(
+			DeserializedObject& outDeserializedObject,
+			const char* path,
+			const ReflectionType& reflection)
+		{
+			// ポインタを直す分だけ書き換えるので、コピーオンライトでマップする.
+			MappedFile mappedFile;
+			if(mappedFile.Open(path, MappedFileAccess::CopyOnWrite) != 0)
+			{
+				SI_WARNING(0, "file(%s) can't be loaded.", path);
+				return false;
+			}
+
+			BinaryArchiveHeader header;
+			if(mappedFile.GetSize() < sizeof(header))
+			{
+				SI_WARNING(0, "file(%s) is broken.", path);
+				return false;
+			}
+			memcpy(&header, mappedFile.GetData(), sizeof(header));
+
+			if(!ValidateHeader(header, mappedFile.GetSize() - sizeof(header), reflection))
+			{
+				SI_WARNING(0, "file(%s) has an incompatible type.", path);
+				return false;
+			}
+
+			// マッピング上のdataのアライメントが足りていれば、コピーせずにそのまま使う.
+			uint8_t* data = mappedFile.GetWritableData() + sizeof(header);
+			if(((uintptr_t)data & (header.m_dataAlignment - 1)) != 0)
+			{
+				return DeserializeRoot(outDeserializedObject, mappedFile.GetData(), mappedFile.GetSize(), reflection);
+			}
+
+			if(!Relocate(data, header, reflection)) return false;
+
+			DeserializedObject outObject(data + header.m_rootOffset, &reflection);
+			outObject.SetMappedFile(std::move(mappedFile));
+
+			outDeserializedObject = std::move(outObject);
+			return true;
+		}
+
+		bool DeserializeRoot(
+			DeserializedObject& outDeserializedObject,
+			const void* buffer,
+			size_t bufferSize,
+			const ReflectionType& reflection)
+		{
+			BinaryArchiveHeader header;
+			if(bufferSize < sizeof(header)) return false;
+			memcpy(&header, buffer, sizeof(header));
+
+			if(!ValidateHeader(header, bufferSize - sizeof(header), reflection)) return false;
+
+			void* data = SI_ALIGNED_MALLOC((size_t)Max(header.m_dataSize, (uint64_t)1), header.m_dataAlignment);
+			DeserializedObject outObject((uint8_t*)data + header.m_rootOffset, &reflection);
+			outObject.AddAllocatedBuffer(data, nullptr, 0);
+
+			memcpy(data, (const uint8_t*)buffer + sizeof(header), (size_t)header.m_dataSize);
+
+			if(!Relocate(data, header, reflection)) return false;
+
+			outDeserializedObject = std::move(outObject);
+			return true;
+		}
+
+	private:
+		bool ValidateHeader(const BinaryArchiveHeader& header, uint64_t dataSize, const ReflectionType& reflection)
+		{
+			if(header.m_signature != BinaryArchiveHeader::kSignature) return false;
+			if(header.m_version   != BinaryArchiveHeader::kVersion)   return false;
+			if(header.m_endianTag != BinaryArchiveHeader::kEndianTag) return false;
+			if(header.m_typeHash  != m_layout.GetLayoutHash(reflection)) return false;
+
+			if(dataSize < header.m_dataSize) return false;
+			if(header.m_dataSize < (uint64_t)header.m_rootOffset + reflection.GetSize()) return false;
+
+			uint32_t alignment = header.m_dataAlignment;
+			if(alignment == 0 || (alignment & (alignment - 1)) != 0) return false;
+			if(header.m_rootOffset % reflection.GetAlignment() != 0) return false;
+
+			return true;
+		}
+
+		bool Relocate(void* data, const BinaryArchiveHeader& header, const ReflectionType& reflection)
+		{
+			if(!m_layout.HasPointer(reflection)) return true; // ポインタが無ければ読むだけで終わり.
+
+			m_data     = (uint8_t*)data;
+			m_dataSize = (size_t)header.m_dataSize;
+			bool ret = RelocateObject(m_data + header.m_rootOffset, reflection);
+			m_data     = nullptr;
+			m_dataSize = 0;
+
+			if(!ret)
+			{
+				SI_WARNING(0, "binary archive has an invalid pointer.");
+			}
+			return ret;
+		}
+
+		// 相対オフセットを絶対アドレスに直す. 指す先がdataの外なら失敗.
+		void* RelocatePointer(uint8_t* pointer, size_t targetSize, uint32_t targetAlignment, bool& outValid)
+		{
+			int64_t relative;
+			memcpy(&relative, pointer, sizeof(relative));
+			if(relative == 0)
+			{
+				*(void**)pointer = nullptr;
+				outValid = true;
+				return nullptr;
+			}
+
+			int64_t target = (int64_t)(pointer - m_data) + relative;
+			outValid =
+				0 <= target &&
+				(uint64_t)target + targetSize <= m_dataSize &&
+				(uint64_t)target % targetAlignment == 0;
+			if(!outValid) return nullptr;
+
+			uint8_t* ptr = m_data + target;
+			*(void**)pointer = ptr;
+			return ptr;
+		}
+
+		bool RelocateValue(uint8_t* buffer, const ReflectionType& reflection, uint32_t pointerCount)
+		{
+			if(pointerCount == 0)
+			{
+				return m_layout.HasPointer(reflection)? RelocateObject(buffer, reflection) : true;
+			}
+
+			bool valid = false;
+
+			// 文字列は終端があるかだけ調べる.
+			if(pointerCount == 1 && reflection.GetNameHash() == GetHash64S("char"))
+			{
+				uint8_t* str = (uint8_t*)RelocatePointer(buffer, 1, 1, valid);
+				if(!valid) return false;
+				return !str || memchr(str, 0, m_dataSize - (size_t)(str - m_data)) != nullptr;
+			}
+
+			size_t size    = (pointerCount == 1)? reflection.GetSize()      : sizeof(void*);
+			uint32_t align = (pointerCount == 1)? reflection.GetAlignment() : (uint32_t)alignof(void*);
+			uint8_t* ptr = (uint8_t*)RelocatePointer(buffer, size, align, valid);
+			if(!valid) return false;
+			if(!ptr) return true;
+
+			return RelocateValue(ptr, reflection, pointerCount - 1);
+		}
+
+		bool RelocateObject(uint8_t* buffer, const ReflectionType& reflection)
+		{
+			if(BinaryArchiveLayout::IsArrayType(reflection))
+			{
+				return RelocateArray(buffer, reflection);
+			}
+
+			uint32_t memberCount = reflection.GetMemberCount();
+			for(uint32_t m=0; m<memberCount; ++m)
+			{
+				const ReflectionMember* member = reflection.GetMember(m);
+				if(!member) continue;
+
+				const ReflectionType& memberType = member->GetType();
+				uint32_t pointerCount = member->GetPointerCount();
+				if(pointerCount == 0 && !m_layout.HasPointer(memberType)) continue;
+
+				uint32_t count  = Max(member->GetArrayCount(), 1u);
+				uint32_t stride = BinaryArchiveLayout::GetStride(memberType, pointerCount);
+				for(uint32_t a=0; a<count; ++a)
+				{
+					uint8_t* memberBuffer = buffer + member->GetOffset() + a * stride;
+					if(!RelocateValue(memberBuffer, memberType, pointerCount)) return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool RelocateArray(uint8_t* buffer, const ReflectionType& reflection)
+		{
+			BinaryArchiveLayout::ArrayMembers members;
+			if(!BinaryArchiveLayout::GetArrayMembers(members, reflection)) return false;
+
+			uint32_t itemCount = *(const uint32_t*)(buffer + members.m_itemCount->GetOffset());
+
+			const ReflectionType& itemType = members.m_items->GetType();
+			uint32_t itemPointerCount = members.m_items->GetPointerCount() - 1;
+			uint32_t stride = BinaryArchiveLayout::GetStride(itemType, itemPointerCount);
+			uint32_t align  = (0<itemPointerCount)? (uint32_t)alignof(void*) : itemType.GetAlignment();
+
+			bool valid = false;
+			uint8_t* items = (uint8_t*)RelocatePointer(buffer + members.m_items->GetOffset(), (size_t)stride * itemCount, align, valid);
+			if(!valid) return false;
+			if(!items) return true;
+
+			if(itemPointerCount == 0 && !m_layout.HasPointer(itemType)) return true;
+
+			for(uint32_t i=0; i<itemCount; ++i)
+			{
+				if(!RelocateValue(items + (size_t)i * stride, itemType, itemPointerCount)) return false;
+			}
+
+			return true;
+		}
+
+	private:
+		BinaryArchiveLayout m_layout;
+		uint8_t*            m_data;
+		size_t              m_dataSize;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	BinaryDeserializer::BinaryDeserializer()
+		: m_impl(nullptr)
+	{
+	}
+
+	BinaryDeserializer::~BinaryDeserializer()
+	{
+		Terminate();
+	}
+		
+	void BinaryDeserializer::Initialize()
+	{
+		SI_ASSERT(!m_impl);
+		m_impl = SI_NEW(BinaryDeserializerImpl);
+	}
+
+	void BinaryDeserializer::Terminate()
+	{
+		if(!m_impl) return;
+
+		SI_DELETE(m_impl);
+		m_impl = nullptr;
+	}
+	
+	bool BinaryDeserializer::DeserializeRoot(
+		DeserializedObject& outDeserializedObject,
+		const char* path,
+		const ReflectionType& reflection)
+	{
+		return m_impl->DeserializeRoot(outDeserializedObject, path, reflection);
+	}
+
+	bool BinaryDeserializer::DeserializeRoot(
+		DeserializedObject& outDeserializedObject,
+		const void* buffer,
+		size_t bufferSize,
+		const ReflectionType& reflection)
+	{
+		return m_impl->DeserializeRoot(outDeserializedObject, buffer, bufferSize, reflection);
+	}
+
+} // namespace SI
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include <cstdint>
+#include "si_base/serialization/reflection.h"
+#include "si_base/serialization/deserializer.h"
+
+namespace SI
+{
+	class BinaryDeserializerImpl;
+
+	// BinarySerializerで書き出したものを読み込む.
+	// 読んだデータをそのままオブジェクトとして使うので、コンストラクタ/デストラクタは呼ばれない.
+	// 型のレイアウトが書き出した時と違う場合は読み込まずに失敗する(json版と違い互換性は無い).
+	class BinaryDeserializer
+	{
+	public:
+		BinaryDeserializer();
+		~BinaryDeserializer();
+		
+		void Initialize();
+		void Terminate();
+
+		template<typename T>
+		bool Deserialize(DeserializedObject& outDeserializedObject, const char* path)
+		{
+			return DeserializeRoot(outDeserializedObject, path, GetReflectionType<T>(0));
+		}
+
+		template<typename T>
+		bool Deserialize(DeserializedObject& outDeserializedObject, const void* buffer, size_t bufferSize)
+		{
+			return DeserializeRoot(outDeserializedObject, buffer, bufferSize, GetReflectionType<T>(0));
+		}
+
+	private:
+		bool DeserializeRoot(DeserializedObject& outDeserializedObject, const char* path, const ReflectionType& reflection);
+		bool DeserializeRoot(DeserializedObject& outDeserializedObject, const void* buffer, size_t bufferSize, const ReflectionType& reflection);
+
+	private:
+		BinaryDeserializerImpl* m_impl;
+	};
+
+} // namespace SI
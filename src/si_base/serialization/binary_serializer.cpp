@@ -0,0 +1,233 @@
+﻿
+#include "si_base/serialization/binary_serializer.h"
+
+#include <cstring>
+#include "si_base/core/new_delete.h"
+#include "si_base/core/print.h"
+#include "si_base/file/file.h"
+#include "si_base/serialization/binary_archive.h"
+
+namespace SI
+{
+	class BinarySerializerImpl
+	{
+	public:
+		BinarySerializerImpl()
+			: m_data(nullptr)
+			, m_dataAlignment(1)
+		{
+		}
+
+		~BinarySerializerImpl()
+		{
+		}
+		
+		bool SerializeRoot(std::vector<uint8_t>& outBuffer, const void* buffer, const ReflectionType& reflection)
+		{
+			static_assert(sizeof(void*) == sizeof(int64_t), "64bitポインタ前提");
+
+			std::vector<uint8_t> data;
+			m_data = &data;
+			m_dataAlignment = 1;
+
+			size_t rootOffset = AllocateData(reflection.GetSize(), reflection.GetAlignment());
+			memcpy(&data[rootOffset], buffer, reflection.GetSize());
+			bool ret = WriteObject(rootOffset, buffer, reflection);
+
+			m_data = nullptr;
+			if(!ret) return false;
+
+			BinaryArchiveHeader header;
+			memset(&header, 0, sizeof(header));
+			header.m_signature     = BinaryArchiveHeader::kSignature;
+			header.m_version       = BinaryArchiveHeader::kVersion;
+			header.m_endianTag     = BinaryArchiveHeader::kEndianTag;
+			header.m_typeHash      = m_layout.GetLayoutHash(reflection);
+			header.m_dataSize      = data.size();
+			header.m_dataAlignment = m_dataAlignment;
+			header.m_rootOffset    = (uint32_t)rootOffset;
+
+			outBuffer.resize(sizeof(header) + data.size());
+			memcpy(&outBuffer[0], &header, sizeof(header));
+			if(!data.empty())
+			{
+				memcpy(&outBuffer[sizeof(header)], &data[0], data.size());
+			}
+
+			return true;
+		}
+
+	private:
+		// 確保した位置を返す. m_dataは伸びるので、アドレスではなくオフセットで扱う.
+		size_t AllocateData(size_t size, uint32_t alignment)
+		{
+			alignment = Max(alignment, 1u);
+			m_dataAlignment = Max(m_dataAlignment, alignment);
+
+			size_t offset = (m_data->size() + alignment - 1) & ~(size_t)(alignment - 1);
+			m_data->resize(offset + size, 0);
+			return offset;
+		}
+
+		void WritePointerOffset(size_t pointerOffset, size_t targetOffset)
+		{
+			int64_t relative = (int64_t)targetOffset - (int64_t)pointerOffset;
+			memcpy(&(*m_data)[pointerOffset], &relative, sizeof(relative));
+		}
+
+		// dstOffsetには既にsrcの値がコピーされている. ポインタだけを書き換えて、指す先を追加していく.
+		bool WriteValue(size_t dstOffset, const void* src, const ReflectionType& reflection, uint32_t pointerCount)
+		{
+			if(pointerCount == 0)
+			{
+				return m_layout.HasPointer(reflection)? WriteObject(dstOffset, src, reflection) : true;
+			}
+
+			const void* ptr = *(const void* const*)src;
+			if(!ptr)
+			{
+				int64_t zero = 0;
+				memcpy(&(*m_data)[dstOffset], &zero, sizeof(zero));
+				return true;
+			}
+
+			// 文字列は終端まで.
+			if(pointerCount == 1 && reflection.GetNameHash() == GetHash64S("char"))
+			{
+				size_t strSize = strlen((const char*)ptr) + 1;
+				size_t strOffset = AllocateData(strSize, 1);
+				memcpy(&(*m_data)[strOffset], ptr, strSize);
+				WritePointerOffset(dstOffset, strOffset);
+				return true;
+			}
+
+			size_t size      = (pointerCount == 1)? reflection.GetSize()      : sizeof(void*);
+			uint32_t align   = (pointerCount == 1)? reflection.GetAlignment() : (uint32_t)alignof(void*);
+			size_t ptrOffset = AllocateData(size, align);
+			memcpy(&(*m_data)[ptrOffset], ptr, size);
+			WritePointerOffset(dstOffset, ptrOffset);
+
+			return WriteValue(ptrOffset, ptr, reflection, pointerCount - 1);
+		}
+
+		bool WriteObject(size_t dstOffset, const void* src, const ReflectionType& reflection)
+		{
+			if(BinaryArchiveLayout::IsArrayType(reflection))
+			{
+				return WriteArray(dstOffset, src, reflection);
+			}
+
+			uint32_t memberCount = reflection.GetMemberCount();
+			for(uint32_t m=0; m<memberCount; ++m)
+			{
+				const ReflectionMember* member = reflection.GetMember(m);
+				if(!member) continue;
+
+				const ReflectionType& memberType = member->GetType();
+				uint32_t pointerCount = member->GetPointerCount();
+				if(pointerCount == 0 && !m_layout.HasPointer(memberType)) continue;
+
+				uint32_t count  = Max(member->GetArrayCount(), 1u);
+				uint32_t stride = BinaryArchiveLayout::GetStride(memberType, pointerCount);
+				for(uint32_t a=0; a<count; ++a)
+				{
+					size_t offset = member->GetOffset() + a * stride;
+					if(!WriteValue(dstOffset + offset, (const uint8_t*)src + offset, memberType, pointerCount)) return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool WriteArray(size_t dstOffset, const void* src, const ReflectionType& reflection)
+		{
+			BinaryArchiveLayout::ArrayMembers members;
+			if(!BinaryArchiveLayout::GetArrayMembers(members, reflection)) return false;
+
+			const void* items = *(const void* const*)((const uint8_t*)src + members.m_items->GetOffset());
+			uint32_t itemCount = *(const uint32_t*)((const uint8_t*)src + members.m_itemCount->GetOffset());
+
+			size_t itemsPointerOffset = dstOffset + members.m_items->GetOffset();
+			if(!items || itemCount == 0)
+			{
+				int64_t zero = 0;
+				memcpy(&(*m_data)[itemsPointerOffset], &zero, sizeof(zero));
+				return true;
+			}
+
+			// 要素はまとめてコピーして、ポインタを含む要素の場合だけ後から直す.
+			const ReflectionType& itemType = members.m_items->GetType();
+			uint32_t itemPointerCount = members.m_items->GetPointerCount() - 1;
+			uint32_t stride = BinaryArchiveLayout::GetStride(itemType, itemPointerCount);
+			uint32_t align  = (0<itemPointerCount)? (uint32_t)alignof(void*) : itemType.GetAlignment();
+
+			size_t itemsOffset = AllocateData((size_t)stride * itemCount, align);
+			memcpy(&(*m_data)[itemsOffset], items, (size_t)stride * itemCount);
+			WritePointerOffset(itemsPointerOffset, itemsOffset);
+
+			if(itemPointerCount == 0 && !m_layout.HasPointer(itemType)) return true;
+
+			for(uint32_t i=0; i<itemCount; ++i)
+			{
+				size_t offset = (size_t)i * stride;
+				if(!WriteValue(itemsOffset + offset, (const uint8_t*)items + offset, itemType, itemPointerCount)) return false;
+			}
+
+			return true;
+		}
+
+	private:
+		BinaryArchiveLayout    m_layout;
+		std::vector<uint8_t>*  m_data;
+		uint32_t               m_dataAlignment;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	BinarySerializer::BinarySerializer()
+		: m_impl(nullptr)
+	{
+	}
+
+	BinarySerializer::~BinarySerializer()
+	{
+		Terminate();
+	}
+		
+	void BinarySerializer::Initialize()
+	{
+		SI_ASSERT(!m_impl);
+		m_impl = SI_NEW(BinarySerializerImpl);
+	}
+
+	void BinarySerializer::Terminate()
+	{
+		if(!m_impl) return;
+
+		SI_DELETE(m_impl);
+		m_impl = nullptr;
+	}
+	
+	bool BinarySerializer::SerializeRoot(std::vector<uint8_t>& outBuffer, const void* buffer, const ReflectionType& reflection)
+	{
+		return m_impl->SerializeRoot(outBuffer, buffer, reflection);
+	}
+	
+	bool BinarySerializer::Save(const char* path, const void* buffer, size_t bufferSize)
+	{
+		File f;
+		int ret = f.Open(path, SI::FileAccessType::Write);
+		if(ret!=0)
+		{
+			SI_WARNING(0, "file(%s) can't be opened.", path);
+			return false;
+		}
+
+		f.Write(buffer, bufferSize);
+
+		f.Close();
+
+		return true;
+	}
+
+} // namespace SI
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "si_base/serialization/reflection.h"
+
+namespace SI
+{
+	class BinarySerializerImpl;
+
+	// リフレクションを元にバイナリで書き出す. 形式はbinary_archive.hを参照.
+	// 同じオブジェクトを複数のポインタで指している場合は別々に書き出される. 循環参照は不可.
+	class BinarySerializer
+	{
+	public:
+		BinarySerializer();
+		~BinarySerializer();
+		
+		void Initialize();
+		void Terminate();
+
+		template<typename T>
+		inline bool Serialize(std::vector<uint8_t>& outBuffer, const T& obj)
+		{
+			return SerializeRoot(outBuffer, &obj, GetReflectionType<T>(0));
+		}
+
+		template<typename T>
+		inline bool Serialize(const char* path, const T& obj)
+		{
+			std::vector<uint8_t> buffer;
+			if(!Serialize(buffer, obj)) return false;
+
+			return Save(path, buffer.data(), buffer.size());
+		}
+
+	private:
+		bool SerializeRoot(std::vector<uint8_t>& outBuffer, const void* buffer, const ReflectionType& reflection);
+
+	private:
+		static bool Save(const char* path, const void* buffer, size_t bufferSize);
+
+	private:
+		BinarySerializerImpl* m_impl;
+	};
+
+} // namespace SI
@@ -7,7 +7,7 @@
 #include "external/picojson/picojson.h"
 
 #include "si_base/core/print.h"
-#include "si_base/file/file.h"
+#include "si_base/file/mapped_file.h"
 #include "si_base/container/array.h"
 
 namespace SI
@@ -130,43 +130,30 @@ namespace SI
 			const char* path,
 			const ReflectionType& reflection)
 		{
-			// ファイルに出力.
-			std::string inputStr;
+			// マップしたファイルから直接パースする.
+			MappedFile mappedFile;
+			if(mappedFile.Open(path) != 0)
 			{
-				std::vector<uint8_t> buffer;
-				
-				File f;
-				int ret = f.Open(path, SI::FileAccessType::Read);
-				if(ret!=0)
-				{
-					SI_WARNING("file(%s) can't be loaded.", path);
-					return false;
-				}
-
-				int64_t size = f.GetFileSize();
-				buffer.resize(size);
-
-				f.Read(&buffer[0], size, nullptr);
+				SI_WARNING(0, "file(%s) can't be loaded.", path);
+				return false;
+			}
 
-				f.Close();
+			const char* begin = (const char*)mappedFile.GetData();
+			const char* end   = begin + mappedFile.GetSize();
 
-				// utf-8 with BOM
-				const uint8_t bom[3] = {0xEF, 0xBB, 0xBF};
-				if( 3<buffer.size() &&
-					buffer[0] == bom[0] &&
-					buffer[1] == bom[1] &&
-					buffer[2] == bom[2])
-				{
-					inputStr = (const char*)&buffer[3];
-				}
-				else
-				{
-					inputStr = (const char*)&buffer[0];
-				}
+			// utf-8 with BOM
+			const uint8_t bom[3] = {0xEF, 0xBB, 0xBF};
+			if( 3<mappedFile.GetSize() &&
+				(uint8_t)begin[0] == bom[0] &&
+				(uint8_t)begin[1] == bom[1] &&
+				(uint8_t)begin[2] == bom[2])
+			{
+				begin += 3;
 			}
 
 			picojson::value picoValue;
-			std::string err = picojson::parse(picoValue, inputStr);
+			std::string err;
+			picojson::parse(picoValue, begin, end, &err);
 			if(!err.empty())
 			{
 				SI_WARNING(0, "%s\n", err.c_str());
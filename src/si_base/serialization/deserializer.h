@@ -5,6 +5,7 @@
 #include "si_base/core/non_copyable.h"
 #include "si_base/serialization/reflection.h"
 #include "si_base/core/new_delete.h"
+#include "si_base/file/mapped_file.h"
 
 namespace SI
 {
@@ -42,6 +43,7 @@ namespace SI
 			src.m_type = nullptr;
 
 			m_allocatedBuffers = std::move(src.m_allocatedBuffers);
+			m_mappedFile = std::move(src.m_mappedFile);
 
 			return *this;
 		}
@@ -53,6 +55,8 @@ namespace SI
 
 		void Release()
 		{
+			m_mappedFile.Close();
+
 			if(m_allocatedBuffers.empty()) return;
 			
 			auto end = m_allocatedBuffers.rend();
@@ -94,10 +98,17 @@ namespace SI
 			item.m_arrayCount = arrayCount;
 		}
 
+		// オブジェクトがファイルのマッピングを直接参照している場合は、一緒に持っておく.
+		void SetMappedFile(MappedFile&& mappedFile)
+		{
+			m_mappedFile = std::move(mappedFile);
+		}
+
 	private:
 		void* m_object;
 		const SI::ReflectionType* m_type;
 		std::vector<AllocatedBuffer> m_allocatedBuffers;
+		MappedFile m_mappedFile;
 	};
 
 	class Deserializer
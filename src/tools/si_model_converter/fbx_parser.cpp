@@ -4,13 +4,13 @@
 #include <fbxsdk.h>
 #include <array>
 #include <vector>
-#include <unordered_map>
 
 #include "si_base/file/file.h"
 #include "si_base/core/print.h"
 #include "si_base/core/assert.h"
 #include "si_base/core/scope_exit.h"
 #include "si_base/misc/hash.h"
+#include "si_base/container/hash_map.h"
 
 #include "si_base/math/math.h"
 #include "si_base/renderer/model.h"
@@ -271,14 +271,12 @@ namespace
 	}
 }
 
-namespace std
+namespace
 {
-	// unordered_map用のオペレータ.
-	template<>
-	class hash<HashKeyVertex>
+	// HashMap用のハッシュ関数. GenerateHashで計算済みの値を返す.
+	struct HashKeyVertexHasher
 	{
-	public:
-		size_t operator () ( const HashKeyVertex &v ) const
+		SI::Hash64 operator()(const HashKeyVertex& v) const
 		{
 			return v.GetHash();
 		}
@@ -623,7 +621,7 @@ namespace SI
 		std::vector<uint32_t>      newIndexArray;
 		std::vector<HashKeyVertex> newVertexArray;
 		{
-			std::unordered_map<HashKeyVertex, uint32_t> hashVertexTable;
+			HashMap<HashKeyVertex, uint32_t, HashKeyVertexHasher> hashVertexTable;
 			
 			newIndexArray.reserve(indexCount);
 			newVertexArray.reserve(indexCount);
@@ -670,20 +668,19 @@ namespace SI
 
 				vertex.GenerateHash();
 
-				auto itr = hashVertexTable.find(vertex);
-				if(itr == hashVertexTable.end())
+				const uint32_t* foundIndex = hashVertexTable.Find(vertex);
+				if(!foundIndex)
 				{
 					uint32_t newIndex = (uint32_t)newVertexArray.size();
 
 					newVertexArray.push_back(vertex);
 					newIndexArray.push_back(newIndex);
-					hashVertexTable.insert( std::make_pair(vertex, newIndex) );
+					hashVertexTable.Insert(vertex, newIndex);
 				}
 				else
 				{
 					// 同じキーが見つかったので、インデックスを使いまわす.
-					uint32_t newIndex = itr->second;
-					newIndexArray.push_back(newIndex);
+					newIndexArray.push_back(*foundIndex);
 				}
 			}
 		}
@@ -0,0 +1,58 @@
+﻿#include "pch.h"
+
+#include <atomic>
+#include <vector>
+#include <si_base/concurency/job_system.h>
+
+using namespace SI;
+
+TEST(JobSystem, ParallelFor)
+{
+	JobSystem jobSystem;
+	jobSystem.Initialize(4);
+	EXPECT_EQ(4u, jobSystem.GetThreadCount());
+
+	std::vector<uint32_t> values(10000, 0);
+	jobSystem.ParallelFor((uint32_t)values.size(), 7, [&](uint32_t begin, uint32_t end)
+	{
+		for(uint32_t i=begin; i<end; ++i)
+		{
+			values[i] += i;
+		}
+	});
+
+	for(uint32_t i=0; i<(uint32_t)values.size(); ++i)
+	{
+		EXPECT_EQ(i, values[i]);
+	}
+
+	jobSystem.Terminate();
+}
+
+TEST(JobSystem, NestedWait)
+{
+	JobSystem jobSystem;
+	jobSystem.Initialize(4);
+
+	std::atomic<int> count = 0;
+	JobCounter counter;
+	for(int i=0; i<100; ++i)
+	{
+		jobSystem.Run([&]()
+		{
+			// Jobの中から更にJobを積んで待つ.
+			JobCounter childCounter;
+			for(int j=0; j<10; ++j)
+			{
+				jobSystem.Run([&](){ ++count; }, &childCounter);
+			}
+			jobSystem.Wait(childCounter);
+		}, &counter);
+	}
+
+	jobSystem.Wait(counter);
+	EXPECT_TRUE(counter.IsDone());
+	EXPECT_EQ(1000, (int)count);
+
+	jobSystem.Terminate();
+}
@@ -0,0 +1,184 @@
+﻿#include "pch.h"
+
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <si_base/container/hash_map.h>
+
+using namespace SI;
+
+namespace
+{
+	// 確保と解放の回数を数えるアロケータ.
+	class CountingAllocator : public AllocatorBase
+	{
+	public:
+		void* Allocate(size_t size) override
+		{
+			return Allocate(size, 16);
+		}
+
+		void* Allocate(size_t size, size_t alignment) override
+		{
+			++m_allocateCount;
+			return SI_ALIGNED_MALLOC(size, alignment);
+		}
+
+		void Deallocate(void* p) override
+		{
+			++m_deallocateCount;
+			SI_ALIGNED_FREE(p);
+		}
+
+		int m_allocateCount   = 0;
+		int m_deallocateCount = 0;
+	};
+
+	// 全部のキーが同じグループから探索を始めるハッシュ. 探索と削除済みの扱いの確認用.
+	struct CollideHasher
+	{
+		Hash64 operator()(const uint32_t& key) const
+		{
+			return key & 0x7f;
+		}
+	};
+
+	// 生存数を数える値. 要素の構築と破棄が対応しているかの確認用.
+	struct CountedValue
+	{
+		CountedValue()                      : m_value(0)        { ++s_aliveCount; }
+		explicit CountedValue(int value)    : m_value(value)    { ++s_aliveCount; }
+		CountedValue(const CountedValue& v) : m_value(v.m_value){ ++s_aliveCount; }
+		~CountedValue(){ --s_aliveCount; }
+
+		int m_value;
+		static int s_aliveCount;
+	};
+	int CountedValue::s_aliveCount = 0;
+}
+
+TEST(HashMap, Basic)
+{
+	HashMap<uint64_t, int> map;
+	EXPECT_TRUE(map.IsEmpty());
+	EXPECT_EQ(nullptr, map.Find(1));
+	EXPECT_FALSE(map.Erase(1));
+
+	EXPECT_TRUE(map.Insert(1, 10));
+	EXPECT_FALSE(map.Insert(1, 20)); // 上書きしない.
+	EXPECT_EQ(10, *map.Find(1));
+
+	map[2] = 30;
+	map[3];
+	EXPECT_EQ(3u, map.GetItemCount());
+	EXPECT_EQ(30, *map.Find(2));
+	EXPECT_EQ(0,  *map.Find(3));
+
+	EXPECT_TRUE(map.Erase(2));
+	EXPECT_FALSE(map.Contains(2));
+	EXPECT_EQ(2u, map.GetItemCount());
+
+	int sum = 0;
+	for(auto& item : map)
+	{
+		sum += (int)item.m_key;
+	}
+	EXPECT_EQ(4, sum);
+
+	map.Clear();
+	EXPECT_TRUE(map.IsEmpty());
+	EXPECT_EQ(nullptr, map.Find(1));
+}
+
+TEST(HashMap, CompareWithUnorderedMap)
+{
+	// ランダムな追加と削除をstd::unordered_mapと突き合わせる.
+	HashMap<uint32_t, uint32_t> map;
+	std::unordered_map<uint32_t, uint32_t> expected;
+
+	uint32_t state = 1234;
+	for(uint32_t i=0; i<200000; ++i)
+	{
+		state = state * 1664525u + 1013904223u;
+		uint32_t key = (state >> 8) % 5000;
+
+		if(((state >> 4) & 3) == 0)
+		{
+			EXPECT_EQ(expected.erase(key) != 0, map.Erase(key));
+		}
+		else
+		{
+			EXPECT_EQ(expected.emplace(key, i).second, map.Insert(key, i));
+		}
+	}
+
+	EXPECT_EQ(expected.size(), map.GetItemCount());
+	for(auto& pair : expected)
+	{
+		const uint32_t* value = map.Find(pair.first);
+		ASSERT_NE(nullptr, value);
+		EXPECT_EQ(pair.second, *value);
+	}
+
+	size_t iteratedCount = 0;
+	for(const auto& item : map)
+	{
+		EXPECT_EQ(expected[item.m_key], item.m_value);
+		++iteratedCount;
+	}
+	EXPECT_EQ(expected.size(), iteratedCount);
+}
+
+TEST(HashMap, Collision)
+{
+	// 全部同じグループから始まるので、後ろのグループへの探索と削除済みの再利用を通る.
+	HashMap<uint32_t, uint32_t, CollideHasher> map;
+	for(uint32_t i=0; i<100; ++i)
+	{
+		EXPECT_TRUE(map.Insert(i << 7, i));
+	}
+	for(uint32_t i=0; i<100; i+=2)
+	{
+		EXPECT_TRUE(map.Erase(i << 7));
+	}
+	for(uint32_t i=0; i<100; ++i)
+	{
+		EXPECT_EQ(i % 2 == 1, map.Contains(i << 7));
+	}
+	for(uint32_t i=0; i<100; i+=2)
+	{
+		EXPECT_TRUE(map.Insert(i << 7, i));
+	}
+	for(uint32_t i=0; i<100; ++i)
+	{
+		ASSERT_NE(nullptr, map.Find(i << 7));
+		EXPECT_EQ(i, *map.Find(i << 7));
+	}
+}
+
+TEST(HashMap, StringKeyAndAllocator)
+{
+	CountingAllocator allocator;
+	{
+		HashMap<std::string, CountedValue> map(&allocator);
+		for(int i=0; i<1000; ++i)
+		{
+			map.Emplace("key" + std::to_string(i), i);
+		}
+		EXPECT_EQ(1000, CountedValue::s_aliveCount);
+		EXPECT_EQ(500, map.Find("key500")->m_value);
+		EXPECT_EQ(nullptr, map.Find("key1000"));
+
+		HashMap<std::string, CountedValue> moved(std::move(map));
+		EXPECT_TRUE(map.IsEmpty());
+		EXPECT_EQ(1000u, moved.GetItemCount());
+		EXPECT_EQ(1000, CountedValue::s_aliveCount);
+
+		moved.Reserve(10000);
+		EXPECT_EQ(999, moved.Find("key999")->m_value);
+	}
+	EXPECT_EQ(0, CountedValue::s_aliveCount);
+	EXPECT_LT(0, allocator.m_allocateCount);
+	EXPECT_EQ(allocator.m_allocateCount, allocator.m_deallocateCount);
+}
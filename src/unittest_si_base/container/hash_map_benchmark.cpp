@@ -0,0 +1,89 @@
+﻿#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include <si_base/container/hash_map.h>
+
+using namespace SI;
+
+// HashMapとstd::unordered_mapの追加と検索のベンチマーク.
+// 要素数ごとに、1操作あたりの時間(ns)を出力する.
+// 既定のテスト実行では動かないように、すべてDISABLED_にしてある.
+// --gtest_also_run_disabled_testsを付けると実行される.
+
+namespace
+{
+	volatile uint64_t g_sink = 0; // 最適化で消されないように結果を書き出す先.
+
+	uint64_t SplitMix64(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	template<typename Func>
+	double Measure(size_t opCount, Func func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		return ns / (double)opCount;
+	}
+
+	void RunBenchmark(size_t itemCount)
+	{
+		std::vector<uint64_t> keys(itemCount);
+		std::vector<uint64_t> missKeys(itemCount);
+		uint64_t state = 1234;
+		for(size_t i=0; i<itemCount; ++i)
+		{
+			keys[i]     = SplitMix64(state);
+			missKeys[i] = SplitMix64(state);
+		}
+
+		// 追加した順と違う順で引く.
+		std::vector<uint64_t> lookupKeys = keys;
+		for(size_t i=itemCount-1; 0<i; --i)
+		{
+			std::swap(lookupKeys[i], lookupKeys[SplitMix64(state) % (i + 1)]);
+		}
+
+		HashMap<uint64_t, uint64_t>             map;
+		std::unordered_map<uint64_t, uint64_t>  stdMap;
+
+		double insert    = Measure(itemCount, [&](){ for(uint64_t k : keys){ map.Insert(k, k); } });
+		double stdInsert = Measure(itemCount, [&](){ for(uint64_t k : keys){ stdMap.emplace(k, k); } });
+
+		uint64_t sum = 0;
+		double hit    = Measure(itemCount, [&](){ for(uint64_t k : lookupKeys){ sum += *map.Find(k); } });
+		double stdHit = Measure(itemCount, [&](){ for(uint64_t k : lookupKeys){ sum += stdMap.find(k)->second; } });
+
+		double miss    = Measure(itemCount, [&](){ for(uint64_t k : missKeys){ sum += map.Contains(k)? 1 : 0; } });
+		double stdMiss = Measure(itemCount, [&](){ for(uint64_t k : missKeys){ sum += (stdMap.find(k) != stdMap.end())? 1 : 0; } });
+		g_sink = sum;
+
+		printf("[%-6s] %9zu items  insert %7.2f / %7.2f ns  hit %7.2f / %7.2f ns  miss %7.2f / %7.2f ns (HashMap / std::unordered_map)\n",
+			kSiHashSimdName, itemCount, insert, stdInsert, hit, stdHit, miss, stdMiss);
+	}
+}
+
+TEST(HashMapBenchmark, DISABLED_InsertAndFind)
+{
+	static const size_t kItemCounts[] = { 1000, 10000, 100000, 1000000 };
+	for(size_t itemCount : kItemCounts)
+	{
+		RunBenchmark(itemCount);
+	}
+}
+
+TEST(HashMapBenchmark, DISABLED_InsertAndFind10M)
+{
+	RunBenchmark(10000000);
+}
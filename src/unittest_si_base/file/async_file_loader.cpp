@@ -0,0 +1,100 @@
+﻿#include "pch.h"
+
+#include <vector>
+#include <si_base/file/file.h>
+#include <si_base/file/async_file_loader.h>
+#include <si_base/concurency/job_system.h>
+
+namespace
+{
+	const uint32_t kFileCount = 8;
+
+	template<size_t N>
+	void GetTestFilePath(char (&outPath)[N], uint32_t index)
+	{
+		sprintf_s(outPath, "asset\\async_file_loader_test%u.bin", index);
+	}
+
+	void WriteTestFiles()
+	{
+		for(uint32_t i=0; i<kFileCount; ++i)
+		{
+			std::vector<uint8_t> data((i + 1) * 10000);
+			for(size_t b=0; b<data.size(); ++b){ data[b] = (uint8_t)(b + i); }
+
+			char path[64];
+			GetTestFilePath(path, i);
+
+			SI::File f;
+			ASSERT_EQ(0, f.Open(path, SI::FileAccessType::Write));
+			f.Write(data.data(), (int64_t)data.size());
+			f.Close();
+		}
+	}
+
+	// processで全byteの和を取る.
+	void LoadAndSum(SI::AsyncFileLoader& loader)
+	{
+		std::vector<uint64_t> sums(kFileCount, 0);
+		std::vector<SI::AsyncFileRequest> requests;
+		for(uint32_t i=0; i<kFileCount; ++i)
+		{
+			char path[64];
+			GetTestFilePath(path, i);
+
+			uint64_t* sum = &sums[i];
+			requests.push_back(loader.Load(path, [sum](SI::MappedFile& file)
+			{
+				for(size_t b=0; b<file.GetSize(); ++b){ *sum += file.GetData()[b]; }
+				return 0;
+			}));
+		}
+
+		SI::AsyncFileRequest missing = loader.Load("asset\\async_file_loader_missing.bin");
+
+		for(uint32_t i=0; i<kFileCount; ++i)
+		{
+			requests[i].Wait();
+			ASSERT_EQ(0, requests[i].GetResult());
+			EXPECT_EQ((i + 1) * 10000, requests[i].GetSize());
+
+			uint64_t expected = 0;
+			for(size_t b=0; b<requests[i].GetSize(); ++b){ expected += (uint8_t)(b + i); }
+			EXPECT_EQ(expected, sums[i]);
+		}
+
+		missing.Wait();
+		EXPECT_NE(0, missing.GetResult());
+	}
+}
+
+TEST(AsyncFileLoader, Load)
+{
+	SI::FileSystem::SetCurrentDir(SI_PROJECT_DIR);
+	WriteTestFiles();
+
+	SI::AsyncFileLoader loader;
+	loader.Initialize(2);
+	LoadAndSum(loader);
+	loader.Terminate();
+}
+
+TEST(AsyncFileLoader, ProcessOnJobSystem)
+{
+	SI::FileSystem::SetCurrentDir(SI_PROJECT_DIR);
+	WriteTestFiles();
+
+	// ワーカーが居なくても、待っている側がprocessを実行する.
+	for(uint32_t threadCount : {1u, 4u})
+	{
+		SI::JobSystem jobSystem;
+		jobSystem.Initialize(threadCount);
+
+		SI::AsyncFileLoader loader;
+		loader.Initialize(2, &jobSystem);
+		LoadAndSum(loader);
+		loader.Terminate();
+
+		jobSystem.Terminate();
+	}
+}
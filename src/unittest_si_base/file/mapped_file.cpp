@@ -0,0 +1,58 @@
+﻿#include "pch.h"
+
+#include <si_base/file/file.h>
+#include <si_base/file/mapped_file.h>
+
+TEST(MappedFile, Open)
+{
+	SI::FileSystem::SetCurrentDir(SI_PROJECT_DIR);
+
+	const char* path = "asset\\mapped_file_test.bin";
+	uint8_t src[256];
+	for(uint32_t i=0; i<256; ++i){ src[i] = (uint8_t)i; }
+
+	{
+		SI::File f;
+		ASSERT_EQ(0, f.Open(path, SI::FileAccessType::Write));
+		f.Write(src, sizeof(src));
+		f.Close();
+	}
+
+	SI::MappedFile readOnly;
+	ASSERT_EQ(0, readOnly.Open(path));
+	ASSERT_EQ(sizeof(src), readOnly.GetSize());
+	EXPECT_EQ(0, memcmp(src, readOnly.GetData(), sizeof(src)));
+	EXPECT_EQ(nullptr, readOnly.GetWritableData());
+
+	// コピーオンライトで書き換えても、ファイルや他のマッピングには影響しない.
+	SI::MappedFile copyOnWrite;
+	ASSERT_EQ(0, copyOnWrite.Open(path, SI::MappedFileAccess::CopyOnWrite));
+	ASSERT_NE(nullptr, copyOnWrite.GetWritableData());
+	copyOnWrite.GetWritableData()[0] = 0xff;
+	EXPECT_EQ(0, readOnly.GetData()[0]);
+
+	SI::MappedFile moved(std::move(copyOnWrite));
+	EXPECT_FALSE(copyOnWrite.IsValid());
+	EXPECT_EQ(0xff, moved.GetData()[0]);
+	moved.Close();
+
+	SI::MappedFile reopened;
+	ASSERT_EQ(0, reopened.Open(path));
+	EXPECT_EQ(0, reopened.GetData()[0]);
+
+	SI::MappedFile missing;
+	EXPECT_NE(0, missing.Open("asset\\mapped_file_missing.bin"));
+	EXPECT_FALSE(missing.IsValid());
+
+	// 空のファイルは参照するものが無いので開けない.
+	const char* emptyPath = "asset\\mapped_file_empty.bin";
+	{
+		SI::File f;
+		ASSERT_EQ(0, f.Open(emptyPath, SI::FileAccessType::Write));
+		f.Close();
+	}
+	SI::MappedFile empty;
+	EXPECT_NE(0, empty.Open(emptyPath));
+	EXPECT_FALSE(empty.IsValid());
+	EXPECT_EQ(0u, empty.GetSize());
+}
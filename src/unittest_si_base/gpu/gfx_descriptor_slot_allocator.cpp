@@ -0,0 +1,197 @@
+﻿#include "pch.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <si_base/gpu/gfx_descriptor_slot_allocator.h>
+
+using namespace SI;
+
+TEST(GfxDescriptorSlotAllocator, AllocateAligned)
+{
+	GfxDescriptorSlotAllocator allocator;
+	allocator.Initialize(64);
+
+	// 2のべき乗に切り上げて、その大きさに整列した位置から取れる.
+	uint32_t a = allocator.Allocate(3);
+	uint32_t b = allocator.Allocate(8);
+	uint32_t c = allocator.Allocate(16);
+	EXPECT_NE(kInvalidHandle, a);
+	EXPECT_NE(kInvalidHandle, b);
+	EXPECT_NE(kInvalidHandle, c);
+	EXPECT_EQ(0u, a % 4);
+	EXPECT_EQ(0u, b % 8);
+	EXPECT_EQ(0u, c % 16);
+	EXPECT_EQ(4u + 8u + 16u, allocator.GetAllocatedSlotCount());
+
+	EXPECT_EQ(kInvalidHandle, allocator.Allocate(64));
+}
+
+TEST(GfxDescriptorSlotAllocator, DeferredFreeAndCoalesce)
+{
+	GfxDescriptorSlotAllocator allocator;
+	allocator.Initialize(32);
+
+	std::vector<uint32_t> slots;
+	for(uint32_t i=0; i<8; ++i)
+	{
+		slots.push_back(allocator.Allocate(4));
+	}
+	EXPECT_EQ(kInvalidHandle, allocator.Allocate(4));
+
+	for(uint32_t i=0; i<slots.size(); ++i)
+	{
+		allocator.Deallocate(slots[i], 10 + i / 4);
+	}
+
+	// フェンスが終わるまでは戻らない.
+	allocator.Retire(9);
+	EXPECT_EQ(8u, allocator.GetPendingCount());
+	EXPECT_EQ(kInvalidHandle, allocator.Allocate(4));
+
+	allocator.Retire(10);
+	EXPECT_EQ(4u, allocator.GetPendingCount());
+	EXPECT_EQ(16u, allocator.GetAllocatedSlotCount());
+
+	// 全部戻ればひとつのブロックにまとまる.
+	allocator.Retire(11);
+	EXPECT_EQ(0u, allocator.GetPendingCount());
+	EXPECT_EQ(0u, allocator.GetAllocatedSlotCount());
+	EXPECT_EQ(0u, allocator.Allocate(32));
+}
+
+TEST(GfxDescriptorSlotAllocator, FlipFenceValue)
+{
+	GfxDescriptorSlotAllocator allocator;
+	allocator.Initialize(16);
+
+	uint32_t a = allocator.Allocate(8);
+	uint32_t b = allocator.Allocate(8);
+
+	// Deallocate(slot)はその時点でFlipに渡したフェンス値で開放される.
+	allocator.Flip(1, 0);
+	allocator.Deallocate(a);
+	allocator.Flip(2, 0);
+	allocator.Deallocate(b);
+	EXPECT_EQ(2u, allocator.GetPendingCount());
+
+	allocator.Flip(3, 1);
+	EXPECT_EQ(1u, allocator.GetPendingCount());
+	EXPECT_EQ(8u, allocator.GetAllocatedSlotCount());
+
+	allocator.Flip(3, 2);
+	EXPECT_EQ(0u, allocator.GetPendingCount());
+	EXPECT_EQ(0u, allocator.Allocate(16));
+}
+
+TEST(GfxDescriptorSlotAllocator, InvalidFree)
+{
+	GfxDescriptorSlotAllocator allocator;
+	allocator.Initialize(16);
+
+	uint32_t a = allocator.Allocate(4);
+	uint32_t b = allocator.Allocate(4);
+
+	// 範囲外, ブロックの途中, 確保していないスロットは積まれない.
+	allocator.Deallocate(16, 1);
+	allocator.Deallocate(a + 1, 1);
+	allocator.Deallocate(8, 1);
+	EXPECT_EQ(0u, allocator.GetPendingCount());
+
+	// Retire前の二重開放.
+	allocator.Deallocate(a, 1);
+	allocator.Deallocate(a, 1);
+	EXPECT_EQ(1u, allocator.GetPendingCount());
+
+	// Retire後の二重開放.
+	allocator.Retire(1);
+	allocator.Deallocate(a, 2);
+	EXPECT_EQ(0u, allocator.GetPendingCount());
+	EXPECT_EQ(4u, allocator.GetAllocatedSlotCount());
+
+	allocator.Deallocate(b, 2);
+	allocator.Retire(2);
+	EXPECT_EQ(0u, allocator.GetAllocatedSlotCount());
+	EXPECT_EQ(0u, allocator.Allocate(16));
+}
+
+TEST(GfxDescriptorSlotAllocator, NonPowerOfTwo)
+{
+	GfxDescriptorSlotAllocator allocator;
+	allocator.Initialize(100);
+
+	// 範囲外のスロットは返さない.
+	std::vector<uint32_t> slots;
+	for(;;)
+	{
+		uint32_t slot = allocator.Allocate(2);
+		if(slot == kInvalidHandle) break;
+		EXPECT_LT(slot + 1, 100u);
+		slots.push_back(slot);
+	}
+	EXPECT_EQ(50u, slots.size());
+
+	for(uint32_t slot : slots)
+	{
+		allocator.Deallocate(slot, 0);
+	}
+	allocator.Retire(0);
+	EXPECT_EQ(0u, allocator.Allocate(64));
+	EXPECT_EQ(64u, allocator.Allocate(32));
+	EXPECT_EQ(96u, allocator.Allocate(4));
+}
+
+TEST(GfxDescriptorSlotAllocator, ThreadCache)
+{
+	static const uint32_t kSlotCount  = 1024;
+	static const uint32_t kThreadCount = 4;
+
+	GfxDescriptorSlotAllocator allocator;
+	allocator.Initialize(kSlotCount);
+
+	std::vector<uint32_t> results[kThreadCount];
+	std::vector<std::thread> threads;
+	for(uint32_t t=0; t<kThreadCount; ++t)
+	{
+		threads.emplace_back([&allocator, &results, t]()
+		{
+			for(uint32_t i=0; i<kSlotCount / kThreadCount; ++i)
+			{
+				results[t].push_back(allocator.Allocate(1));
+			}
+		});
+	}
+	for(std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// 全スレッド合わせて重複なく使い切れる.
+	std::vector<uint32_t> all;
+	for(const std::vector<uint32_t>& r : results)
+	{
+		all.insert(all.end(), r.begin(), r.end());
+	}
+	std::sort(all.begin(), all.end());
+	for(uint32_t i=0; i<kSlotCount; ++i)
+	{
+		EXPECT_EQ(i, all[i]);
+	}
+	EXPECT_EQ(kSlotCount, allocator.GetAllocatedSlotCount());
+
+	// 他のスレッドのキャッシュに残った分も回収して大きいブロックを取れる.
+	for(uint32_t i=0; i<kSlotCount; i+=2)
+	{
+		allocator.Deallocate(all[i], 1);
+	}
+	allocator.Retire(1);
+	uint32_t slot = allocator.Allocate(1);
+	EXPECT_NE(kInvalidHandle, slot);
+	allocator.Deallocate(slot, 2);
+	for(uint32_t i=1; i<kSlotCount; i+=2)
+	{
+		allocator.Deallocate(all[i], 2);
+	}
+	allocator.Retire(2);
+	EXPECT_EQ(0u, allocator.Allocate(kSlotCount));
+}
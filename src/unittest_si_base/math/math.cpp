@@ -1,6 +1,9 @@
 ﻿#include "pch.h"
 
+#include <vector>
 #include <si_base/math/math.h>
+#include <si_base/math/math_batch.h>
+#include <si_base/math/frustum.h>
 
 using namespace SI;
 
@@ -84,3 +87,188 @@ TEST(Math, TestFloor)
 		EXPECT_EQ(floorValue.W().AsFloat(), floorValueW);
 	}
 }
+
+
+TEST(Math, TestMultiply)
+{
+	float a[16];
+	float b[16];
+	for(int i=0; i<16; ++i)
+	{
+		a[i] = (float)(i + 1) * 0.5f;
+		b[i] = (float)(16 - i) * 0.25f - 1.0f;
+	}
+
+	{
+		SI::Vfloat4x4 m = SI::Math::Multiply(SI::Vfloat4x4(a), SI::Vfloat4x4(b));
+		for(uint32_t r=0; r<4; ++r)
+		{
+			for(uint32_t c=0; c<4; ++c)
+			{
+				float expected = 0.0f;
+				for(uint32_t k=0; k<4; ++k){ expected += a[r*4+k] * b[k*4+c]; }
+				EXPECT_FLOAT_EQ(m.Get(r, c).AsFloat(), expected);
+			}
+		}
+	}
+
+	{
+		SI::Vfloat4 v(1.0f, -2.0f, 3.0f, 0.5f);
+		SI::Vfloat4 result = SI::Math::Multiply(v, SI::Vfloat4x4(b));
+		for(uint32_t c=0; c<4; ++c)
+		{
+			float expected = 1.0f*b[c] - 2.0f*b[4+c] + 3.0f*b[8+c] + 0.5f*b[12+c];
+			EXPECT_FLOAT_EQ(result[c].AsFloat(), expected);
+		}
+
+		EXPECT_FLOAT_EQ(SI::Math::Dot(v, v).AsFloat(), 1.0f + 4.0f + 9.0f + 0.25f);
+		EXPECT_EQ(SI::Math::Abs(-v), SI::Vfloat4(1.0f, 2.0f, 3.0f, 0.5f));
+	}
+}
+
+
+TEST(Math, TestBatch)
+{
+	static const size_t kCount = 37; // 8の倍数にならない数で端数の処理も確認する.
+
+	SI::Vfloat4x4 m = SI::Vfloat4x4(SI::Vfloat4x3::RotateY(0.7f) * SI::Vfloat4x3::Translate(SI::Vfloat3(1.0f, -2.0f, 3.0f)));
+
+	std::vector<SI::Vfloat3> points(kCount);
+	for(size_t i=0; i<kCount; ++i)
+	{
+		points[i] = SI::Vfloat3((float)i, (float)(i % 5) - 2.0f, 10.0f - (float)i * 0.5f);
+	}
+
+	// 余りの要素は0のまま.
+	std::vector<SI::Vfloat3x8Soa> soa(SI::GetVfloat3x8SoaCount(kCount));
+	for(size_t i=0; i<kCount; ++i)
+	{
+		soa[i / SI::Vfloat3x8Soa::kWidth].Set((uint32_t)(i % SI::Vfloat3x8Soa::kWidth), points[i]);
+	}
+
+	auto getSoa = [](const std::vector<SI::Vfloat3x8Soa>& v, size_t i)
+	{
+		return v[i / SI::Vfloat3x8Soa::kWidth].Get((uint32_t)(i % SI::Vfloat3x8Soa::kWidth));
+	};
+
+	auto expectNear = [](SI::Vfloat3_arg actual, SI::Vfloat3_arg expected, float error)
+	{
+		EXPECT_NEAR(actual.Xf(), expected.Xf(), error);
+		EXPECT_NEAR(actual.Yf(), expected.Yf(), error);
+		EXPECT_NEAR(actual.Zf(), expected.Zf(), error);
+	};
+
+	{
+		std::vector<SI::Vfloat3> transformed(kCount);
+		SI::Math::TransformPoints(transformed.data(), points.data(), kCount, m);
+
+		std::vector<SI::Vfloat3x8Soa> soaTransformed(soa.size());
+		SI::Math::TransformPoints(soaTransformed.data(), soa.data(), soa.size(), m);
+
+		for(size_t i=0; i<kCount; ++i)
+		{
+			SI::Vfloat3 expected = SI::Math::Multiply(points[i], m);
+			expectNear(transformed[i], expected, 1e-4f);
+			expectNear(getSoa(soaTransformed, i), expected, 1e-4f);
+		}
+	}
+
+	{
+		std::vector<SI::Vfloat3> transformed(kCount);
+		SI::Math::TransformNormals(transformed.data(), points.data(), kCount, m);
+
+		std::vector<SI::Vfloat3x8Soa> soaTransformed(soa.size());
+		SI::Math::TransformNormals(soaTransformed.data(), soa.data(), soa.size(), m);
+
+		for(size_t i=0; i<kCount; ++i)
+		{
+			SI::Vfloat3 expected = SI::Math::Multiply(SI::Vfloat4(points[i], 0.0f), m).XYZ();
+			expectNear(transformed[i], expected, 1e-4f);
+			expectNear(getSoa(soaTransformed, i), expected, 1e-4f);
+		}
+	}
+
+	{
+		std::vector<SI::Vfloat3> normalized = points;
+		SI::Math::Normalize(normalized.data(), kCount);
+
+		std::vector<SI::Vfloat3x8Soa> soaNormalized = soa;
+		SI::Math::Normalize(soaNormalized.data(), soaNormalized.size());
+
+		for(size_t i=0; i<kCount; ++i)
+		{
+			SI::Vfloat3 expected = SI::Math::Normalize(points[i]);
+			expectNear(normalized[i], expected, 1e-5f);
+			expectNear(getSoa(soaNormalized, i), expected, 1e-5f);
+		}
+	}
+
+	{
+		SI::Vfloat3 soaMin, soaMax, aosMin, aosMax;
+		SI::Math::ComputeAabb(soaMin, soaMax, soa.data(), kCount);
+		SI::Math::ComputeAabb(aosMin, aosMax, points.data(), kCount);
+		EXPECT_EQ(soaMin, SI::Vfloat3(0.0f, -2.0f, -8.0f));
+		EXPECT_EQ(soaMax, SI::Vfloat3(36.0f, 2.0f, 10.0f));
+		EXPECT_EQ(aosMin, soaMin);
+		EXPECT_EQ(aosMax, soaMax);
+	}
+
+	{
+		std::vector<SI::Vfloat4x4> m0(kCount);
+		std::vector<SI::Vfloat4x4> m1(kCount);
+		for(size_t i=0; i<kCount; ++i)
+		{
+			m0[i] = SI::Vfloat4x4(SI::Vfloat4x3::RotateX((float)i * 0.1f) * SI::Vfloat4x3::Translate(points[i]));
+			m1[i] = SI::Vfloat4x4(SI::Vfloat4x3::RotateZ((float)i * -0.2f) * SI::Vfloat4x3::Scale(SI::Vfloat3(1.0f + (float)i * 0.25f)));
+		}
+
+		std::vector<SI::Vfloat4x4> shared(kCount);
+		std::vector<SI::Vfloat4x4> pairwise(kCount);
+		SI::Math::Multiply(shared.data(), m0.data(), m, kCount);
+		SI::Math::Multiply(pairwise.data(), m0.data(), m1.data(), kCount);
+
+		for(size_t i=0; i<kCount; ++i)
+		{
+			SI::Vfloat4x4 expectedShared   = SI::Math::Multiply(m0[i], m);
+			SI::Vfloat4x4 expectedPairwise = SI::Math::Multiply(m0[i], m1[i]);
+			for(uint32_t r=0; r<4; ++r)
+			{
+				for(uint32_t c=0; c<4; ++c)
+				{
+					EXPECT_FLOAT_EQ(shared[i].Get(r, c).AsFloat(),   expectedShared.Get(r, c).AsFloat());
+					EXPECT_FLOAT_EQ(pairwise[i].Get(r, c).AsFloat(), expectedPairwise.Get(r, c).AsFloat());
+				}
+			}
+		}
+	}
+}
+
+
+TEST(Math, TestFrustum)
+{
+	// z+方向を見ている. 幅と高さはnear面でのもの.
+	SI::Frustum frustum;
+	frustum.Set(SI::Math::Perspective(2.0f, 2.0f, 1.0f, 100.0f));
+
+	SI::Aabb aabb;
+	aabb.SetCenterExtend(SI::Vfloat3(0.0f, 0.0f, 10.0f), SI::Vfloat3(1.0f));
+	EXPECT_TRUE(frustum.IsVisible(aabb));
+
+	aabb.SetCenterExtend(SI::Vfloat3(0.0f, 0.0f, -10.0f), SI::Vfloat3(1.0f)); // 後ろ.
+	EXPECT_FALSE(frustum.IsVisible(aabb));
+
+	aabb.SetCenterExtend(SI::Vfloat3(30.0f, 0.0f, 10.0f), SI::Vfloat3(1.0f)); // 右の外.
+	EXPECT_FALSE(frustum.IsVisible(aabb));
+
+	aabb.SetCenterExtend(SI::Vfloat3(0.0f, 0.0f, 200.0f), SI::Vfloat3(1.0f)); // farより奥.
+	EXPECT_FALSE(frustum.IsVisible(aabb));
+
+	aabb.SetCenterExtend(SI::Vfloat3(11.5f, 0.0f, 10.0f), SI::Vfloat3(2.0f)); // 右の面にかかっている.
+	EXPECT_TRUE(frustum.IsVisible(aabb));
+
+	// 平行移動で外に出したものは見えない.
+	aabb.SetCenterExtend(SI::Vfloat3(0.0f, 0.0f, 10.0f), SI::Vfloat3(1.0f));
+	SI::Aabb moved = aabb.Transform(SI::Vfloat4x4(SI::Vfloat4x3::Translate(SI::Vfloat3(0.0f, -50.0f, 0.0f))));
+	EXPECT_FALSE(frustum.IsVisible(moved));
+	EXPECT_EQ(moved.GetMin(), SI::Vfloat3(-1.0f, -51.0f, 9.0f));
+}
@@ -0,0 +1,191 @@
+﻿#include "pch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <si_base/math/math.h>
+#include <si_base/math/math_batch.h>
+
+using namespace SI;
+
+// 数学ライブラリの演算ごとのマイクロベンチマーク.
+// 選ばれているSIMDバックエンドと、1演算あたりの時間(ns)を出力する.
+// 通常のテストでは実行しないようにDISABLED_にしてある.
+// --gtest_also_run_disabled_testsを付けると実行される.
+
+namespace
+{
+	static const uint32_t kBenchmarkLoop  = 1 << 16;
+	static const uint32_t kBenchmarkCount = 64; // 入力の種類. L1に収まる程度.
+
+	volatile float g_sink = 0.0f; // 最適化で消されないように結果を書き出す先.
+
+	template<typename Func>
+	void RunBenchmark(const char* name, Func func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		float sum = 0.0f;
+		for(uint32_t i=0; i<kBenchmarkLoop; ++i)
+		{
+			sum += func(i % kBenchmarkCount);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		g_sink = sum;
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		printf("[%-8s] %-28s %8.2f ns/op\n", kSiMathSimdName, name, ns / kBenchmarkLoop);
+	}
+
+	float RandomFloat(uint32_t& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (float)(state >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+	}
+
+	struct BenchmarkData
+	{
+		BenchmarkData()
+		{
+			uint32_t state = 1234;
+			for(uint32_t i=0; i<kBenchmarkCount; ++i)
+			{
+				float v[16];
+				for(float& f : v){ f = RandomFloat(state); }
+
+				m_v3[i]   = Vfloat3(v[0], v[1], v[2]);
+				m_v4[i]   = Vfloat4(v[3], v[4], v[5], v[6]);
+				m_q[i]    = Math::Normalize(Vquat(v[7], v[8], v[9], v[10]));
+				m_m4x4[i] = Vfloat4x4(v);
+				m_m4x3[i] = Vfloat4x3::RotateY(v[11]) * Vfloat4x3::Translate(Vfloat3(v[12], v[13], v[14]));
+			}
+		}
+
+		Vfloat3   m_v3[kBenchmarkCount];
+		Vfloat4   m_v4[kBenchmarkCount];
+		Vquat     m_q[kBenchmarkCount];
+		Vfloat4x4 m_m4x4[kBenchmarkCount];
+		Vfloat4x3 m_m4x3[kBenchmarkCount];
+	};
+
+	const BenchmarkData& GetBenchmarkData()
+	{
+		static BenchmarkData s_data;
+		return s_data;
+	}
+
+	uint32_t Next(uint32_t i)
+	{
+		return (i + 1) % kBenchmarkCount;
+	}
+}
+
+TEST(MathBenchmark, DISABLED_Vfloat3)
+{
+	const BenchmarkData& d = GetBenchmarkData();
+
+	RunBenchmark("Vfloat3 Add",       [&](uint32_t i){ return (d.m_v3[i] + d.m_v3[Next(i)]).X().AsFloat(); });
+	RunBenchmark("Vfloat3 Mul",       [&](uint32_t i){ return (d.m_v3[i] * d.m_v3[Next(i)]).Y().AsFloat(); });
+	RunBenchmark("Vfloat3 Dot",       [&](uint32_t i){ return Math::Dot(d.m_v3[i], d.m_v3[Next(i)]).AsFloat(); });
+	RunBenchmark("Vfloat3 Cross",     [&](uint32_t i){ return Math::Cross(d.m_v3[i], d.m_v3[Next(i)]).Z().AsFloat(); });
+	RunBenchmark("Vfloat3 Normalize", [&](uint32_t i){ return Math::Normalize(d.m_v3[i]).X().AsFloat(); });
+}
+
+TEST(MathBenchmark, DISABLED_Vfloat4)
+{
+	const BenchmarkData& d = GetBenchmarkData();
+
+	RunBenchmark("Vfloat4 Add",       [&](uint32_t i){ return (d.m_v4[i] + d.m_v4[Next(i)]).X().AsFloat(); });
+	RunBenchmark("Vfloat4 Mul",       [&](uint32_t i){ return (d.m_v4[i] * d.m_v4[Next(i)]).W().AsFloat(); });
+	RunBenchmark("Vfloat4 Dot",       [&](uint32_t i){ return Math::Dot(d.m_v4[i], d.m_v4[Next(i)]).AsFloat(); });
+	RunBenchmark("Vfloat4 Normalize", [&](uint32_t i){ return Math::Normalize(d.m_v4[i]).X().AsFloat(); });
+	RunBenchmark("Vfloat4 Multiply",  [&](uint32_t i){ return d.m_v4[i].Multiply(d.m_m4x4[Next(i)]).Z().AsFloat(); });
+}
+
+TEST(MathBenchmark, DISABLED_Matrix)
+{
+	const BenchmarkData& d = GetBenchmarkData();
+
+	RunBenchmark("Vfloat4x4 Multiply",  [&](uint32_t i){ return Math::Multiply(d.m_m4x4[i], d.m_m4x4[Next(i)]).Get(3, 3).AsFloat(); });
+	RunBenchmark("Vfloat4x4 Transpose", [&](uint32_t i){ return Math::Transpose(d.m_m4x4[i]).Get(1, 2).AsFloat(); });
+	RunBenchmark("Vfloat4x3 Multiply",  [&](uint32_t i){ return Math::Multiply(d.m_m4x3[i], d.m_m4x3[Next(i)]).Get(3, 0).AsFloat(); });
+	RunBenchmark("Vfloat3 * Vfloat4x3", [&](uint32_t i){ return Math::Multiply(d.m_v3[i], d.m_m4x3[Next(i)]).X().AsFloat(); });
+	RunBenchmark("Vfloat4 * Vfloat4x3", [&](uint32_t i){ return Math::Multiply(d.m_v4[i], d.m_m4x3[Next(i)]).W().AsFloat(); });
+}
+
+TEST(MathBenchmark, DISABLED_Vquat)
+{
+	const BenchmarkData& d = GetBenchmarkData();
+
+	RunBenchmark("Vquat Multiply",   [&](uint32_t i){ return Math::Multiply(d.m_q[i], d.m_q[Next(i)]).X().AsFloat(); });
+	RunBenchmark("Vquat Rotate",     [&](uint32_t i){ return Math::Multiply(d.m_v3[i], d.m_q[Next(i)]).Y().AsFloat(); });
+	RunBenchmark("Vquat Normalize",  [&](uint32_t i){ return Math::Normalize(d.m_q[i]).W().AsFloat(); });
+}
+
+TEST(MathBenchmark, DISABLED_Batch)
+{
+	// 配列の一括処理と、1要素ずつの関数をループで回した場合の比較. 1要素あたりの時間を出す.
+	static const size_t kPointCount  = 4096;
+	static const size_t kMatrixCount = 1024;
+	static const uint32_t kLoop      = 64;
+
+	const BenchmarkData& d = GetBenchmarkData();
+	Vfloat4x4 m = d.m_m4x4[0];
+
+	std::vector<Vfloat3> points(kPointCount);
+	std::vector<Vfloat3> out(kPointCount);
+	std::vector<Vfloat3x8Soa> soa(GetVfloat3x8SoaCount(kPointCount));
+	for(size_t i=0; i<kPointCount; ++i)
+	{
+		points[i] = d.m_v3[i % kBenchmarkCount];
+	}
+	for(size_t b=0; b<soa.size(); ++b)
+	{
+		soa[b].Load(&points[b * Vfloat3x8Soa::kWidth]);
+	}
+
+	std::vector<Vfloat4x4> matrices(kMatrixCount);
+	std::vector<Vfloat4x4> outMatrices(kMatrixCount);
+	for(size_t i=0; i<kMatrixCount; ++i)
+	{
+		matrices[i] = d.m_m4x4[i % kBenchmarkCount];
+	}
+
+	auto measure = [](const char* name, size_t elementCount, auto func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for(uint32_t l=0; l<kLoop; ++l)
+		{
+			func();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		printf("[%-8s] %-28s %8.2f ns/element\n", kSiMathSimdName, name, ns / (double)(kLoop * elementCount));
+	};
+
+	measure("TransformPoints AoS loop", kPointCount, [&]()
+	{
+		for(size_t i=0; i<kPointCount; ++i){ out[i] = Math::Multiply(points[i], m); }
+	});
+	measure("TransformPoints Vfloat3[]", kPointCount, [&](){ Math::TransformPoints(out.data(), points.data(), kPointCount, m); });
+	measure("TransformPoints Soa",       kPointCount, [&](){ Math::TransformPoints(soa.data(), soa.data(), soa.size(), m); });
+
+	measure("Normalize AoS loop", kPointCount, [&]()
+	{
+		for(size_t i=0; i<kPointCount; ++i){ out[i] = Math::Normalize(points[i]); }
+	});
+	measure("Normalize Vfloat3[]", kPointCount, [&](){ out = points; Math::Normalize(out.data(), kPointCount); });
+	measure("Normalize Soa",       kPointCount, [&](){ Math::Normalize(soa.data(), soa.size()); });
+
+	Vfloat3 aabbMin, aabbMax;
+	measure("ComputeAabb Vfloat3[]", kPointCount, [&](){ Math::ComputeAabb(aabbMin, aabbMax, points.data(), kPointCount); });
+	measure("ComputeAabb Soa",       kPointCount, [&](){ Math::ComputeAabb(aabbMin, aabbMax, soa.data(), kPointCount); });
+
+	measure("Multiply4x4 AoS loop", kMatrixCount, [&]()
+	{
+		for(size_t i=0; i<kMatrixCount; ++i){ outMatrices[i] = Math::Multiply(matrices[i], m); }
+	});
+	measure("Multiply4x4 array", kMatrixCount, [&](){ Math::Multiply(outMatrices.data(), matrices.data(), m, kMatrixCount); });
+
+	g_sink = out[kPointCount-1].Xf() + soa[0].Get(0).Xf() + aabbMin.Xf() + aabbMax.Xf() + outMatrices[0].Get(0, 0).AsFloat();
+}
@@ -0,0 +1,84 @@
+﻿#include "pch.h"
+
+#include <si_base/math/math.h>
+#include <si_base/math/sampling.h>
+
+using namespace SI;
+
+TEST(Sampling, Pcg32)
+{
+	// pcg32のリファレンス実装(seed=42, stream=54)と同じ系列になる.
+	Pcg32 random(42u, 54u);
+	EXPECT_EQ(random.NextUint32(), 0xa15c02b7u);
+	EXPECT_EQ(random.NextUint32(), 0x7b47f409u);
+	EXPECT_EQ(random.NextUint32(), 0xba1d3330u);
+	EXPECT_EQ(random.NextUint32(), 0x83d2f293u);
+
+	Xoshiro128Plus xoshiro(1);
+	for(int i=0; i<1000; ++i)
+	{
+		float f = xoshiro.NextFloat();
+		EXPECT_TRUE(0.0f <= f && f < 1.0f);
+	}
+}
+
+TEST(Sampling, Sobol02Stratification)
+{
+	// 先頭の16点は4x4, 2x8, 8x2, 1x16, 16x1のどの層にも1点ずつ入る.
+	for(uint32_t seed=0; seed<4; ++seed)
+	{
+		for(uint32_t log2X=0; log2X<=4; ++log2X)
+		{
+			uint32_t strataX = 1u << log2X;
+			uint32_t strataY = 16u >> log2X;
+			uint32_t counts[16] = {};
+
+			for(uint32_t i=0; i<16; ++i)
+			{
+				float u, v;
+				Sampling::Sobol02(i, seed, u, v);
+				uint32_t x = (uint32_t)(u * (float)strataX);
+				uint32_t y = (uint32_t)(v * (float)strataY);
+				++counts[y * strataX + x];
+			}
+
+			for(uint32_t c : counts)
+			{
+				EXPECT_EQ(c, 1u);
+			}
+		}
+	}
+}
+
+TEST(Sampling, SobolSamplerDeterministic)
+{
+	Sampling::SobolSampler a;
+	Sampling::SobolSampler b;
+	a.Start(123, 7);
+	b.Start(123, 7);
+
+	for(int i=0; i<8; ++i)
+	{
+		EXPECT_EQ(a.Get1D(), b.Get1D());
+	}
+	EXPECT_EQ(a.GetDimension(), 8u);
+}
+
+TEST(Sampling, Mapping)
+{
+	Pcg32 random;
+	for(int i=0; i<1000; ++i)
+	{
+		float u = random.NextFloat();
+		float v = random.NextFloat();
+		float w = random.NextFloat();
+
+		float sphereLength = Sampling::UniformSampleSphere(u, v).Length().AsFloat();
+		EXPECT_NEAR(sphereLength, 1.0f, 1.0e-5f);
+		EXPECT_LE(Sampling::UniformSampleBall(u, v, w).Length().AsFloat(), 1.0f + 1.0e-5f);
+
+		Vfloat3 disk = Sampling::ConcentricSampleDisk(u, v);
+		EXPECT_LE(disk.Length().AsFloat(), 1.0f + 1.0e-5f);
+		EXPECT_EQ(disk.Z().AsFloat(), 0.0f);
+	}
+}
@@ -0,0 +1,184 @@
+﻿#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <si_base/memory/concurrent_handle_allocator.h>
+#include <si_base/memory/concurrent_object_pool.h>
+#include <si_base/concurency/mutex.h>
+#include <si_base/core/basic_function.h>
+
+using namespace SI;
+
+namespace
+{
+	// 比較用. 既存のHandleAllocatorをMutexで守ったもの.
+	class MutexHandleAllocator
+	{
+	public:
+		void Initialize(uint32_t itemCount){ m_allocator.Initialize(itemCount); }
+		void Terminate(){ m_allocator.Terminate(); }
+
+		uint32_t Allocate()
+		{
+			MutexLocker locker(m_mutex);
+			return m_allocator.Allocate();
+		}
+
+		void Deallocate(uint32_t handle)
+		{
+			MutexLocker locker(m_mutex);
+			m_allocator.Deallocate(handle);
+		}
+
+	private:
+		Mutex           m_mutex;
+		HandleAllocator m_allocator;
+	};
+
+	template<typename Allocator, typename Func>
+	void RunThreads(uint32_t threadCount, Func func)
+	{
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for(uint32_t t=0; t<threadCount; ++t)
+		{
+			threads.emplace_back(func, t);
+		}
+		for(std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// 各スレッドが数個ずつ確保しては開放するのを繰り返す.
+	template<typename Allocator>
+	double Benchmark(uint32_t threadCount, uint32_t loopCount)
+	{
+		static const uint32_t kHoldCount = 8;
+
+		Allocator allocator;
+		allocator.Initialize(threadCount * 64);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		RunThreads<Allocator>(threadCount, [&allocator, loopCount](uint32_t)
+		{
+			uint32_t handles[kHoldCount];
+			for(uint32_t i=0; i<loopCount; ++i)
+			{
+				for(uint32_t& h : handles) h = allocator.Allocate();
+				for(uint32_t  h : handles) allocator.Deallocate(h);
+			}
+		});
+		auto end = std::chrono::high_resolution_clock::now();
+
+		allocator.Terminate();
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		return ns / ((double)threadCount * loopCount * kHoldCount);
+	}
+}
+
+TEST(ConcurrentHandleAllocator, Test)
+{
+	static const uint32_t kItemCount   = 1024;
+	static const uint32_t kThreadCount = 8;
+
+	ConcurrentHandleAllocator allocator;
+	allocator.Initialize(kItemCount);
+
+	// 全部確保できて、重複しないこと.
+	{
+		std::vector<uint32_t> handles;
+		for(uint32_t i=0; i<kItemCount; ++i)
+		{
+			uint32_t h = allocator.Allocate();
+			ASSERT_NE(kInvalidHandle, h);
+			handles.push_back(h);
+		}
+		EXPECT_EQ(kInvalidHandle, allocator.Allocate());
+		EXPECT_EQ(kItemCount, allocator.GetAllocatedCount());
+
+		std::sort(handles.begin(), handles.end());
+		EXPECT_TRUE(std::unique(handles.begin(), handles.end()) == handles.end());
+
+		for(uint32_t h : handles) allocator.Deallocate(h);
+		EXPECT_EQ(0u, allocator.GetAllocatedCount());
+	}
+
+	// 複数スレッドで同じハンドルを同時に持たないこと.
+	std::vector<AtomicUint32> owners(kItemCount);
+	Atomic<bool> failed(false);
+	RunThreads<ConcurrentHandleAllocator>(kThreadCount, [&](uint32_t threadIndex)
+	{
+		uint32_t handles[16];
+		for(uint32_t loop=0; loop<2000; ++loop)
+		{
+			for(uint32_t& h : handles)
+			{
+				h = allocator.Allocate();
+				if(h == kInvalidHandle || owners[h].Exchange(threadIndex + 1) != 0) failed = true;
+			}
+			for(uint32_t h : handles)
+			{
+				if(h == kInvalidHandle) continue;
+				owners[h].Store(0);
+				allocator.Deallocate(h);
+			}
+		}
+	});
+	EXPECT_FALSE((bool)failed);
+	EXPECT_EQ(0u, allocator.GetAllocatedCount());
+
+	// 他のスレッドのキャッシュに残っていても、全部確保できること.
+	{
+		std::vector<uint32_t> handles;
+		for(uint32_t i=0; i<kItemCount; ++i)
+		{
+			uint32_t h = allocator.Allocate();
+			ASSERT_NE(kInvalidHandle, h);
+			handles.push_back(h);
+		}
+		for(uint32_t h : handles) allocator.Deallocate(h);
+	}
+
+	allocator.Terminate();
+}
+
+TEST(ConcurrentObjectPool, Test)
+{
+	ConcurrentObjectPool<uint64_t> pool;
+	pool.Initialize(256);
+
+	RunThreads<ConcurrentObjectPool<uint64_t>>(4, [&pool](uint32_t threadIndex)
+	{
+		for(uint32_t loop=0; loop<1000; ++loop)
+		{
+			uint64_t* obj = pool.Allocate();
+			ASSERT_NE(nullptr, obj);
+			*obj = threadIndex;
+			pool.Deallocate(obj);
+		}
+	});
+	EXPECT_EQ(0u, pool.GetAllocatedObjectCount());
+
+	pool.Terminate();
+}
+
+// Mutexで守ったHandleAllocatorとの比較. スレッド数ごとの1操作あたりの時間(ns)を出力する.
+// 通常のテストでは実行しない. --gtest_also_run_disabled_testsを付けると実行される.
+TEST(ConcurrentHandleAllocator, DISABLED_Benchmark)
+{
+	static const uint32_t kTotalLoop = 1 << 15;
+
+	for(uint32_t threadCount : {1u, 2u, 4u, 8u, 16u, 32u, 64u})
+	{
+		uint32_t loopCount = Max(kTotalLoop / threadCount, 256u);
+		double mutexNs      = Benchmark<MutexHandleAllocator>(threadCount, loopCount);
+		double concurrentNs = Benchmark<ConcurrentHandleAllocator>(threadCount, loopCount);
+		printf("[HandleAllocator] threads %2u: mutex %8.2f ns/op, lock-free %8.2f ns/op\n",
+			threadCount, mutexNs, concurrentNs);
+	}
+}
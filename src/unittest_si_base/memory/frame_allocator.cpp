@@ -0,0 +1,52 @@
+﻿#include "pch.h"
+
+#include <thread>
+#include <si_base/memory/frame_allocator.h>
+
+using namespace SI;
+
+TEST(FrameAllocator, FrameVector)
+{
+	// FrameAllocatorが無ければヒープから確保する.
+	{
+		FrameVector<uint32_t> values;
+		EXPECT_EQ(nullptr, values.get_allocator().GetAllocator());
+		for(uint32_t i=0; i<100; ++i) values.push_back(i);
+		EXPECT_EQ(99u, values.back());
+	}
+
+	FrameAllocator frameAllocator;
+	frameAllocator.Initialize();
+
+	LinearAllocator* mainAllocator = FrameAllocator::GetCurrentThreadAllocator();
+	ASSERT_NE(nullptr, mainAllocator);
+
+	{
+		FrameVector<uint32_t> values;
+		EXPECT_EQ(mainAllocator, values.get_allocator().GetAllocator());
+		for(uint32_t i=0; i<10000; ++i) values.push_back(i);
+		for(uint32_t i=0; i<10000; ++i) EXPECT_EQ(i, values[i]);
+	}
+
+	// スレッド毎に別のアロケータになる.
+	LinearAllocator* threadAllocator = nullptr;
+	std::thread thread([&threadAllocator]()
+	{
+		threadAllocator = FrameAllocator::GetCurrentThreadAllocator();
+		FrameVector<uint64_t> values(256, 1);
+		EXPECT_EQ(256u, values.size());
+	});
+	thread.join();
+	EXPECT_NE(nullptr, threadAllocator);
+	EXPECT_NE(mainAllocator, threadAllocator);
+	EXPECT_EQ(2u, frameAllocator.GetThreadCount());
+
+	// フレームが変わると、もう一方のバッファを使う.
+	frameAllocator.Flip();
+	EXPECT_NE(mainAllocator, FrameAllocator::GetCurrentThreadAllocator());
+	frameAllocator.Flip();
+	EXPECT_EQ(mainAllocator, FrameAllocator::GetCurrentThreadAllocator());
+
+	frameAllocator.Terminate();
+	EXPECT_EQ(nullptr, FrameAllocator::GetCurrentThreadAllocator());
+}
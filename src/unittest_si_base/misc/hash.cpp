@@ -1,5 +1,6 @@
 ﻿#include "pch.h"
 
+#include <vector>
 #include <si_base/misc/hash.h>
 
 using namespace SI;
@@ -77,3 +78,87 @@ TEST(Hash, Test32)
 	Hash32 hashT = GetHash32(hoge5);
 	EXPECT_EQ(hashS, hashT);
 }
+
+TEST(Hash, Xxh3)
+{
+	// 本家xxHash(XXH3_64bits, XXH3_64bits_withSeed, XXH3_128bits_withSeed)で求めた値.
+	struct Expected
+	{
+		size_t   m_size;
+		uint64_t m_hash64;
+		uint64_t m_hash64Seeded;
+		Hash128  m_hash128Seeded;
+	};
+	static const Expected kExpected[] =
+	{
+		{    0, 0x2d06800538d394c2ull, 0xb5991a1202758c1dull, { 0xac58ea339c643281ull, 0xb67ab81a27f3a0beull } },
+		{    1, 0x13e608bc156defedull, 0xf9024169eda18259ull, { 0xf9024169eda18259ull, 0xc3f356137c392987ull } },
+		{    3, 0xa9088dda485b481cull, 0xb1650cf53c3bfa4aull, { 0xb1650cf53c3bfa4aull, 0x8e8e1e137f39217full } },
+		{    4, 0x6d9253b16c8b1ed3ull, 0x4a1246d0fb3b24acull, { 0xb7fc0f34d8f89fddull, 0xaa666b91cc8e1073ull } },
+		{    8, 0x60539db630471163ull, 0x4e3a3c685e7041f4ull, { 0x404586be9a9eea20ull, 0x4086e38a166e21b2ull } },
+		{    9, 0xfeff668361d723a8ull, 0xd015937d83642a47ull, { 0x54f1c42641da2da7ull, 0xeb63cd9497c2be81ull } },
+		{   16, 0xb8c859b0f030b585ull, 0xd95ae03fbddf7a62ull, { 0xe2b826a99b99a7c5ull, 0x91f9559637c20775ull } },
+		{   17, 0x714a04408e79b80full, 0xb3863e74762be2adull, { 0xb97322865e83ddd7ull, 0x0d93b5cca64cb30full } },
+		{  128, 0x67425a03650261bfull, 0xb203911ea7be499bull, { 0x663de2be6b1c43b9ull, 0x64b7326d24dfb3f5ull } },
+		{  129, 0xc664bf3311c6abc4ull, 0x514cc53e4dcf1a90ull, { 0x484637037b8012ccull, 0x3cf84e126990e13bull } },
+		{  240, 0x64556dc6b462a6cfull, 0x594b752a2f7f28b0ull, { 0x966f6ffd1f5e29f6ull, 0xb6ea0cf664562e2bull } },
+		{  241, 0x8beadd3a8874fe17ull, 0x2ebccff302188d4aull, { 0x2ebccff302188d4aull, 0x456af2c3e7a6eb6dull } },
+		{ 1024, 0x9b81661c641c72b1ull, 0xd528c5411ed85abfull, { 0xd528c5411ed85abfull, 0xc59c7dd52cb8e211ull } },
+		{ 1025, 0x806c2072ed713576ull, 0x167b5c86f888fdceull, { 0x167b5c86f888fdceull, 0x6dd7f7a36d21db49ull } },
+		{ 5000, 0x799aaddd7339581dull, 0xe893403bb65365a8ull, { 0xe893403bb65365a8ull, 0xabb2f59b19f77d20ull } },
+	};
+	const uint64_t kSeed = 0x1234567890abcdefull;
+
+	std::vector<uint8_t> data(5000 + 1);
+	for(size_t i=0; i<data.size(); ++i)
+	{
+		data[i] = (uint8_t)(i * 7 + 3);
+	}
+
+	for(const Expected& e : kExpected)
+	{
+		EXPECT_EQ(e.m_hash64,        Xxh3Hash64 (data.data(), e.m_size, 0))     << e.m_size;
+		EXPECT_EQ(e.m_hash64Seeded,  Xxh3Hash64 (data.data(), e.m_size, kSeed)) << e.m_size;
+		EXPECT_EQ(e.m_hash128Seeded, Xxh3Hash128(data.data(), e.m_size, kSeed)) << e.m_size;
+
+		// アラインメントがずれていても同じ値になる.
+		std::vector<uint8_t> shifted(e.m_size + 1);
+		if(0 < e.m_size) memcpy(&shifted[1], data.data(), e.m_size);
+		EXPECT_EQ(e.m_hash64Seeded, Xxh3Hash64(&shifted[1], e.m_size, kSeed)) << e.m_size;
+	}
+
+	// 分割してAddしても、まとめて計算した値と一致する.
+	static const size_t kSizes[]  = { 0, 1, 17, 240, 241, 256, 257, 1024, 1025, 5000 };
+	static const size_t kSplits[] = { 1, 3, 63, 64, 65, 255, 256, 257, 1024 };
+	for(size_t size : kSizes)
+	{
+		Hash64 expected = Xxh3Hash64(data.data(), size, kSeed);
+		for(size_t split : kSplits)
+		{
+			Xxh3Hash64Generator generator(kSeed);
+			for(size_t offset=0; offset<size; offset+=split)
+			{
+				generator.Add(data.data() + offset, std::min(split, size - offset));
+			}
+			EXPECT_EQ(expected, generator.Generate()) << size << " " << split;
+		}
+	}
+
+#if USE_STATIC_HASH
+	// コンパイル時の計算も実行時と一致する.
+	constexpr Hash64 hashS     = StaticXxh3Hash64("12wedfghjuertyuikjhgfde45", 25);
+	constexpr Hash64 hashLongS = StaticXxh3Hash64(
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 256);
+	EXPECT_EQ(hashS,     Xxh3Hash64("12wedfghjuertyuikjhgfde45", 25));
+	EXPECT_EQ(hashLongS, Xxh3Hash64(
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 256));
+#endif
+
+	EXPECT_EQ(GetHash128("12wedfghjuertyuikjhgfde45"), Xxh3Hash128("12wedfghjuertyuikjhgfde45", 25));
+}
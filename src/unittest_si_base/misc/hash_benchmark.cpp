@@ -0,0 +1,115 @@
+﻿#include "pch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <si_base/core/basic_function.h>
+#include <si_base/misc/hash.h>
+
+using namespace SI;
+
+// ハッシュ関数のスループットのベンチマーク.
+// 入力サイズごとに、Murmur2AとXXH3の1秒あたりの処理量(GB/s)を出力する.
+// 通常のテストでは実行しない. --gtest_also_run_disabled_testsを付けると実行される.
+
+namespace
+{
+	static const size_t kBenchmarkBytes = 64 * 1024 * 1024; // 1サイズあたりにハッシュする総量.
+
+	volatile uint64_t g_sink = 0; // 最適化で消されないように結果を書き出す先.
+
+	template<typename Func>
+	void RunBenchmark(const char* name, size_t size, Func func)
+	{
+		size_t loop = kBenchmarkBytes / size;
+		if(loop < 16) loop = 16;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		uint64_t sum = 0;
+		for(size_t i=0; i<loop; ++i)
+		{
+			// 毎回同じ値にならないように、ループ回数をseedにする.
+			sum += func((uint64_t)i);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		g_sink = sum;
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		double gbPerSec = (double)(size * loop) / ns;
+		printf("[%-6s] %-20s %8zu byte %8.2f GB/s %10.2f ns/hash\n", kSiHashSimdName, name, size, gbPerSec, ns / (double)loop);
+	}
+
+	template<size_t kSize>
+	struct SmallKey
+	{
+		uint8_t m_bytes[kSize];
+	};
+
+	// GetHash64(const T&)で構造体やポインタをキーにする場合. サイズはコンパイル時に決まっている.
+	template<size_t kSize>
+	void RunSmallKeyBenchmark(const uint8_t* data)
+	{
+		auto makeKey = [data](uint64_t i)
+		{
+			SmallKey<kSize> key;
+			memcpy(&key, data + (i & 63), kSize);
+			return key;
+		};
+
+		RunBenchmark("Murmur2AHash64",  kSize, [&](uint64_t i){ SmallKey<kSize> key = makeKey(i); return Murmur2AHash64(&key, kSize); });
+		RunBenchmark("GetHash64",       kSize, [&](uint64_t i){ return GetHash64(makeKey(i)); });
+		RunBenchmark("Hash64Generator", kSize, [&](uint64_t i)
+		{
+			Hash64Generator generator;
+			generator.Add(makeKey(i));
+			return generator.Generate();
+		});
+	}
+}
+
+TEST(HashBenchmark, DISABLED_Throughput)
+{
+	static const size_t kSizes[] = { 16, 64, 256, 1024, 4 * 1024, 64 * 1024, 1024 * 1024 };
+
+	// Generatorは既定のシードで使うので、読む位置をずらして毎回違う入力にする.
+	std::vector<uint8_t> data(kSizes[ArraySize(kSizes) - 1] + 8);
+	for(size_t i=0; i<data.size(); ++i)
+	{
+		data[i] = (uint8_t)(i * 7 + 3);
+	}
+
+	for(size_t size : kSizes)
+	{
+		const uint8_t* p = data.data();
+
+		RunBenchmark("Murmur2AHash64", size, [&](uint64_t seed){ return Murmur2AHash64(p, size, seed); });
+		RunBenchmark("Xxh3Hash64",     size, [&](uint64_t seed){ return Xxh3Hash64(p, size, seed); });
+		RunBenchmark("Xxh3Hash128",    size, [&](uint64_t seed){ return Xxh3Hash128(p, size, seed).m_low; });
+		RunBenchmark("Hash64Generator", size, [&](uint64_t seed)
+		{
+			// 256byteずつに分けて追加する. ファイルなどを少しずつ読んでハッシュする場合を想定.
+			const uint8_t* input = p + (seed & 7);
+			Hash64Generator generator;
+			for(size_t offset=0; offset<size; offset+=256)
+			{
+				generator.Add(input + offset, std::min<size_t>(256, size - offset));
+			}
+			return generator.Generate();
+		});
+	}
+}
+
+TEST(HashBenchmark, DISABLED_SmallKey)
+{
+	std::vector<uint8_t> data(64 + 64);
+	for(size_t i=0; i<data.size(); ++i)
+	{
+		data[i] = (uint8_t)(i * 7 + 3);
+	}
+
+	RunSmallKeyBenchmark<4> (data.data());
+	RunSmallKeyBenchmark<8> (data.data());
+	RunSmallKeyBenchmark<16>(data.data());
+	RunSmallKeyBenchmark<32>(data.data());
+	RunSmallKeyBenchmark<64>(data.data());
+}
@@ -0,0 +1,47 @@
+﻿#include "pch.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <si_base/misc/radix_sort.h>
+
+using namespace SI;
+
+namespace
+{
+	struct KeyValue
+	{
+		uint64_t m_key;
+		uint32_t m_value;
+	};
+}
+
+TEST(RadixSort, Test64)
+{
+	std::mt19937_64 rand(1234);
+
+	for(size_t count : {0u, 1u, 2u, 17u, 1000u})
+	{
+		std::vector<KeyValue> items(count);
+		for(size_t i=0; i<count; ++i)
+		{
+			// 上位ビットが揃ったキー(パス省略)と重複キー(安定性)を混ぜる.
+			uint64_t key = (i%3 == 0)? (rand() & 0xff) : (0xa000000000000000ull | (rand() & 0xffffffffull));
+			items[i].m_key   = key;
+			items[i].m_value = (uint32_t)i;
+		}
+
+		std::vector<KeyValue> expected = items;
+		std::stable_sort(expected.begin(), expected.end(),
+			[](const KeyValue& a, const KeyValue& b){ return a.m_key < b.m_key; });
+
+		std::vector<KeyValue> work(count);
+		RadixSort64(items.data(), work.data(), count, [](const KeyValue& kv){ return kv.m_key; });
+
+		for(size_t i=0; i<count; ++i)
+		{
+			EXPECT_EQ(expected[i].m_key,   items[i].m_key);
+			EXPECT_EQ(expected[i].m_value, items[i].m_value);
+		}
+	}
+}
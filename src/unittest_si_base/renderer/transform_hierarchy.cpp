@@ -0,0 +1,57 @@
+﻿#include "pch.h"
+
+#include <si_base/renderer/transform_hierarchy.h>
+
+using namespace SI;
+
+namespace
+{
+	void ExpectNear(const Vfloat4x4& a, const Vfloat4x4& b)
+	{
+		for(uint32_t r=0; r<4; ++r)
+		{
+			Vfloat4 ra = a.GetRow(r);
+			Vfloat4 rb = b.GetRow(r);
+			EXPECT_NEAR(ra.Xf(), rb.Xf(), 1.0e-5f);
+			EXPECT_NEAR(ra.Yf(), rb.Yf(), 1.0e-5f);
+			EXPECT_NEAR(ra.Zf(), rb.Zf(), 1.0e-5f);
+			EXPECT_NEAR(ra.Wf(), rb.Wf(), 1.0e-5f);
+		}
+	}
+}
+
+TEST(TransformHierarchy, Update)
+{
+	const uint32_t kInvalid = TransformHierarchy::kInvalidIndex;
+
+	// root - a - c
+	//      - b
+	TransformHierarchy hierarchy;
+	uint32_t root = hierarchy.Add(kInvalid, Vfloat4x4::Translate(Vfloat3(1.0f, 0.0f, 0.0f)));
+	uint32_t a    = hierarchy.Add(root,     Vfloat4x4::RotateY(0.5f));
+	uint32_t b    = hierarchy.Add(root,     Vfloat4x4::Scale(Vfloat3(2.0f)));
+	uint32_t c    = hierarchy.Add(a,        Vfloat4x4::Translate(Vfloat3(0.0f, 3.0f, 0.0f)));
+
+	EXPECT_TRUE(hierarchy.Update());
+	EXPECT_EQ(4u, (uint32_t)hierarchy.GetChangedIndices().size());
+
+	ExpectNear(hierarchy.GetWorldMatrix(root), hierarchy.GetLocalMatrix(root));
+	ExpectNear(hierarchy.GetWorldMatrix(b), hierarchy.GetLocalMatrix(b) * hierarchy.GetWorldMatrix(root));
+	ExpectNear(hierarchy.GetWorldMatrix(c), hierarchy.GetLocalMatrix(c) * hierarchy.GetLocalMatrix(a) * hierarchy.GetLocalMatrix(root));
+
+	// 変更が無ければ何もしない.
+	EXPECT_FALSE(hierarchy.Update());
+	EXPECT_TRUE(hierarchy.GetChangedIndices().empty());
+
+	// aを動かすと、aとその子のcだけが更新される.
+	hierarchy.SetLocalTRS(a, Vfloat3(0.0f, 0.0f, 5.0f), Vquat(), Vfloat3(1.0f));
+	EXPECT_TRUE(hierarchy.Update());
+	ASSERT_EQ(2u, (uint32_t)hierarchy.GetChangedIndices().size());
+	EXPECT_EQ(a, hierarchy.GetChangedIndices()[0]);
+	EXPECT_EQ(c, hierarchy.GetChangedIndices()[1]);
+
+	Vfloat3 cPos = Math::Multiply(Vfloat3(0.0f), hierarchy.GetWorldMatrix(c));
+	EXPECT_NEAR(1.0f, cPos.Xf(), 1.0e-5f);
+	EXPECT_NEAR(3.0f, cPos.Yf(), 1.0e-5f);
+	EXPECT_NEAR(5.0f, cPos.Zf(), 1.0e-5f);
+}
@@ -0,0 +1,363 @@
+﻿#include "pch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <si_base/serialization/serializer.h>
+#include <si_base/serialization/deserializer.h>
+#include <si_base/serialization/binary_serializer.h>
+#include <si_base/serialization/binary_deserializer.h>
+#include <si_base/serialization/binary_archive.h>
+#include <si_base/container/array.h>
+#include <si_base/math/math.h>
+#include <si_base/file/file.h>
+
+namespace BinarySerializationTest
+{
+	struct Child
+	{
+		int                 intHoge;
+		const char*         strHoge;
+		SI::Array<uint8_t>  uint8ArrayHoge;
+
+		SI_REFLECTION(
+			BinarySerializationTest::Child,
+			SI_REFLECTION_MEMBER(intHoge),
+			SI_REFLECTION_MEMBER(strHoge),
+			SI_REFLECTION_MEMBER(uint8ArrayHoge))
+	};
+
+	struct Root
+	{
+		double                  doubleHoge;
+		SI::Vfloat4x4           matrixHoge;
+		const char*             strHoge;
+		Child*                  childPtrHoge;
+		Child*                  nullPtrHoge;
+		int                     intArrayHoge[4];
+		Child                   childArrayHoge[2];
+		SI::Array<SI::Vfloat3>  vfloat3ArrayHoge;
+		SI::Array<Child>        childArrayArrayHoge;
+
+		SI_REFLECTION(
+			BinarySerializationTest::Root,
+			SI_REFLECTION_MEMBER(doubleHoge),
+			SI_REFLECTION_MEMBER(matrixHoge),
+			SI_REFLECTION_MEMBER(strHoge),
+			SI_REFLECTION_MEMBER(childPtrHoge),
+			SI_REFLECTION_MEMBER(nullPtrHoge),
+			SI_REFLECTION_MEMBER_ARRAY(intArrayHoge),
+			SI_REFLECTION_MEMBER_ARRAY(childArrayHoge),
+			SI_REFLECTION_MEMBER(vfloat3ArrayHoge),
+			SI_REFLECTION_MEMBER(childArrayArrayHoge))
+	};
+
+	// Rootとメンバの並びだけ違う型.
+	struct RootChanged
+	{
+		SI::Vfloat4x4           matrixHoge;
+		double                  doubleHoge;
+
+		SI_REFLECTION(
+			BinarySerializationTest::RootChanged,
+			SI_REFLECTION_MEMBER(matrixHoge),
+			SI_REFLECTION_MEMBER(doubleHoge))
+	};
+
+	struct Matrices
+	{
+		SI::Array<SI::Vfloat4x4> matrices;
+
+		SI_REFLECTION(
+			BinarySerializationTest::Matrices,
+			SI_REFLECTION_MEMBER(matrices))
+	};
+
+	bool IsSameChild(const Child& a, const Child& b)
+	{
+		if(a.intHoge != b.intHoge) return false;
+		if(strcmp(a.strHoge, b.strHoge) != 0) return false;
+		if(a.uint8ArrayHoge.GetItemCount() != b.uint8ArrayHoge.GetItemCount()) return false;
+		for(uint32_t i=0; i<a.uint8ArrayHoge.GetItemCount(); ++i)
+		{
+			if(a.uint8ArrayHoge[i] != b.uint8ArrayHoge[i]) return false;
+		}
+		return true;
+	}
+
+	void ExpectSameRoot(const Root& src, const Root& dst)
+	{
+		EXPECT_EQ(src.doubleHoge, dst.doubleHoge);
+		for(uint32_t i=0; i<4; ++i)
+		{
+			EXPECT_TRUE(src.matrixHoge[i] == dst.matrixHoge[i]);
+			EXPECT_EQ(src.intArrayHoge[i], dst.intArrayHoge[i]);
+		}
+		EXPECT_STREQ(src.strHoge, dst.strHoge);
+		EXPECT_TRUE(IsSameChild(*src.childPtrHoge, *dst.childPtrHoge));
+		EXPECT_EQ(nullptr, dst.nullPtrHoge);
+		for(uint32_t i=0; i<2; ++i)
+		{
+			EXPECT_TRUE(IsSameChild(src.childArrayHoge[i], dst.childArrayHoge[i]));
+		}
+
+		ASSERT_EQ(src.vfloat3ArrayHoge.GetItemCount(), dst.vfloat3ArrayHoge.GetItemCount());
+		for(uint32_t i=0; i<src.vfloat3ArrayHoge.GetItemCount(); ++i)
+		{
+			EXPECT_TRUE(src.vfloat3ArrayHoge[i] == dst.vfloat3ArrayHoge[i]);
+		}
+
+		ASSERT_EQ(src.childArrayArrayHoge.GetItemCount(), dst.childArrayArrayHoge.GetItemCount());
+		for(uint32_t i=0; i<src.childArrayArrayHoge.GetItemCount(); ++i)
+		{
+			EXPECT_TRUE(IsSameChild(src.childArrayArrayHoge[i], dst.childArrayArrayHoge[i]));
+		}
+	}
+}
+
+TEST(BinarySerialization, RoundTrip)
+{
+	using namespace BinarySerializationTest;
+	SI::FileSystem::SetCurrentDir(SI_PROJECT_DIR);
+
+	uint8_t bytes[5] = {1, 2, 3, 4, 5};
+	SI::Vfloat3 vectors[3] = { SI::Vfloat3(1.0f, 2.0f, 3.0f), SI::Vfloat3(4.0f, 5.0f, 6.0f), SI::Vfloat3(7.0f, 8.0f, 9.0f) };
+
+	Child child;
+	child.intHoge = 7;
+	child.strHoge = "child";
+	child.uint8ArrayHoge.Setup(bytes, 5);
+
+	Child children[3];
+	for(uint32_t i=0; i<3; ++i)
+	{
+		children[i].intHoge = 10 + i;
+		children[i].strHoge = (i==1)? "" : "array";
+		children[i].uint8ArrayHoge.Setup(bytes, i);
+	}
+
+	Root src;
+	src.doubleHoge   = 0.125;
+	src.matrixHoge   = SI::Vfloat4x4(
+		SI::Vfloat4( 1.0f,  2.0f,  3.0f,  4.0f),
+		SI::Vfloat4( 5.0f,  6.0f,  7.0f,  8.0f),
+		SI::Vfloat4( 9.0f, 10.0f, 11.0f, 12.0f),
+		SI::Vfloat4(13.0f, 14.0f, 15.0f, 16.0f));
+	src.strHoge      = "hogehoge";
+	src.childPtrHoge = &child;
+	src.nullPtrHoge  = nullptr;
+	for(uint32_t i=0; i<4; ++i){ src.intArrayHoge[i] = (int)(i*i); }
+	src.childArrayHoge[0] = children[0];
+	src.childArrayHoge[1] = children[2];
+	src.vfloat3ArrayHoge.Setup(vectors, 3);
+	src.childArrayArrayHoge.Setup(children, 3);
+
+	SI::BinarySerializer serializer;
+	serializer.Initialize();
+	bool ret = serializer.Serialize("asset\\binary_test0.bin", src);
+	serializer.Terminate();
+	EXPECT_EQ(ret, true);
+
+	SI::BinaryDeserializer deserializer;
+	deserializer.Initialize();
+
+	SI::DeserializedObject obj;
+	ret = deserializer.Deserialize<Root>(obj, "asset\\binary_test0.bin");
+	EXPECT_EQ(ret, true);
+
+	// 型のレイアウトが違うものは読まない.
+	SI::DeserializedObject changedObj;
+	EXPECT_FALSE(deserializer.Deserialize<RootChanged>(changedObj, "asset\\binary_test0.bin"));
+	deserializer.Terminate();
+
+	ExpectSameRoot(src, *obj.Get<Root>());
+}
+
+TEST(BinarySerialization, BrokenData)
+{
+	using namespace BinarySerializationTest;
+
+	Child child;
+	child.intHoge = 1;
+	child.strHoge = "broken";
+
+	std::vector<uint8_t> buffer;
+	SI::BinarySerializer serializer;
+	serializer.Initialize();
+	EXPECT_TRUE(serializer.Serialize(buffer, child));
+	serializer.Terminate();
+
+	SI::BinaryDeserializer deserializer;
+	deserializer.Initialize();
+
+	SI::DeserializedObject obj;
+	EXPECT_TRUE(deserializer.Deserialize<Child>(obj, buffer.data(), buffer.size()));
+	EXPECT_STREQ("broken", obj.Get<Child>()->strHoge);
+
+	// 途中で切れている.
+	EXPECT_FALSE(deserializer.Deserialize<Child>(obj, buffer.data(), buffer.size()-4));
+
+	// ポインタがdataの外を指している.
+	size_t strOffset = sizeof(SI::BinaryArchiveHeader) + offsetof(Child, strHoge);
+	int64_t invalidOffset = 0x10000;
+	memcpy(&buffer[strOffset], &invalidOffset, sizeof(invalidOffset));
+	EXPECT_FALSE(deserializer.Deserialize<Child>(obj, buffer.data(), buffer.size()));
+
+	deserializer.Terminate();
+}
+
+namespace BinarySerializationTest
+{
+	// ポインタで互いを持つ型.
+	// SI_REFLECTIONだと型情報の初期化が再帰してしまうので、型情報は直接作る.
+	struct CycleB;
+
+	struct CycleA
+	{
+		int     intHoge;
+		CycleB* bPtrHoge;
+	};
+
+	struct CycleB
+	{
+		double  doubleHoge;
+		CycleA* aPtrHoge;
+	};
+
+	extern const SI::ReflectionUserType<CycleA, 2> s_cycleAType;
+	extern const SI::ReflectionUserType<CycleB, 2> s_cycleBType;
+
+	const SI::ReflectionUserType<CycleA, 2> s_cycleAType(
+		"BinarySerializationTest::CycleA",
+		{
+			SI::ReflectionMember("intHoge",  (uint32_t)offsetof(CycleA, intHoge),  0u, 0u, SI::GetReflectionType<int>(0)),
+			SI::ReflectionMember("bPtrHoge", (uint32_t)offsetof(CycleA, bPtrHoge), 1u, 0u, s_cycleBType)
+		});
+
+	const SI::ReflectionUserType<CycleB, 2> s_cycleBType(
+		"BinarySerializationTest::CycleB",
+		{
+			SI::ReflectionMember("doubleHoge", (uint32_t)offsetof(CycleB, doubleHoge), 0u, 0u, SI::GetReflectionType<double>(0)),
+			SI::ReflectionMember("aPtrHoge",   (uint32_t)offsetof(CycleB, aPtrHoge),   1u, 0u, s_cycleAType)
+		});
+}
+
+TEST(BinarySerialization, CyclicLayoutHash)
+{
+	using namespace BinarySerializationTest;
+
+	// それぞれ新しいLayoutで計算した値.
+	SI::BinaryArchiveLayout freshA;
+	SI::BinaryArchiveLayout freshB;
+	SI::Hash64 hashA = freshA.GetLayoutHash(s_cycleAType);
+	SI::Hash64 hashB = freshB.GetLayoutHash(s_cycleBType);
+	EXPECT_NE(hashA, hashB);
+
+	// どちらから計算しても、同じLayoutで何度計算しても変わらない.
+	SI::BinaryArchiveLayout layoutAB;
+	EXPECT_EQ(hashA, layoutAB.GetLayoutHash(s_cycleAType));
+	EXPECT_EQ(hashB, layoutAB.GetLayoutHash(s_cycleBType));
+	EXPECT_EQ(hashA, layoutAB.GetLayoutHash(s_cycleAType));
+
+	SI::BinaryArchiveLayout layoutBA;
+	EXPECT_EQ(hashB, layoutBA.GetLayoutHash(s_cycleBType));
+	EXPECT_EQ(hashA, layoutBA.GetLayoutHash(s_cycleAType));
+	EXPECT_EQ(hashB, layoutBA.GetLayoutHash(s_cycleBType));
+}
+
+namespace BinarySerializationTest
+{
+	static const uint32_t kMatrixCount = 4096;
+
+	// 同じ行列の配列をjsonとバイナリの両方で書き出す.
+	std::vector<SI::Vfloat4x4> WriteMatrixFiles()
+	{
+		std::vector<SI::Vfloat4x4> matrices(kMatrixCount);
+		for(uint32_t i=0; i<kMatrixCount; ++i)
+		{
+			float f = (float)i;
+			matrices[i] = SI::Vfloat4x4(
+				SI::Vfloat4(f, f+0.1f, f+0.2f, f+0.3f),
+				SI::Vfloat4(f, f+1.1f, f+1.2f, f+1.3f),
+				SI::Vfloat4(f, f+2.1f, f+2.2f, f+2.3f),
+				SI::Vfloat4(f, f+3.1f, f+3.2f, f+3.3f));
+		}
+
+		Matrices src;
+		src.matrices.Setup(matrices.data(), kMatrixCount);
+
+		SI::Serializer serializer;
+		serializer.Initialize();
+		serializer.Serialize("asset\\binary_test1.json", src);
+		serializer.Terminate();
+
+		SI::BinarySerializer binarySerializer;
+		binarySerializer.Initialize();
+		binarySerializer.Serialize("asset\\binary_test1.bin", src);
+		binarySerializer.Terminate();
+
+		return matrices;
+	}
+}
+
+TEST(BinarySerialization, CompareWithJson)
+{
+	using namespace BinarySerializationTest;
+	SI::FileSystem::SetCurrentDir(SI_PROJECT_DIR);
+
+	std::vector<SI::Vfloat4x4> matrices = WriteMatrixFiles();
+
+	SI::Deserializer deserializer;
+	deserializer.Initialize();
+	SI::DeserializedObject jsonObj;
+	EXPECT_TRUE(deserializer.Deserialize<Matrices>(jsonObj, "asset\\binary_test1.json"));
+	deserializer.Terminate();
+
+	SI::BinaryDeserializer binaryDeserializer;
+	binaryDeserializer.Initialize();
+	SI::DeserializedObject binaryObj;
+	EXPECT_TRUE(binaryDeserializer.Deserialize<Matrices>(binaryObj, "asset\\binary_test1.bin"));
+	binaryDeserializer.Terminate();
+
+	const Matrices& jsonDst   = *jsonObj.Get<Matrices>();
+	const Matrices& binaryDst = *binaryObj.Get<Matrices>();
+	ASSERT_EQ(kMatrixCount, binaryDst.matrices.GetItemCount());
+	ASSERT_EQ(kMatrixCount, jsonDst.matrices.GetItemCount());
+	for(uint32_t i=0; i<kMatrixCount; ++i)
+	{
+		for(uint32_t r=0; r<4; ++r)
+		{
+			EXPECT_TRUE(matrices[i][r] == binaryDst.matrices[i][r]);
+			EXPECT_TRUE(matrices[i][r] == jsonDst.matrices[i][r]);
+		}
+	}
+}
+
+// jsonとバイナリの読み込み時間を出力する.
+// 通常のテストでは実行しない. --gtest_also_run_disabled_testsを付けると実行される.
+TEST(BinarySerialization, DISABLED_BenchmarkCompareWithJson)
+{
+	using namespace BinarySerializationTest;
+	SI::FileSystem::SetCurrentDir(SI_PROJECT_DIR);
+
+	WriteMatrixFiles();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	SI::Deserializer deserializer;
+	deserializer.Initialize();
+	SI::DeserializedObject jsonObj;
+	EXPECT_TRUE(deserializer.Deserialize<Matrices>(jsonObj, "asset\\binary_test1.json"));
+	deserializer.Terminate();
+	double jsonMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	SI::BinaryDeserializer binaryDeserializer;
+	binaryDeserializer.Initialize();
+	SI::DeserializedObject binaryObj;
+	EXPECT_TRUE(binaryDeserializer.Deserialize<Matrices>(binaryObj, "asset\\binary_test1.bin"));
+	binaryDeserializer.Terminate();
+	double binaryMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	printf("json   : %.3f ms\n", jsonMs);
+	printf("binary : %.3f ms (x%.1f)\n", binaryMs, jsonMs / binaryMs);
+}